@@ -8,6 +8,21 @@
 #define internal static
 #define AX_APPLICATION_RETRIES 10
 
+/* NOTE(koekeishiya): An application whose average AX latency exceeds the budget, or that keeps timing out,
+                      is marked as degraded. Degraded applications get a shorter messaging timeout and their
+                      windows are moved and resized off the event thread, see AXLibMoveWindow(..). */
+#define AX_LATENCY_BUDGET 100.0
+#define AX_LATENCY_WEIGHT 0.2
+#define AX_DEGRADED_TIMEOUTS 2
+#define AX_MAX_TIMEOUTS 8
+#define AX_DEGRADED_MESSAGING_TIMEOUT 0.25f
+
+/* NOTE(koekeishiya): Latency is recorded on the event thread, the main queue and the workers of
+                      AXLibInitializeApplications(..), so the latency state of every application is
+                      guarded by this lock. The messaging timeouts are changed on the event thread,
+                      which owns the window list of an application. */
+internal pthread_mutex_t LatencyLock = PTHREAD_MUTEX_INITIALIZER;
+
 enum ax_application_notifications
 {
     AXApplication_Notification_WindowCreated,
@@ -72,6 +87,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
         if(AXLibAddObserverNotification(&Application->Observer, Window->Ref, kAXUIElementDestroyedNotification, Window) == kAXErrorSuccess)
         {
             AXLibAddApplicationWindow(Application, Window);
+            AXLibSetWindowVisible(Window->ID, true);
 
             /* NOTE(koekeishiya): Triggers an AXEvent_WindowCreated and passes a pointer to the new ax_window */
             uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
@@ -172,6 +188,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
         if(Window)
         {
             AXLibAddFlags(Window, AXWindow_Minimized);
+            AXLibSetWindowVisible(Window->ID, false);
             uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
             *WindowID = Window->ID;
             AXLibConstructEvent(AXEvent_WindowMinimized, WindowID, false);
@@ -199,6 +216,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
 
                 Window->ID = AXLibGetWindowID(Window->Ref);
                 Window->Application->Windows[Window->ID] = Window;
+                AXLibIndexWindow(Window);
             }
 
             /* NOTE(koekeishiya): kAXWindowDeminiaturized is sent before didActiveSpaceChange, when a deminimized
@@ -210,6 +228,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
             ax_display *Display = AXLibWindowDisplay(Window);
             if(AXLibSpaceHasWindow(Window, Display->Space->ID))
             {
+                AXLibSetWindowVisible(Window->ID, true);
                 uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
                 *WindowID = Window->ID;
                 AXLibConstructEvent(AXEvent_WindowDeminimized, WindowID, false);
@@ -230,7 +249,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
         ax_window *Window = AXLibGetWindowByRef(Application, Element);
         if(Window)
         {
-            Window->Position = AXLibGetWindowPosition(Window->Ref);
+            AXLibRefreshWindowAttributes(Window, AXWindowAttribute_Position);
 
             bool Intrinsic = AXLibHasFlags(Window, AXWindow_MoveIntrinsic);
             uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
@@ -246,8 +265,7 @@ internal OBSERVER_CALLBACK(AXApplicationCallback)
         ax_window *Window = AXLibGetWindowByRef(Application, Element);
         if(Window)
         {
-            Window->Position = AXLibGetWindowPosition(Window->Ref);
-            Window->Size = AXLibGetWindowSize(Window->Ref);
+            AXLibRefreshWindowAttributes(Window, AXWindowAttribute_Position | AXWindowAttribute_Size);
 
             bool Intrinsic = AXLibHasFlags(Window, AXWindow_SizeIntrinsic);
             uint32_t *WindowID = (uint32_t *) malloc(sizeof(uint32_t));
@@ -331,47 +349,72 @@ ax_application AXLibConstructApplication(pid_t PID, std::string Name)
     GetProcessForPID(PID, &Application.PSN);
     Application.Name = Name;
     Application.PID = PID;
+    Application.Queue = AXLibCreateQueue("kwm.axlib.application");
 
     return Application;
 }
 
-bool AXLibInitializeApplication(pid_t PID)
+/* NOTE(koekeishiya): Performs the blocking part of initializing an application; creating the observer and
+                      enumerating its windows. Only touches state that belongs to this application, so it
+                      can run for several applications at the same time. */
+internal bool
+AXLibLoadApplication(ax_application *Application)
 {
-    ax_application *Application = AXLibGetApplicationByPID(PID);
-    if(Application)
+    bool Result = AXLibAddApplicationObserver(Application);
+    if(Result)
+    {
+        AXLibAddApplicationWindows(Application);
+        Application->Focus = AXLibGetFocusedWindow(Application);
+    }
+
+    return Result;
+}
+
+internal void
+AXLibRetryApplication(ax_application *Application)
+{
+    pid_t PID = Application->PID;
+    AXLibRemoveApplicationObserver(Application);
+    if(++Application->Retries < AX_APPLICATION_RETRIES)
     {
-        bool Result = AXLibAddApplicationObserver(Application);
-        if(Result)
-        {
-            AXLibAddApplicationWindows(Application);
-            Application->Focus = AXLibGetFocusedWindow(Application);
-        }
-        else
-        {
-            AXLibRemoveApplicationObserver(Application);
-            if(++Application->Retries < AX_APPLICATION_RETRIES)
-            {
 #ifdef DEBUG_BUILD
-                printf("AX: %s - Not responding, retry %d\n", Application->Name.c_str(), Application->Retries);
+        printf("AX: %s - Not responding, retry %d\n", Application->Name.c_str(), Application->Retries);
 #endif
-                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_SEC), dispatch_get_main_queue(),
-                ^{
-                    if(AXLibInitializeApplication(PID))
-                    {
-                        AXLibInitializedApplication(Application);
-                    }
-                });
-            }
-            else
-            {
+        pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
+        *ApplicationPID = PID;
+        AXLibConstructTimedEvent(NULL, 1.0, AXEvent_ApplicationInitialize, ApplicationPID, false);
+    }
+    else
+    {
 #ifdef DEBUG_BUILD
-                printf("AX: %s did not respond, remove application reference\n", Application->Name.c_str());
+        printf("AX: %s did not respond, remove application reference\n", Application->Name.c_str());
 #endif
-                pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
-                *ApplicationPID = Application->PID;
-                AXLibConstructEvent(AXEvent_ApplicationTerminated, ApplicationPID, false);
-            }
-        }
+        pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
+        *ApplicationPID = Application->PID;
+        AXLibConstructEvent(AXEvent_ApplicationTerminated, ApplicationPID, false);
+    }
+}
+
+/* NOTE(koekeishiya): The application is looked up again, as it may have terminated while this event was pending. */
+EVENT_CALLBACK(Callback_AXEvent_ApplicationInitialize)
+{
+    pid_t *ApplicationPID = (pid_t *) Event->Context;
+    pid_t PID = *ApplicationPID;
+    free(ApplicationPID);
+
+    ax_application *Application = AXLibGetApplicationByPID(PID);
+    if(Application && AXLibInitializeApplication(PID))
+        AXLibInitializedApplication(Application);
+}
+
+bool AXLibInitializeApplication(pid_t PID)
+{
+    ax_application *Application = AXLibGetApplicationByPID(PID);
+    if(Application)
+    {
+        bool Result = AXLibLoadApplication(Application);
+        if(!Result)
+            AXLibRetryApplication(Application);
 
         return Result;
     }
@@ -379,6 +422,34 @@ bool AXLibInitializeApplication(pid_t PID)
     return false;
 }
 
+/* NOTE(koekeishiya): Initialize a batch of applications concurrently. The time spent waiting on an application
+                      no longer adds up across all running applications. dispatch_apply bounds the number of
+                      workers to the number of active cores. Applications that did not respond are handled
+                      afterwards, in the order given, so any events are emitted in a deterministic order. */
+void AXLibInitializeApplications(std::vector<ax_application *> &Applications)
+{
+    std::size_t Count = Applications.size();
+    if(Count == 0)
+        return;
+
+    bool *Results = (bool *) malloc(sizeof(bool) * Count);
+    ax_application **List = Applications.data();
+
+    dispatch_apply(Count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0),
+    ^(size_t Index)
+    {
+        Results[Index] = AXLibLoadApplication(List[Index]);
+    });
+
+    for(std::size_t Index = 0; Index < Count; ++Index)
+    {
+        if(!Results[Index])
+            AXLibRetryApplication(Applications[Index]);
+    }
+
+    free(Results);
+}
+
 void AXLibInitializedApplication(ax_application *Application)
 {
     pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
@@ -433,6 +504,7 @@ void AXLibRemoveApplicationWindows(ax_application *Application)
     for(It = Windows.begin(); It != Windows.end(); ++It)
     {
         ax_window *Window = It->second;
+        AXLibUnindexWindow(Window);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXUIElementDestroyedNotification);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowMiniaturizedNotification);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowDeminiaturizedNotification);
@@ -457,10 +529,18 @@ void AXLibAddApplicationWindow(ax_application *Application, ax_window *Window)
         AXLibAddObserverNotification(&Application->Observer, Window->Ref, kAXWindowMiniaturizedNotification, Window);
         AXLibAddObserverNotification(&Application->Observer, Window->Ref, kAXWindowDeminiaturizedNotification, Window);
 
+        if(AXLibIsApplicationDegraded(Application))
+            AXUIElementSetMessagingTimeout(Window->Ref, AX_DEGRADED_MESSAGING_TIMEOUT);
+
         if(Window->ID == 0)
+        {
             Application->NullWindows.push_back(Window);
+        }
         else
+        {
             Application->Windows[Window->ID] = Window;
+            AXLibIndexWindow(Window);
+        }
     }
 }
 
@@ -473,9 +553,101 @@ void AXLibRemoveApplicationWindow(ax_application *Application, uint32_t WID)
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowMiniaturizedNotification);
         AXLibRemoveObserverNotification(&Window->Application->Observer, Window->Ref, kAXWindowDeminiaturizedNotification);
         Application->Windows.erase(WID);
+        AXLibUnindexWindow(Window);
     }
 }
 
+/* NOTE(koekeishiya): A timeout of 0 makes the element use the global timeout set in AXLibInit(..). */
+internal void
+AXLibSetApplicationMessagingTimeout(ax_application *Application, float Timeout)
+{
+    AXUIElementSetMessagingTimeout(Application->Ref, Timeout);
+
+    std::map<uint32_t, ax_window *>::iterator It;
+    for(It = Application->Windows.begin(); It != Application->Windows.end(); ++It)
+        AXUIElementSetMessagingTimeout(It->second->Ref, Timeout);
+}
+
+void AXLibRecordApplicationLatency(ax_application *Application, double Milliseconds, bool TimedOut)
+{
+    bool Changed = false;
+    pthread_mutex_lock(&LatencyLock);
+    Application->Latency = Application->Latency == 0
+                         ? Milliseconds
+                         : (AX_LATENCY_WEIGHT * Milliseconds) + ((1.0 - AX_LATENCY_WEIGHT) * Application->Latency);
+
+    if(TimedOut)
+    {
+        if(Application->Timeouts < AX_MAX_TIMEOUTS)
+            ++Application->Timeouts;
+    }
+    else if(Application->Timeouts > 0 && Milliseconds < AX_LATENCY_BUDGET)
+    {
+        --Application->Timeouts;
+    }
+
+    if((!Application->Degraded) &&
+       ((Application->Latency > AX_LATENCY_BUDGET) ||
+        (Application->Timeouts >= AX_DEGRADED_TIMEOUTS)))
+    {
+        Application->Degraded = true;
+        Changed = true;
+    }
+    else if((Application->Degraded) &&
+            (Application->Latency < AX_LATENCY_BUDGET / 2) &&
+            (Application->Timeouts == 0))
+    {
+        Application->Degraded = false;
+        Changed = true;
+    }
+
+    bool Degraded = Application->Degraded;
+    double Latency = Application->Latency;
+    pthread_mutex_unlock(&LatencyLock);
+
+    if(Changed)
+    {
+#ifdef DEBUG_BUILD
+        if(Degraded)
+            printf("AX: %s - Degraded, average latency %.1fms\n", Application->Name.c_str(), Latency);
+        else
+            printf("AX: %s - Responsive again\n", Application->Name.c_str());
+#endif
+        pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
+        *ApplicationPID = Application->PID;
+        AXLibConstructEvent(AXEvent_ApplicationLatencyChanged, ApplicationPID, false);
+    }
+}
+
+bool AXLibIsApplicationDegraded(ax_application *Application)
+{
+    pthread_mutex_lock(&LatencyLock);
+    bool Result = Application->Degraded;
+    pthread_mutex_unlock(&LatencyLock);
+    return Result;
+}
+
+double AXLibApplicationLatency(ax_application *Application)
+{
+    pthread_mutex_lock(&LatencyLock);
+    double Result = Application->Latency;
+    pthread_mutex_unlock(&LatencyLock);
+    return Result;
+}
+
+/* NOTE(koekeishiya): The state may have changed again since the event was posted, so the timeout
+                      follows the current state of the application. */
+EVENT_CALLBACK(Callback_AXEvent_ApplicationLatencyChanged)
+{
+    pid_t *ApplicationPID = (pid_t *) Event->Context;
+    pid_t PID = *ApplicationPID;
+    free(ApplicationPID);
+
+    ax_application *Application = AXLibGetApplicationByPID(PID);
+    if(Application)
+        AXLibSetApplicationMessagingTimeout(Application, AXLibIsApplicationDegraded(Application) ? AX_DEGRADED_MESSAGING_TIMEOUT : 0);
+}
+
 void AXLibActivateApplication(ax_application *Application)
 {
     SharedWorkspaceActivateApplication(Application->PID);
@@ -495,6 +667,12 @@ void AXLibDestroyApplication(ax_application *Application)
 {
     AXLibRemoveApplicationWindows(Application);
     AXLibRemoveApplicationObserver(Application);
+    if(Application->Queue)
+    {
+        AXLibDestroyQueue(Application->Queue);
+        Application->Queue = NULL;
+    }
+
     CFRelease(Application->Ref);
     Application->Ref = NULL;
 }
@@ -4,12 +4,15 @@
 #include <Carbon/Carbon.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <dispatch/dispatch.h>
 #include <string>
 #include <map>
 #include <vector>
 
 #include "window.h"
 #include "observer.h"
+#include "queue.h"
+#include "event.h"
 
 enum ax_application_flags
 {
@@ -27,10 +30,18 @@ struct ax_application
 
     ProcessSerialNumber PSN;
     ax_observer Observer;
+    ax_queue *Queue;
     uint32_t Flags;
     uint32_t Notifications;
     unsigned int Retries;
 
+    /* NOTE(koekeishiya): Exponentially weighted average of AX call latency in milliseconds,
+                          and the number of recent calls that timed out. Latency is recorded from
+                          several threads, so these are only accessed through the functions below. */
+    double Latency;
+    unsigned int Timeouts;
+    bool Degraded;
+
     ax_window *Focus;
     std::map<uint32_t, ax_window *> Windows;
     std::vector<ax_window *> NullWindows;
@@ -58,7 +69,15 @@ AXLibClearFlags(ax_application *Application, uint32_t Flag)
 ax_application AXLibConstructApplication(pid_t PID, std::string Name);
 void AXLibDestroyApplication(ax_application *Application);
 
+/* NOTE(koekeishiya): Event context is a pointer to the process id of the application to initialize. */
+EVENT_CALLBACK(Callback_AXEvent_ApplicationInitialize);
+
+/* NOTE(koekeishiya): Event context is a pointer to the process id of an application that became
+                      degraded or responsive again. */
+EVENT_CALLBACK(Callback_AXEvent_ApplicationLatencyChanged);
+
 bool AXLibInitializeApplication(pid_t PID);
+void AXLibInitializeApplications(std::vector<ax_application *> &Applications);
 void AXLibInitializedApplication(ax_application *Application);
 
 void AXLibAddApplicationWindows(ax_application *Application);
@@ -68,6 +87,10 @@ ax_window *AXLibFindApplicationWindow(ax_application *Application, uint32_t WID)
 void AXLibAddApplicationWindow(ax_application *Application, ax_window *Window);
 void AXLibRemoveApplicationWindow(ax_application *Application, uint32_t WID);
 
+void AXLibRecordApplicationLatency(ax_application *Application, double Milliseconds, bool TimedOut);
+bool AXLibIsApplicationDegraded(ax_application *Application);
+double AXLibApplicationLatency(ax_application *Application);
+
 void AXLibActivateApplication(ax_application *Application);
 bool AXLibIsApplicationActive(ax_application *Application);
 bool AXLibIsApplicationHidden(ax_application *Application);
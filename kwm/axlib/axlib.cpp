@@ -1,5 +1,8 @@
 #include "axlib.h"
 #include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <pthread.h>
 
 #define internal static
 #define local_persist static
@@ -16,6 +19,17 @@ internal std::map<pid_t, ax_application> *AXApplications;
 internal std::map<CGDirectDisplayID, ax_display> *AXDisplays;
 internal CGPoint Cursor;
 
+/* NOTE(koekeishiya): The set of on-screen window ids is kept up to date from the notifications we receive.
+                      Events we cannot track per window (space and display changes) invalidate the set, and it
+                      is rebuilt from the window server at most every AX_VISIBLE_WINDOWS_RESCAN seconds otherwise. */
+#define AX_VISIBLE_WINDOWS_RESCAN 2.0
+internal pthread_mutex_t VisibleWindowsLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::unordered_set<uint32_t> VisibleWindows;
+internal bool VisibleWindowsValid;
+internal CFAbsoluteTime VisibleWindowsScanTime;
+internal uint64_t VisibleWindowsFullScans;
+internal uint64_t VisibleWindowsCachedScans;
+
 internal inline AXUIElementRef
 AXLibSystemWideElement()
 {
@@ -124,6 +138,75 @@ void AXLibSetFocusedWindow(ax_window *Window)
     }
 }
 
+/* NOTE(koekeishiya): AXState->Windows indexes every window with a valid id across all applications, so that
+                      a window can be found without searching each application. It is kept in sync by
+                      AXLibAddApplicationWindow(..) and AXLibRemoveApplicationWindow(s)(..). */
+ax_window *AXLibFindWindow(uint32_t WID)
+{
+    return AXLibLookupWindow(&AXState->Windows, WID);
+}
+
+/* NOTE(koekeishiya): Applications are initialized concurrently and other threads look windows up
+                      meanwhile, so the index does its own locking, see windowindex.h. */
+void AXLibIndexWindow(ax_window *Window)
+{
+    if(Window->ID != 0)
+        AXLibInsertWindow(&AXState->Windows, Window->ID, Window);
+}
+
+void AXLibUnindexWindow(ax_window *Window)
+{
+    if(AXLibEraseWindow(&AXState->Windows, Window->ID, Window))
+        AXLibSetWindowVisible(Window->ID, false);
+}
+
+void AXLibSetWindowVisible(uint32_t WID, bool Visible)
+{
+    if(WID == 0)
+        return;
+
+    pthread_mutex_lock(&VisibleWindowsLock);
+    if(Visible)
+        VisibleWindows.insert(WID);
+    else
+        VisibleWindows.erase(WID);
+    pthread_mutex_unlock(&VisibleWindowsLock);
+}
+
+void AXLibSetApplicationVisible(ax_application *Application, bool Visible)
+{
+    if(!Visible)
+    {
+        pthread_mutex_lock(&VisibleWindowsLock);
+        std::map<uint32_t, ax_window *>::iterator It;
+        for(It = Application->Windows.begin(); It != Application->Windows.end(); ++It)
+            VisibleWindows.erase(It->first);
+        pthread_mutex_unlock(&VisibleWindowsLock);
+    }
+    else
+    {
+        /* NOTE(koekeishiya): We do not know which of the windows are on the active space. */
+        AXLibInvalidateVisibleWindows();
+    }
+}
+
+void AXLibInvalidateVisibleWindows()
+{
+    pthread_mutex_lock(&VisibleWindowsLock);
+    VisibleWindowsValid = false;
+    pthread_mutex_unlock(&VisibleWindowsLock);
+}
+
+uint64_t AXLibVisibleWindowsFullScans()
+{
+    return VisibleWindowsFullScans;
+}
+
+uint64_t AXLibVisibleWindowsCachedScans()
+{
+    return VisibleWindowsCachedScans;
+}
+
 /* NOTE(koekeishiya): Returns a vector of all windows that we currently know about. This fuction is probably not necessary. */
 std::vector<ax_window *> AXLibGetAllKnownWindows()
 {
@@ -140,16 +223,54 @@ std::vector<ax_window *> AXLibGetAllKnownWindows()
     return Windows;
 }
 
-internal inline bool
-AXLibArrayContains(int *WindowList, int WindowCount, uint32_t WindowID)
+/* NOTE(koekeishiya): Rebuild the visible set from the window server. The on-screen list also contains
+                      windows we do not manage, so we look each id up in the window index instead of
+                      searching the list once for every window we know about. Caller holds VisibleWindowsLock. */
+internal void
+AXLibRescanVisibleWindows()
 {
-    while(WindowCount > 0)
+    /* NOTE(koekeishiya): Is it necessary to actually decide how many windows are on the screen.
+                          Can we just pass an estimated high enough number such as 200 (?) */
+    int WindowCount = 0;
+    CGError Error = CGSGetOnScreenWindowCount(CGSDefaultConnection, 0, &WindowCount);
+    if(Error != kCGErrorSuccess)
+        return;
+
+    /* NOTE(koekeishiya): This function seems to be pretty expensive.. Is CGWindowListCopyWindowInfo faster (?) */
+    std::vector<int> WindowList(WindowCount);
+    Error = CGSGetOnScreenWindowList(CGSDefaultConnection, 0, WindowCount, WindowList.data(), &WindowCount);
+    if(Error != kCGErrorSuccess)
+        return;
+
+    VisibleWindows.clear();
+    std::map<pid_t, bool> HiddenApplications;
+    for(int Index = 0; Index < WindowCount; ++Index)
     {
-        if(WindowList[--WindowCount] == WindowID)
-            return true;
+        ax_window *Window = AXLibFindWindow(WindowList[Index]);
+        if(!Window)
+            continue;
+
+        pid_t PID = Window->Application->PID;
+        std::map<pid_t, bool>::iterator It = HiddenApplications.find(PID);
+        if(It == HiddenApplications.end())
+            It = HiddenApplications.insert(std::make_pair(PID, AXLibIsApplicationHidden(Window->Application))).first;
+
+        if(!It->second)
+            VisibleWindows.insert(Window->ID);
     }
 
-    return false;
+    VisibleWindowsValid = true;
+    VisibleWindowsScanTime = CFAbsoluteTimeGetCurrent();
+    ++VisibleWindowsFullScans;
+}
+
+internal bool
+AXLibCompareVisibleWindows(ax_window *A, ax_window *B)
+{
+    if(A->Application->PID != B->Application->PID)
+        return A->Application->PID < B->Application->PID;
+
+    return A->ID < B->ID;
 }
 
 /* NOTE(koekeishiya): Returns a list of pointer to ax_window structs containing all windows currently visible,
@@ -158,111 +279,207 @@ std::vector<ax_window *> AXLibGetAllVisibleWindows()
 {
     std::vector<ax_window *> Windows;
 
-    /* NOTE(koekeishiya): Is it necessary to actually decide how many windows are on the screen.
-                          Can we just pass an estimated high enough number such as 200 (?) */
-    int WindowCount = 0;
-    CGError Error = CGSGetOnScreenWindowCount(CGSDefaultConnection, 0, &WindowCount);
-    if(Error == kCGErrorSuccess)
+    pthread_mutex_lock(&VisibleWindowsLock);
+    if((!VisibleWindowsValid) ||
+       (CFAbsoluteTimeGetCurrent() - VisibleWindowsScanTime > AX_VISIBLE_WINDOWS_RESCAN))
+        AXLibRescanVisibleWindows();
+    else
+        ++VisibleWindowsCachedScans;
+
+    std::unordered_set<uint32_t>::iterator It;
+    for(It = VisibleWindows.begin(); It != VisibleWindows.end(); ++It)
     {
-        /* NOTE(koekeishiya): This function seems to be pretty expensive.. Is CGWindowListCopyWindowInfo faster (?) */
-        int WindowList[WindowCount];
-        Error = CGSGetOnScreenWindowList(CGSDefaultConnection, 0, WindowCount, WindowList, &WindowCount);
-        if(Error == kCGErrorSuccess)
+        ax_window *Window = AXLibFindWindow(*It);
+        if((Window) &&
+           (!AXLibHasFlags(Window, AXWindow_Minimized)) &&
+           (AXLibIsWindowStandard(Window) || AXLibIsWindowCustom(Window)) &&
+           (!AXLibHasFlags(Window, AXWindow_Floating)))
         {
-            std::map<pid_t, ax_application>::iterator It;
-            for(It = AXApplications->begin(); It != AXApplications->end(); ++It)
-            {
-                ax_application *Application = &It->second;
-                if(!AXLibIsApplicationHidden(Application))
-                {
-                    std::map<uint32_t, ax_window *>::iterator WIt;
-                    for(WIt = Application->Windows.begin(); WIt != Application->Windows.end(); ++WIt)
-                    {
-                        ax_window *Window = WIt->second;
-                        /* NOTE(koekeishiya): If a window is minimized, the ArrayContains check should fail
-                                              if(!AXLibIsWindowMinimized(Window->Ref)) */
-
-                        if((AXLibArrayContains(WindowList, WindowCount, Window->ID)) &&
-                           (AXLibIsWindowStandard(Window) || AXLibIsWindowCustom(Window)) &&
-                           (!AXLibHasFlags(Window, AXWindow_Floating)))
-                        {
-                            Windows.push_back(Window);
-                        }
-                    }
-                }
-            }
+            Windows.push_back(Window);
         }
     }
+    pthread_mutex_unlock(&VisibleWindowsLock);
 
+    /* NOTE(koekeishiya): Keep the order the per-application scan used to produce. */
+    std::sort(Windows.begin(), Windows.end(), AXLibCompareVisibleWindows);
     return Windows;
 }
 
-/* NOTE(koekeishiya): Returns the window id of the window below the cursor. */
+/* NOTE(koekeishiya): Snapshot of the on-screen windows in z-order (front to back), used for hit-testing
+                      the cursor. It is only rebuilt when an event that can change the window layout has been
+                      posted, after a mouse click, or when it is older than AX_WINDOW_RECTS_REFRESH seconds,
+                      since context menus and Launchpad do not notify us. */
 #define CONTEXT_MENU_LAYER 101
-uint32_t AXLibGetWindowBelowCursor()
+#define AX_WINDOW_RECTS_REFRESH 1.0
+#define AX_MOUSE_MOVE_IDLE 0.25
+
+enum ax_window_rect_kind
 {
-    uint32_t Result = 0;
+    AXWindowRect_Window,
+    AXWindowRect_Blocking,
+};
+
+struct ax_window_rect
+{
+    uint32_t ID;
+    CGRect Frame;
+    ax_window_rect_kind Kind;
+};
+
+internal pthread_mutex_t WindowRectsLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::vector<ax_window_rect> WindowRects;
+internal bool WindowRectsValid;
+internal CFAbsoluteTime WindowRectsTime;
+internal int LastHitIndex = -1;
+internal bool LastHitUnobscured;
+internal uint64_t WindowListCopies;
+internal uint64_t HitTestSamples;
+internal CFAbsoluteTime LastSampleTime;
+internal double MouseMoveSeconds;
+
+internal void
+AXLibRefreshWindowRects()
+{
+    WindowRects.clear();
+    LastHitIndex = -1;
+    ++WindowListCopies;
+
     CGWindowListOption WindowListOption = kCGWindowListOptionOnScreenOnly |
                                           kCGWindowListExcludeDesktopElements;
-    Cursor = GetCursorPos();
-
     CFArrayRef WindowList = CGWindowListCopyWindowInfo(WindowListOption, kCGNullWindowID);
     if(WindowList)
     {
         CFIndex WindowCount = CFArrayGetCount(WindowList);
-        for(std::size_t Index = 0; Index < WindowCount; ++Index)
+        for(CFIndex Index = 0; Index < WindowCount; ++Index)
         {
-            uint32_t WindowID;
-            uint32_t WindowLayer;
-            CGRect WindowRect = {};
-            CFNumberRef CFWindowNumber;
-            CFNumberRef CFWindowLayer;
-            CFDictionaryRef CFWindowBounds;
+            ax_window_rect Rect = {};
+            uint32_t WindowLayer = 0;
             CFDictionaryRef Elem = (CFDictionaryRef)CFArrayGetValueAtIndex(WindowList, Index);
-            CFWindowNumber = (CFNumberRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowNumber"));
-            CFWindowLayer = (CFNumberRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowLayer"));
-            CFWindowBounds = (CFDictionaryRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowBounds"));
-            CFNumberGetValue(CFWindowNumber, kCFNumberSInt32Type, &WindowID);
-            CFNumberGetValue(CFWindowLayer, kCFNumberSInt32Type, &WindowLayer);
-            CFRelease(CFWindowNumber);
-            CFRelease(CFWindowLayer);
+            CFNumberRef CFWindowNumber = (CFNumberRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowNumber"));
+            CFNumberRef CFWindowLayer = (CFNumberRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowLayer"));
+            CFDictionaryRef CFWindowBounds = (CFDictionaryRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowBounds"));
+            if(CFWindowNumber)
+                CFNumberGetValue(CFWindowNumber, kCFNumberSInt32Type, &Rect.ID);
+
+            if(CFWindowLayer)
+                CFNumberGetValue(CFWindowLayer, kCFNumberSInt32Type, &WindowLayer);
+
             if(CFWindowBounds)
-            {
-                CGRectMakeWithDictionaryRepresentation(CFWindowBounds, &WindowRect);
-            }
+                CGRectMakeWithDictionaryRepresentation(CFWindowBounds, &Rect.Frame);
 
             CFStringRef CFOwner = (CFStringRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowOwnerName"));
             CFStringRef CFName = (CFStringRef) CFDictionaryGetValue(Elem, CFSTR("kCGWindowName"));
 
+            if(CFOwner && CFStringCompare(CFOwner, CFSTR("kwm-overlay"), 0) == kCFCompareEqualTo)
+                continue;
+
+            /* NOTE(koekeishiya): While Launchpad or a context menu is open, no window is below the cursor. */
             if(((CFOwner && (CFStringCompare(CFOwner, CFSTR("Dock"), 0) == kCFCompareEqualTo)) &&
                 (CFName && (CFStringCompare(CFName, CFSTR("LPSpringboard"), 0) == kCFCompareEqualTo))) ||
                 (WindowLayer == CONTEXT_MENU_LAYER))
             {
-                CFRelease(WindowList);
-                return 0;
+                Rect.Kind = AXWindowRect_Blocking;
+                Rect.Frame = CGRectInfinite;
             }
 
-            if(CFOwner && CFStringCompare(CFOwner, CFSTR("kwm-overlay"), 0) == kCFCompareEqualTo)
-                continue;
+            WindowRects.push_back(Rect);
+        }
+
+        CFRelease(WindowList);
+    }
+
+    WindowRectsValid = true;
+    WindowRectsTime = CFAbsoluteTimeGetCurrent();
+}
+
+void AXLibInvalidateWindowBelowCursor()
+{
+    pthread_mutex_lock(&WindowRectsLock);
+    WindowRectsValid = false;
+    pthread_mutex_unlock(&WindowRectsLock);
+}
+
+/* NOTE(koekeishiya): Returns the window id of the window below the cursor. */
+uint32_t AXLibGetWindowBelowCursor()
+{
+    uint32_t Result = 0;
+    Cursor = GetCursorPos();
+
+    pthread_mutex_lock(&WindowRectsLock);
+    CFAbsoluteTime Now = CFAbsoluteTimeGetCurrent();
+    if(Now - LastSampleTime < AX_MOUSE_MOVE_IDLE)
+        MouseMoveSeconds += Now - LastSampleTime;
 
-            if(IsElementBelowCursor(&WindowRect))
+    LastSampleTime = Now;
+    ++HitTestSamples;
+
+    if((!WindowRectsValid) ||
+       (Now - WindowRectsTime > AX_WINDOW_RECTS_REFRESH))
+        AXLibRefreshWindowRects();
+
+    /* NOTE(koekeishiya): Consecutive samples inside the window that was hit last time, with nothing
+                          stacked on top of it, resolve to the same window. */
+    if((LastHitIndex != -1) &&
+       (LastHitUnobscured) &&
+       (IsElementBelowCursor(&WindowRects[LastHitIndex].Frame)))
+    {
+        Result = WindowRects[LastHitIndex].ID;
+    }
+    else
+    {
+        LastHitIndex = -1;
+        for(std::size_t Index = 0; Index < WindowRects.size(); ++Index)
+        {
+            ax_window_rect *Rect = &WindowRects[Index];
+            if(IsElementBelowCursor(&Rect->Frame))
             {
-                Result = WindowID;
+                if(Rect->Kind == AXWindowRect_Window)
+                {
+                    Result = Rect->ID;
+                    LastHitIndex = Index;
+                    LastHitUnobscured = true;
+                    for(std::size_t Above = 0; Above < Index; ++Above)
+                    {
+                        if(CGRectIntersectsRect(WindowRects[Above].Frame, Rect->Frame))
+                        {
+                            LastHitUnobscured = false;
+                            break;
+                        }
+                    }
+                }
+
                 break;
             }
         }
-
-        CFRelease(WindowList);
     }
+    pthread_mutex_unlock(&WindowRectsLock);
 
     return Result;
 }
 
+uint64_t AXLibWindowListCopies()
+{
+    return WindowListCopies;
+}
+
+uint64_t AXLibHitTestSamples()
+{
+    return HitTestSamples;
+}
+
+double AXLibMouseMoveSeconds()
+{
+    return MouseMoveSeconds;
+}
+
 /* NOTE(koekeishiya): Update state of known applications and their windows, stored inside the ax_state passed to AXLibInit(..). */
 void AXLibRunningApplications()
 {
     std::map<pid_t, std::string> List = SharedWorkspaceRunningApplications();
+    std::vector<ax_application *> Applications;
 
+    /* NOTE(koekeishiya): New applications are inserted before any of them are initialized, so
+                          that the map is not modified while the workers hold pointers into it. */
     std::map<pid_t, std::string>::iterator It;
     for(It = List.begin(); It != List.end(); ++It)
     {
@@ -271,13 +488,15 @@ void AXLibRunningApplications()
         {
             std::string Name = It->second;
             (*AXApplications)[PID] = AXLibConstructApplication(PID, Name);
-            AXLibInitializeApplication(PID);
+            Applications.push_back(&(*AXApplications)[PID]);
         }
         else
         {
             AXLibAddApplicationWindows(&(*AXApplications)[PID]);
         }
     }
+
+    AXLibInitializeApplications(Applications);
 }
 
 /* NOTE(koekeishiya): This function is responsible for initializing internal variables used by AXLib, and must be
@@ -289,7 +508,9 @@ void AXLibInit(ax_state *State)
     AXApplications = &AXState->Applications;
     AXDisplays = &AXState->Displays;
     Carbon = &AXState->Carbon;
+    AXLibInitWindowIndex(&AXState->Windows);
     AXUIElementSetMessagingTimeout(AXLibSystemWideElement(), 1.0);
+    AXLibInitializeFrameBackend();
     AXLibInitializeCarbonEventHandler(Carbon, AXApplications);
     SharedWorkspaceInitialize(AXApplications);
     AXLibInitializeDisplays(AXDisplays);
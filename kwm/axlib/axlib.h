@@ -8,7 +8,9 @@
 #include "display.h"
 #include "sharedworkspace.h"
 #include "event.h"
+#include "trace.h"
 #include "carbon.h"
+#include "windowindex.h"
 
 /*
  * NOTE(koekeishiya):
@@ -39,6 +41,7 @@ struct ax_state
     carbon_event_handler Carbon;
     std::map<pid_t, ax_application> Applications;
     std::map<CGDirectDisplayID, ax_display> Displays;
+    ax_window_index Windows;
 };
 
 ax_application *AXLibGetApplicationByPID(pid_t PID);
@@ -46,9 +49,23 @@ ax_application *AXLibGetFocusedApplication();
 ax_window *AXLibGetFocusedWindow(ax_application *Application);
 void AXLibSetFocusedWindow(ax_window *Window);
 
+ax_window *AXLibFindWindow(uint32_t WID);
+void AXLibIndexWindow(ax_window *Window);
+void AXLibUnindexWindow(ax_window *Window);
+
+void AXLibSetWindowVisible(uint32_t WID, bool Visible);
+void AXLibSetApplicationVisible(ax_application *Application, bool Visible);
+void AXLibInvalidateVisibleWindows();
+uint64_t AXLibVisibleWindowsFullScans();
+uint64_t AXLibVisibleWindowsCachedScans();
+
 std::vector<ax_window *> AXLibGetAllKnownWindows();
 std::vector<ax_window *> AXLibGetAllVisibleWindows();
 uint32_t AXLibGetWindowBelowCursor();
+void AXLibInvalidateWindowBelowCursor();
+uint64_t AXLibWindowListCopies();
+uint64_t AXLibHitTestSamples();
+double AXLibMouseMoveSeconds();
 void AXLibRunningApplications();
 void AXLibInit(ax_state *State);
 
@@ -75,13 +75,10 @@ CarbonApplicationLaunched(ProcessSerialNumber PSN)
     */
 
     (*Applications)[PID] = AXLibConstructApplication(PID, Name);
-    ax_application *Application = &(*Applications)[PID];
 
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, 0.5 * NSEC_PER_SEC), dispatch_get_main_queue(),
-    ^{
-        if(AXLibInitializeApplication(Application->PID))
-            AXLibInitializedApplication(Application);
-    });
+    pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
+    *ApplicationPID = PID;
+    AXLibConstructTimedEvent(NULL, 0.5, AXEvent_ApplicationInitialize, ApplicationPID, false);
 }
 
 internal void
@@ -4,6 +4,10 @@
 #include <Carbon/Carbon.h>
 #include <string>
 #include <map>
+#include <vector>
+
+#include "topology.h"
+#include "membership.h"
 
 /* NOTE(koekeishiya): User controlled spaces */
 #define kCGSSpaceUser 0
@@ -21,7 +25,6 @@ enum CGSSpaceSelector
     kCGSSpaceAll = 7
 };
 
-typedef int CGSSpaceID;
 typedef int CGSSpaceType;
 
 struct ax_window;
@@ -49,6 +52,9 @@ struct ax_display
     ax_space *Space;
     ax_space *PrevSpace;
     std::map<CGSSpaceID, ax_space> Spaces;
+
+    /* NOTE(koekeishiya): Read from the window server, and marked stale by AXLibInvalidateSpaceTopology(). */
+    ax_space_topology Topology;
 };
 
 inline bool
@@ -88,6 +94,7 @@ void AXLibSpaceTransition(ax_display *Display, CGSSpaceID SpaceID);
 bool AXLibIsSpaceTransitionInProgress();
 bool AXLibDisplayHasSeparateSpaces();
 
+void AXLibInvalidateSpaceTopology();
 unsigned int AXLibDisplaySpacesCount(ax_display *Display);
 unsigned int AXLibDesktopIDFromCGSSpaceID(ax_display *Display, CGSSpaceID SpaceID);
 CGSSpaceID AXLibCGSSpaceIDFromDesktopID(ax_display *Display, unsigned int DesktopID);
@@ -96,5 +103,6 @@ bool AXLibStickyWindow(ax_window *Window);
 bool AXLibSpaceHasWindow(ax_window *Window, CGSSpaceID SpaceID);
 void AXLibSpaceAddWindow(CGSSpaceID SpaceID, uint32_t WindowID);
 void AXLibSpaceRemoveWindow(CGSSpaceID SpaceID, uint32_t WindowID);
+ax_window_spaces AXLibSpacesForWindows(const std::vector<uint32_t> &WindowIDs);
 
 #endif
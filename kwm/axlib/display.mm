@@ -2,6 +2,8 @@
 #include "event.h"
 #include "window.h"
 #include "element.h"
+#include "axlib.h"
+#include "placement.h"
 #include <Cocoa/Cocoa.h>
 #include <stdio.h>
 
@@ -13,6 +15,7 @@ extern "C" CGSConnectionID _CGSDefaultConnection(void);
 extern "C" CGSSpaceType CGSSpaceGetType(CGSConnectionID CID, CGSSpaceID SID);
 extern "C" CFArrayRef CGSCopyManagedDisplaySpaces(const CGSConnectionID CID);
 extern "C" CFArrayRef CGSCopySpacesForWindows(CGSConnectionID CID, CGSSpaceSelector Type, CFArrayRef Windows);
+extern "C" CFArrayRef CGSCopyWindowsWithOptionsAndTags(CGSConnectionID CID, uint32_t Owner, CFArrayRef Spaces, uint32_t Options, uint64_t *SetTags, uint64_t *ClearTags);
 extern "C" bool CGSManagedDisplayIsAnimating(CGSConnectionID CID, CFStringRef DisplayIdentifier);
 
 extern "C" void CGSHideSpaces(CGSConnectionID CID, CFArrayRef Spaces);
@@ -27,6 +30,10 @@ internal std::map<CGDirectDisplayID, ax_display> *Displays;
 internal unsigned int MaxDisplayCount = 5;
 internal unsigned int ActiveDisplayCount = 0;
 
+/* NOTE(koekeishiya): Changed whenever a display is added, removed or moved. An ax_window caches the display
+                      it belongs to together with the generation of the arrangement it was computed for. */
+internal ax_display_arrangement DisplayArrangement;
+
 /* NOTE(koekeishiya): If the display UUID is stored, return the corresponding
                       CGDirectDisplayID. Otherwise we return 0 */
 internal CGDirectDisplayID
@@ -197,6 +204,28 @@ AXLibConstructSpacesForDisplay(ax_display *Display)
     CFRelease(DisplayDictionaries);
 }
 
+/* NOTE(koekeishiya): The SpaceTopologySource of an ax_display. Context is the display identifier. */
+internal SPACE_TOPOLOGY_SOURCE(AXLibReadSpaceTopology)
+{
+    NSString *CurrentIdentifier = (__bridge NSString *)(CFStringRef)Context;
+
+    CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
+    for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
+    {
+        NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
+        if([ScreenIdentifier isEqualToString:CurrentIdentifier])
+        {
+            NSArray *SpaceDictionaries = ScreenDictionary[@"Spaces"];
+            for(NSDictionary *SpaceDictionary in (__bridge NSArray *)SpaceDictionaries)
+                SpaceOrder->push_back([SpaceDictionary[@"id64"] intValue]);
+
+            break;
+        }
+    }
+
+    CFRelease(ScreenDictionaries);
+}
+
 /* NOTE(koekeishiya): CGDirectDisplayID of a display can change when swapping GPUs, but the
                       UUID remain the same. This function performs the CGDirectDisplayID update
                       and repopulates the list of spaces. */
@@ -209,10 +238,12 @@ AXLibChangeDisplayID(CGDirectDisplayID OldDisplayID, CGDirectDisplayID NewDispla
     ax_display OldDisplay = (*Displays)[OldDisplayID];
     (*Displays)[NewDisplayID] = OldDisplay;
     Displays->erase(OldDisplayID);
+    AXLibChangeDisplayArrangement(&DisplayArrangement);
 
     ax_display *Display = &(*Displays)[NewDisplayID];
     Display->ID = NewDisplayID;
     Display->Spaces.clear();
+    AXLibMarkSpaceTopologyStale(&Display->Topology);
     AXLibConstructSpacesForDisplay(Display);
     Display->Space = AXLibGetActiveSpace(Display);
     Display->PrevSpace = Display->Space;
@@ -227,6 +258,7 @@ AXLibConstructDisplay(CGDirectDisplayID DisplayID, unsigned int ArrangementID)
     Display.ID = DisplayID;
     Display.ArrangementID = ArrangementID;
     Display.Identifier = AXLibGetDisplayIdentifier(DisplayID);
+    AXLibInitSpaceTopology(&Display.Topology, &AXLibReadSpaceTopology, Display.Identifier);
     Display.Frame = CGDisplayBounds(DisplayID);
     AXLibConstructSpacesForDisplay(&Display);
     Display.Space = AXLibGetActiveSpace(&Display);
@@ -264,6 +296,8 @@ AXLibRefreshDisplays()
     }
 
     free(CGDirectDisplayList);
+    AXLibChangeDisplayArrangement(&DisplayArrangement);
+    AXLibInvalidateSpaceTopology();
 }
 
 internal inline void
@@ -291,6 +325,8 @@ AXLibAddDisplay(CGDirectDisplayID DisplayID)
     /* NOTE(koekeishiya): Refresh map of connected displays and update exisitng frame bounds. */
     AXLibRefreshDisplays();
 
+    AXLibInvalidateVisibleWindows();
+
     /* TODO(koekeishiya): Should probably pass an identifier for the added display. */
     AXLibConstructEvent(AXEvent_DisplayAdded, NULL, false);
 }
@@ -311,12 +347,15 @@ AXLibRemoveDisplay(CGDirectDisplayID DisplayID)
                 CFRelease((*Displays)[StoredDisplayID].Identifier);
 
             Displays->erase(StoredDisplayID);
+            AXLibChangeDisplayArrangement(&DisplayArrangement);
         }
     }
 
     /* NOTE(koekeishiya): Refresh all displays for now. */
     AXLibRefreshDisplays();
 
+    AXLibInvalidateVisibleWindows();
+
     /* TODO(koekeishiya): Should probably pass an identifier for the removed display. */
     AXLibConstructEvent(AXEvent_DisplayRemoved, NULL, false);
 }
@@ -330,6 +369,7 @@ AXLibResizeDisplay(CGDirectDisplayID DisplayID)
     {
         CFStringRef DisplayIdentifier = AXLibGetDisplayIdentifier(DisplayID);
         AXLibRefreshDisplays();
+        AXLibInvalidateVisibleWindows();
 
         ax_display *Display = AXLibDisplay(DisplayIdentifier);
         if(Display)
@@ -350,6 +390,7 @@ AXLibMoveDisplay(CGDirectDisplayID DisplayID)
     {
         CFStringRef DisplayIdentifier = AXLibGetDisplayIdentifier(DisplayID);
         AXLibRefreshDisplays();
+        AXLibInvalidateVisibleWindows();
 
         ax_display *Display = AXLibDisplay(DisplayIdentifier);
         if(Display)
@@ -479,30 +520,27 @@ ax_display *AXLibCursorDisplay()
     return Result;
 }
 
-/* NOTE(koekeishiya): The display that holds the largest portion of the given window. */
-ax_display *AXLibWindowDisplay(ax_window *Window)
+internal DISPLAY_ARRANGEMENT_SOURCE(AXLibReadDisplayArrangement)
 {
-    CGRect Frame = { Window->Position, Window->Size };
-    CGFloat HighestVolume = 0;
-    ax_display *BestDisplay = NULL;
-
     std::map<CGDirectDisplayID, ax_display>::iterator It;
     for(It = Displays->begin(); It != Displays->end(); ++It)
     {
         ax_display *Display = &It->second;
-        CGRect Intersection = CGRectIntersection(Frame, Display->Frame);
-        CGFloat Volume = Intersection.size.width * Intersection.size.height;
-
-        if(Volume > HighestVolume)
-        {
-            HighestVolume = Volume;
-            BestDisplay = Display;
-        }
+        ax_display_area Area = { Display,
+                                 Display->Frame.origin.x, Display->Frame.origin.y,
+                                 Display->Frame.size.width, Display->Frame.size.height };
+        Areas->push_back(Area);
     }
-
-    return BestDisplay;
 }
 
+/* NOTE(koekeishiya): The display is only recomputed after the window has been moved or resized,
+                      or the display arrangement has changed since it was last computed. */
+ax_display *AXLibWindowDisplay(ax_window *Window)
+{
+    return (ax_display *) AXLibPlaceWindow(&DisplayArrangement, &Window->Placement,
+                                           Window->Position.x, Window->Position.y,
+                                           Window->Size.width, Window->Size.height);
+}
 
 ax_display *AXLibNextDisplay(ax_display *Display)
 {
@@ -545,85 +583,29 @@ ax_display *AXLibArrangementDisplay(unsigned int ArrangementID)
     return NULL;
 }
 
-unsigned int AXLibDesktopIDFromCGSSpaceID(ax_display *Display, CGSSpaceID SpaceID)
+/* NOTE(koekeishiya): Spaces can be added or rearranged in Mission Control without an active space
+                      change, so every topology is marked stale when the active space or the display
+                      arrangement changes. A failed lookup also forces a single refresh. */
+void AXLibInvalidateSpaceTopology()
 {
-    unsigned int Result = 0;
-    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
-
-    CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
-    for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
-    {
-        int SpaceIndex = 1;
-        NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
-        if([ScreenIdentifier isEqualToString:CurrentIdentifier])
-        {
-            NSArray *SpaceDictionaries = ScreenDictionary[@"Spaces"];
-            for(NSDictionary *SpaceDictionary in (__bridge NSArray *)SpaceDictionaries)
-            {
-                if(SpaceID == [SpaceDictionary[@"id64"] intValue])
-                {
-                    Result = SpaceIndex;
-                    break;
-                }
-
-                ++SpaceIndex;
-            }
-            break;
-        }
-    }
+    std::map<CGDirectDisplayID, ax_display>::iterator It;
+    for(It = Displays->begin(); It != Displays->end(); ++It)
+        AXLibMarkSpaceTopologyStale(&It->second.Topology);
+}
 
-    CFRelease(ScreenDictionaries);
-    return Result;
+unsigned int AXLibDesktopIDFromCGSSpaceID(ax_display *Display, CGSSpaceID SpaceID)
+{
+    return AXLibTopologyDesktopID(&Display->Topology, SpaceID);
 }
 
 CGSSpaceID AXLibCGSSpaceIDFromDesktopID(ax_display *Display, unsigned int DesktopID)
 {
-    CGSSpaceID Result = 0;
-    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
-
-    CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
-    for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
-    {
-        int SpaceIndex = 1;
-        NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
-        if([ScreenIdentifier isEqualToString:CurrentIdentifier])
-        {
-            NSArray *SpaceDictionaries = ScreenDictionary[@"Spaces"];
-            for(NSDictionary *SpaceDictionary in (__bridge NSArray *)SpaceDictionaries)
-            {
-                if(SpaceIndex == DesktopID)
-                {
-                    Result = [SpaceDictionary[@"id64"] intValue];
-                    break;
-                }
-                ++SpaceIndex;
-            }
-            break;
-        }
-    }
-
-    CFRelease(ScreenDictionaries);
-    return Result;
+    return AXLibTopologySpaceID(&Display->Topology, DesktopID);
 }
 
 unsigned int AXLibDisplaySpacesCount(ax_display *Display)
 {
-    unsigned int Result = 0;
-    NSString *CurrentIdentifier = (__bridge NSString *)Display->Identifier;
-
-    CFArrayRef ScreenDictionaries = CGSCopyManagedDisplaySpaces(CGSDefaultConnection);
-    for(NSDictionary *ScreenDictionary in (__bridge NSArray *)ScreenDictionaries)
-    {
-        NSString *ScreenIdentifier = ScreenDictionary[@"Display Identifier"];
-        if ([ScreenIdentifier isEqualToString:CurrentIdentifier])
-        {
-            NSArray *Spaces = ScreenDictionary[@"Spaces"];
-            Result = CFArrayGetCount((__bridge CFArrayRef)Spaces);
-        }
-    }
-
-    CFRelease(ScreenDictionaries);
-    return Result;
+    return AXLibTopologySpacesCount(&Display->Topology);
 }
 
 /* NOTE(koekeishiya): Given an abitrary CGSSpaceID, return the ax_display it belongs to. */
@@ -682,6 +664,7 @@ void AXLibSpaceAddWindow(CGSSpaceID SpaceID, uint32_t WindowID)
     CGSAddWindowsToSpaces(CGSDefaultConnection, (__bridge CFArrayRef)NSArrayWindow, (__bridge CFArrayRef)NSArrayDestinationSpace);
     [NSArrayWindow release];
     [NSArrayDestinationSpace release];
+    AXLibInvalidateVisibleWindows();
 }
 
 void AXLibSpaceRemoveWindow(CGSSpaceID SpaceID, uint32_t WindowID)
@@ -691,6 +674,7 @@ void AXLibSpaceRemoveWindow(CGSSpaceID SpaceID, uint32_t WindowID)
     CGSRemoveWindowsFromSpaces(CGSDefaultConnection, (__bridge CFArrayRef)NSArrayWindow, (__bridge CFArrayRef)NSArraySourceSpace);
     [NSArrayWindow release];
     [NSArraySourceSpace release];
+    AXLibInvalidateVisibleWindows();
 }
 
 bool AXLibSpaceHasWindow(ax_window *Window, CGSSpaceID SpaceID)
@@ -727,6 +711,44 @@ bool AXLibStickyWindow(ax_window *Window)
     return Result;
 }
 
+internal SPACE_WINDOWS_SOURCE(AXLibReadWindowsOnSpace)
+{
+    NSArray *NSArraySpace = @[ @(SpaceID) ];
+    uint64_t SetTags = 0, ClearTags = 0;
+    CFArrayRef SpaceWindows = CGSCopyWindowsWithOptionsAndTags(CGSDefaultConnection, 0, (__bridge CFArrayRef)NSArraySpace, 0x2, &SetTags, &ClearTags);
+    if(SpaceWindows)
+    {
+        int NumberOfWindows = CFArrayGetCount(SpaceWindows);
+        for(int WindowIndex = 0; WindowIndex < NumberOfWindows; ++WindowIndex)
+        {
+            NSNumber *ID = (__bridge NSNumber *)CFArrayGetValueAtIndex(SpaceWindows, WindowIndex);
+            Windows->push_back([ID unsignedIntValue]);
+        }
+
+        CFRelease(SpaceWindows);
+    }
+
+    [NSArraySpace release];
+}
+
+/* NOTE(koekeishiya): Looks up the spaces of every given window with one call per known space. */
+ax_window_spaces AXLibSpacesForWindows(const std::vector<uint32_t> &WindowIDs)
+{
+    std::vector<CGSSpaceID> Spaces;
+    if(!WindowIDs.empty())
+    {
+        std::map<CGDirectDisplayID, ax_display>::iterator It;
+        for(It = Displays->begin(); It != Displays->end(); ++It)
+        {
+            ax_display *Display = &It->second;
+            unsigned int SpacesCount = AXLibTopologySpacesCount(&Display->Topology);
+            Spaces.insert(Spaces.end(), Display->Topology.SpaceOrder.begin(), Display->Topology.SpaceOrder.begin() + SpacesCount);
+        }
+    }
+
+    return AXLibCollectWindowSpaces(WindowIDs, Spaces, &AXLibReadWindowsOnSpace, NULL);
+}
+
 bool AXLibDisplayHasSeparateSpaces()
 {
     return [NSScreen screensHaveSeparateSpaces];
@@ -735,5 +757,6 @@ bool AXLibDisplayHasSeparateSpaces()
 void AXLibInitializeDisplays(std::map<CGDirectDisplayID, ax_display> *AXDisplays)
 {
     Displays = AXDisplays;
+    AXLibInitDisplayArrangement(&DisplayArrangement, &AXLibReadDisplayArrangement, NULL);
     AXLibActiveDisplays();
 }
@@ -34,6 +34,20 @@ CFTypeRef AXLibGetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property)
     return Result ? TypeRef : NULL;
 }
 
+/* NOTE(koekeishiya): Fetch several attributes with a single request. The returned array has one value per
+                      requested attribute; attributes that could not be read hold an AXValue of kAXValueAXErrorType. */
+CFArrayRef AXLibGetWindowProperties(AXUIElementRef WindowRef, CFArrayRef Properties, AXError *Error)
+{
+    CFArrayRef Values = NULL;
+    *Error = AXUIElementCopyMultipleAttributeValues(WindowRef, Properties, 0, &Values);
+    bool Result = (*Error == kAXErrorSuccess);
+
+    if(!Result && Values)
+        CFRelease(Values);
+
+    return Result ? Values : NULL;
+}
+
 AXError AXLibSetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property, CFTypeRef Value)
 {
     return AXUIElementSetAttributeValue(WindowRef, Property, Value);
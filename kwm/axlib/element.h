@@ -14,6 +14,7 @@ bool AXLibSetWindowPosition(AXUIElementRef WindowRef, int X, int Y);
 bool AXLibSetWindowSize(AXUIElementRef WindowRef, int Width, int Height);
 
 CFTypeRef AXLibGetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property);
+CFArrayRef AXLibGetWindowProperties(AXUIElementRef WindowRef, CFArrayRef Properties, AXError *Error);
 AXError AXLibSetWindowProperty(AXUIElementRef WindowRef, CFStringRef Property, CFTypeRef Value);
 
 char *AXLibGetWindowTitle(AXUIElementRef WindowRef);
@@ -1,20 +1,175 @@
 #include "event.h"
 #include "display.h"
+#include "axlib.h"
 #include <stdio.h>
+#include <cmath>
+#include <chrono>
 
 #define internal static
+#define AX_EVENT_TIMER_RESOLUTION 0.01
+
 internal ax_event_loop EventLoop = {};
 
-/* NOTE(koekeishiya): Must be thread-safe! Called through AXLibConstructEvent macro */
-void AXLibAddEvent(ax_event Event)
+/* NOTE(koekeishiya): Timers may be scheduled before the event-loop is started, so the wheel has its
+                      own statically initialized lock and is set up on first use. */
+internal pthread_mutex_t TimerLock = PTHREAD_MUTEX_INITIALIZER;
+internal ax_timer_wheel TimerWheel;
+internal std::chrono::steady_clock::time_point TimerEpoch;
+internal bool TimerWheelInitialized;
+
+/* NOTE(koekeishiya): Must be thread-safe! Called through AXLibConstructEvent macro.
+                      Returns false if the event was not queued, because the event loop is not running. */
+bool AXLibAddEvent(ax_event Event)
 {
+    /* NOTE(koekeishiya): Anything but a mouse move may change which window is below the cursor. */
+    if(Event.Handle != &Callback_AXEvent_MouseMoved)
+        AXLibInvalidateWindowBelowCursor();
+
     if(EventLoop.Running && Event.Handle)
     {
+        if(AXLibIsTracing())
+            Event.Queued = AXLibTraceTime();
+
         pthread_mutex_lock(&EventLoop.WorkerLock);
         EventLoop.Queue.push(Event);
 
-        pthread_cond_signal(&EventLoop.State);
+        AXLibSignalWakeup(&EventLoop.Wakeup);
         pthread_mutex_unlock(&EventLoop.WorkerLock);
+        return true;
+    }
+
+    return false;
+}
+
+internal inline uint64_t
+AXLibCurrentTimerTick()
+{
+    std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - TimerEpoch;
+    return (uint64_t) (Elapsed.count() / AX_EVENT_TIMER_RESOLUTION);
+}
+
+internal inline void
+AXLibInitializeTimerWheel()
+{
+    if(!TimerWheelInitialized)
+    {
+        TimerEpoch = std::chrono::steady_clock::now();
+        AXLibInitTimerWheel(&TimerWheel, 0);
+        TimerWheelInitialized = true;
+    }
+}
+
+internal inline void
+AXLibSignalEventLoop()
+{
+    if(EventLoop.Running)
+    {
+        pthread_mutex_lock(&EventLoop.WorkerLock);
+        AXLibSignalWakeup(&EventLoop.Wakeup);
+        pthread_mutex_unlock(&EventLoop.WorkerLock);
+    }
+}
+
+/* NOTE(koekeishiya): Must be thread-safe! Called through AXLibConstructTimedEvent macro.
+                      The expiry is rounded up to the next tick, so an event is never posted early. */
+void AXLibScheduleEvent(ax_event_timer *Timer, double Seconds, ax_event Event)
+{
+    if(!Event.Handle)
+        return;
+
+    if(!Timer)
+    {
+        Timer = (ax_event_timer *) calloc(1, sizeof(ax_event_timer));
+        Timer->Owned = true;
+    }
+
+    pthread_mutex_lock(&TimerLock);
+    AXLibInitializeTimerWheel();
+
+    uint64_t Tick = AXLibCurrentTimerTick();
+    uint64_t Ticks = (uint64_t) std::ceil(Seconds / AX_EVENT_TIMER_RESOLUTION);
+    AXLibAdvanceTimerWheel(&TimerWheel, Tick);
+
+    Timer->Event = Event;
+    AXLibAddTimer(&TimerWheel, &Timer->Timer, Tick + (Ticks > 0 ? Ticks : 1));
+    pthread_mutex_unlock(&TimerLock);
+
+    AXLibSignalEventLoop();
+}
+
+void AXLibCancelEvent(ax_event_timer *Timer)
+{
+    pthread_mutex_lock(&TimerLock);
+    if(TimerWheelInitialized)
+        AXLibRemoveTimer(&TimerWheel, &Timer->Timer);
+    pthread_mutex_unlock(&TimerLock);
+}
+
+/* NOTE(koekeishiya): A timer stops being pending once its event has been posted, so a callback
+                      can tell that it was rescheduled after its event was already queued. */
+bool AXLibIsEventPending(ax_event_timer *Timer)
+{
+    pthread_mutex_lock(&TimerLock);
+    bool Result = AXLibIsTimerPending(&Timer->Timer);
+    pthread_mutex_unlock(&TimerLock);
+    return Result;
+}
+
+/* NOTE(koekeishiya): Post the events of all expired timers to the queue, and return the number of
+                      seconds until the wheel has to be advanced again, or a negative value if no
+                      timers are pending. */
+internal double
+AXLibProcessTimers()
+{
+    double Result = -1;
+    pthread_mutex_lock(&TimerLock);
+    if(TimerWheelInitialized)
+    {
+        uint64_t Tick = AXLibCurrentTimerTick();
+        AXLibAdvanceTimerWheel(&TimerWheel, Tick);
+
+        ax_timer *Expired;
+        while((Expired = AXLibPopExpiredTimer(&TimerWheel)))
+        {
+            ax_event_timer *Timer = (ax_event_timer *) Expired;
+            ax_event Event = Timer->Event;
+            if(AXLibIsTracing())
+                Event.Queued = AXLibTraceTime();
+
+            pthread_mutex_lock(&EventLoop.WorkerLock);
+            EventLoop.Queue.push(Event);
+            pthread_mutex_unlock(&EventLoop.WorkerLock);
+
+            if(Timer->Owned)
+                free(Timer);
+        }
+
+        uint64_t Next = AXLibNextTimerTick(&TimerWheel);
+        if(Next != UINT64_MAX)
+            Result = (Next > Tick ? Next - Tick : 1) * AX_EVENT_TIMER_RESOLUTION;
+    }
+    pthread_mutex_unlock(&TimerLock);
+
+    return Result;
+}
+
+/* NOTE(koekeishiya): Traces the time an event spent in the queue, followed by its handler. An
+ *                    event that was posted before the trace started has no queue span. */
+internal void
+AXLibDispatchEvent(ax_event *Event)
+{
+    if(AXLibIsTracing())
+    {
+        const char *Name = Event->Name ? Event->Name : "AXEvent";
+        if(Event->Queued)
+            AXLibAddTraceSpan(Name, "queue", Event->Queued, AXLibTraceTime());
+
+        AXLibTraceScope(Name, "event");
+        (*Event->Handle)(Event);
+    }
+    else
+    {
+        (*Event->Handle)(Event);
     }
 }
 
@@ -22,6 +177,7 @@ void AXLibAddEvent(ax_event Event)
 internal void *
 AXLibProcessEventQueue(void *)
 {
+    AXLibSetTraceThreadName("event-loop");
     while(EventLoop.Running)
     {
         pthread_mutex_lock(&EventLoop.StateLock);
@@ -34,14 +190,21 @@ AXLibProcessEventQueue(void *)
                 EventLoop.Queue.pop();
                 pthread_mutex_unlock(&EventLoop.WorkerLock);
 
-                (*Event.Handle)(&Event);
+                AXLibDispatchEvent(&Event);
             }
         }
 
-        while(EventLoop.Queue.empty() && EventLoop.Running)
-            pthread_cond_wait(&EventLoop.State, &EventLoop.StateLock);
-
+        double Timeout = AXLibProcessTimers();
         pthread_mutex_unlock(&EventLoop.StateLock);
+
+        /* NOTE(koekeishiya): The queue, Running and the wakeup are all guarded by the WorkerLock,
+                              so an event or timer that is added after we processed the timers
+                              wakes us up even if it arrives before we start to wait. The StateLock
+                              is released first, so that the event-loop can be paused while idle. */
+        pthread_mutex_lock(&EventLoop.WorkerLock);
+        if(EventLoop.Queue.empty() && EventLoop.Running)
+            AXLibWaitForWakeup(&EventLoop.Wakeup, Timeout);
+        pthread_mutex_unlock(&EventLoop.WorkerLock);
     }
 
     return NULL;
@@ -69,6 +232,9 @@ AXLibInitializeEventLoop()
         return false;
    }
 
+   EventLoop.Wakeup.Lock = &EventLoop.WorkerLock;
+   EventLoop.Wakeup.Condition = &EventLoop.State;
+   EventLoop.Wakeup.Pending = false;
    return true;
 }
 
@@ -119,8 +285,10 @@ void AXLibStopEventLoop()
 {
     if(EventLoop.Running)
     {
+        pthread_mutex_lock(&EventLoop.WorkerLock);
         EventLoop.Running = false;
-        pthread_cond_signal(&EventLoop.State);
+        AXLibSignalWakeup(&EventLoop.Wakeup);
+        pthread_mutex_unlock(&EventLoop.WorkerLock);
         pthread_join(EventLoop.Worker, NULL);
         AXLibTerminateEventLoop();
     }
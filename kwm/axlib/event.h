@@ -4,6 +4,9 @@
 #include <pthread.h>
 #include <queue>
 
+#include "timer.h"
+#include "trace.h"
+
 struct ax_event;
 
 #define EVENT_CALLBACK(name) void name(ax_event *Event)
@@ -67,11 +70,24 @@ enum ax_event_type
     AXEvent_MouseMoved,
 };
 
+/* NOTE(koekeishiya): Name is the stringified event type, and Queued is the time at which the
+ *                    event was posted. Both are only used for tracing. */
 struct ax_event
 {
     EventCallback *Handle;
     bool Intrinsic;
     void *Context;
+    const char *Name;
+    uint64_t Queued;
+};
+
+/* NOTE(koekeishiya): An event that is posted to the event-loop once its timer expires. Owners
+ *                    embed the timer and may reschedule or cancel it at any time. */
+struct ax_event_timer
+{
+    ax_timer Timer;
+    ax_event Event;
+    bool Owned;
 };
 
 struct ax_event_loop
@@ -82,6 +98,7 @@ struct ax_event_loop
     pthread_t Worker;
     bool Running;
     std::queue<ax_event> Queue;
+    ax_wakeup Wakeup;
 };
 
 bool AXLibStartEventLoop();
@@ -90,7 +107,10 @@ void AXLibStopEventLoop();
 void AXLibPauseEventLoop();
 void AXLibResumeEventLoop();
 
-void AXLibAddEvent(ax_event Event);
+bool AXLibAddEvent(ax_event Event);
+void AXLibScheduleEvent(ax_event_timer *Timer, double Seconds, ax_event Event);
+void AXLibCancelEvent(ax_event_timer *Timer);
+bool AXLibIsEventPending(ax_event_timer *Timer);
 
 /* NOTE(koekeishiya): Construct an ax_event with the appropriate callback through macro expansion. */
 #define AXLibConstructEvent(EventType, EventContext, EventIntrinsic) \
@@ -98,7 +118,19 @@ void AXLibAddEvent(ax_event Event);
          Event.Context = EventContext; \
          Event.Intrinsic = EventIntrinsic; \
          Event.Handle = &Callback_##EventType; \
+         Event.Name = #EventType; \
          AXLibAddEvent(Event); \
        } while(0)
 
+/* NOTE(koekeishiya): As AXLibConstructEvent, but the event is posted after the given number of seconds.
+ *                    A pending timer is rescheduled. Pass NULL for a one-shot event that cannot be cancelled. */
+#define AXLibConstructTimedEvent(EventTimer, Seconds, EventType, EventContext, EventIntrinsic) \
+    do { ax_event Event = {}; \
+         Event.Context = EventContext; \
+         Event.Intrinsic = EventIntrinsic; \
+         Event.Handle = &Callback_##EventType; \
+         Event.Name = #EventType; \
+         AXLibScheduleEvent(EventTimer, Seconds, Event); \
+       } while(0)
+
 #endif
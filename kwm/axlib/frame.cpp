@@ -0,0 +1,252 @@
+#include "frame.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+
+#define internal static
+
+/* NOTE(koekeishiya): The latest frame requested for a window of a degraded application, which is
+                      applied once by the work that was queued for the first of these requests.
+                      SizeFirst is set when the latest size was requested before the latest position,
+                      in which case the size is applied first, as a separate update. */
+struct ax_deferred_frame
+{
+    void *Ref;
+    int PID;
+    ax_frame Frame;
+    bool SizeFirst;
+};
+
+struct ax_frame_request
+{
+    void *Ref;
+    int PID;
+    ax_frame Frame;
+    ax_frame_result Result;
+
+    ax_frame_callback *Callback;
+    void *Context;
+};
+
+internal ax_frame_backend *Backend;
+internal std::atomic<uint32_t> BackendLatency(0);
+
+internal pthread_mutex_t DeferredFramesLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::map<uint32_t, ax_deferred_frame> DeferredFrames;
+
+internal inline double
+AXLibMillisecondsSince(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+}
+
+internal inline void
+AXLibSimulateBackendLatency()
+{
+    uint32_t Microseconds = BackendLatency.load(std::memory_order_relaxed);
+    if(Microseconds)
+    {
+        struct timespec Delay;
+        Delay.tv_sec = Microseconds / 1000000;
+        Delay.tv_nsec = (Microseconds % 1000000) * 1000;
+        nanosleep(&Delay, NULL);
+    }
+}
+
+internal ax_frame_result
+AXLibBackendSetFrame(void *Ref, ax_frame *Frame)
+{
+    AXLibSimulateBackendLatency();
+    return (*Backend->SetFrame)(Ref, Frame);
+}
+
+internal ax_frame_result
+AXLibBackendGetFrame(void *Ref, ax_frame *Frame)
+{
+    AXLibSimulateBackendLatency();
+    return (*Backend->GetFrame)(Ref, Frame);
+}
+
+internal ax_frame_request *
+AXLibCreateFrameRequest(ax_frame_target *Target)
+{
+    ax_frame_request *Request = (ax_frame_request *) calloc(1, sizeof(ax_frame_request));
+    (*Backend->Retain)(Target->Ref);
+    Request->Ref = Target->Ref;
+    Request->PID = Target->PID;
+    return Request;
+}
+
+internal void
+AXLibDestroyFrameRequest(ax_frame_request *Request)
+{
+    (*Backend->Release)(Request->Ref);
+    free(Request);
+}
+
+void AXLibSetFrameBackend(ax_frame_backend *FrameBackend)
+{
+    Backend = FrameBackend;
+}
+
+void AXLibSetFrameBackendLatency(double Milliseconds)
+{
+    BackendLatency.store(Milliseconds > 0 ? (uint32_t) (Milliseconds * 1000.0) : 0, std::memory_order_relaxed);
+}
+
+/* NOTE(koekeishiya): Runs on the application queue. */
+internal AX_QUEUE_WORK(AXLibApplyDeferredFrame)
+{
+    uint32_t WindowID = (uint32_t) (uintptr_t) Context;
+
+    pthread_mutex_lock(&DeferredFramesLock);
+    ax_deferred_frame Deferred = DeferredFrames[WindowID];
+    DeferredFrames.erase(WindowID);
+    pthread_mutex_unlock(&DeferredFramesLock);
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    ax_frame_result Result = AXFrame_Success;
+    if(Deferred.SizeFirst)
+    {
+        ax_frame Size = Deferred.Frame;
+        Size.HasPosition = false;
+        Deferred.Frame.HasSize = false;
+        Result = AXLibBackendSetFrame(Deferred.Ref, &Size);
+    }
+
+    if(Result != AXFrame_TimedOut)
+    {
+        ax_frame_result FrameResult = AXLibBackendSetFrame(Deferred.Ref, &Deferred.Frame);
+        if(Result == AXFrame_Success)
+            Result = FrameResult;
+    }
+
+    (*Backend->RecordLatency)(NULL, Deferred.PID, AXLibMillisecondsSince(Start), Result, true);
+    (*Backend->Release)(Deferred.Ref);
+}
+
+internal void
+AXLibDeferWindowFrame(ax_frame_target *Target, ax_frame *Frame)
+{
+    pthread_mutex_lock(&DeferredFramesLock);
+    bool Scheduled = DeferredFrames.find(Target->WindowID) != DeferredFrames.end();
+    ax_deferred_frame *Deferred = &DeferredFrames[Target->WindowID];
+    if(!Scheduled)
+    {
+        (*Backend->Retain)(Target->Ref);
+        Deferred->Ref = Target->Ref;
+        Deferred->PID = Target->PID;
+        Deferred->Frame = ax_frame();
+        Deferred->SizeFirst = false;
+    }
+
+    if(Frame->HasPosition)
+    {
+        Deferred->Frame.HasPosition = true;
+        Deferred->Frame.X = Frame->X;
+        Deferred->Frame.Y = Frame->Y;
+        Deferred->SizeFirst = !Frame->HasSize && Deferred->Frame.HasSize;
+    }
+
+    if(Frame->HasSize)
+    {
+        Deferred->Frame.HasSize = true;
+        Deferred->Frame.Width = Frame->Width;
+        Deferred->Frame.Height = Frame->Height;
+        Deferred->SizeFirst = false;
+    }
+    pthread_mutex_unlock(&DeferredFramesLock);
+
+    if(!Scheduled)
+        AXLibQueueDetached(Target->Queue, &AXLibApplyDeferredFrame, (void *) (uintptr_t) Target->WindowID);
+}
+
+/* NOTE(koekeishiya): Runs on the application queue, and owns the request. */
+internal AX_QUEUE_WORK(AXLibApplyQueuedFrame)
+{
+    ax_frame_request *Request = (ax_frame_request *) Context;
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    ax_frame_result Result = AXLibBackendSetFrame(Request->Ref, &Request->Frame);
+    (*Backend->RecordLatency)(NULL, Request->PID, AXLibMillisecondsSince(Start), Result, true);
+    AXLibDestroyFrameRequest(Request);
+}
+
+internal AX_QUEUE_WORK(AXLibApplyFrame)
+{
+    ax_frame_request *Request = (ax_frame_request *) Context;
+    Request->Result = AXLibBackendSetFrame(Request->Ref, &Request->Frame);
+}
+
+/* NOTE(koekeishiya): Frame updates always execute on the application queue, so that updates of the same
+                      window are applied in order. Inside a batch the caller does not wait for the update and
+                      it is reported as successful. Updates for an application that is marked as degraded are
+                      not waited on at all, so that one unresponsive application can not stall the event thread.
+                      The moved and resized notifications follow as usual in both cases. */
+bool AXLibSubmitFrame(ax_frame_target *Target, ax_frame *Frame)
+{
+    if((Target->WindowID != 0) &&
+       (Target->Degraded))
+    {
+        AXLibDeferWindowFrame(Target, Frame);
+        return true;
+    }
+
+    if((AXLibIsBatchActive()) &&
+       (!AXLibIsOnQueue(Target->Queue)))
+    {
+        ax_frame_request *Request = AXLibCreateFrameRequest(Target);
+        Request->Frame = *Frame;
+        AXLibQueueAsync(Target->Queue, &AXLibApplyQueuedFrame, Request);
+        return true;
+    }
+
+    ax_frame_request Request = {};
+    Request.Ref = Target->Ref;
+    Request.Frame = *Frame;
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    AXLibQueueSync(Target->Queue, &AXLibApplyFrame, &Request);
+    (*Backend->RecordLatency)(Target->Owner, Target->PID, AXLibMillisecondsSince(Start), Request.Result, false);
+    return Request.Result == AXFrame_Success;
+}
+
+internal AX_QUEUE_WORK(AXLibGetQueuedFrame)
+{
+    ax_frame_request *Request = (ax_frame_request *) Context;
+    Request->Result = AXLibBackendGetFrame(Request->Ref, &Request->Frame);
+}
+
+internal AX_QUEUE_WORK(AXLibFinishFrameRead)
+{
+    ax_frame_request *Request = (ax_frame_request *) Context;
+    (*Request->Callback)(Request->Context, &Request->Frame, Request->Result);
+    AXLibDestroyFrameRequest(Request);
+}
+
+/* NOTE(koekeishiya): Reads the frame a window has after every update requested before this call has been
+                      applied. Inside a batch the read is queued with the updates, and the callback runs on the
+                      thread that ends the batch, once it has completed. Otherwise the callback runs before this
+                      function returns. Either way the callback never runs on the application queue. */
+void AXLibReadFrame(ax_frame_target *Target, ax_frame_callback *Callback, void *Context)
+{
+    ax_frame_request *Request = AXLibCreateFrameRequest(Target);
+    Request->Callback = Callback;
+    Request->Context = Context;
+
+    if((AXLibIsBatchActive()) &&
+       (!AXLibIsOnQueue(Target->Queue)))
+    {
+        AXLibQueueAsync(Target->Queue, &AXLibGetQueuedFrame, Request);
+        AXLibOnBatchEnd(&AXLibFinishFrameRead, Request);
+    }
+    else
+    {
+        AXLibQueueSync(Target->Queue, &AXLibGetQueuedFrame, Request);
+        AXLibFinishFrameRead(Request);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef AXLIB_FRAME_H
+#define AXLIB_FRAME_H
+
+#include <stdint.h>
+
+#include "queue.h"
+
+/*
+ * NOTE(koekeishiya):
+ *        Moves and resizes windows on the serial queue of their application, see queue.h. The
+ *        AX calls themselves go through an ax_frame_backend, which axlib sets to one that talks
+ *        to the accessibility API. Tests install their own, so that the ordering, batching and
+ *        deferral below can be exercised on Linux.
+ *
+ *        Every backend call can be slowed down by a fixed latency, to reproduce unresponsive
+ *        applications.
+ * */
+
+enum ax_frame_result
+{
+    AXFrame_Success,
+    AXFrame_Failure,
+    AXFrame_TimedOut,
+};
+
+struct ax_frame
+{
+    bool HasPosition;
+    double X;
+    double Y;
+
+    bool HasSize;
+    double Width;
+    double Height;
+};
+
+/* NOTE(koekeishiya): Owner is the application of the window. Latency measured on a queue is
+                      reported with Queued set and must not touch Owner, as the application may
+                      be gone by then; PID is there to look it up again. */
+#define AX_FRAME_BACKEND_SET(name) ax_frame_result name(void *Ref, ax_frame *Frame)
+#define AX_FRAME_BACKEND_GET(name) ax_frame_result name(void *Ref, ax_frame *Frame)
+#define AX_FRAME_BACKEND_RETAIN(name) void name(void *Ref)
+#define AX_FRAME_BACKEND_RELEASE(name) void name(void *Ref)
+#define AX_FRAME_BACKEND_LATENCY(name) void name(void *Owner, int PID, double Milliseconds, ax_frame_result Result, bool Queued)
+
+typedef AX_FRAME_BACKEND_SET(ax_frame_backend_set);
+typedef AX_FRAME_BACKEND_GET(ax_frame_backend_get);
+typedef AX_FRAME_BACKEND_RETAIN(ax_frame_backend_retain);
+typedef AX_FRAME_BACKEND_RELEASE(ax_frame_backend_release);
+typedef AX_FRAME_BACKEND_LATENCY(ax_frame_backend_latency);
+
+struct ax_frame_backend
+{
+    ax_frame_backend_set *SetFrame;
+    ax_frame_backend_get *GetFrame;
+    ax_frame_backend_retain *Retain;
+    ax_frame_backend_release *Release;
+    ax_frame_backend_latency *RecordLatency;
+};
+
+/* NOTE(koekeishiya): A window as seen by this layer. Windows without an id are never deferred. */
+struct ax_frame_target
+{
+    void *Ref;
+    uint32_t WindowID;
+    void *Owner;
+    int PID;
+    ax_queue *Queue;
+    bool Degraded;
+};
+
+#define AX_FRAME_CALLBACK(name) void name(void *Context, ax_frame *Frame, ax_frame_result Result)
+typedef AX_FRAME_CALLBACK(ax_frame_callback);
+
+void AXLibSetFrameBackend(ax_frame_backend *Backend);
+void AXLibSetFrameBackendLatency(double Milliseconds);
+
+bool AXLibSubmitFrame(ax_frame_target *Target, ax_frame *Frame);
+void AXLibReadFrame(ax_frame_target *Target, ax_frame_callback *Callback, void *Context);
+
+#endif
@@ -0,0 +1,30 @@
+#include "membership.h"
+
+/* NOTE(koekeishiya): Every requested window gets an entry, possibly empty. The source is not
+                      called at all when there are no windows to look up. */
+ax_window_spaces AXLibCollectWindowSpaces(const std::vector<uint32_t> &WindowIDs, const std::vector<CGSSpaceID> &Spaces,
+                                          SpaceWindowsSource *Source, const void *Context)
+{
+    ax_window_spaces Result;
+    for(std::size_t Index = 0; Index < WindowIDs.size(); ++Index)
+        Result[WindowIDs[Index]];
+
+    if(Result.empty())
+        return Result;
+
+    std::vector<uint32_t> Windows;
+    for(std::size_t SpaceIndex = 0; SpaceIndex < Spaces.size(); ++SpaceIndex)
+    {
+        Windows.clear();
+        (*Source)(Context, Spaces[SpaceIndex], &Windows);
+
+        for(std::size_t WindowIndex = 0; WindowIndex < Windows.size(); ++WindowIndex)
+        {
+            ax_window_spaces::iterator It = Result.find(Windows[WindowIndex]);
+            if(It != Result.end())
+                It->second.push_back(Spaces[SpaceIndex]);
+        }
+    }
+
+    return Result;
+}
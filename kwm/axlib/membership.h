@@ -0,0 +1,34 @@
+#ifndef AXLIB_MEMBERSHIP_H
+#define AXLIB_MEMBERSHIP_H
+
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+#include "topology.h"
+
+/*
+ * NOTE(koekeishiya):
+ *        The spaces each of a set of windows is on. CGSCopySpacesForWindows returns the union
+ *        of spaces for all windows passed to it, so it can not answer this for more than one
+ *        window at a time. Instead the windows of every known space are read from a source,
+ *        which is the window server for axlib and a recording fake in tests. This costs one
+ *        call per space rather than two calls per window.
+ * */
+
+#define SPACE_WINDOWS_SOURCE(name) void name(const void *Context, CGSSpaceID SpaceID, std::vector<uint32_t> *Windows)
+typedef SPACE_WINDOWS_SOURCE(SpaceWindowsSource);
+
+typedef std::map<uint32_t, std::vector<CGSSpaceID> > ax_window_spaces;
+
+/* NOTE(koekeishiya): Equivalent to AXLibSpaceHasWindow(..) && !AXLibStickyWindow(..). */
+inline bool
+AXLibWindowOnlyOnSpace(const std::vector<CGSSpaceID> &Spaces, CGSSpaceID SpaceID)
+{
+    return Spaces.size() == 1 && Spaces[0] == SpaceID;
+}
+
+ax_window_spaces AXLibCollectWindowSpaces(const std::vector<uint32_t> &WindowIDs, const std::vector<CGSSpaceID> &Spaces,
+                                          SpaceWindowsSource *Source, const void *Context);
+
+#endif
@@ -0,0 +1,65 @@
+#include "placement.h"
+
+#include <algorithm>
+
+#define internal static
+
+internal inline double
+AXLibIntersectionArea(ax_display_area *Area, double X, double Y, double Width, double Height)
+{
+    double Left = std::max(Area->X, X);
+    double Right = std::min(Area->X + Area->Width, X + Width);
+    double Top = std::max(Area->Y, Y);
+    double Bottom = std::min(Area->Y + Area->Height, Y + Height);
+    return (Right > Left && Bottom > Top) ? (Right - Left) * (Bottom - Top) : 0;
+}
+
+void AXLibInitDisplayArrangement(ax_display_arrangement *Arrangement, DisplayArrangementSource *Source, const void *Context)
+{
+    Arrangement->Source = Source;
+    Arrangement->Context = Context;
+    Arrangement->Areas.clear();
+    Arrangement->Generation = 1;
+    Arrangement->Valid = false;
+}
+
+void AXLibChangeDisplayArrangement(ax_display_arrangement *Arrangement)
+{
+    if(++Arrangement->Generation == 0)
+        Arrangement->Generation = 1;
+
+    Arrangement->Valid = false;
+}
+
+/* NOTE(koekeishiya): Returns NULL if the window is not on any display. */
+void *AXLibPlaceWindow(ax_display_arrangement *Arrangement, ax_window_placement *Placement,
+                       double X, double Y, double Width, double Height)
+{
+    if(Placement->Generation == Arrangement->Generation)
+        return Placement->Display;
+
+    if(!Arrangement->Valid)
+    {
+        Arrangement->Areas.clear();
+        if(Arrangement->Source)
+            (*Arrangement->Source)(Arrangement->Context, &Arrangement->Areas);
+
+        Arrangement->Valid = true;
+    }
+
+    double HighestArea = 0;
+    Placement->Display = NULL;
+    for(std::size_t Index = 0; Index < Arrangement->Areas.size(); ++Index)
+    {
+        ax_display_area *Area = &Arrangement->Areas[Index];
+        double Intersection = AXLibIntersectionArea(Area, X, Y, Width, Height);
+        if(Intersection > HighestArea)
+        {
+            HighestArea = Intersection;
+            Placement->Display = Area->Display;
+        }
+    }
+
+    Placement->Generation = Arrangement->Generation;
+    return Placement->Display;
+}
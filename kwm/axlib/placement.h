@@ -0,0 +1,55 @@
+#ifndef AXLIB_PLACEMENT_H
+#define AXLIB_PLACEMENT_H
+
+#include <stdint.h>
+#include <vector>
+
+/*
+ * NOTE(koekeishiya):
+ *        A window belongs to the display that holds the largest portion of its frame. The frames
+ *        of the displays are read from a source that is given when the arrangement is set up,
+ *        which is the display map for axlib and a scripted list in tests.
+ *
+ *        The display of a window is cached together with the generation of the arrangement it
+ *        was computed for. Adding, removing, moving or resizing a display starts a new generation,
+ *        which the frames are read for lazily. Moving or resizing the window itself resets its
+ *        cache. Generation 0 is never used, so a reset cache is always recomputed.
+ * */
+
+struct ax_display_area
+{
+    void *Display;
+    double X, Y;
+    double Width, Height;
+};
+
+#define DISPLAY_ARRANGEMENT_SOURCE(name) void name(const void *Context, std::vector<ax_display_area> *Areas)
+typedef DISPLAY_ARRANGEMENT_SOURCE(DisplayArrangementSource);
+
+struct ax_display_arrangement
+{
+    DisplayArrangementSource *Source;
+    const void *Context;
+    std::vector<ax_display_area> Areas;
+    uint32_t Generation;
+    bool Valid;
+};
+
+struct ax_window_placement
+{
+    void *Display;
+    uint32_t Generation;
+};
+
+inline void
+AXLibInvalidateWindowPlacement(ax_window_placement *Placement)
+{
+    Placement->Generation = 0;
+}
+
+void AXLibInitDisplayArrangement(ax_display_arrangement *Arrangement, DisplayArrangementSource *Source, const void *Context);
+void AXLibChangeDisplayArrangement(ax_display_arrangement *Arrangement);
+void *AXLibPlaceWindow(ax_display_arrangement *Arrangement, ax_window_placement *Placement,
+                       double X, double Y, double Width, double Height);
+
+#endif
@@ -0,0 +1,329 @@
+#include "queue.h"
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <vector>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#endif
+
+#define internal static
+
+struct ax_queue_callback
+{
+    ax_queue_work *Work;
+    void *Context;
+};
+
+#ifdef __APPLE__
+
+struct ax_queue
+{
+    dispatch_queue_t Handle;
+};
+
+typedef dispatch_group_t ax_queue_group;
+
+internal int QueueKey;
+
+ax_queue *AXLibCreateQueue(const char *Label)
+{
+    ax_queue *Queue = (ax_queue *) malloc(sizeof(ax_queue));
+    Queue->Handle = dispatch_queue_create(Label, DISPATCH_QUEUE_SERIAL);
+    dispatch_queue_set_specific(Queue->Handle, &QueueKey, Queue, NULL);
+    return Queue;
+}
+
+/* NOTE(koekeishiya): Work that is still pending keeps the GCD queue alive until it has run. */
+void AXLibDestroyQueue(ax_queue *Queue)
+{
+    dispatch_release(Queue->Handle);
+    free(Queue);
+}
+
+bool AXLibIsOnQueue(ax_queue *Queue)
+{
+    return dispatch_get_specific(&QueueKey) == Queue;
+}
+
+internal ax_queue_group
+AXLibCreateQueueGroup()
+{
+    return dispatch_group_create();
+}
+
+internal void
+AXLibWaitQueueGroup(ax_queue_group Group)
+{
+    dispatch_group_wait(Group, DISPATCH_TIME_FOREVER);
+    dispatch_release(Group);
+}
+
+internal void
+AXLibEnqueue(ax_queue *Queue, ax_queue_group Group, ax_queue_work *Work, void *Context)
+{
+    if(Group)
+        dispatch_group_async_f(Group, Queue->Handle, Context, Work);
+    else
+        dispatch_async_f(Queue->Handle, Context, Work);
+}
+
+internal void
+AXLibEnqueueSync(ax_queue *Queue, ax_queue_work *Work, void *Context)
+{
+    dispatch_sync_f(Queue->Handle, Context, Work);
+}
+
+#else
+
+/* NOTE(koekeishiya): A serial queue runs its work on a thread of its own, which is started when
+                      work arrives and exits once the queue is empty. A destroyed queue is freed
+                      by its thread after the pending work has run. */
+struct ax_queue_group_state
+{
+    pthread_mutex_t Lock;
+    pthread_cond_t Done;
+    int Pending;
+};
+
+struct ax_queue_item
+{
+    ax_queue_work *Work;
+    void *Context;
+    ax_queue_group_state *Group;
+    ax_queue_item *Next;
+};
+
+/* NOTE(koekeishiya): Label names the threads that run the queue in a trace, the way it names
+                      the dispatch queue on macOS. */
+struct ax_queue
+{
+    const char *Label;
+    pthread_mutex_t Lock;
+    ax_queue_item *Head;
+    ax_queue_item *Tail;
+    bool Running;
+    bool Destroyed;
+};
+
+typedef ax_queue_group_state *ax_queue_group;
+
+internal __thread ax_queue *CurrentQueue;
+
+internal ax_queue_group
+AXLibCreateQueueGroup()
+{
+    ax_queue_group Group = (ax_queue_group) malloc(sizeof(ax_queue_group_state));
+    pthread_mutex_init(&Group->Lock, NULL);
+    pthread_cond_init(&Group->Done, NULL);
+    Group->Pending = 0;
+    return Group;
+}
+
+internal void
+AXLibWaitQueueGroup(ax_queue_group Group)
+{
+    pthread_mutex_lock(&Group->Lock);
+    while(Group->Pending > 0)
+        pthread_cond_wait(&Group->Done, &Group->Lock);
+    pthread_mutex_unlock(&Group->Lock);
+
+    pthread_cond_destroy(&Group->Done);
+    pthread_mutex_destroy(&Group->Lock);
+    free(Group);
+}
+
+internal void
+AXLibLeaveQueueGroup(ax_queue_group Group)
+{
+    pthread_mutex_lock(&Group->Lock);
+    if(--Group->Pending == 0)
+        pthread_cond_broadcast(&Group->Done);
+    pthread_mutex_unlock(&Group->Lock);
+}
+
+internal void
+AXLibFreeQueue(ax_queue *Queue)
+{
+    pthread_mutex_destroy(&Queue->Lock);
+    free(Queue);
+}
+
+internal void *
+AXLibRunQueue(void *Data)
+{
+    ax_queue *Queue = (ax_queue *) Data;
+    CurrentQueue = Queue;
+    AXLibSetTraceThreadName(Queue->Label);
+
+    pthread_mutex_lock(&Queue->Lock);
+    while(Queue->Head)
+    {
+        ax_queue_item *Item = Queue->Head;
+        Queue->Head = Item->Next;
+        if(!Queue->Head)
+            Queue->Tail = NULL;
+        pthread_mutex_unlock(&Queue->Lock);
+
+        (*Item->Work)(Item->Context);
+        if(Item->Group)
+            AXLibLeaveQueueGroup(Item->Group);
+
+        free(Item);
+        pthread_mutex_lock(&Queue->Lock);
+    }
+
+    Queue->Running = false;
+    bool Destroyed = Queue->Destroyed;
+    pthread_mutex_unlock(&Queue->Lock);
+
+    if(Destroyed)
+        AXLibFreeQueue(Queue);
+
+    return NULL;
+}
+
+internal void
+AXLibEnqueue(ax_queue *Queue, ax_queue_group Group, ax_queue_work *Work, void *Context)
+{
+    ax_queue_item *Item = (ax_queue_item *) malloc(sizeof(ax_queue_item));
+    Item->Work = Work;
+    Item->Context = Context;
+    Item->Group = Group;
+    Item->Next = NULL;
+
+    if(Group)
+    {
+        pthread_mutex_lock(&Group->Lock);
+        ++Group->Pending;
+        pthread_mutex_unlock(&Group->Lock);
+    }
+
+    pthread_mutex_lock(&Queue->Lock);
+    if(Queue->Tail)
+        Queue->Tail->Next = Item;
+    else
+        Queue->Head = Item;
+    Queue->Tail = Item;
+
+    if(!Queue->Running)
+    {
+        pthread_t Thread;
+        pthread_create(&Thread, NULL, &AXLibRunQueue, Queue);
+        pthread_detach(Thread);
+        Queue->Running = true;
+    }
+    pthread_mutex_unlock(&Queue->Lock);
+}
+
+internal void
+AXLibEnqueueSync(ax_queue *Queue, ax_queue_work *Work, void *Context)
+{
+    ax_queue_group Group = AXLibCreateQueueGroup();
+    AXLibEnqueue(Queue, Group, Work, Context);
+    AXLibWaitQueueGroup(Group);
+}
+
+ax_queue *AXLibCreateQueue(const char *Label)
+{
+    ax_queue *Queue = (ax_queue *) malloc(sizeof(ax_queue));
+    Queue->Label = Label;
+    pthread_mutex_init(&Queue->Lock, NULL);
+    Queue->Head = NULL;
+    Queue->Tail = NULL;
+    Queue->Running = false;
+    Queue->Destroyed = false;
+    return Queue;
+}
+
+void AXLibDestroyQueue(ax_queue *Queue)
+{
+    pthread_mutex_lock(&Queue->Lock);
+    Queue->Destroyed = true;
+    bool Running = Queue->Running;
+    pthread_mutex_unlock(&Queue->Lock);
+
+    if(!Running)
+        AXLibFreeQueue(Queue);
+}
+
+bool AXLibIsOnQueue(ax_queue *Queue)
+{
+    return CurrentQueue == Queue;
+}
+
+#endif
+
+internal __thread ax_queue_group Batch;
+internal __thread int BatchDepth;
+internal __thread std::vector<ax_queue_callback> *BatchCallbacks;
+
+/* NOTE(koekeishiya): Part of the current batch, if there is one. */
+void AXLibQueueAsync(ax_queue *Queue, ax_queue_work *Work, void *Context)
+{
+    AXLibEnqueue(Queue, Batch, Work, Context);
+}
+
+/* NOTE(koekeishiya): Never waited on, not even by an active batch. */
+void AXLibQueueDetached(ax_queue *Queue, ax_queue_work *Work, void *Context)
+{
+    AXLibEnqueue(Queue, NULL, Work, Context);
+}
+
+/* NOTE(koekeishiya): Runs the work inline when called from the queue itself, which would
+                      otherwise deadlock. */
+void AXLibQueueSync(ax_queue *Queue, ax_queue_work *Work, void *Context)
+{
+    if(AXLibIsOnQueue(Queue))
+        (*Work)(Context);
+    else
+        AXLibEnqueueSync(Queue, Work, Context);
+}
+
+void AXLibBeginBatch()
+{
+    if(BatchDepth++ == 0)
+    {
+        Batch = AXLibCreateQueueGroup();
+        BatchCallbacks = new std::vector<ax_queue_callback>;
+    }
+}
+
+void AXLibEndBatch()
+{
+    AXLibTraceFunction("ax");
+    if(BatchDepth > 0 && --BatchDepth == 0)
+    {
+        ax_queue_group Group = Batch;
+        std::vector<ax_queue_callback> *Callbacks = BatchCallbacks;
+        Batch = NULL;
+        BatchCallbacks = NULL;
+
+        AXLibWaitQueueGroup(Group);
+        for(std::size_t Index = 0; Index < Callbacks->size(); ++Index)
+            (*(*Callbacks)[Index].Work)((*Callbacks)[Index].Context);
+
+        delete Callbacks;
+    }
+}
+
+bool AXLibIsBatchActive()
+{
+    return Batch != NULL;
+}
+
+/* NOTE(koekeishiya): Runs the work right away when no batch is active. */
+void AXLibOnBatchEnd(ax_queue_work *Work, void *Context)
+{
+    if(BatchCallbacks)
+    {
+        ax_queue_callback Callback = { Work, Context };
+        BatchCallbacks->push_back(Callback);
+    }
+    else
+    {
+        (*Work)(Context);
+    }
+}
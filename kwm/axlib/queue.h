@@ -0,0 +1,39 @@
+#ifndef AXLIB_QUEUE_H
+#define AXLIB_QUEUE_H
+
+/*
+ * NOTE(koekeishiya):
+ *        Every ax_application owns a serial queue and all AX requests that modify its windows
+ *        are executed on it, which keeps requests for the same window in the order they were made.
+ *
+ *        AXLibBeginBatch(..) and AXLibEndBatch(..) can be wrapped around code that updates many
+ *        windows at once. Requests issued in between run concurrently on their application queues,
+ *        and AXLibEndBatch(..) waits once for all of them to complete. Batches nest, and only
+ *        affect the thread that started them. Work registered with AXLibOnBatchEnd(..) runs on
+ *        that thread once the outermost batch has completed, which is how results of queued
+ *        requests are handed back to the event thread.
+ *
+ *        Work is a plain function and context, so that this layer does not depend on blocks.
+ *        On macOS the queues are GCD queues. Elsewhere they are backed by pthreads, which lets
+ *        the layer be tested on Linux.
+ * */
+
+#define AX_QUEUE_WORK(name) void name(void *Context)
+typedef AX_QUEUE_WORK(ax_queue_work);
+
+struct ax_queue;
+
+ax_queue *AXLibCreateQueue(const char *Label);
+void AXLibDestroyQueue(ax_queue *Queue);
+bool AXLibIsOnQueue(ax_queue *Queue);
+
+void AXLibQueueAsync(ax_queue *Queue, ax_queue_work *Work, void *Context);
+void AXLibQueueDetached(ax_queue *Queue, ax_queue_work *Work, void *Context);
+void AXLibQueueSync(ax_queue *Queue, ax_queue_work *Work, void *Context);
+
+void AXLibBeginBatch();
+void AXLibEndBatch();
+bool AXLibIsBatchActive();
+void AXLibOnBatchEnd(ax_queue_work *Work, void *Context);
+
+#endif
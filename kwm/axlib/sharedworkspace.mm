@@ -133,6 +133,8 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
 
 - (void)activeSpaceDidChange:(NSNotification *)notification
 {
+    AXLibInvalidateSpaceTopology();
+
     /* NOTE(koekeishiya): OSX APIs are horrible, so we need to detect which display
                           this event was triggered for. */
     ax_display *MainDisplay = AXLibMainDisplay();
@@ -148,6 +150,7 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
         Display = AXLibNextDisplay(Display);
     } while(Display != MainDisplay);
 
+    AXLibInvalidateVisibleWindows();
     AXLibConstructEvent(AXEvent_SpaceChanged, Display, false);
 }
 
@@ -187,6 +190,7 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
     if(Applications->find(PID) != Applications->end())
     {
         ax_application *Application = &(*Applications)[PID];
+        AXLibSetApplicationVisible(Application, false);
 
         pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
         *ApplicationPID = Application->PID;
@@ -200,6 +204,7 @@ bool SharedWorkspaceIsApplicationHidden(pid_t PID)
     if(Applications->find(PID) != Applications->end())
     {
         ax_application *Application = &(*Applications)[PID];
+        AXLibSetApplicationVisible(Application, true);
 
         pid_t *ApplicationPID = (pid_t *) malloc(sizeof(pid_t));
         *ApplicationPID = Application->PID;
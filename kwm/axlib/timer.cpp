@@ -0,0 +1,221 @@
+#include "timer.h"
+
+#include <sys/time.h>
+
+#define internal static
+
+internal inline void
+AXLibInitTimerList(ax_timer *List)
+{
+    List->Prev = List;
+    List->Next = List;
+}
+
+internal inline bool
+AXLibIsTimerListEmpty(ax_timer *List)
+{
+    return List->Next == List;
+}
+
+internal inline void
+AXLibLinkTimer(ax_timer *List, ax_timer *Timer)
+{
+    Timer->Prev = List->Prev;
+    Timer->Next = List;
+    List->Prev->Next = Timer;
+    List->Prev = Timer;
+}
+
+internal inline void
+AXLibUnlinkTimer(ax_timer *Timer)
+{
+    Timer->Prev->Next = Timer->Next;
+    Timer->Next->Prev = Timer->Prev;
+    Timer->Prev = NULL;
+    Timer->Next = NULL;
+}
+
+void AXLibInitTimerWheel(ax_timer_wheel *Wheel, uint64_t Tick)
+{
+    for(int Level = 0; Level < AX_TIMER_WHEEL_LEVELS; ++Level)
+    {
+        for(int Slot = 0; Slot < AX_TIMER_WHEEL_SLOTS; ++Slot)
+            AXLibInitTimerList(&Wheel->Slots[Level][Slot]);
+    }
+
+    AXLibInitTimerList(&Wheel->Expired);
+    Wheel->Tick = Tick;
+    Wheel->Count = 0;
+}
+
+/* NOTE(koekeishiya): Wheel->Tick is the next tick to be processed. A timer that has already
+ *                    expired goes into the slot of that tick, and a timer beyond the range of
+ *                    the top level is clamped to its last tick. */
+void AXLibAddTimer(ax_timer_wheel *Wheel, ax_timer *Timer, uint64_t Expires)
+{
+    if(AXLibIsTimerPending(Timer))
+        AXLibRemoveTimer(Wheel, Timer);
+
+    uint64_t Range = (uint64_t) 1 << (AX_TIMER_WHEEL_BITS * AX_TIMER_WHEEL_LEVELS);
+    if(Expires < Wheel->Tick)
+        Expires = Wheel->Tick;
+    else if(Expires - Wheel->Tick >= Range)
+        Expires = Wheel->Tick + Range - 1;
+
+    uint64_t Delta = Expires - Wheel->Tick;
+    int Level = 0;
+    while(Delta >= ((uint64_t) 1 << (AX_TIMER_WHEEL_BITS * (Level + 1))))
+        ++Level;
+
+    int Slot = (Expires >> (AX_TIMER_WHEEL_BITS * Level)) & AX_TIMER_WHEEL_MASK;
+    Timer->Expires = Expires;
+    AXLibLinkTimer(&Wheel->Slots[Level][Slot], Timer);
+    ++Wheel->Count;
+}
+
+/* NOTE(koekeishiya): Removing a timer that has expired but was not popped yet is allowed, and
+ *                    keeps it from being handed out. */
+void AXLibRemoveTimer(ax_timer_wheel *Wheel, ax_timer *Timer)
+{
+    if(!AXLibIsTimerPending(Timer))
+        return;
+
+    if(Timer->Expires >= Wheel->Tick)
+        --Wheel->Count;
+
+    AXLibUnlinkTimer(Timer);
+}
+
+/* NOTE(koekeishiya): Re-add the timers of a slot, which moves them to a lower level. Returns
+ *                    the slot index, so that the caller knows whether this level wrapped. */
+internal int
+AXLibCascadeTimers(ax_timer_wheel *Wheel, int Level)
+{
+    int Slot = (Wheel->Tick >> (AX_TIMER_WHEEL_BITS * Level)) & AX_TIMER_WHEEL_MASK;
+    ax_timer List;
+    AXLibInitTimerList(&List);
+
+    ax_timer *Head = &Wheel->Slots[Level][Slot];
+    while(!AXLibIsTimerListEmpty(Head))
+    {
+        ax_timer *Timer = Head->Next;
+        AXLibUnlinkTimer(Timer);
+        AXLibLinkTimer(&List, Timer);
+    }
+
+    while(!AXLibIsTimerListEmpty(&List))
+    {
+        ax_timer *Timer = List.Next;
+        AXLibUnlinkTimer(Timer);
+        --Wheel->Count;
+        AXLibAddTimer(Wheel, Timer, Timer->Expires);
+    }
+
+    return Slot;
+}
+
+/* NOTE(koekeishiya): Process every tick up to and including Tick. Timers that expire are moved
+ *                    to the expired list, in the order of their expiry, to be popped by the
+ *                    owner. An empty wheel jumps straight to Tick. */
+void AXLibAdvanceTimerWheel(ax_timer_wheel *Wheel, uint64_t Tick)
+{
+    while(Wheel->Tick <= Tick)
+    {
+        if(Wheel->Count == 0)
+        {
+            Wheel->Tick = Tick + 1;
+            break;
+        }
+
+        int Slot = Wheel->Tick & AX_TIMER_WHEEL_MASK;
+        if(Slot == 0)
+        {
+            for(int Level = 1; Level < AX_TIMER_WHEEL_LEVELS; ++Level)
+            {
+                if(AXLibCascadeTimers(Wheel, Level) != 0)
+                    break;
+            }
+        }
+
+        ax_timer *Head = &Wheel->Slots[0][Slot];
+        while(!AXLibIsTimerListEmpty(Head))
+        {
+            ax_timer *Timer = Head->Next;
+            AXLibUnlinkTimer(Timer);
+            AXLibLinkTimer(&Wheel->Expired, Timer);
+            --Wheel->Count;
+        }
+
+        ++Wheel->Tick;
+    }
+}
+
+ax_timer *AXLibPopExpiredTimer(ax_timer_wheel *Wheel)
+{
+    if(AXLibIsTimerListEmpty(&Wheel->Expired))
+        return NULL;
+
+    ax_timer *Timer = Wheel->Expired.Next;
+    AXLibUnlinkTimer(Timer);
+    return Timer;
+}
+
+/* NOTE(koekeishiya): Returns the tick at which the wheel next needs to be advanced, which is
+ *                    either the expiry of the first timer in level 0, or the next time level 0
+ *                    wraps around and a higher level cascades into it. */
+uint64_t AXLibNextTimerTick(ax_timer_wheel *Wheel)
+{
+    if(Wheel->Count == 0)
+        return UINT64_MAX;
+
+    for(int Offset = 0; Offset < AX_TIMER_WHEEL_SLOTS; ++Offset)
+    {
+        int Slot = (Wheel->Tick + Offset) & AX_TIMER_WHEEL_MASK;
+        if(Offset > 0 && Slot == 0)
+            break;
+
+        if(!AXLibIsTimerListEmpty(&Wheel->Slots[0][Slot]))
+            return Wheel->Tick + Offset;
+    }
+
+    return (Wheel->Tick | AX_TIMER_WHEEL_MASK) + 1;
+}
+
+/* NOTE(koekeishiya): Must be called with Wakeup->Lock held. */
+void AXLibSignalWakeup(ax_wakeup *Wakeup)
+{
+    Wakeup->Pending = true;
+    pthread_cond_signal(Wakeup->Condition);
+}
+
+/* NOTE(koekeishiya): Must be called with Wakeup->Lock held. Waits until the wakeup is signalled,
+                      or for Timeout seconds if Timeout is not negative. Returns true if it was
+                      signalled, and consumes the signal. */
+bool AXLibWaitForWakeup(ax_wakeup *Wakeup, double Timeout)
+{
+    if(Timeout < 0)
+    {
+        while(!Wakeup->Pending)
+            pthread_cond_wait(Wakeup->Condition, Wakeup->Lock);
+    }
+    else
+    {
+        struct timeval Now;
+        gettimeofday(&Now, NULL);
+
+        uint64_t Nanoseconds = (uint64_t) Now.tv_usec * 1000 + (uint64_t) (Timeout * 1000000000.0);
+        struct timespec Deadline;
+        Deadline.tv_sec = Now.tv_sec + Nanoseconds / 1000000000;
+        Deadline.tv_nsec = Nanoseconds % 1000000000;
+
+        while(!Wakeup->Pending)
+        {
+            if(pthread_cond_timedwait(Wakeup->Condition, Wakeup->Lock, &Deadline) != 0)
+                break;
+        }
+    }
+
+    bool Result = Wakeup->Pending;
+    Wakeup->Pending = false;
+    return Result;
+}
@@ -0,0 +1,67 @@
+#ifndef AXLIB_TIMER_H
+#define AXLIB_TIMER_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * NOTE(koekeishiya):
+ *        A hierarchical timer wheel. Level 0 has a slot for each of the next 64 ticks, and each
+ *        level above covers 64 times the range of the one below it. A timer is put in the slot
+ *        of the lowest level that covers its expiry, and is moved down a level each time the
+ *        level below wraps around, until it expires from level 0.
+ *
+ *        Timers are intrusive and are linked into their slot, so adding and removing a timer
+ *        is O(1) and needs no allocation. The wheel knows nothing about time or threads; the
+ *        owner advances it in ticks and must serialize access to it.
+ * */
+
+#define AX_TIMER_WHEEL_BITS 6
+#define AX_TIMER_WHEEL_SLOTS (1 << AX_TIMER_WHEEL_BITS)
+#define AX_TIMER_WHEEL_MASK (AX_TIMER_WHEEL_SLOTS - 1)
+#define AX_TIMER_WHEEL_LEVELS 4
+
+struct ax_timer
+{
+    ax_timer *Prev;
+    ax_timer *Next;
+    uint64_t Expires;
+};
+
+struct ax_timer_wheel
+{
+    ax_timer Slots[AX_TIMER_WHEEL_LEVELS][AX_TIMER_WHEEL_SLOTS];
+    ax_timer Expired;
+    uint64_t Tick;
+    size_t Count;
+};
+
+inline bool
+AXLibIsTimerPending(ax_timer *Timer)
+{
+    return Timer->Next != NULL;
+}
+
+void AXLibInitTimerWheel(ax_timer_wheel *Wheel, uint64_t Tick);
+void AXLibAddTimer(ax_timer_wheel *Wheel, ax_timer *Timer, uint64_t Expires);
+void AXLibRemoveTimer(ax_timer_wheel *Wheel, ax_timer *Timer);
+void AXLibAdvanceTimerWheel(ax_timer_wheel *Wheel, uint64_t Tick);
+ax_timer *AXLibPopExpiredTimer(ax_timer_wheel *Wheel);
+uint64_t AXLibNextTimerTick(ax_timer_wheel *Wheel);
+
+/* NOTE(koekeishiya): Lets the thread that owns a wheel sleep until its next timer expires, while
+                      other threads can wake it after they add work. Pending is set and cleared
+                      with Lock held, so a signal that arrives before the owner starts to wait is
+                      not lost; the wait then returns immediately. */
+struct ax_wakeup
+{
+    pthread_mutex_t *Lock;
+    pthread_cond_t *Condition;
+    bool Pending;
+};
+
+void AXLibSignalWakeup(ax_wakeup *Wakeup);
+bool AXLibWaitForWakeup(ax_wakeup *Wakeup, double Timeout);
+
+#endif
@@ -0,0 +1,78 @@
+#include "topology.h"
+
+#define internal static
+
+internal void
+AXLibRefreshSpaceTopology(ax_space_topology *Topology)
+{
+    Topology->SpaceOrder.clear();
+    if(Topology->Source)
+        (*Topology->Source)(Topology->Context, &Topology->SpaceOrder);
+
+    Topology->Valid = true;
+}
+
+internal inline void
+AXLibEnsureSpaceTopology(ax_space_topology *Topology)
+{
+    if(!Topology->Valid)
+        AXLibRefreshSpaceTopology(Topology);
+}
+
+internal unsigned int
+AXLibFindDesktopID(ax_space_topology *Topology, CGSSpaceID SpaceID)
+{
+    for(std::size_t Index = 0; Index < Topology->SpaceOrder.size(); ++Index)
+    {
+        if(Topology->SpaceOrder[Index] == SpaceID)
+            return Index + 1;
+    }
+
+    return 0;
+}
+
+void AXLibInitSpaceTopology(ax_space_topology *Topology, SpaceTopologySource *Source, const void *Context)
+{
+    Topology->Source = Source;
+    Topology->Context = Context;
+    Topology->SpaceOrder.clear();
+    Topology->Valid = false;
+}
+
+void AXLibMarkSpaceTopologyStale(ax_space_topology *Topology)
+{
+    Topology->Valid = false;
+}
+
+/* NOTE(koekeishiya): Returns 0 if the space does not belong to this display. */
+unsigned int AXLibTopologyDesktopID(ax_space_topology *Topology, CGSSpaceID SpaceID)
+{
+    AXLibEnsureSpaceTopology(Topology);
+    unsigned int Result = AXLibFindDesktopID(Topology, SpaceID);
+    if(Result == 0)
+    {
+        AXLibRefreshSpaceTopology(Topology);
+        Result = AXLibFindDesktopID(Topology, SpaceID);
+    }
+
+    return Result;
+}
+
+/* NOTE(koekeishiya): Returns 0 if the display has no such desktop. */
+CGSSpaceID AXLibTopologySpaceID(ax_space_topology *Topology, unsigned int DesktopID)
+{
+    AXLibEnsureSpaceTopology(Topology);
+    if(DesktopID > Topology->SpaceOrder.size())
+        AXLibRefreshSpaceTopology(Topology);
+
+    if(DesktopID == 0 || DesktopID > Topology->SpaceOrder.size())
+        return 0;
+
+    return Topology->SpaceOrder[DesktopID - 1];
+}
+
+unsigned int AXLibTopologySpacesCount(ax_space_topology *Topology)
+{
+    AXLibEnsureSpaceTopology(Topology);
+    return Topology->SpaceOrder.size();
+}
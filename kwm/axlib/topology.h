@@ -0,0 +1,37 @@
+#ifndef AXLIB_TOPOLOGY_H
+#define AXLIB_TOPOLOGY_H
+
+#include <vector>
+
+typedef int CGSSpaceID;
+
+/*
+ * NOTE(koekeishiya):
+ *        The spaces of a display in Mission Control order; desktop n is SpaceOrder[n - 1].
+ *        The order is read from a source that is given when the topology is set up, which is
+ *        the window server for an ax_display and a scripted list in tests.
+ *
+ *        The order is read lazily, the first time it is used after being marked stale. Spaces
+ *        can be added or rearranged in Mission Control without a notification, so a lookup
+ *        that misses reads the order once more before giving up.
+ * */
+
+#define SPACE_TOPOLOGY_SOURCE(name) void name(const void *Context, std::vector<CGSSpaceID> *SpaceOrder)
+typedef SPACE_TOPOLOGY_SOURCE(SpaceTopologySource);
+
+struct ax_space_topology
+{
+    SpaceTopologySource *Source;
+    const void *Context;
+    std::vector<CGSSpaceID> SpaceOrder;
+    bool Valid;
+};
+
+void AXLibInitSpaceTopology(ax_space_topology *Topology, SpaceTopologySource *Source, const void *Context);
+void AXLibMarkSpaceTopologyStale(ax_space_topology *Topology);
+
+unsigned int AXLibTopologyDesktopID(ax_space_topology *Topology, CGSSpaceID SpaceID);
+CGSSpaceID AXLibTopologySpaceID(ax_space_topology *Topology, unsigned int DesktopID);
+unsigned int AXLibTopologySpacesCount(ax_space_topology *Topology);
+
+#endif
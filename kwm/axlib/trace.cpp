@@ -0,0 +1,257 @@
+#include "trace.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <chrono>
+
+#define internal static
+
+struct ax_trace_span
+{
+    const char *Name;
+    const char *Category;
+    uint64_t Start;
+    uint64_t End;
+};
+
+/* NOTE(koekeishiya): Count and Next are published with release semantics, so that the thread
+ *                    that stops the trace can read a chunk while its owner is appending. */
+struct ax_trace_chunk
+{
+    ax_trace_span Spans[AX_TRACE_CHUNK_SIZE];
+    std::atomic<uint32_t> Count;
+    std::atomic<ax_trace_chunk *> Next;
+
+    ax_trace_chunk() : Count(0), Next(NULL) {}
+};
+
+/* NOTE(koekeishiya): A buffer only holds spans of the trace it was last written in. The owner
+ *                    clears it on the first span of a new trace, and publishes Generation once
+ *                    it is done. A trace can not start while the previous one is exported, and
+ *                    the export skips a buffer that has not been cleared for its trace yet. */
+struct ax_trace_buffer
+{
+    ax_trace_chunk *Head;
+    ax_trace_chunk *Tail;
+    uint32_t Chunks;
+    std::atomic<uint32_t> Generation;
+    std::atomic<uint64_t> Dropped;
+    uint32_t Thread;
+    const char *Name;
+    std::atomic<bool> Orphaned;
+    ax_trace_buffer *Next;
+
+    ax_trace_buffer() : Head(NULL), Tail(NULL), Chunks(0), Generation(0), Dropped(0),
+                        Thread(0), Name(NULL), Orphaned(false), Next(NULL) {}
+};
+
+std::atomic<bool> AXTraceEnabled(false);
+
+internal std::atomic<uint32_t> TraceGeneration(0);
+internal uint64_t TraceStart;
+internal pthread_mutex_t TraceLock = PTHREAD_MUTEX_INITIALIZER;
+internal ax_trace_buffer *TraceBuffers;
+internal uint32_t TraceThreads;
+
+internal __thread ax_trace_buffer *TraceBuffer;
+internal __thread const char *TraceThreadName;
+internal pthread_key_t TraceBufferKey;
+internal pthread_once_t TraceBufferKeyOnce = PTHREAD_ONCE_INIT;
+
+internal void
+AXLibOrphanTraceBuffer(void *Buffer)
+{
+    ((ax_trace_buffer *) Buffer)->Orphaned.store(true, std::memory_order_release);
+}
+
+internal void
+AXLibCreateTraceBufferKey()
+{
+    pthread_key_create(&TraceBufferKey, AXLibOrphanTraceBuffer);
+}
+
+internal void
+AXLibFreeTraceChunks(ax_trace_chunk *Chunk)
+{
+    while(Chunk)
+    {
+        ax_trace_chunk *Next = Chunk->Next.load(std::memory_order_relaxed);
+        delete Chunk;
+        Chunk = Next;
+    }
+}
+
+internal ax_trace_buffer *
+AXLibGetTraceBuffer()
+{
+    if(!TraceBuffer)
+    {
+        pthread_once(&TraceBufferKeyOnce, AXLibCreateTraceBufferKey);
+        TraceBuffer = new ax_trace_buffer;
+        TraceBuffer->Name = TraceThreadName;
+        TraceBuffer->Head = new ax_trace_chunk;
+        TraceBuffer->Tail = TraceBuffer->Head;
+        TraceBuffer->Chunks = 1;
+
+        pthread_mutex_lock(&TraceLock);
+        TraceBuffer->Thread = ++TraceThreads;
+        TraceBuffer->Next = TraceBuffers;
+        TraceBuffers = TraceBuffer;
+        pthread_mutex_unlock(&TraceLock);
+
+        pthread_setspecific(TraceBufferKey, TraceBuffer);
+    }
+
+    return TraceBuffer;
+}
+
+/* NOTE(koekeishiya): Nanoseconds on the monotonic clock. */
+uint64_t AXLibTraceTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void AXLibSetTraceThreadName(const char *Name)
+{
+    TraceThreadName = Name;
+    if(TraceBuffer)
+        TraceBuffer->Name = Name;
+}
+
+void AXLibAddTraceSpan(const char *Name, const char *Category, uint64_t Start, uint64_t End)
+{
+    ax_trace_buffer *Buffer = AXLibGetTraceBuffer();
+    uint32_t Generation = TraceGeneration.load(std::memory_order_acquire);
+    if(Buffer->Generation.load(std::memory_order_relaxed) != Generation)
+    {
+        AXLibFreeTraceChunks(Buffer->Head->Next.load(std::memory_order_relaxed));
+        Buffer->Head->Next.store(NULL, std::memory_order_relaxed);
+        Buffer->Head->Count.store(0, std::memory_order_relaxed);
+        Buffer->Tail = Buffer->Head;
+        Buffer->Chunks = 1;
+        Buffer->Dropped.store(0, std::memory_order_relaxed);
+        Buffer->Generation.store(Generation, std::memory_order_release);
+    }
+
+    ax_trace_chunk *Chunk = Buffer->Tail;
+    uint32_t Count = Chunk->Count.load(std::memory_order_relaxed);
+    if(Count == AX_TRACE_CHUNK_SIZE)
+    {
+        if(Buffer->Chunks == AX_TRACE_MAX_CHUNKS)
+        {
+            Buffer->Dropped.store(Buffer->Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        Chunk = new ax_trace_chunk;
+        Buffer->Tail->Next.store(Chunk, std::memory_order_release);
+        Buffer->Tail = Chunk;
+        ++Buffer->Chunks;
+        Count = 0;
+    }
+
+    ax_trace_span *Span = &Chunk->Spans[Count];
+    Span->Name = Name;
+    Span->Category = Category;
+    Span->Start = Start;
+    Span->End = End;
+    Chunk->Count.store(Count + 1, std::memory_order_release);
+}
+
+/* NOTE(koekeishiya): Starting a trace discards the spans of the previous one. */
+void AXLibStartTrace()
+{
+    pthread_mutex_lock(&TraceLock);
+    if(!AXLibIsTracing())
+    {
+        TraceStart = AXLibTraceTime();
+        TraceGeneration.store(TraceGeneration.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        AXTraceEnabled.store(true, std::memory_order_release);
+    }
+    pthread_mutex_unlock(&TraceLock);
+}
+
+internal void
+AXLibWriteTraceBuffer(FILE *Handle, ax_trace_buffer *Buffer, bool *First)
+{
+    int PID = getpid();
+    if(Buffer->Name)
+    {
+        fprintf(Handle, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                *First ? "" : ",", PID, Buffer->Thread, Buffer->Name);
+        *First = false;
+    }
+
+    for(ax_trace_chunk *Chunk = Buffer->Head; Chunk; Chunk = Chunk->Next.load(std::memory_order_acquire))
+    {
+        uint32_t Count = Chunk->Count.load(std::memory_order_acquire);
+        for(uint32_t Index = 0; Index < Count; ++Index)
+        {
+            ax_trace_span *Span = &Chunk->Spans[Index];
+            uint64_t Start = Span->Start > TraceStart ? Span->Start - TraceStart : 0;
+            uint64_t Duration = Span->End > Span->Start ? Span->End - Span->Start : 0;
+            fprintf(Handle, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%u}",
+                    *First ? "" : ",", Span->Name, Span->Category,
+                    Start / 1000.0, Duration / 1000.0, PID, Buffer->Thread);
+            *First = false;
+        }
+    }
+
+    uint64_t Dropped = Buffer->Dropped.load(std::memory_order_relaxed);
+    if(Dropped)
+    {
+        fprintf(Handle, "%s\n{\"name\":\"dropped %llu spans\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,\"pid\":%d,\"tid\":%u}",
+                *First ? "" : ",", (unsigned long long) Dropped, PID, Buffer->Thread);
+        *First = false;
+    }
+}
+
+/* NOTE(koekeishiya): Stops the running trace and writes it to File. Buffers of threads that
+ *                    have exited are freed once they have been written. */
+bool AXLibStopTrace(std::string File)
+{
+    pthread_mutex_lock(&TraceLock);
+    if(!AXLibIsTracing())
+    {
+        pthread_mutex_unlock(&TraceLock);
+        return false;
+    }
+
+    AXTraceEnabled.store(false, std::memory_order_release);
+    uint32_t Generation = TraceGeneration.load(std::memory_order_relaxed);
+
+    FILE *Handle = fopen(File.c_str(), "w");
+    if(Handle)
+    {
+        bool First = true;
+        fprintf(Handle, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+        for(ax_trace_buffer *Buffer = TraceBuffers; Buffer; Buffer = Buffer->Next)
+        {
+            if(Buffer->Generation.load(std::memory_order_acquire) == Generation)
+                AXLibWriteTraceBuffer(Handle, Buffer, &First);
+        }
+
+        fprintf(Handle, "\n]}\n");
+        fclose(Handle);
+    }
+
+    ax_trace_buffer **Link = &TraceBuffers;
+    while(*Link)
+    {
+        ax_trace_buffer *Buffer = *Link;
+        if(Buffer->Orphaned.load(std::memory_order_acquire))
+        {
+            *Link = Buffer->Next;
+            AXLibFreeTraceChunks(Buffer->Head);
+            delete Buffer;
+        }
+        else
+        {
+            Link = &Buffer->Next;
+        }
+    }
+
+    pthread_mutex_unlock(&TraceLock);
+    return Handle != NULL;
+}
@@ -0,0 +1,68 @@
+#ifndef AXLIB_TRACE_H
+#define AXLIB_TRACE_H
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+/*
+ * NOTE(koekeishiya):
+ *        Scoped trace spans that are exported as Chrome trace-event JSON, which can be opened
+ *        in chrome://tracing or Perfetto.
+ *
+ *        A span records its name, category and start and end time into a buffer that belongs
+ *        to the calling thread, so no locks are taken while tracing. The name and category must
+ *        outlive the trace; string literals and __FUNCTION__ are what we use.
+ *
+ *        While no trace is running, a span costs a relaxed load and a branch.
+ * */
+
+#define AX_TRACE_CHUNK_SIZE 4096
+#define AX_TRACE_MAX_CHUNKS 256
+
+extern std::atomic<bool> AXTraceEnabled;
+
+inline bool
+AXLibIsTracing()
+{
+    return AXTraceEnabled.load(std::memory_order_relaxed);
+}
+
+uint64_t AXLibTraceTime();
+void AXLibAddTraceSpan(const char *Name, const char *Category, uint64_t Start, uint64_t End);
+void AXLibSetTraceThreadName(const char *Name);
+
+void AXLibStartTrace();
+bool AXLibStopTrace(std::string File);
+
+struct ax_trace_scope
+{
+    const char *Name;
+    const char *Category;
+    uint64_t Start;
+
+    ax_trace_scope(const char *SpanName, const char *SpanCategory) : Name(NULL)
+    {
+        if(AXLibIsTracing())
+        {
+            Name = SpanName;
+            Category = SpanCategory;
+            Start = AXLibTraceTime();
+        }
+    }
+
+    ~ax_trace_scope()
+    {
+        if(Name)
+            AXLibAddTraceSpan(Name, Category, Start, AXLibTraceTime());
+    }
+};
+
+#define AX_TRACE_CONCAT_(A, B) A##B
+#define AX_TRACE_CONCAT(A, B) AX_TRACE_CONCAT_(A, B)
+
+/* NOTE(koekeishiya): Trace the rest of the enclosing scope. */
+#define AXLibTraceScope(Name, Category) ax_trace_scope AX_TRACE_CONCAT(TraceScope, __LINE__)(Name, Category)
+#define AXLibTraceFunction(Category) AXLibTraceScope(__FUNCTION__, Category)
+
+#endif
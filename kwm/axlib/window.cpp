@@ -1,5 +1,14 @@
 #include "window.h"
 #include "element.h"
+#include "axlib.h"
+
+#define internal static
+
+internal inline double
+AXLibMillisecondsSince(CFAbsoluteTime Start)
+{
+    return (CFAbsoluteTimeGetCurrent() - Start) * 1000.0;
+}
 
 ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef WindowRef)
 {
@@ -9,9 +18,6 @@ ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef Wind
     Window->Ref = (AXUIElementRef) CFRetain(WindowRef);
     Window->Application = Application;
     Window->ID = AXLibGetWindowID(Window->Ref);
-    Window->Name = AXLibGetWindowTitle(Window->Ref);
-    Window->Position = AXLibGetWindowPosition(Window->Ref);
-    Window->Size = AXLibGetWindowSize(Window->Ref);
 
     if(AXLibIsWindowMovable(Window->Ref))
         AXLibAddFlags(Window, AXWindow_Movable);
@@ -19,15 +25,328 @@ ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef Wind
     if(AXLibIsWindowResizable(Window->Ref))
         AXLibAddFlags(Window, AXWindow_Resizable);
 
-    if(AXLibIsWindowMinimized(Window->Ref))
-        AXLibAddFlags(Window, AXWindow_Minimized);
-
-    AXLibGetWindowRole(Window->Ref, &Window->Type.Role);
-    AXLibGetWindowSubrole(Window->Ref, &Window->Type.Subrole);
+    /* NOTE(koekeishiya): The title is not loaded here; most windows never have it read. */
+    AXLibLoadWindowAttributes(Window, AXWindowAttribute_Role |
+                                      AXWindowAttribute_Subrole |
+                                      AXWindowAttribute_Position |
+                                      AXWindowAttribute_Size |
+                                      AXWindowAttribute_Minimized);
 
     return Window;
 }
 
+internal CFStringRef
+AXLibWindowAttributeName(uint32_t Attribute)
+{
+    switch(Attribute)
+    {
+        case AXWindowAttribute_Role: return kAXRoleAttribute;
+        case AXWindowAttribute_Subrole: return kAXSubroleAttribute;
+        case AXWindowAttribute_Position: return kAXPositionAttribute;
+        case AXWindowAttribute_Size: return kAXSizeAttribute;
+        case AXWindowAttribute_Minimized: return kAXMinimizedAttribute;
+        case AXWindowAttribute_Title: return kAXTitleAttribute;
+        default: return NULL;
+    }
+}
+
+/* NOTE(koekeishiya): A value that is an AXError, or missing, means the window has no value for the
+                      attribute, unless the application did not answer in time, in which case the
+                      attribute has not been read and Loaded is false. */
+internal inline CFTypeRef
+AXLibValidAttributeValue(CFArrayRef Values, CFIndex Index, bool *Loaded)
+{
+    *Loaded = true;
+    if(Index >= CFArrayGetCount(Values))
+        return NULL;
+
+    CFTypeRef Value = CFArrayGetValueAtIndex(Values, Index);
+    if((Value) &&
+       (CFGetTypeID(Value) == AXValueGetTypeID()) &&
+       (AXValueGetType((AXValueRef) Value) == kAXValueAXErrorType))
+    {
+        AXError Error = kAXErrorSuccess;
+        AXValueGetValue((AXValueRef) Value, kAXValueAXErrorType, &Error);
+        *Loaded = Error != kAXErrorCannotComplete;
+        return NULL;
+    }
+
+    return Value;
+}
+
+internal void
+AXLibStoreWindowAttribute(ax_window *Window, uint32_t Attribute, CFTypeRef Value)
+{
+    switch(Attribute)
+    {
+        case AXWindowAttribute_Role:
+        {
+            if(Window->Type.Role)
+                CFRelease(Window->Type.Role);
+
+            Window->Type.Role = Value ? CFRetain(Value) : NULL;
+        } break;
+        case AXWindowAttribute_Subrole:
+        {
+            if(Window->Type.Subrole)
+                CFRelease(Window->Type.Subrole);
+
+            Window->Type.Subrole = Value ? CFRetain(Value) : NULL;
+        } break;
+        case AXWindowAttribute_Position:
+        {
+            if(Value)
+                AXValueGetValue((AXValueRef) Value, kAXValueCGPointType, &Window->Position);
+
+            AXLibInvalidateWindowDisplay(Window);
+        } break;
+        case AXWindowAttribute_Size:
+        {
+            if(Value)
+                AXValueGetValue((AXValueRef) Value, kAXValueCGSizeType, &Window->Size);
+
+            AXLibInvalidateWindowDisplay(Window);
+        } break;
+        case AXWindowAttribute_Minimized:
+        {
+            /* NOTE(koekeishiya): A window we can not query is treated as minimized. */
+            if(!Value || CFBooleanGetValue((CFBooleanRef) Value))
+                AXLibAddFlags(Window, AXWindow_Minimized);
+            else
+                AXLibClearFlags(Window, AXWindow_Minimized);
+        } break;
+        case AXWindowAttribute_Title:
+        {
+            if(Window->Name)
+                free(Window->Name);
+
+            Window->Name = NULL;
+            if(Value)
+            {
+                Window->Name = CopyCFStringToC((CFStringRef) Value, true);
+                if(!Window->Name)
+                    Window->Name = CopyCFStringToC((CFStringRef) Value, false);
+            }
+        } break;
+    }
+}
+
+/* NOTE(koekeishiya): Every requested attribute that has not been loaded yet is fetched with a single
+                      cross-process request, instead of one blocking request per attribute. When the
+                      request fails the stored values are kept, and the attributes are read again
+                      the next time they are needed. */
+void AXLibLoadWindowAttributes(ax_window *Window, uint32_t Attributes)
+{
+    Attributes &= ~Window->Loaded;
+    if(!Attributes)
+        return;
+
+    uint32_t Requested[AXWindowAttribute_Count];
+    CFStringRef Names[AXWindowAttribute_Count];
+    int Count = 0;
+
+    for(int Index = 0; Index < AXWindowAttribute_Count; ++Index)
+    {
+        uint32_t Attribute = (1 << Index);
+        if(Attributes & Attribute)
+        {
+            Requested[Count] = Attribute;
+            Names[Count++] = AXLibWindowAttributeName(Attribute);
+        }
+    }
+
+    AXError Error;
+    CFAbsoluteTime Start = CFAbsoluteTimeGetCurrent();
+    CFArrayRef Properties = CFArrayCreate(NULL, (const void **) Names, Count, &kCFTypeArrayCallBacks);
+    CFArrayRef Values = AXLibGetWindowProperties(Window->Ref, Properties, &Error);
+    AXLibRecordApplicationLatency(Window->Application, AXLibMillisecondsSince(Start), Error == kAXErrorCannotComplete);
+    CFRelease(Properties);
+
+    if(!Values)
+        return;
+
+    for(int Index = 0; Index < Count; ++Index)
+    {
+        bool Loaded;
+        CFTypeRef Value = AXLibValidAttributeValue(Values, Index, &Loaded);
+        if(Loaded)
+        {
+            AXLibStoreWindowAttribute(Window, Requested[Index], Value);
+            Window->Loaded |= Requested[Index];
+        }
+    }
+
+    CFRelease(Values);
+}
+
+void AXLibRefreshWindowAttributes(ax_window *Window, uint32_t Attributes)
+{
+    Window->Loaded &= ~Attributes;
+    AXLibLoadWindowAttributes(Window, Attributes);
+}
+
+char *AXLibWindowName(ax_window *Window)
+{
+    AXLibLoadWindowAttributes(Window, AXWindowAttribute_Title);
+    return Window->Name;
+}
+
+/* NOTE(koekeishiya): Hands the cached title over to the caller and marks it as not loaded,
+                      so the next AXLibWindowName(..) fetches the current title. */
+char *AXLibTakeWindowName(ax_window *Window)
+{
+    char *Name = Window->Name;
+    Window->Name = NULL;
+    Window->Loaded &= ~AXWindowAttribute_Title;
+    return Name;
+}
+
+internal AX_FRAME_BACKEND_SET(AXLibSetElementFrame)
+{
+    AXLibTraceFunction("ax");
+    AXUIElementRef WindowRef = (AXUIElementRef) Ref;
+    AXError Error = kAXErrorSuccess;
+    if(Frame->HasPosition)
+    {
+        CGPoint Position = CGPointMake(Frame->X, Frame->Y);
+        AXValueRef Value = AXValueCreate(kAXValueCGPointType, &Position);
+        Error = AXLibSetWindowProperty(WindowRef, kAXPositionAttribute, Value);
+        CFRelease(Value);
+    }
+
+    if(Frame->HasSize && Error != kAXErrorCannotComplete)
+    {
+        CGSize Size = CGSizeMake(Frame->Width, Frame->Height);
+        AXValueRef Value = AXValueCreate(kAXValueCGSizeType, &Size);
+        AXError SizeError = AXLibSetWindowProperty(WindowRef, kAXSizeAttribute, Value);
+        if(Error == kAXErrorSuccess)
+            Error = SizeError;
+
+        CFRelease(Value);
+    }
+
+    if(Error == kAXErrorSuccess)
+        return AXFrame_Success;
+
+    return Error == kAXErrorCannotComplete ? AXFrame_TimedOut : AXFrame_Failure;
+}
+
+internal AX_FRAME_BACKEND_GET(AXLibGetElementFrame)
+{
+    AXLibTraceFunction("ax");
+    AXUIElementRef WindowRef = (AXUIElementRef) Ref;
+    AXValueRef PositionRef = (AXValueRef) AXLibGetWindowProperty(WindowRef, kAXPositionAttribute);
+    AXValueRef SizeRef = (AXValueRef) AXLibGetWindowProperty(WindowRef, kAXSizeAttribute);
+
+    CGPoint Position = {};
+    CGSize Size = {};
+    Frame->HasPosition = PositionRef && AXValueGetValue(PositionRef, kAXValueCGPointType, &Position);
+    Frame->HasSize = SizeRef && AXValueGetValue(SizeRef, kAXValueCGSizeType, &Size);
+    Frame->X = Position.x;
+    Frame->Y = Position.y;
+    Frame->Width = Size.width;
+    Frame->Height = Size.height;
+
+    if(PositionRef)
+        CFRelease(PositionRef);
+    if(SizeRef)
+        CFRelease(SizeRef);
+
+    return Frame->HasPosition && Frame->HasSize ? AXFrame_Success : AXFrame_Failure;
+}
+
+internal AX_FRAME_BACKEND_RETAIN(AXLibRetainElement)
+{
+    CFRetain((CFTypeRef) Ref);
+}
+
+internal AX_FRAME_BACKEND_RELEASE(AXLibReleaseElement)
+{
+    CFRelease((CFTypeRef) Ref);
+}
+
+/* NOTE(koekeishiya): Latency measured on an application queue is reported back on the main thread, where
+                      the application is looked up again because it may have terminated in the meantime. */
+internal AX_FRAME_BACKEND_LATENCY(AXLibRecordElementLatency)
+{
+    bool TimedOut = Result == AXFrame_TimedOut;
+    if(!Queued)
+    {
+        AXLibRecordApplicationLatency((ax_application *) Owner, Milliseconds, TimedOut);
+        return;
+    }
+
+    dispatch_async(dispatch_get_main_queue(),
+    ^{
+        ax_application *Application = AXLibGetApplicationByPID(PID);
+        if(Application)
+            AXLibRecordApplicationLatency(Application, Milliseconds, TimedOut);
+    });
+}
+
+internal ax_frame_backend ElementFrameBackend =
+{
+    &AXLibSetElementFrame,
+    &AXLibGetElementFrame,
+    &AXLibRetainElement,
+    &AXLibReleaseElement,
+    &AXLibRecordElementLatency,
+};
+
+void AXLibInitializeFrameBackend()
+{
+    AXLibSetFrameBackend(&ElementFrameBackend);
+}
+
+internal ax_frame_target
+AXLibWindowFrameTarget(ax_window *Window)
+{
+    ax_application *Application = Window->Application;
+
+    ax_frame_target Target = {};
+    Target.Ref = Window->Ref;
+    Target.WindowID = Window->ID;
+    Target.Owner = Application;
+    Target.PID = Application->PID;
+    Target.Queue = Application->Queue;
+    Target.Degraded = AXLibIsApplicationDegraded(Application);
+    return Target;
+}
+
+internal bool
+AXLibUpdateWindowFrame(ax_window *Window, ax_frame *Frame)
+{
+    AXLibTraceFunction("ax");
+    ax_frame_target Target = AXLibWindowFrameTarget(Window);
+    return AXLibSubmitFrame(&Target, Frame);
+}
+
+/* NOTE(koekeishiya): See AXLibReadFrame(..). Inside a batch the callback runs once AXLibEndBatch(..)
+                      returns, so the window may have been destroyed by then and has to be looked up again. */
+void AXLibReadWindowFrame(ax_window *Window, ax_frame_callback *Callback, void *Context)
+{
+    ax_frame_target Target = AXLibWindowFrameTarget(Window);
+    AXLibReadFrame(&Target, Callback, Context);
+}
+
+bool AXLibMoveWindow(ax_window *Window, int X, int Y)
+{
+    ax_frame Frame = {};
+    Frame.HasPosition = true;
+    Frame.X = X;
+    Frame.Y = Y;
+    return AXLibUpdateWindowFrame(Window, &Frame);
+}
+
+bool AXLibResizeWindow(ax_window *Window, int Width, int Height)
+{
+    ax_frame Frame = {};
+    Frame.HasSize = true;
+    Frame.Width = Width;
+    Frame.Height = Height;
+    return AXLibUpdateWindowFrame(Window, &Frame);
+}
+
 bool AXLibIsWindowStandard(ax_window *Window)
 {
     bool Result = ((CFEqual(Window->Type.Role, kAXWindowRole)) &&
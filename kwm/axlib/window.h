@@ -3,6 +3,9 @@
 
 #include <Carbon/Carbon.h>
 
+#include "frame.h"
+#include "placement.h"
+
 enum ax_window_flags
 {
     AXWindow_Movable = (1 << 0),
@@ -14,6 +17,20 @@ enum ax_window_flags
     AXWindow_SizeIntrinsic = (1 << 5),
 };
 
+/* NOTE(koekeishiya): Attributes that are fetched from the application on demand. A bit in
+                      ax_window.Loaded is set once the corresponding attribute has been read. */
+enum ax_window_attributes
+{
+    AXWindowAttribute_Role = (1 << 0),
+    AXWindowAttribute_Subrole = (1 << 1),
+    AXWindowAttribute_Position = (1 << 2),
+    AXWindowAttribute_Size = (1 << 3),
+    AXWindowAttribute_Minimized = (1 << 4),
+    AXWindowAttribute_Title = (1 << 5),
+
+    AXWindowAttribute_Count = 6,
+};
+
 struct ax_window_role
 {
     CFTypeRef Role;
@@ -29,11 +46,14 @@ struct ax_window
     uint32_t ID;
 
     uint32_t Flags;
+    uint32_t Loaded;
     ax_window_role Type;
 
     CGSize Size;
     CGPoint Position;
     char *Name;
+
+    ax_window_placement Placement;
 };
 
 inline bool
@@ -55,9 +75,27 @@ AXLibClearFlags(ax_window *Window, uint32_t Flag)
     Window->Flags &= ~Flag;
 }
 
+/* NOTE(koekeishiya): Must be called whenever Position or Size changes, so that
+                      AXLibWindowDisplay(..) recomputes the display for this window. */
+inline void
+AXLibInvalidateWindowDisplay(ax_window *Window)
+{
+    AXLibInvalidateWindowPlacement(&Window->Placement);
+}
+
 ax_window *AXLibConstructWindow(ax_application *Application, AXUIElementRef WindowRef);
 void AXLibDestroyWindow(ax_window *Window);
 
+void AXLibLoadWindowAttributes(ax_window *Window, uint32_t Attributes);
+void AXLibRefreshWindowAttributes(ax_window *Window, uint32_t Attributes);
+char *AXLibWindowName(ax_window *Window);
+char *AXLibTakeWindowName(ax_window *Window);
+
+bool AXLibMoveWindow(ax_window *Window, int X, int Y);
+bool AXLibResizeWindow(ax_window *Window, int Width, int Height);
+void AXLibReadWindowFrame(ax_window *Window, ax_frame_callback *Callback, void *Context);
+void AXLibInitializeFrameBackend();
+
 bool AXLibIsWindowStandard(ax_window *Window);
 bool AXLibIsWindowCustom(ax_window *Window);
 
@@ -0,0 +1,38 @@
+#include "windowindex.h"
+
+void AXLibInitWindowIndex(ax_window_index *Index)
+{
+    pthread_mutex_init(&Index->Lock, NULL);
+}
+
+ax_window *AXLibLookupWindow(ax_window_index *Index, uint32_t WID)
+{
+    pthread_mutex_lock(&Index->Lock);
+    std::unordered_map<uint32_t, ax_window *>::iterator It = Index->Windows.find(WID);
+    ax_window *Result = It != Index->Windows.end() ? It->second : NULL;
+    pthread_mutex_unlock(&Index->Lock);
+    return Result;
+}
+
+void AXLibInsertWindow(ax_window_index *Index, uint32_t WID, ax_window *Window)
+{
+    pthread_mutex_lock(&Index->Lock);
+    Index->Windows[WID] = Window;
+    pthread_mutex_unlock(&Index->Lock);
+}
+
+/* NOTE(koekeishiya): The id may have been taken over by a newer window already, in which case
+                      the entry is left alone. Returns true if the entry was removed. */
+bool AXLibEraseWindow(ax_window_index *Index, uint32_t WID, ax_window *Window)
+{
+    bool Result = false;
+    pthread_mutex_lock(&Index->Lock);
+    std::unordered_map<uint32_t, ax_window *>::iterator It = Index->Windows.find(WID);
+    if(It != Index->Windows.end() && It->second == Window)
+    {
+        Index->Windows.erase(It);
+        Result = true;
+    }
+    pthread_mutex_unlock(&Index->Lock);
+    return Result;
+}
@@ -0,0 +1,28 @@
+#ifndef AXLIB_WINDOWINDEX_H
+#define AXLIB_WINDOWINDEX_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <unordered_map>
+
+struct ax_window;
+
+/*
+ * NOTE(koekeishiya):
+ *        Maps window ids to the ax_window that owns them, across all applications. Applications
+ *        are initialized concurrently while other threads look up windows, so every access to
+ *        the map goes through the lock. Only the map is protected; the windows are not.
+ * */
+
+struct ax_window_index
+{
+    pthread_mutex_t Lock;
+    std::unordered_map<uint32_t, ax_window *> Windows;
+};
+
+void AXLibInitWindowIndex(ax_window_index *Index);
+ax_window *AXLibLookupWindow(ax_window_index *Index, uint32_t WID);
+void AXLibInsertWindow(ax_window_index *Index, uint32_t WID, ax_window *Window);
+bool AXLibEraseWindow(ax_window_index *Index, uint32_t WID, ax_window *Window);
+
+#endif
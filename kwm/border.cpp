@@ -5,6 +5,7 @@ extern kwm_hotkeys KWMHotkeys;
 
 void UpdateBorder(kwm_border *Border, ax_window *Window)
 {
+    AXLibTraceFunction("border");
     if(Border)
     {
         if(Window)
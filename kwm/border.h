@@ -14,7 +14,7 @@ OpenBorder(kwm_border *Border)
     if(Border->Enabled && !Border->Handle)
     {
         local_persist std::string OverlayBin = KWMPath.FilePath + "/kwm-overlay";
-        DEBUG("Kwm: popen " << OverlayBin);
+        LOG_DEBUG(LogCategory_General, "Kwm: popen " << OverlayBin);
 
         Border->Handle = popen(OverlayBin.c_str(), "w");
         if(!Border->Handle)
@@ -49,6 +49,7 @@ ClearBorder(kwm_border *Border)
 inline void
 RefreshBorder(kwm_border *Border, ax_window *Window)
 {
+    AXLibTraceFunction("border");
     std::string Command = "x:" + std::to_string(Window->Position.x) + \
                           " y:" + std::to_string(Window->Position.y) + \
                           " w:" + std::to_string(Window->Size.width) + \
@@ -0,0 +1,244 @@
+#include "cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define internal static
+
+#ifdef __APPLE__
+#define KWM_STAT_MTIME(Buffer) (Buffer).st_mtimespec
+#else
+#define KWM_STAT_MTIME(Buffer) (Buffer).st_mtim
+#endif
+
+#define KWM_CONFIG_CACHE_MAGIC 0x434d574b
+
+/* NOTE(koekeishiya): The smallest encoding of a cached file and of a cached statement. A count
+ *                    that can not fit in the bytes that are left is rejected before we resize. */
+#define KWM_CONFIG_CACHE_MIN_FILE sizeof(uint32_t)
+#define KWM_CONFIG_CACHE_MIN_STATEMENT (3 * sizeof(uint32_t) + sizeof(uint8_t) + 2 * sizeof(int) + \
+                                        sizeof(config_statement::Values) + sizeof(unsigned int) + \
+                                        2 * sizeof(uint32_t))
+
+uint64_t KwmHashBytes(uint64_t Hash, const void *Data, std::size_t Size)
+{
+    const unsigned char *At = (const unsigned char *) Data;
+    for(std::size_t Index = 0; Index < Size; ++Index)
+    {
+        Hash ^= At[Index];
+        Hash *= 1099511628211ULL;
+    }
+
+    return Hash;
+}
+
+internal char *
+KwmReadConfigContents(int FD, std::size_t Size)
+{
+    char *Contents = (char *) malloc(Size + 1);
+    std::size_t Length = 0;
+    while(Length < Size)
+    {
+        ssize_t Bytes = read(FD, Contents + Length, Size - Length);
+        if(Bytes <= 0)
+            break;
+
+        Length += Bytes;
+    }
+
+    Contents[Length] = '\0';
+    return Contents;
+}
+
+/* NOTE(koekeishiya): Hash the path, mtime, size and contents of a config file. The file is
+ *                    stat'ed before it is read, so an edit made while we read it always
+ *                    leaves a key that no longer matches. Missing files are hashed too,
+ *                    so creating a previously absent include invalidates the cache.
+ *                    The contents are handed back to the caller, who must free them. */
+uint64_t KwmHashConfigFile(uint64_t Hash, std::string File, char **Contents)
+{
+    Hash = KwmHashBytes(Hash, File.c_str(), File.size() + 1);
+    *Contents = NULL;
+
+    int FD = open(File.c_str(), O_RDONLY);
+    struct stat Buffer;
+    if(FD != -1 && fstat(FD, &Buffer) == 0)
+    {
+        Hash = KwmHashBytes(Hash, &KWM_STAT_MTIME(Buffer), sizeof(KWM_STAT_MTIME(Buffer)));
+        Hash = KwmHashBytes(Hash, &Buffer.st_size, sizeof(Buffer.st_size));
+        *Contents = KwmReadConfigContents(FD, Buffer.st_size);
+    }
+
+    if(FD != -1)
+        close(FD);
+
+    if(*Contents)
+        Hash = KwmHashBytes(Hash, *Contents, strlen(*Contents));
+    else
+        Hash = KwmHashBytes(Hash, "", 1);
+
+    return Hash;
+}
+
+internal uint64_t
+KwmHashConfigFiles(std::vector<std::string> &Files)
+{
+    uint64_t Hash = KWM_CONFIG_HASH_SEED;
+    for(std::size_t Index = 0; Index < Files.size(); ++Index)
+    {
+        char *Contents;
+        Hash = KwmHashConfigFile(Hash, Files[Index], &Contents);
+        if(Contents)
+            free(Contents);
+    }
+
+    return Hash;
+}
+
+internal bool
+KwmCacheReadStatement(config_cache_reader *Reader, config_statement *Statement)
+{
+    uint32_t Type, Mode;
+    uint8_t Enabled;
+
+    bool Result = KwmCacheRead(Reader, &Type) &&
+                  KwmCacheRead(Reader, &Statement->Flags) &&
+                  KwmCacheRead(Reader, &Enabled) &&
+                  KwmCacheRead(Reader, &Mode) &&
+                  KwmCacheRead(Reader, &Statement->Display) &&
+                  KwmCacheRead(Reader, &Statement->Space) &&
+                  KwmCacheRead(Reader, &Statement->Values) &&
+                  KwmCacheRead(Reader, &Statement->Color) &&
+                  KwmCacheReadString(Reader, &Statement->Text) &&
+                  KwmCacheReadString(Reader, &Statement->Argument);
+
+    if(!Result || Type > Config_LayoutsPath || Mode > SpaceModeDefault)
+        return false;
+
+    Statement->Type = (config_statement_type) Type;
+    Statement->Mode = (space_tiling_option) Mode;
+    Statement->Enabled = Enabled;
+    return true;
+}
+
+internal bool
+KwmCacheReadConfig(config_cache_reader *Reader, std::string File, std::string Include, kwm_config *Config)
+{
+    uint32_t Magic, Version, FileCount, StatementCount;
+    std::string CachedFile, CachedInclude;
+
+    if((!KwmCacheRead(Reader, &Magic)) || (Magic != KWM_CONFIG_CACHE_MAGIC) ||
+       (!KwmCacheRead(Reader, &Version)) || (Version != KWM_CONFIG_CACHE_VERSION) ||
+       (!KwmCacheReadString(Reader, &CachedFile)) || (CachedFile != File) ||
+       (!KwmCacheReadString(Reader, &CachedInclude)) || (CachedInclude != Include) ||
+       (!KwmCacheRead(Reader, &Config->Hash)) ||
+       (!KwmCacheRead(Reader, &FileCount)) ||
+       (FileCount > (Reader->End - Reader->At) / KWM_CONFIG_CACHE_MIN_FILE))
+        return false;
+
+    Config->Files.resize(FileCount);
+    for(uint32_t Index = 0; Index < FileCount; ++Index)
+    {
+        if(!KwmCacheReadString(Reader, &Config->Files[Index]))
+            return false;
+    }
+
+    if(KwmHashConfigFiles(Config->Files) != Config->Hash)
+        return false;
+
+    if((!KwmCacheRead(Reader, &StatementCount)) ||
+       (StatementCount > (Reader->End - Reader->At) / KWM_CONFIG_CACHE_MIN_STATEMENT))
+        return false;
+
+    Config->Statements.resize(StatementCount);
+    for(uint32_t Index = 0; Index < StatementCount; ++Index)
+    {
+        if(!KwmCacheReadStatement(Reader, &Config->Statements[Index]))
+            return false;
+    }
+
+    return Reader->At == Reader->End;
+}
+
+/* NOTE(koekeishiya): The cache is mapped in one go and decoded in place. A cache that was
+ *                    written by another version, for another config or include directory,
+ *                    or whose files have changed since, is rejected. */
+bool KwmLoadConfigCache(std::string Cache, std::string File, std::string Include, kwm_config *Config)
+{
+    int FD = open(Cache.c_str(), O_RDONLY);
+    if(FD == -1)
+        return false;
+
+    struct stat Buffer;
+    if(fstat(FD, &Buffer) == -1 || Buffer.st_size == 0)
+    {
+        close(FD);
+        return false;
+    }
+
+    void *Data = mmap(NULL, Buffer.st_size, PROT_READ, MAP_PRIVATE, FD, 0);
+    close(FD);
+
+    if(Data == MAP_FAILED)
+        return false;
+
+    config_cache_reader Reader = { (const char *) Data, (const char *) Data + Buffer.st_size };
+    bool Result = KwmCacheReadConfig(&Reader, File, Include, Config);
+    munmap(Data, Buffer.st_size);
+
+    if(!Result)
+    {
+        Config->Statements.clear();
+        Config->Files.clear();
+        Config->Hash = 0;
+    }
+
+    return Result;
+}
+
+/* NOTE(koekeishiya): Written to a temporary file and renamed into place, so a concurrent
+ *                    load never sees a partially written cache. */
+void KwmSaveConfigCache(std::string Cache, std::string File, std::string Include, kwm_config *Config)
+{
+    std::string Buffer;
+    KwmCacheWrite<uint32_t>(Buffer, KWM_CONFIG_CACHE_MAGIC);
+    KwmCacheWrite<uint32_t>(Buffer, KWM_CONFIG_CACHE_VERSION);
+    KwmCacheWriteString(Buffer, File);
+    KwmCacheWriteString(Buffer, Include);
+    KwmCacheWrite<uint64_t>(Buffer, Config->Hash);
+
+    KwmCacheWrite<uint32_t>(Buffer, Config->Files.size());
+    for(std::size_t Index = 0; Index < Config->Files.size(); ++Index)
+        KwmCacheWriteString(Buffer, Config->Files[Index]);
+
+    KwmCacheWrite<uint32_t>(Buffer, Config->Statements.size());
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        config_statement *Statement = &Config->Statements[Index];
+        KwmCacheWrite<uint32_t>(Buffer, Statement->Type);
+        KwmCacheWrite<uint32_t>(Buffer, Statement->Flags);
+        KwmCacheWrite<uint8_t>(Buffer, Statement->Enabled);
+        KwmCacheWrite<uint32_t>(Buffer, Statement->Mode);
+        KwmCacheWrite<int>(Buffer, Statement->Display);
+        KwmCacheWrite<int>(Buffer, Statement->Space);
+        Buffer.append((const char *) Statement->Values, sizeof(Statement->Values));
+        KwmCacheWrite<unsigned int>(Buffer, Statement->Color);
+        KwmCacheWriteString(Buffer, Statement->Text);
+        KwmCacheWriteString(Buffer, Statement->Argument);
+    }
+
+    std::string Temporary = Cache + ".tmp";
+    FILE *Handle = fopen(Temporary.c_str(), "wb");
+    if(!Handle)
+        return;
+
+    bool Written = fwrite(Buffer.data(), Buffer.size(), 1, Handle) == 1;
+    Written = (fclose(Handle) == 0) && Written;
+
+    if(!Written || rename(Temporary.c_str(), Cache.c_str()) != 0)
+        unlink(Temporary.c_str());
+}
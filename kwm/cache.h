@@ -0,0 +1,60 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "statement.h"
+
+#include <string.h>
+
+/* NOTE(koekeishiya): Bump whenever config_statement or the cache layout changes. */
+#define KWM_CONFIG_CACHE_VERSION 3
+#define KWM_CONFIG_HASH_SEED 14695981039346656037ULL
+
+/* NOTE(koekeishiya): Helpers for the flat binary files kwm keeps next to its config. */
+struct config_cache_reader
+{
+    const char *At;
+    const char *End;
+};
+
+template<typename T> inline void
+KwmCacheWrite(std::string &Buffer, T Value)
+{
+    Buffer.append((const char *) &Value, sizeof(T));
+}
+
+inline void
+KwmCacheWriteString(std::string &Buffer, const std::string &Text)
+{
+    KwmCacheWrite<uint32_t>(Buffer, Text.size());
+    Buffer.append(Text);
+}
+
+template<typename T> inline bool
+KwmCacheRead(config_cache_reader *Reader, T *Value)
+{
+    if(Reader->End - Reader->At < (std::ptrdiff_t) sizeof(T))
+        return false;
+
+    memcpy(Value, Reader->At, sizeof(T));
+    Reader->At += sizeof(T);
+    return true;
+}
+
+inline bool
+KwmCacheReadString(config_cache_reader *Reader, std::string *Text)
+{
+    uint32_t Size;
+    if(!KwmCacheRead(Reader, &Size) || (uint32_t) (Reader->End - Reader->At) < Size)
+        return false;
+
+    Text->assign(Reader->At, Size);
+    Reader->At += Size;
+    return true;
+}
+
+uint64_t KwmHashBytes(uint64_t Hash, const void *Data, std::size_t Size);
+uint64_t KwmHashConfigFile(uint64_t Hash, std::string File, char **Contents);
+bool KwmLoadConfigCache(std::string Cache, std::string File, std::string Include, kwm_config *Config);
+void KwmSaveConfigCache(std::string Cache, std::string File, std::string Include, kwm_config *Config);
+
+#endif
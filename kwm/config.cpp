@@ -1,15 +1,34 @@
 #include "config.h"
-#include "tokenizer.h"
-#include "interpreter.h"
+#include "configdiff.h"
+#include "lexer.h"
+#include "cache.h"
+#include "display.h"
+#include "space.h"
+#include "border.h"
 #include "rules.h"
 #include "helpers.h"
 #include "keys.h"
+#include "launcher.h"
+#include "axlib/axlib.h"
+
+#include <fcntl.h>
 
 #define internal static
 
+extern ax_application *FocusedApplication;
 extern kwm_path KWMPath;
 extern kwm_settings KWMSettings;
 extern kwm_hotkeys KWMHotkeys;
+extern kwm_metrics KWMMetrics;
+extern kwm_border FocusedBorder;
+extern kwm_border MarkedBorder;
+
+#define KWM_CONFIG_WATCH_DEBOUNCE 0.25
+
+internal kwm_config LiveConfig = {};
+internal bool ConfigWatchEnabled = false;
+internal std::vector<dispatch_source_t> ConfigWatchSources;
+internal uint64_t ConfigWatchGeneration = 0;
 
 internal inline void
 ReportInvalidCommand(std::string Command)
@@ -17,473 +36,282 @@ ReportInvalidCommand(std::string Command)
     std::cerr << "Parse error: " << Command << std::endl;
 }
 
-internal void
-KwmParseConfigOptionTiling(tokenizer *Tokenizer)
+internal bool
+KwmParseTilingMode(token Token, space_tiling_option *Mode)
 {
-    token Token = GetToken(Tokenizer);
     if(TokenEquals(Token, "bsp"))
-        KwmInterpretCommand("config tiling bsp", 0);
+        *Mode = SpaceModeBSP;
     else if(TokenEquals(Token, "monocle"))
-        KwmInterpretCommand("config tiling monocle", 0);
+        *Mode = SpaceModeMonocle;
     else if(TokenEquals(Token, "float"))
-        KwmInterpretCommand("config tiling float", 0);
+        *Mode = SpaceModeFloating;
     else
-        ReportInvalidCommand("Unknown command 'config tiling " + std::string(Token.Text, Token.TextLength) + "'");
-}
+        return false;
 
-internal void
-KwmParseConfigOptionHotkeys(tokenizer *Tokenizer)
-{
-    token Token = GetToken(Tokenizer);
-    if(TokenEquals(Token, "on"))
-        KwmInterpretCommand("config hotkeys on", 0);
-    else if(TokenEquals(Token, "off"))
-        KwmInterpretCommand("config hotkeys off", 0);
-    else
-        ReportInvalidCommand("Unknown command 'config hotkeys " + std::string(Token.Text, Token.TextLength) + "'");
+    return true;
 }
 
-internal void
-KwmParseConfigOptionPadding(tokenizer *Tokenizer)
+/* NOTE(koekeishiya): Consume the '-word' parts of a dashed option name, e.g. the
+ *                    '-follows-mouse' of 'focus-follows-mouse'. Command is extended
+ *                    with every part that matched. */
+internal bool
+KwmParseConfigName(config_lexer *Lexer, std::string &Command, const char *First, const char *Second)
 {
-    bool IsValid = true;
-    token TokenTop = GetToken(Tokenizer);
-    token TokenBottom = GetToken(Tokenizer);
-    token TokenLeft = GetToken(Tokenizer);
-    token TokenRight = GetToken(Tokenizer);
-
-    if(TokenTop.Type != Token_Digit)
-    {
-        ReportInvalidCommand("Unknown config padding top value '" + std::string(TokenTop.Text, TokenTop.TextLength) + "'");
-        IsValid = false;
-    }
-    if(TokenBottom.Type != Token_Digit)
-    {
-        ReportInvalidCommand("Unknown config padding bottom value '" + std::string(TokenBottom.Text, TokenBottom.TextLength) + "'");
-        IsValid = false;
-    }
-    if(TokenLeft.Type != Token_Digit)
+    const char *Parts[] = { First, Second };
+    for(int Index = 0; Index < 2 && Parts[Index]; ++Index)
     {
-        ReportInvalidCommand("Unknown config padding left value '" + std::string(TokenLeft.Text, TokenLeft.TextLength) + "'");
-        IsValid = false;
-    }
-    if(TokenRight.Type != Token_Digit)
-    {
-        ReportInvalidCommand("Unknown config padding right value '" + std::string(TokenRight.Text, TokenRight.TextLength) + "'");
-        IsValid = false;
-    }
+        if(!KwmRequireConfigToken(Lexer, Token_Dash))
+        {
+            ReportInvalidCommand("Expected token '-' after '" + Command + "'");
+            return false;
+        }
 
-    if(IsValid)
-    {
-        KwmInterpretCommand("config padding " + std::string(TokenTop.Text, TokenTop.TextLength) +
-                            " " + std::string(TokenBottom.Text, TokenBottom.TextLength) +
-                            " " + std::string(TokenLeft.Text, TokenLeft.TextLength) +
-                            " " + std::string(TokenRight.Text, TokenRight.TextLength), 0);
+        token Token = KwmConfigToken(Lexer);
+        if(!TokenEquals(Token, Parts[Index]))
+        {
+            ReportInvalidCommand("Unknown command '" + Command + "-" + std::string(Token.Text, Token.TextLength) + "'");
+            return false;
+        }
+
+        Command += "-" + std::string(Parts[Index]);
     }
+
+    return true;
 }
 
 internal void
-KwmParseConfigOptionGap(tokenizer *Tokenizer)
+KwmParseConfigOptionToggle(config_lexer *Lexer, kwm_config *Config, config_statement_type Type,
+                           std::string Command, const char *First = NULL, const char *Second = NULL)
 {
-    bool IsValid = true;
-    token TokenVertical = GetToken(Tokenizer);
-    token TokenHorizontal = GetToken(Tokenizer);
+    if(!KwmParseConfigName(Lexer, Command, First, Second))
+        return;
 
-    if(TokenVertical.Type != Token_Digit)
+    token Token = KwmConfigToken(Lexer);
+    if((TokenEquals(Token, "on")) || (TokenEquals(Token, "off")))
     {
-        ReportInvalidCommand("Unknown config gap vertical value '" + std::string(TokenVertical.Text, TokenVertical.TextLength) + "'");
-        IsValid = false;
+        config_statement Statement = {};
+        Statement.Type = Type;
+        Statement.Enabled = TokenEquals(Token, "on");
+        Config->Statements.push_back(Statement);
     }
-    if(TokenHorizontal.Type != Token_Digit)
-    {
-        ReportInvalidCommand("Unknown config gap horizontal value '" + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength) + "'");
-        IsValid = false;
-    }
-
-    if(IsValid)
+    else
     {
-        KwmInterpretCommand("config gap " + std::string(TokenVertical.Text, TokenVertical.TextLength) +
-                            " " + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength), 0);
+        ReportInvalidCommand("Unknown command '" + Command + " " + std::string(Token.Text, Token.TextLength) + "'");
     }
 }
 
 internal void
-KwmParseConfigOptionFocusFollowsMouse(tokenizer *Tokenizer)
+KwmParseConfigOptionRatio(config_lexer *Lexer, kwm_config *Config, config_statement_type Type, std::string Command)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
+    if(!KwmParseConfigName(Lexer, Command, "ratio", NULL))
+        return;
+
+    token Token = KwmConfigToken(Lexer);
+    if(Token.Type == Token_Digit)
     {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "follows"))
-        {
-            if(RequireToken(Tokenizer, Token_Dash))
-            {
-                token Token = GetToken(Tokenizer);
-                if(TokenEquals(Token, "mouse"))
-                {
-                    token Token = GetToken(Tokenizer);
-                    if(TokenEquals(Token, "on"))
-                        KwmInterpretCommand("config focus-follows-mouse on", 0);
-                    else if(TokenEquals(Token, "off"))
-                        KwmInterpretCommand("config focus-follows-mouse off", 0);
-                    else
-                        ReportInvalidCommand("Unknown command 'config focus-follows-mouse " + std::string(Token.Text, Token.TextLength) + "'");
-                }
-                else
-                    ReportInvalidCommand("Unknown command 'config focus-follows-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
-        {
-            ReportInvalidCommand("Unknown command 'config focus-" + std::string(Token.Text, Token.TextLength) + "'");
-        }
+        config_statement Statement = {};
+        Statement.Type = Type;
+        Statement.Values[0] = ConvertStringToDouble(std::string(Token.Text, Token.TextLength));
+        Config->Statements.push_back(Statement);
     }
     else
     {
-        ReportInvalidCommand("Expected token '-' after 'config focus'");
+        ReportInvalidCommand("Unknown command '" + Command + " " + std::string(Token.Text, Token.TextLength) + "'");
     }
 }
 
-internal void
-KwmParseConfigOptionMouseFollowsFocus(tokenizer *Tokenizer)
+internal bool
+KwmParseConfigPadding(config_lexer *Lexer, config_statement *Statement)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
+    bool IsValid = true;
+    const char *Names[] = { "top", "bottom", "left", "right" };
+    for(int Index = 0; Index < 4; ++Index)
     {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "follows"))
-        {
-            if(RequireToken(Tokenizer, Token_Dash))
-            {
-                token Token = GetToken(Tokenizer);
-                if(TokenEquals(Token, "focus"))
-                {
-                    token Token = GetToken(Tokenizer);
-                    if(TokenEquals(Token, "on"))
-                        KwmInterpretCommand("config mouse-follows-focus on", 0);
-                    else if(TokenEquals(Token, "off"))
-                        KwmInterpretCommand("config mouse-follows-focus off", 0);
-                    else
-                        ReportInvalidCommand("Unknown command 'config mouse-follows-focus " + std::string(Token.Text, Token.TextLength) + "'");
-                }
-                else
-                    ReportInvalidCommand("Unknown command 'config mouse-follows-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
+        token Token = KwmConfigToken(Lexer);
+        std::string Value(Token.Text, Token.TextLength);
+        if(Token.Type != Token_Digit)
         {
-            ReportInvalidCommand("Unknown command 'config mouse-" + std::string(Token.Text, Token.TextLength) + "'");
+            ReportInvalidCommand("Unknown config padding " + std::string(Names[Index]) + " value '" + Value + "'");
+            IsValid = false;
         }
+
+        Statement->Values[Index] = ConvertStringToDouble(Value);
     }
-    else
-    {
-        ReportInvalidCommand("Expected token '-' after 'config mouse'");
-    }
+
+    return IsValid;
 }
 
-internal void
-KwmParseConfigOptionStandbyOnFloat(tokenizer *Tokenizer)
+internal bool
+KwmParseConfigGap(config_lexer *Lexer, config_statement *Statement)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
+    bool IsValid = true;
+    const char *Names[] = { "vertical", "horizontal" };
+    for(int Index = 0; Index < 2; ++Index)
     {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "on"))
+        token Token = KwmConfigToken(Lexer);
+        std::string Value(Token.Text, Token.TextLength);
+        if(Token.Type != Token_Digit)
         {
-            if(RequireToken(Tokenizer, Token_Dash))
-            {
-                token Token = GetToken(Tokenizer);
-                if(TokenEquals(Token, "float"))
-                {
-                    token Token = GetToken(Tokenizer);
-                    if(TokenEquals(Token, "on"))
-                        KwmInterpretCommand("config standby-on-float on", 0);
-                    else if(TokenEquals(Token, "off"))
-                        KwmInterpretCommand("config standby-on-float off", 0);
-                    else
-                        ReportInvalidCommand("Unknown command 'config standby-on-float " + std::string(Token.Text, Token.TextLength) + "'");
-                }
-                else
-                    ReportInvalidCommand("Unknown command 'config standby-on-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
-        {
-            ReportInvalidCommand("Unknown command 'config standby-" + std::string(Token.Text, Token.TextLength) + "'");
+            ReportInvalidCommand("Unknown config gap " + std::string(Names[Index]) + " value '" + Value + "'");
+            IsValid = false;
         }
+
+        Statement->Values[Index] = ConvertStringToDouble(Value);
     }
-    else
-    {
-        ReportInvalidCommand("Expected token '-' after 'config standby'");
-    }
+
+    return IsValid;
 }
 
 internal void
-KwmParseConfigOptionCenterOnFloat(tokenizer *Tokenizer)
+KwmParseConfigOptionTiling(config_lexer *Lexer, kwm_config *Config)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
-    {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "on"))
-        {
-            if(RequireToken(Tokenizer, Token_Dash))
-            {
-                token Token = GetToken(Tokenizer);
-                if(TokenEquals(Token, "float"))
-                {
-                    token Token = GetToken(Tokenizer);
-                    if(TokenEquals(Token, "on"))
-                        KwmInterpretCommand("config center-on-float on", 0);
-                    else if(TokenEquals(Token, "off"))
-                        KwmInterpretCommand("config center-on-float off", 0);
-                    else
-                        ReportInvalidCommand("Unknown command 'config center-on-float " + std::string(Token.Text, Token.TextLength) + "'");
-                }
-                else
-                    ReportInvalidCommand("Unknown command 'config center-on-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
-        {
-            ReportInvalidCommand("Unknown command 'config center-" + std::string(Token.Text, Token.TextLength) + "'");
-        }
-    }
+    token Token = KwmConfigToken(Lexer);
+    config_statement Statement = {};
+    Statement.Type = Config_Tiling;
+    if(KwmParseTilingMode(Token, &Statement.Mode))
+        Config->Statements.push_back(Statement);
     else
-    {
-        ReportInvalidCommand("Expected token '-' after 'config center'");
-    }
+        ReportInvalidCommand("Unknown command 'config tiling " + std::string(Token.Text, Token.TextLength) + "'");
 }
 
 internal void
-KwmParseConfigOptionFloatNonResizable(tokenizer *Tokenizer)
+KwmParseConfigOptionPadding(config_lexer *Lexer, kwm_config *Config)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
-    {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "non"))
-        {
-            if(RequireToken(Tokenizer, Token_Dash))
-            {
-                token Token = GetToken(Tokenizer);
-                if(TokenEquals(Token, "resizable"))
-                {
-                    token Token = GetToken(Tokenizer);
-                    if(TokenEquals(Token, "on"))
-                        KwmInterpretCommand("config float-non-resizable on", 0);
-                    else if(TokenEquals(Token, "off"))
-                        KwmInterpretCommand("config float-non-resizable off", 0);
-                    else
-                        ReportInvalidCommand("Unknown command 'config float-non-resizable " + std::string(Token.Text, Token.TextLength) + "'");
-                }
-                else
-                    ReportInvalidCommand("Unknown command 'config float-non-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
-        {
-            ReportInvalidCommand("Unknown command 'config float-" + std::string(Token.Text, Token.TextLength) + "'");
-        }
-    }
-    else
-    {
-        ReportInvalidCommand("Expected token '-' after 'config float'");
-    }
+    config_statement Statement = {};
+    Statement.Type = Config_Padding;
+    if(KwmParseConfigPadding(Lexer, &Statement))
+        Config->Statements.push_back(Statement);
 }
 
 internal void
-KwmParseConfigOptionLockToContainer(tokenizer *Tokenizer)
+KwmParseConfigOptionGap(config_lexer *Lexer, kwm_config *Config)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
-    {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "to"))
-        {
-            if(RequireToken(Tokenizer, Token_Dash))
-            {
-                token Token = GetToken(Tokenizer);
-                if(TokenEquals(Token, "container"))
-                {
-                    token Token = GetToken(Tokenizer);
-                    if(TokenEquals(Token, "on"))
-                        KwmInterpretCommand("config lock-to-container on", 0);
-                    else if(TokenEquals(Token, "off"))
-                        KwmInterpretCommand("config lock-to-container off", 0);
-                    else
-                        ReportInvalidCommand("Unknown command 'config lock-to-container " + std::string(Token.Text, Token.TextLength) + "'");
-                }
-                else
-                    ReportInvalidCommand("Unknown command 'config lock-to-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
-        {
-            ReportInvalidCommand("Unknown command 'config lock-" + std::string(Token.Text, Token.TextLength) + "'");
-        }
-    }
-    else
-    {
-        ReportInvalidCommand("Expected token '-' after 'config lock'");
-    }
+    config_statement Statement = {};
+    Statement.Type = Config_Gap;
+    if(KwmParseConfigGap(Lexer, &Statement))
+        Config->Statements.push_back(Statement);
 }
 
 internal void
-KwmParseConfigOptionCycleFocus(tokenizer *Tokenizer)
+KwmParseConfigOptionSpawn(config_lexer *Lexer, kwm_config *Config)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
+    token Token = KwmConfigToken(Lexer);
+    if((TokenEquals(Token, "left")) || (TokenEquals(Token, "right")))
     {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "focus"))
-        {
-            token Token = GetToken(Tokenizer);
-            if(TokenEquals(Token, "on"))
-                KwmInterpretCommand("config cycle-focus on", 0);
-            else if(TokenEquals(Token, "off"))
-                KwmInterpretCommand("config cycle-focus off", 0);
-            else
-                ReportInvalidCommand("Unknown command 'config cycle-focus " + std::string(Token.Text, Token.TextLength) + "'");
-        }
-        else
-            ReportInvalidCommand("Unknown command 'config cycle-" + std::string(Token.Text, Token.TextLength) + "'");
+        config_statement Statement = {};
+        Statement.Type = Config_Spawn;
+        Statement.Enabled = TokenEquals(Token, "left");
+        Config->Statements.push_back(Statement);
     }
     else
     {
-        ReportInvalidCommand("Expected token '-' after 'config cycle'");
+        ReportInvalidCommand("Unknown command 'config spawn " + std::string(Token.Text, Token.TextLength) + "'");
     }
 }
 
+/* NOTE(koekeishiya): 'config log-level <level>' and 'config log-category <category> on|off'. */
 internal void
-KwmParseConfigOptionSplitRatio(tokenizer *Tokenizer)
+KwmParseConfigOptionLog(config_lexer *Lexer, kwm_config *Config)
 {
-    if(RequireToken(Tokenizer, Token_Dash))
+    if(!KwmRequireConfigToken(Lexer, Token_Dash))
+    {
+        ReportInvalidCommand("Expected token '-' after 'config log'");
+        return;
+    }
+
+    token TokenOption = KwmConfigToken(Lexer);
+    token Token = KwmConfigToken(Lexer);
+    std::string Name(Token.Text, Token.TextLength);
+
+    config_statement Statement = {};
+    if(TokenEquals(TokenOption, "level"))
     {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "ratio"))
+        kwm_log_level Level;
+        if(KwmParseLogLevel(Name, &Level))
         {
-            token Token = GetToken(Tokenizer);
-            switch(Token.Type)
-            {
-                case Token_Digit:
-                {
-                    KwmInterpretCommand("config split-ratio " + std::string(Token.Text, Token.TextLength), 0);
-                } break;
-                default:
-                {
-                    ReportInvalidCommand("Unknown command 'config split-ratio " + std::string(Token.Text, Token.TextLength) + "'");
-                } break;
-            }
+            Statement.Type = Config_LogLevel;
+            Statement.Values[0] = Level;
+            Config->Statements.push_back(Statement);
         }
         else
-            ReportInvalidCommand("Unknown command 'config split-" + std::string(Token.Text, Token.TextLength) + "'");
-    }
-    else
-    {
-        ReportInvalidCommand("Expected token '-' after 'config cycle'");
+        {
+            ReportInvalidCommand("Unknown command 'config log-level " + Name + "'");
+        }
     }
-}
-
-internal void
-KwmParseConfigOptionOptimalRatio(tokenizer *Tokenizer)
-{
-    if(RequireToken(Tokenizer, Token_Dash))
+    else if(TokenEquals(TokenOption, "category"))
     {
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "ratio"))
+        uint32_t Category = KwmParseLogCategory(Name);
+        token TokenState = KwmConfigToken(Lexer);
+        if(Category && ((TokenEquals(TokenState, "on")) || (TokenEquals(TokenState, "off"))))
         {
-            token Token = GetToken(Tokenizer);
-            switch(Token.Type)
-            {
-                case Token_Digit:
-                {
-                    KwmInterpretCommand("config optimal-ratio " + std::string(Token.Text, Token.TextLength), 0);
-                } break;
-                default:
-                {
-                    ReportInvalidCommand("Unknown command 'config optimal-ratio " + std::string(Token.Text, Token.TextLength) + "'");
-                } break;
-            }
+            Statement.Type = Config_LogCategory;
+            Statement.Values[0] = Category;
+            Statement.Enabled = TokenEquals(TokenState, "on");
+            Config->Statements.push_back(Statement);
         }
         else
-            ReportInvalidCommand("Unknown command 'config optimal-" + std::string(Token.Text, Token.TextLength) + "'");
+        {
+            ReportInvalidCommand("Unknown command 'config log-category " + Name + " " + std::string(TokenState.Text, TokenState.TextLength) + "'");
+        }
     }
     else
     {
-        ReportInvalidCommand("Expected token '-' after 'config optimal'");
+        ReportInvalidCommand("Unknown command 'config log-" + std::string(TokenOption.Text, TokenOption.TextLength) + "'");
     }
 }
 
 internal void
-KwmParseConfigOptionSpawn(tokenizer *Tokenizer)
+KwmParseConfigOptionBorder(config_lexer *Lexer, kwm_config *Config)
 {
-    token Token = GetToken(Tokenizer);
-    if(TokenEquals(Token, "left"))
-        KwmInterpretCommand("config spawn left", 0);
-    else if(TokenEquals(Token, "right"))
-        KwmInterpretCommand("config spawn right", 0);
-    else
-        ReportInvalidCommand("Unknown command 'config spawn " + std::string(Token.Text, Token.TextLength) + "'");
-}
+    token TokenBorder = KwmConfigToken(Lexer);
+    if((!TokenEquals(TokenBorder, "focused")) &&
+       (!TokenEquals(TokenBorder, "marked")))
+    {
+        ReportInvalidCommand("Unknown command 'config border " + std::string(TokenBorder.Text, TokenBorder.TextLength) + "'");
+        return;
+    }
 
-internal void
-KwmParseConfigOptionBorder(tokenizer *Tokenizer)
-{
-    token TokenBorder = GetToken(Tokenizer);
-    if((TokenEquals(TokenBorder, "focused")) ||
-       (TokenEquals(TokenBorder, "marked")))
+    std::string BorderType(TokenBorder.Text, TokenBorder.TextLength);
+    config_statement Statement = {};
+    if(TokenEquals(TokenBorder, "marked"))
+        Statement.Flags |= ConfigFlag_MarkedBorder;
+
+    token Token = KwmConfigToken(Lexer);
+    if((TokenEquals(Token, "on")) || (TokenEquals(Token, "off")))
     {
-        std::string BorderType(TokenBorder.Text, TokenBorder.TextLength);
-        token Token = GetToken(Tokenizer);
-        if(TokenEquals(Token, "on"))
-            KwmInterpretCommand("config border " + BorderType + " on", 0);
-        else if(TokenEquals(Token, "off"))
-            KwmInterpretCommand("config border " + BorderType + " off", 0);
-        else if(TokenEquals(Token, "size"))
+        Statement.Type = Config_BorderEnabled;
+        Statement.Enabled = TokenEquals(Token, "on");
+        Config->Statements.push_back(Statement);
+    }
+    else if((TokenEquals(Token, "size")) || (TokenEquals(Token, "radius")))
+    {
+        std::string Property(Token.Text, Token.TextLength);
+        token Token = KwmConfigToken(Lexer);
+        std::string Value(Token.Text, Token.TextLength);
+        if(Token.Type == Token_Digit)
         {
-            token Token = GetToken(Tokenizer);
-            switch(Token.Type)
-            {
-                case Token_Digit:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    KwmInterpretCommand("config border " + BorderType + " size " + BorderSize, 0);
-                } break;
-                default:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    ReportInvalidCommand("Unknown command 'config border " + BorderType + " size " + BorderSize + "'");
-                } break;
-            }
+            Statement.Type = Property == "size" ? Config_BorderSize : Config_BorderRadius;
+            Statement.Values[0] = ConvertStringToDouble(Value);
+            Config->Statements.push_back(Statement);
         }
-        else if(TokenEquals(Token, "radius"))
-        {
-            token Token = GetToken(Tokenizer);
-            switch(Token.Type)
-            {
-                case Token_Digit:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    KwmInterpretCommand("config border " + BorderType + " radius " + BorderSize, 0);
-                } break;
-                default:
-                {
-                    std::string BorderSize(Token.Text, Token.TextLength);
-                    ReportInvalidCommand("Unknown command 'config border " + BorderType + " radius " + BorderSize + "'");
-                } break;
-            }
-        }
-        else if(TokenEquals(Token, "color"))
+        else
         {
-            token Token = GetToken(Tokenizer);
-            std::string BorderColor(Token.Text, Token.TextLength);
-            KwmInterpretCommand("config border " + BorderType + " color " + BorderColor, 0);
+            ReportInvalidCommand("Unknown command 'config border " + BorderType + " " + Property + " " + Value + "'");
         }
     }
-    else
+    else if(TokenEquals(Token, "color"))
     {
-        ReportInvalidCommand("Unknown command 'config border " + std::string(TokenBorder.Text, TokenBorder.TextLength) + "'");
+        token Token = KwmConfigToken(Lexer);
+        Statement.Type = Config_BorderColor;
+        Statement.Color = ConvertHexStringToInt(std::string(Token.Text, Token.TextLength));
+        Config->Statements.push_back(Statement);
     }
 }
 
 internal void
-KwmParseConfigOptionSpace(tokenizer *Tokenizer)
+KwmParseConfigOptionSpace(config_lexer *Lexer, kwm_config *Config)
 {
-    token TokenDisplay = GetToken(Tokenizer);
+    token TokenDisplay = KwmConfigToken(Lexer);
     std::string Display(TokenDisplay.Text, TokenDisplay.TextLength);
     if(TokenDisplay.Type != Token_Digit)
     {
@@ -491,7 +319,7 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
         return;
     }
 
-    token TokenSpace = GetToken(Tokenizer);
+    token TokenSpace = KwmConfigToken(Lexer);
     std::string Space(TokenSpace.Text, TokenSpace.TextLength);
     if(TokenSpace.Type != Token_Digit)
     {
@@ -499,87 +327,38 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
         return;
     }
 
-    token Token = GetToken(Tokenizer);
+    config_statement Statement = {};
+    Statement.Display = ConvertStringToInt(Display);
+    Statement.Space = ConvertStringToInt(Space);
+
+    token Token = KwmConfigToken(Lexer);
     if(TokenEquals(Token, "mode"))
     {
-        token Token = GetToken(Tokenizer);
-        std::string Mode(Token.Text, Token.TextLength);
-        if((TokenEquals(Token, "bsp")) || (TokenEquals(Token, "monocle")) || (TokenEquals(Token, "float")))
-            KwmInterpretCommand("config space " + Display + " " + Space + " mode " + Mode, 0);
+        token Token = KwmConfigToken(Lexer);
+        Statement.Type = Config_SpaceMode;
+        if(KwmParseTilingMode(Token, &Statement.Mode))
+            Config->Statements.push_back(Statement);
         else
-            ReportInvalidCommand("Unknown command 'config space " + Display + " " + Space + " mode " + Mode + "'");
+            ReportInvalidCommand("Unknown command 'config space " + Display + " " + Space + " mode " + std::string(Token.Text, Token.TextLength) + "'");
     }
     else if(TokenEquals(Token, "padding"))
     {
-        bool IsValid = true;
-        token TokenTop = GetToken(Tokenizer);
-        token TokenBottom = GetToken(Tokenizer);
-        token TokenLeft = GetToken(Tokenizer);
-        token TokenRight = GetToken(Tokenizer);
-
-        if(TokenTop.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding top value '" + std::string(TokenTop.Text, TokenTop.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenBottom.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding bottom value '" + std::string(TokenBottom.Text, TokenBottom.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenLeft.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding left value '" + std::string(TokenLeft.Text, TokenLeft.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenRight.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding right value '" + std::string(TokenRight.Text, TokenRight.TextLength) + "'");
-            IsValid = false;
-        }
-
-        if(IsValid)
-        {
-            KwmInterpretCommand("config space " + Display + " " + Space +
-                    " padding " + std::string(TokenTop.Text, TokenTop.TextLength) +
-                    " " + std::string(TokenBottom.Text, TokenBottom.TextLength) +
-                    " " + std::string(TokenLeft.Text, TokenLeft.TextLength) +
-                    " " + std::string(TokenRight.Text, TokenRight.TextLength), 0);
-        }
+        Statement.Type = Config_SpacePadding;
+        if(KwmParseConfigPadding(Lexer, &Statement))
+            Config->Statements.push_back(Statement);
     }
     else if(TokenEquals(Token, "gap"))
     {
-        bool IsValid = true;
-        token TokenVertical = GetToken(Tokenizer);
-        token TokenHorizontal = GetToken(Tokenizer);
-
-        if(TokenVertical.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config gap vertical value '" + std::string(TokenVertical.Text, TokenVertical.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenHorizontal.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config gap horizontal value '" + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength) + "'");
-            IsValid = false;
-        }
-
-        if(IsValid)
-        {
-            KwmInterpretCommand("config space " + Display + " " + Space +
-                    " gap " + std::string(TokenVertical.Text, TokenVertical.TextLength) +
-                    " " + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength), 0);
-        }
-    }
-    else if(TokenEquals(Token, "name"))
-    {
-        token Token = GetToken(Tokenizer);
-        KwmInterpretCommand("config space " + Display + " " + Space + " name " + std::string(Token.Text, Token.TextLength), 0);
+        Statement.Type = Config_SpaceGap;
+        if(KwmParseConfigGap(Lexer, &Statement))
+            Config->Statements.push_back(Statement);
     }
-    else if(TokenEquals(Token, "tree"))
+    else if((TokenEquals(Token, "name")) || (TokenEquals(Token, "tree")))
     {
-        token Token = GetToken(Tokenizer);
-        KwmInterpretCommand("config space " + Display + " " + Space + " tree " + std::string(Token.Text, Token.TextLength), 0);
+        Statement.Type = TokenEquals(Token, "name") ? Config_SpaceName : Config_SpaceTree;
+        token Token = KwmConfigToken(Lexer);
+        Statement.Text = std::string(Token.Text, Token.TextLength);
+        Config->Statements.push_back(Statement);
     }
     else
     {
@@ -588,9 +367,9 @@ KwmParseConfigOptionSpace(tokenizer *Tokenizer)
 }
 
 internal void
-KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
+KwmParseConfigOptionDisplay(config_lexer *Lexer, kwm_config *Config)
 {
-    token TokenDisplay = GetToken(Tokenizer);
+    token TokenDisplay = KwmConfigToken(Lexer);
     std::string Display(TokenDisplay.Text, TokenDisplay.TextLength);
     if(TokenDisplay.Type != Token_Digit)
     {
@@ -598,115 +377,58 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
         return;
     }
 
-    token Token = GetToken(Tokenizer);
+    config_statement Statement = {};
+    Statement.Display = ConvertStringToInt(Display);
+
+    token Token = KwmConfigToken(Lexer);
     if(TokenEquals(Token, "mode"))
     {
-        token Token = GetToken(Tokenizer);
-        std::string Mode(Token.Text, Token.TextLength);
-        if((TokenEquals(Token, "bsp")) || (TokenEquals(Token, "monocle")) || (TokenEquals(Token, "float")))
-            KwmInterpretCommand("config display " + Display + " mode " + Mode, 0);
+        token Token = KwmConfigToken(Lexer);
+        Statement.Type = Config_DisplayMode;
+        if(KwmParseTilingMode(Token, &Statement.Mode))
+            Config->Statements.push_back(Statement);
         else
-            ReportInvalidCommand("Unknown command 'config display " + Display + " mode " + Mode + "'");
+            ReportInvalidCommand("Unknown command 'config display " + Display + " mode " + std::string(Token.Text, Token.TextLength) + "'");
     }
     else if(TokenEquals(Token, "padding"))
     {
-        bool IsValid = true;
-        token TokenTop = GetToken(Tokenizer);
-        token TokenBottom = GetToken(Tokenizer);
-        token TokenLeft = GetToken(Tokenizer);
-        token TokenRight = GetToken(Tokenizer);
-
-        if(TokenTop.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding top value '" + std::string(TokenTop.Text, TokenTop.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenBottom.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding bottom value '" + std::string(TokenBottom.Text, TokenBottom.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenLeft.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding left value '" + std::string(TokenLeft.Text, TokenLeft.TextLength) + "'");
-            IsValid = false;
-        }
-        if(TokenRight.Type != Token_Digit)
-        {
-            ReportInvalidCommand("Unknown config padding right value '" + std::string(TokenRight.Text, TokenRight.TextLength) + "'");
-            IsValid = false;
-        }
-
-        if(IsValid)
-        {
-            KwmInterpretCommand("config display " + Display +
-                    " padding " + std::string(TokenTop.Text, TokenTop.TextLength) +
-                    " " + std::string(TokenBottom.Text, TokenBottom.TextLength) +
-                    " " + std::string(TokenLeft.Text, TokenLeft.TextLength) +
-                    " " + std::string(TokenRight.Text, TokenRight.TextLength), 0);
-        }
+        Statement.Type = Config_DisplayPadding;
+        if(KwmParseConfigPadding(Lexer, &Statement))
+            Config->Statements.push_back(Statement);
     }
     else if(TokenEquals(Token, "gap"))
     {
+        Statement.Type = Config_DisplayGap;
+        if(KwmParseConfigGap(Lexer, &Statement))
+            Config->Statements.push_back(Statement);
+    }
+    else if(TokenEquals(Token, "float"))
+    {
+        std::string Command = "config display " + Display + " float";
+        if(!KwmParseConfigName(Lexer, Command, "dim", NULL))
+            return;
+
         bool IsValid = true;
-        token TokenVertical = GetToken(Tokenizer);
-        token TokenHorizontal = GetToken(Tokenizer);
+        token TokenWidth = KwmConfigToken(Lexer);
+        token TokenHeight = KwmConfigToken(Lexer);
 
-        if(TokenVertical.Type != Token_Digit)
+        if(TokenWidth.Type != Token_Digit)
         {
-            ReportInvalidCommand("Unknown config gap vertical value '" + std::string(TokenVertical.Text, TokenVertical.TextLength) + "'");
+            ReportInvalidCommand("Unknown float-dim width value '" + std::string(TokenWidth.Text, TokenWidth.TextLength) + "'");
             IsValid = false;
         }
-        if(TokenHorizontal.Type != Token_Digit)
+        if(TokenHeight.Type != Token_Digit)
         {
-            ReportInvalidCommand("Unknown config gap horizontal value '" + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength) + "'");
+            ReportInvalidCommand("Unknown float-dim height value '" + std::string(TokenHeight.Text, TokenHeight.TextLength) + "'");
             IsValid = false;
         }
 
         if(IsValid)
         {
-            KwmInterpretCommand("config display " + Display +
-                    " gap " + std::string(TokenVertical.Text, TokenVertical.TextLength) +
-                    " " + std::string(TokenHorizontal.Text, TokenHorizontal.TextLength), 0);
-        }
-    }
-    else if(TokenEquals(Token, "float"))
-    {
-        if(RequireToken(Tokenizer, Token_Dash))
-        {
-            token Token = GetToken(Tokenizer);
-            if(TokenEquals(Token, "dim"))
-            {
-                bool IsValid = true;
-                token TokenWidth = GetToken(Tokenizer);
-                token TokenHeight = GetToken(Tokenizer);
-
-                if(TokenWidth.Type != Token_Digit)
-                {
-                    ReportInvalidCommand("Unknown float-dim width value '" + std::string(TokenWidth.Text, TokenWidth.TextLength) + "'");
-                    IsValid = false;
-                }
-                if(TokenHeight.Type != Token_Digit)
-                {
-                    ReportInvalidCommand("Unknown float-dim height value '" + std::string(TokenHeight.Text, TokenHeight.TextLength) + "'");
-                    IsValid = false;
-                }
-
-                if(IsValid)
-                {
-                    KwmInterpretCommand("config display " + Display +
-                            " float-dim " + std::string(TokenWidth.Text, TokenWidth.TextLength) +
-                            " " + std::string(TokenHeight.Text, TokenHeight.TextLength), 0);
-                }
-            }
-            else
-            {
-                ReportInvalidCommand("Unknown command 'config display " + Display + " float-" + std::string(Token.Text, Token.TextLength) + "'");
-            }
-        }
-        else
-        {
-            ReportInvalidCommand("Expected token '-' after 'config display " + Display + " float'");
+            Statement.Type = Config_DisplayFloatDim;
+            Statement.Values[0] = ConvertStringToDouble(std::string(TokenWidth.Text, TokenWidth.TextLength));
+            Statement.Values[1] = ConvertStringToDouble(std::string(TokenHeight.Text, TokenHeight.TextLength));
+            Config->Statements.push_back(Statement);
         }
     }
     else
@@ -716,63 +438,72 @@ KwmParseConfigOptionDisplay(tokenizer *Tokenizer)
 }
 
 internal void
-KwmParseModeOptionActivate(tokenizer *Tokenizer)
+KwmParseModeOptionActivate(config_lexer *Lexer, kwm_config *Config)
 {
-    token TokenMode = GetToken(Tokenizer);
-    std::string Mode(TokenMode.Text, TokenMode.TextLength);
-    KwmInterpretCommand("mode activate " + Mode, 0);
+    token TokenMode = KwmConfigToken(Lexer);
+    config_statement Statement = {};
+    Statement.Type = Config_ModeActivate;
+    Statement.Text = std::string(TokenMode.Text, TokenMode.TextLength);
+    Config->Statements.push_back(Statement);
 }
 
 internal void
-KwmParseModeOptionProperties(token *TokenMode, tokenizer *Tokenizer)
+KwmParseModeOptionProperties(token *TokenMode, config_lexer *Lexer, kwm_config *Config)
 {
     std::string Mode(TokenMode->Text, TokenMode->TextLength);
-    token Token = GetToken(Tokenizer);
+    config_statement Statement = {};
+    Statement.Text = Mode;
 
+    token Token = KwmConfigToken(Lexer);
     if(TokenEquals(Token, "prefix"))
     {
-        token Token = GetToken(Tokenizer);
-        std::string Status(Token.Text, Token.TextLength);
+        token Token = KwmConfigToken(Lexer);
         if((TokenEquals(Token, "on")) || (TokenEquals(Token, "off")))
-            KwmInterpretCommand("mode " + Mode + " prefix " + Status, 0);
+        {
+            Statement.Type = Config_ModePrefix;
+            Statement.Enabled = TokenEquals(Token, "on");
+            Config->Statements.push_back(Statement);
+        }
         else
-            ReportInvalidCommand("Unknown command 'mode " + Mode + " prefix " + Status + "'");
+        {
+            ReportInvalidCommand("Unknown command 'mode " + Mode + " prefix " + std::string(Token.Text, Token.TextLength) + "'");
+        }
     }
     else if(TokenEquals(Token, "timeout"))
     {
-        token Token = GetToken(Tokenizer);
-        switch(Token.Type)
+        token Token = KwmConfigToken(Lexer);
+        std::string Timeout(Token.Text, Token.TextLength);
+        if(Token.Type == Token_Digit)
         {
-            case Token_Digit:
-            {
-                std::string Timeout(Token.Text, Token.TextLength);
-                KwmInterpretCommand("mode " + Mode + " timeout " + Timeout, 0);
-            } break;
-            default:
-            {
-                std::string Timeout(Token.Text, Token.TextLength);
-                ReportInvalidCommand("Unknown command 'mode " + Mode + " timeout " + Timeout + "'");
-            } break;
+            Statement.Type = Config_ModeTimeout;
+            Statement.Values[0] = ConvertStringToDouble(Timeout);
+            Config->Statements.push_back(Statement);
+        }
+        else
+        {
+            ReportInvalidCommand("Unknown command 'mode " + Mode + " timeout " + Timeout + "'");
         }
     }
     else if(TokenEquals(Token, "color"))
     {
-        token Token = GetToken(Tokenizer);
-        std::string Color(Token.Text, Token.TextLength);
-        KwmInterpretCommand("mode " + Mode + " color " + Color, 0);
+        token Token = KwmConfigToken(Lexer);
+        Statement.Type = Config_ModeColor;
+        Statement.Color = ConvertHexStringToInt(std::string(Token.Text, Token.TextLength));
+        Config->Statements.push_back(Statement);
     }
     else if(TokenEquals(Token, "restore"))
     {
-        token Token = GetToken(Tokenizer);
-        std::string Restore(Token.Text, Token.TextLength);
-        KwmInterpretCommand("mode " + Mode + " restore " + Restore, 0);
+        token Token = KwmConfigToken(Lexer);
+        Statement.Type = Config_ModeRestore;
+        Statement.Argument = std::string(Token.Text, Token.TextLength);
+        Config->Statements.push_back(Statement);
     }
 }
 
 internal void
-KwmParseConfigOption(tokenizer *Tokenizer)
+KwmParseConfigOption(config_lexer *Lexer, kwm_config *Config)
 {
-    token Token = GetToken(Tokenizer);
+    token Token = KwmConfigToken(Lexer);
     switch(Token.Type)
     {
         case Token_EndOfStream:
@@ -783,39 +514,43 @@ KwmParseConfigOption(tokenizer *Tokenizer)
         case Token_Identifier:
         {
             if(TokenEquals(Token, "tiling"))
-                KwmParseConfigOptionTiling(Tokenizer);
+                KwmParseConfigOptionTiling(Lexer, Config);
             else if(TokenEquals(Token, "hotkeys"))
-                KwmParseConfigOptionHotkeys(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_Hotkeys, "config hotkeys");
             else if(TokenEquals(Token, "padding"))
-                KwmParseConfigOptionPadding(Tokenizer);
+                KwmParseConfigOptionPadding(Lexer, Config);
             else if(TokenEquals(Token, "gap"))
-                KwmParseConfigOptionGap(Tokenizer);
+                KwmParseConfigOptionGap(Lexer, Config);
             else if(TokenEquals(Token, "focus"))
-                KwmParseConfigOptionFocusFollowsMouse(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_FocusFollowsMouse, "config focus", "follows", "mouse");
             else if(TokenEquals(Token, "mouse"))
-                KwmParseConfigOptionMouseFollowsFocus(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_MouseFollowsFocus, "config mouse", "follows", "focus");
             else if(TokenEquals(Token, "standby"))
-                KwmParseConfigOptionStandbyOnFloat(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_StandbyOnFloat, "config standby", "on", "float");
             else if(TokenEquals(Token, "center"))
-                KwmParseConfigOptionCenterOnFloat(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_CenterOnFloat, "config center", "on", "float");
             else if(TokenEquals(Token, "float"))
-                KwmParseConfigOptionFloatNonResizable(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_FloatNonResizable, "config float", "non", "resizable");
             else if(TokenEquals(Token, "lock"))
-                KwmParseConfigOptionLockToContainer(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_LockToContainer, "config lock", "to", "container");
             else if(TokenEquals(Token, "cycle"))
-                KwmParseConfigOptionCycleFocus(Tokenizer);
+                KwmParseConfigOptionToggle(Lexer, Config, Config_CycleFocus, "config cycle", "focus");
             else if(TokenEquals(Token, "split"))
-                KwmParseConfigOptionSplitRatio(Tokenizer);
+                KwmParseConfigOptionRatio(Lexer, Config, Config_SplitRatio, "config split");
             else if(TokenEquals(Token, "optimal"))
-                KwmParseConfigOptionOptimalRatio(Tokenizer);
+                KwmParseConfigOptionRatio(Lexer, Config, Config_OptimalRatio, "config optimal");
             else if(TokenEquals(Token, "spawn"))
-                KwmParseConfigOptionSpawn(Tokenizer);
+                KwmParseConfigOptionSpawn(Lexer, Config);
+            else if(TokenEquals(Token, "watch"))
+                KwmParseConfigOptionToggle(Lexer, Config, Config_Watch, "config watch");
+            else if(TokenEquals(Token, "log"))
+                KwmParseConfigOptionLog(Lexer, Config);
             else if(TokenEquals(Token, "border"))
-                KwmParseConfigOptionBorder(Tokenizer);
+                KwmParseConfigOptionBorder(Lexer, Config);
             else if(TokenEquals(Token, "space"))
-                KwmParseConfigOptionSpace(Tokenizer);
+                KwmParseConfigOptionSpace(Lexer, Config);
             else if(TokenEquals(Token, "display"))
-                KwmParseConfigOptionDisplay(Tokenizer);
+                KwmParseConfigOptionDisplay(Lexer, Config);
             else
                 ReportInvalidCommand("Unknown command 'config " + std::string(Token.Text, Token.TextLength) + "'");
         } break;
@@ -827,9 +562,9 @@ KwmParseConfigOption(tokenizer *Tokenizer)
 }
 
 internal void
-KwmParseModeOption(tokenizer *Tokenizer)
+KwmParseModeOption(config_lexer *Lexer, kwm_config *Config)
 {
-    token Token = GetToken(Tokenizer);
+    token Token = KwmConfigToken(Lexer);
     switch(Token.Type)
     {
         case Token_EndOfStream:
@@ -840,9 +575,9 @@ KwmParseModeOption(tokenizer *Tokenizer)
         case Token_Identifier:
         {
             if(TokenEquals(Token, "activate"))
-                KwmParseModeOptionActivate(Tokenizer);
+                KwmParseModeOptionActivate(Lexer, Config);
             else
-                KwmParseModeOptionProperties(&Token, Tokenizer);
+                KwmParseModeOptionProperties(&Token, Lexer, Config);
         } break;
         default:
         {
@@ -851,10 +586,45 @@ KwmParseModeOption(tokenizer *Tokenizer)
     }
 }
 
+/* NOTE(koekeishiya): The key and the command are split on the first space, the same way
+ *                    'kwmc bindsym' splits its arguments. */
 internal void
-KwmParseKwmc(tokenizer *Tokenizer)
+KwmParseBind(token *TokenBind, config_lexer *Lexer, kwm_config *Config)
 {
-    token Token = GetToken(Tokenizer);
+    std::string Bind(TokenBind->Text, TokenBind->TextLength);
+    config_statement Statement = {};
+    Statement.Type = Config_Bind;
+
+    if(Bind.find("bindcode") != std::string::npos)
+        Statement.Flags |= ConfigFlag_Keycode;
+    if(Bind.find("_passthrough") != std::string::npos)
+        Statement.Flags |= ConfigFlag_Passthrough;
+
+    std::string Line = KwmConfigLine(Lexer);
+    std::size_t Split = Line.find(' ');
+    Statement.Text = Line.substr(0, Split);
+    if(Split != std::string::npos)
+        Statement.Argument = Line.substr(Split + 1);
+
+    if(Statement.Text.empty())
+        ReportInvalidCommand("Expected key after '" + Bind + "'");
+    else
+        Config->Statements.push_back(Statement);
+}
+
+internal void
+KwmParseLine(config_lexer *Lexer, kwm_config *Config, config_statement_type Type)
+{
+    config_statement Statement = {};
+    Statement.Type = Type;
+    Statement.Text = KwmConfigLine(Lexer);
+    Config->Statements.push_back(Statement);
+}
+
+internal void
+KwmParseKwmc(config_lexer *Lexer, kwm_config *Config)
+{
+    token Token = KwmConfigToken(Lexer);
     switch(Token.Type)
     {
         case Token_EndOfStream:
@@ -864,17 +634,18 @@ KwmParseKwmc(tokenizer *Tokenizer)
         case Token_Identifier:
         {
             if(TokenEquals(Token, "config"))
-                KwmParseConfigOption(Tokenizer);
+                KwmParseConfigOption(Lexer, Config);
             else if(TokenEquals(Token, "mode"))
-                KwmParseModeOption(Tokenizer);
+                KwmParseModeOption(Lexer, Config);
             else if(TokenEquals(Token, "bindsym") ||
                     TokenEquals(Token, "bindcode") ||
                     TokenEquals(Token, "bindsym_passthrough") ||
-                    TokenEquals(Token, "bindcode_passthrough") ||
-                    TokenEquals(Token, "rule"))
-                KwmInterpretCommand(std::string(Token.Text, Token.TextLength) + " " + GetTextTilEndOfLine(Tokenizer), 0);
+                    TokenEquals(Token, "bindcode_passthrough"))
+                KwmParseBind(&Token, Lexer, Config);
+            else if(TokenEquals(Token, "rule"))
+                KwmParseLine(Lexer, Config, Config_Rule);
             else if(TokenEquals(Token, "whitelist"))
-                KwmInterpretCommand(std::string(Token.Text, Token.TextLength) + " " + GetTextTilEndOfLine(Tokenizer), 0);
+                KwmParseLine(Lexer, Config, Config_Whitelist);
             else
                 ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
         } break;
@@ -885,48 +656,25 @@ KwmParseKwmc(tokenizer *Tokenizer)
     }
 }
 
+/* NOTE(koekeishiya): The passed string has to include the absolute path to the file.
+ *                    Include tracks 'kwm_include' while compiling, since it decides
+ *                    where later include statements are resolved. */
 internal void
-KwmParseInclude(tokenizer *Tokenizer)
+KwmCompileConfigFile(std::string File, kwm_config *Config, std::string &Include)
 {
-    std::string File = KWMPath.Include + "/" + GetTextTilEndOfLine(Tokenizer);
-    KwmParseConfig(File);
-}
-
-internal void
-KwmParseDefine(tokenizer *Tokenizer, std::map<std::string, std::string> &Defines)
-{
-    token Token = GetToken(Tokenizer);
-    std::string Variable(Token.Text, Token.TextLength);
-    std::string Value = GetTextTilEndOfLine(Tokenizer);
-    Defines[Variable] = Value;
-}
-
-internal void
-KwmExpandVariables(std::map<std::string, std::string> &Defines, std::string &Text)
-{
-    std::map<std::string, std::string>::iterator It;
-    for(It = Defines.begin(); It != Defines.end(); ++It)
-    {
-        std::size_t Pos = Text.find(It->first);
-        while(Pos != std::string::npos)
-        {
-            Text.replace(Pos, It->first.size(), It->second);
-            Pos = Text.find(It->first, Pos + It->second.size() + 1);
-        }
-    }
-}
+    char *FileContents;
+    Config->Files.push_back(File);
+    Config->Hash = KwmHashConfigFile(Config->Hash, File, &FileContents);
+    if(!FileContents)
+        return;
 
-internal void
-KwmPreprocessConfig(std::string &Text)
-{
-    std::map<std::string, std::string> Defines;
-    tokenizer Tokenizer = {};
-    Tokenizer.At = const_cast<char*>(Text.c_str());
+    config_lexer Lexer = {};
+    Lexer.File.At = FileContents;
 
     bool Parsing = true;
     while(Parsing)
     {
-        token Token = GetToken(&Tokenizer);
+        token Token = KwmConfigToken(&Lexer);
         switch(Token.Type)
         {
             case Token_EndOfStream:
@@ -938,86 +686,530 @@ KwmPreprocessConfig(std::string &Text)
             } break;
             case Token_Identifier:
             {
-                if(TokenEquals(Token, "define"))
-                    KwmParseDefine(&Tokenizer, Defines);
+                if(TokenEquals(Token, "kwmc"))
+                    KwmParseKwmc(&Lexer, Config);
+                else if(TokenEquals(Token, "exec"))
+                    KwmParseLine(&Lexer, Config, Config_Exec);
+                else if(TokenEquals(Token, "include"))
+                    KwmCompileConfigFile(Include + "/" + KwmConfigLine(&Lexer), Config, Include);
+                else if(TokenEquals(Token, "define"))
+                    KwmParseDefine(&Lexer);
+                else if(TokenEquals(Token, "kwm_home"))
+                    KwmParseLine(&Lexer, Config, Config_HomePath);
+                else if(TokenEquals(Token, "kwm_include"))
+                {
+                    KwmParseLine(&Lexer, Config, Config_IncludePath);
+                    Include = Config->Statements.back().Text;
+                }
+                else if(TokenEquals(Token, "kwm_layouts"))
+                    KwmParseLine(&Lexer, Config, Config_LayoutsPath);
+                else
+                    ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
             } break;
             default:
             {
+                ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
             } break;
         }
     }
 
-    KwmExpandVariables(Defines, Text);
+    free(FileContents);
 }
 
-/* NOTE(koekeishiya): The passed string has to include the absolute path to the file. */
-void KwmParseConfig(std::string File)
+void KwmCompileConfig(std::string File, kwm_config *Config)
+{
+    std::string Include = KWMPath.Include;
+    Config->Hash = KWM_CONFIG_HASH_SEED;
+    KwmCompileConfigFile(File, Config, Include);
+}
+
+internal inline void
+KwmApplyConfigFlag(uint32_t Flag, bool Enabled)
 {
-    tokenizer Tokenizer = {};
-    char *FileContents = ReadFile(File);
+    if(Enabled)
+        AddFlags(&KWMSettings, Flag);
+    else
+        ClearFlags(&KWMSettings, Flag);
+}
+
+/* NOTE(koekeishiya): The settings kwm starts out with, split by config section. A reload resets a
+ *                    section that changed to these before it applies the new statements, so a
+ *                    statement that was removed from the config is undone, as on a cold start. */
+internal void
+KwmSetDefaultSpaceSettings()
+{
+    KWMSettings.DefaultOffset = CreateDefaultDisplayOffset();
+}
+
+internal void
+KwmSetDefaultBorder(kwm_border *Border)
+{
+    Border->Enabled = false;
+    Border->Radius = -1;
+    Border->Width = 0;
+    Border->Color = color();
+}
 
-    if(FileContents)
+internal void
+KwmSetDefaultGlobalSettings()
+{
+    KWMSettings.Space = SpaceModeBSP;
+    KWMSettings.Focus = FocusModeAutoraise;
+    KWMSettings.Cycle = CycleModeScreen;
+    KWMSettings.SplitRatio = 0.5;
+    KWMSettings.OptimalRatio = 1.618;
+
+    ClearFlags(&KWMSettings,
+               Settings_SpawnAsLeftChild |
+               Settings_FloatNonResizable);
+
+    AddFlags(&KWMSettings,
+             Settings_MouseFollowsFocus |
+             Settings_BuiltinHotkeys |
+             Settings_StandbyOnFloat |
+             Settings_CenterOnFloat |
+             Settings_LockToContainer);
+
+    KwmSetDefaultBorder(&FocusedBorder);
+    KwmSetDefaultBorder(&MarkedBorder);
+
+    KWMPath.Home = KWMPath.EnvHome + "/.kwm";
+    KWMPath.Include = KWMPath.Home;
+    KWMPath.Layouts = KWMPath.Home + "/layouts";
+
+    ConfigWatchEnabled = false;
+    KwmResetLogSettings();
+}
+
+void KwmSetDefaultSettings()
+{
+    KWMSettings.SplitMode = SPLIT_OPTIMAL;
+    KwmSetDefaultSpaceSettings();
+    KwmSetDefaultGlobalSettings();
+}
+
+internal void
+KwmApplyConfigBorder(config_statement *Statement)
+{
+    bool Marked = Statement->Flags & ConfigFlag_MarkedBorder;
+    kwm_border *Border = Marked ? &MarkedBorder : &FocusedBorder;
+
+    switch(Statement->Type)
     {
-        std::string FileContentsString(FileContents);
-        free(FileContents);
+        case Config_BorderEnabled:
+        {
+            Border->Enabled = Statement->Enabled;
+            if(!Border->Enabled)
+                CloseBorder(Border);
+            else if(!Marked && !Border->Color.Format.empty() && FocusedApplication)
+                UpdateBorder(Border, FocusedApplication->Focus);
+        } break;
+        case Config_BorderSize:
+        {
+            Border->Width = (int) Statement->Values[0];
+        } break;
+        case Config_BorderRadius:
+        {
+            Border->Radius = Statement->Values[0];
+        } break;
+        case Config_BorderColor:
+        {
+            Border->Color = ConvertHexRGBAToColor(Statement->Color);
+            CreateColorFormat(&Border->Color);
+        } break;
+        default: {} break;
+    }
+}
+
+internal void
+KwmApplyConfigSpaceSettings(config_statement *Statement, space_settings *Settings)
+{
+    switch(Statement->Type)
+    {
+        case Config_SpaceMode:
+        case Config_DisplayMode:
+        {
+            Settings->Mode = Statement->Mode;
+        } break;
+        case Config_SpacePadding:
+        case Config_DisplayPadding:
+        {
+            Settings->Offset.PaddingTop = Statement->Values[0];
+            Settings->Offset.PaddingBottom = Statement->Values[1];
+            Settings->Offset.PaddingLeft = Statement->Values[2];
+            Settings->Offset.PaddingRight = Statement->Values[3];
+        } break;
+        case Config_SpaceGap:
+        case Config_DisplayGap:
+        {
+            Settings->Offset.VerticalGap = Statement->Values[0];
+            Settings->Offset.HorizontalGap = Statement->Values[1];
+        } break;
+        case Config_DisplayFloatDim:
+        {
+            Settings->FloatDim.width = Statement->Values[0];
+            Settings->FloatDim.height = Statement->Values[1];
+        } break;
+        case Config_SpaceName:
+        {
+            Settings->Name = Statement->Text;
+        } break;
+        case Config_SpaceTree:
+        {
+            Settings->Layout = Statement->Text;
+        } break;
+        default: {} break;
+    }
+}
 
-        KwmPreprocessConfig(FileContentsString);
-        Tokenizer.At = const_cast<char*>(FileContentsString.c_str());
+internal void
+KwmApplyConfigStatement(config_statement *Statement)
+{
+    switch(Statement->Type)
+    {
+        case Config_Tiling: { KWMSettings.Space = Statement->Mode; } break;
+        case Config_Hotkeys: { KwmApplyConfigFlag(Settings_BuiltinHotkeys, Statement->Enabled); } break;
+        case Config_MouseFollowsFocus: { KwmApplyConfigFlag(Settings_MouseFollowsFocus, Statement->Enabled); } break;
+        case Config_StandbyOnFloat: { KwmApplyConfigFlag(Settings_StandbyOnFloat, Statement->Enabled); } break;
+        case Config_CenterOnFloat: { KwmApplyConfigFlag(Settings_CenterOnFloat, Statement->Enabled); } break;
+        case Config_FloatNonResizable: { KwmApplyConfigFlag(Settings_FloatNonResizable, Statement->Enabled); } break;
+        case Config_LockToContainer: { KwmApplyConfigFlag(Settings_LockToContainer, Statement->Enabled); } break;
+        case Config_Spawn: { KwmApplyConfigFlag(Settings_SpawnAsLeftChild, Statement->Enabled); } break;
+        case Config_FocusFollowsMouse:
+        {
+            KWMSettings.Focus = Statement->Enabled ? FocusModeAutoraise : FocusModeDisabled;
+        } break;
+        case Config_CycleFocus:
+        {
+            KWMSettings.Cycle = Statement->Enabled ? CycleModeScreen : CycleModeDisabled;
+        } break;
+        case Config_Padding:
+        {
+            container_offset Offset = { Statement->Values[0],
+                                        Statement->Values[1],
+                                        Statement->Values[2],
+                                        Statement->Values[3],
+                                        0,
+                                        0
+                                      };
 
-        bool Parsing = true;
-        while(Parsing)
+            SetDefaultPaddingOfDisplay(Offset);
+        } break;
+        case Config_Gap:
         {
-            token Token = GetToken(&Tokenizer);
-            switch(Token.Type)
-            {
-                case Token_EndOfStream:
-                {
-                    Parsing = false;
-                } break;
-                case Token_Comment:
-                {
-                    // printf("%d Comment: %.*s\n", Token.Type, Token.TextLength, Token.Text);
-                } break;
-                case Token_Identifier:
-                {
-                    if(TokenEquals(Token, "kwmc"))
-                        KwmParseKwmc(&Tokenizer);
-                    else if(TokenEquals(Token, "exec"))
-                        KwmExecuteSystemCommand(GetTextTilEndOfLine(&Tokenizer));
-                    else if(TokenEquals(Token, "include"))
-                        KwmParseInclude(&Tokenizer);
-                    else if(TokenEquals(Token, "define"))
-                        GetTextTilEndOfLine(&Tokenizer);
-                    else if(TokenEquals(Token, "kwm_home"))
-                        KWMPath.Home = GetTextTilEndOfLine(&Tokenizer);
-                    else if(TokenEquals(Token, "kwm_include"))
-                        KWMPath.Include = GetTextTilEndOfLine(&Tokenizer);
-                    else if(TokenEquals(Token, "kwm_layouts"))
-                        KWMPath.Layouts = GetTextTilEndOfLine(&Tokenizer);
-                    else
-                        ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
-                } break;
-                default:
-                {
-                    ReportInvalidCommand("Unknown token '" + std::string(Token.Text, Token.TextLength) + "'");
-                } break;
-            }
+            container_offset Offset = { 0,
+                                        0,
+                                        0,
+                                        0,
+                                        Statement->Values[0],
+                                        Statement->Values[1]
+                                      };
+
+            SetDefaultGapOfDisplay(Offset);
+        } break;
+        case Config_SplitRatio:
+        {
+            if(Statement->Values[0] > 0.0 && Statement->Values[0] < 1.0)
+                KWMSettings.SplitRatio = Statement->Values[0];
+        } break;
+        case Config_OptimalRatio:
+        {
+            KWMSettings.OptimalRatio = Statement->Values[0];
+        } break;
+        case Config_BorderEnabled:
+        case Config_BorderSize:
+        case Config_BorderRadius:
+        case Config_BorderColor:
+        {
+            KwmApplyConfigBorder(Statement);
+        } break;
+        case Config_SpaceMode:
+        case Config_SpacePadding:
+        case Config_SpaceGap:
+        case Config_SpaceName:
+        case Config_SpaceTree:
+        {
+            KwmApplyConfigSpaceSettings(Statement, GetOrCreateSpaceSettingsForDesktopID(Statement->Display, Statement->Space));
+        } break;
+        case Config_DisplayMode:
+        case Config_DisplayPadding:
+        case Config_DisplayGap:
+        case Config_DisplayFloatDim:
+        {
+            KwmApplyConfigSpaceSettings(Statement, GetOrCreateSpaceSettingsForDisplay(Statement->Display));
+        } break;
+        case Config_ModeActivate:
+        {
+            KwmActivateBindingMode(Statement->Text);
+        } break;
+        case Config_Whitelist: { CarbonWhitelistProcess(Statement->Text); } break;
+        case Config_Watch: { ConfigWatchEnabled = Statement->Enabled; } break;
+        case Config_LogLevel: { KwmSetLogLevel((kwm_log_level) Statement->Values[0]); } break;
+        case Config_LogCategory: { KwmSetLogCategory((uint32_t) Statement->Values[0], Statement->Enabled); } break;
+        case Config_HomePath: { KWMPath.Home = Statement->Text; } break;
+        case Config_IncludePath: { KWMPath.Include = Statement->Text; } break;
+        case Config_LayoutsPath: { KWMPath.Layouts = Statement->Text; } break;
+        default: {} break;
+    }
+}
+
+/* NOTE(koekeishiya): The space and display settings are rebuilt from scratch, and the settings
+ *                    they replace are handed to UpdateSpaceSettings so that only the spaces
+ *                    whose settings actually changed are laid out again. */
+internal void
+KwmApplyConfigSpaces(kwm_config *Config)
+{
+    kwm_settings Previous = {};
+    Previous.Space = KWMSettings.Space;
+    Previous.DefaultOffset = KWMSettings.DefaultOffset;
+    Previous.SpaceSettings.swap(KWMSettings.SpaceSettings);
+    Previous.DisplaySettings.swap(KWMSettings.DisplaySettings);
+    KwmSetDefaultSpaceSettings();
+
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        if(KwmIsSpaceStatement(&Config->Statements[Index]))
+            KwmApplyConfigStatement(&Config->Statements[Index]);
+    }
+
+    int Spaces = UpdateSpaceSettings(&Previous);
+    KWMMetrics.ConfigSpacesUpdated += Spaces;
+    LOG_INFO(LogCategory_Config, "Config reload: space settings changed, " << Spaces << " space(s) updated");
+}
+
+internal void
+KwmApplyConfigBinding(config_statement *Statement, std::map<std::string, mode> &Modes)
+{
+    switch(Statement->Type)
+    {
+        case Config_ModePrefix:
+        {
+            GetBindingMode(Modes, Statement->Text)->Prefix = Statement->Enabled;
+        } break;
+        case Config_ModeTimeout:
+        {
+            GetBindingMode(Modes, Statement->Text)->Timeout = Statement->Values[0];
+        } break;
+        case Config_ModeColor:
+        case Config_BorderColor:
+        {
+            std::string Mode = Statement->Type == Config_BorderColor ? "default" : Statement->Text;
+            mode *BindingMode = GetBindingMode(Modes, Mode);
+            BindingMode->Color = ConvertHexRGBAToColor(Statement->Color);
+            CreateColorFormat(&BindingMode->Color);
+        } break;
+        case Config_ModeRestore:
+        {
+            GetBindingMode(Modes, Statement->Text)->Restore = Statement->Argument;
+        } break;
+        case Config_Bind:
+        {
+            KwmAddHotkey(Modes, Statement->Text, Statement->Argument,
+                         Statement->Flags & ConfigFlag_Passthrough,
+                         Statement->Flags & ConfigFlag_Keycode);
+        } break;
+        default: {} break;
+    }
+}
+
+/* NOTE(koekeishiya): The binding modes are built off to the side and swapped in as a whole,
+ *                    so a hotkey is matched against either the old or the new set, never
+ *                    against a half built one. */
+internal void
+KwmApplyConfigBindings(kwm_config *Config)
+{
+    std::map<std::string, mode> Modes;
+    GetBindingMode(Modes, "default");
+
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        if(KwmIsBindingStatement(&Config->Statements[Index]))
+            KwmApplyConfigBinding(&Config->Statements[Index], Modes);
+    }
+
+    KwmSetBindingModes(Modes);
+    LOG_INFO(LogCategory_Config, "Config reload: bindings changed");
+}
+
+internal void
+KwmApplyConfigRules(kwm_config *Config)
+{
+    KwmClearRules();
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        if(KwmIsRuleStatement(&Config->Statements[Index]))
+            KwmAddRule(Config->Statements[Index].Text);
+    }
+
+    LOG_INFO(LogCategory_Config, "Config reload: rules changed");
+}
+
+/* NOTE(koekeishiya): A border that is no longer enabled once the section has been applied again is
+ *                    closed, and one that stays enabled is redrawn with its new size and color. */
+internal void
+KwmApplyConfigGlobals(kwm_config *Config)
+{
+    bool FocusedBorderEnabled = FocusedBorder.Enabled;
+    bool MarkedBorderEnabled = MarkedBorder.Enabled;
+    KwmSetDefaultGlobalSettings();
+
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        if(KwmIsGlobalStatement(&Config->Statements[Index]))
+            KwmApplyConfigStatement(&Config->Statements[Index]);
+    }
+
+    if(FocusedBorderEnabled && !FocusedBorder.Enabled)
+        CloseBorder(&FocusedBorder);
+    else if(FocusedBorder.Enabled && !FocusedBorder.Color.Format.empty() && FocusedApplication)
+        UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
+
+    if(MarkedBorderEnabled && !MarkedBorder.Enabled)
+        CloseBorder(&MarkedBorder);
+
+    LOG_INFO(LogCategory_Config, "Config reload: global settings changed");
+}
+
+/* NOTE(koekeishiya): Apply Config on top of the live config and make it the live config.
+ *                    The very first config is diffed against an empty one, so every
+ *                    section that has statements is applied. */
+void KwmApplyConfig(kwm_config *Config)
+{
+    if(KwmConfigSectionChanged(&LiveConfig, Config, KwmIsSpaceStatement))
+        KwmApplyConfigSpaces(Config);
+
+    if(KwmConfigSectionChanged(&LiveConfig, Config, KwmIsBindingStatement))
+        KwmApplyConfigBindings(Config);
+
+    if(KwmConfigSectionChanged(&LiveConfig, Config, KwmIsRuleStatement))
+        KwmApplyConfigRules(Config);
+
+    if(KwmConfigSectionChanged(&LiveConfig, Config, KwmIsGlobalStatement))
+        KwmApplyConfigGlobals(Config);
+
+    std::vector<std::string> Commands = KwmNewConfigExecs(&LiveConfig, Config);
+    KwmExecuteSystemCommands(Commands);
+    LiveConfig = *Config;
+}
+
+internal void
+KwmStopConfigWatch()
+{
+    for(std::size_t Index = 0; Index < ConfigWatchSources.size(); ++Index)
+    {
+        dispatch_source_cancel(ConfigWatchSources[Index]);
+        dispatch_release(ConfigWatchSources[Index]);
+    }
+
+    ConfigWatchSources.clear();
+}
+
+/* NOTE(koekeishiya): Editors tend to save in bursts, or by writing a new file and renaming it
+ *                    over the old one. Every event pushes the reload back, and the reload arms
+ *                    new watchers, which then follow the file that took the old one's place. */
+internal void
+KwmScheduleConfigReload()
+{
+    uint64_t Generation = ++ConfigWatchGeneration;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, KWM_CONFIG_WATCH_DEBOUNCE * NSEC_PER_SEC), dispatch_get_main_queue(),
+    ^{
+        if(Generation != ConfigWatchGeneration)
+            return;
+
+        if(access(KWMPath.Config.c_str(), R_OK) == 0)
+        {
+            LOG_INFO(LogCategory_Config, "Config changed on disk, reloading");
+            KwmReloadConfig();
         }
+        else
+        {
+            LOG_WARN(LogCategory_Config, "Config changed on disk, but " << KWMPath.Config << " can not be read");
+        }
+    });
+}
+
+internal void
+KwmWatchConfigFile(std::string File)
+{
+    int FD = open(File.c_str(), O_EVTONLY);
+    if(FD == -1)
+        return;
+
+    dispatch_source_t Source = dispatch_source_create(DISPATCH_SOURCE_TYPE_VNODE, FD,
+                                                      DISPATCH_VNODE_WRITE | DISPATCH_VNODE_EXTEND |
+                                                      DISPATCH_VNODE_DELETE | DISPATCH_VNODE_RENAME,
+                                                      dispatch_get_main_queue());
+    if(!Source)
+    {
+        close(FD);
+        return;
     }
+
+    dispatch_source_set_event_handler(Source, ^{ KwmScheduleConfigReload(); });
+    dispatch_source_set_cancel_handler(Source, ^{ close(FD); });
+    dispatch_resume(Source);
+    ConfigWatchSources.push_back(Source);
 }
 
+/* NOTE(koekeishiya): Watch every file the live config was compiled from, includes as well. */
 internal void
-KwmClearSettings()
+KwmUpdateConfigWatch()
+{
+    KwmStopConfigWatch();
+    if(!ConfigWatchEnabled)
+        return;
+
+    for(std::size_t Index = 0; Index < LiveConfig.Files.size(); ++Index)
+        KwmWatchConfigFile(LiveConfig.Files[Index]);
+}
+
+void KwmSetConfigWatch(bool Enabled)
+{
+    if(!pthread_main_np())
+    {
+        dispatch_sync(dispatch_get_main_queue(), ^{ KwmSetConfigWatch(Enabled); });
+        return;
+    }
+
+    ConfigWatchEnabled = Enabled;
+    KwmUpdateConfigWatch();
+}
+
+void KwmParseConfig(std::string File)
 {
-    KWMHotkeys.Modes.clear();
-    KWMSettings.WindowRules.clear();
-    KWMSettings.SpaceSettings.clear();
-    KWMSettings.DisplaySettings.clear();
-    KWMHotkeys.ActiveMode = GetBindingMode("default");
+    kwm_time_point StartTime = std::chrono::steady_clock::now();
+
+    /* NOTE(koekeishiya): The cache is keyed on the include directory we start out with,
+     *                    because applying a config may change it for the next reload. */
+    kwm_config Config = {};
+    std::string Include = KWMPath.Include;
+    if(KwmLoadConfigCache(KWMPath.Cache, File, Include, &Config))
+    {
+        ++KWMMetrics.ConfigCacheHits;
+    }
+    else
+    {
+        ++KWMMetrics.ConfigCacheMisses;
+        KwmCompileConfig(File, &Config);
+        KwmSaveConfigCache(KWMPath.Cache, File, Include, &Config);
+    }
+
+    KwmApplyConfig(&Config);
+    KwmUpdateConfigWatch();
+
+    KWMMetrics.ConfigLoadTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+    LOG_INFO(LogCategory_Config, "Config loaded in " << KWMMetrics.ConfigLoadTime << "ms");
 }
 
+/* NOTE(koekeishiya): Hotkeys are matched on the main thread; reloading there as well means
+ *                    a reload requested through the daemon is never observed half applied. */
 void KwmReloadConfig()
 {
-    KwmClearSettings();
+    if(!pthread_main_np())
+    {
+        dispatch_sync(dispatch_get_main_queue(), ^{ KwmReloadConfig(); });
+        return;
+    }
+
     KwmParseConfig(KWMPath.Config);
 }
@@ -1,9 +1,13 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-#include <string>
+#include "types.h"
 
+void KwmSetDefaultSettings();
+void KwmCompileConfig(std::string File, kwm_config *Config);
+void KwmApplyConfig(kwm_config *Config);
 void KwmParseConfig(std::string File);
 void KwmReloadConfig();
+void KwmSetConfigWatch(bool Enabled);
 
 #endif
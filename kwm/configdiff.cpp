@@ -0,0 +1,125 @@
+#include "configdiff.h"
+
+#include <string.h>
+#include <map>
+
+bool KwmIsSpaceStatement(config_statement *Statement)
+{
+    switch(Statement->Type)
+    {
+        case Config_Padding:
+        case Config_Gap:
+        case Config_SpaceMode:
+        case Config_SpacePadding:
+        case Config_SpaceGap:
+        case Config_SpaceName:
+        case Config_SpaceTree:
+        case Config_DisplayMode:
+        case Config_DisplayPadding:
+        case Config_DisplayGap:
+        case Config_DisplayFloatDim: return true;
+        default: return false;
+    }
+}
+
+/* NOTE(koekeishiya): The focused border color is also the color of the default mode. */
+bool KwmIsBindingStatement(config_statement *Statement)
+{
+    switch(Statement->Type)
+    {
+        case Config_ModePrefix:
+        case Config_ModeTimeout:
+        case Config_ModeColor:
+        case Config_ModeRestore:
+        case Config_Bind: return true;
+        case Config_BorderColor: return !(Statement->Flags & ConfigFlag_MarkedBorder);
+        default: return false;
+    }
+}
+
+bool KwmIsRuleStatement(config_statement *Statement)
+{
+    return Statement->Type == Config_Rule;
+}
+
+/* NOTE(koekeishiya): Exec lines are not part of any section; they are run when they are new. */
+bool KwmIsGlobalStatement(config_statement *Statement)
+{
+    switch(Statement->Type)
+    {
+        case Config_ModePrefix:
+        case Config_ModeTimeout:
+        case Config_ModeColor:
+        case Config_ModeRestore:
+        case Config_Bind:
+        case Config_Rule:
+        case Config_Exec: return false;
+        default: return !KwmIsSpaceStatement(Statement);
+    }
+}
+
+bool KwmConfigStatementsAreEqual(config_statement *A, config_statement *B)
+{
+    return A->Type == B->Type &&
+           A->Flags == B->Flags &&
+           A->Enabled == B->Enabled &&
+           A->Mode == B->Mode &&
+           A->Display == B->Display &&
+           A->Space == B->Space &&
+           memcmp(A->Values, B->Values, sizeof(A->Values)) == 0 &&
+           A->Color == B->Color &&
+           A->Text == B->Text &&
+           A->Argument == B->Argument;
+}
+
+bool KwmConfigSectionChanged(kwm_config *Old, kwm_config *New, config_section Section)
+{
+    std::size_t OldIndex = 0, NewIndex = 0;
+    while(true)
+    {
+        while(OldIndex < Old->Statements.size() && !Section(&Old->Statements[OldIndex]))
+            ++OldIndex;
+        while(NewIndex < New->Statements.size() && !Section(&New->Statements[NewIndex]))
+            ++NewIndex;
+
+        bool OldDone = OldIndex == Old->Statements.size();
+        bool NewDone = NewIndex == New->Statements.size();
+        if(OldDone || NewDone)
+            return OldDone != NewDone;
+
+        if(!KwmConfigStatementsAreEqual(&Old->Statements[OldIndex], &New->Statements[NewIndex]))
+            return true;
+
+        ++OldIndex;
+        ++NewIndex;
+    }
+}
+
+/* NOTE(koekeishiya): The exec lines of New that Old does not have, counting duplicates, so that
+ *                    a reload does not launch a second copy of everything. */
+std::vector<std::string> KwmNewConfigExecs(kwm_config *Old, kwm_config *New)
+{
+    std::map<std::string, int> Executed;
+    std::vector<std::string> Commands;
+    for(std::size_t Index = 0; Index < Old->Statements.size(); ++Index)
+    {
+        if(Old->Statements[Index].Type == Config_Exec)
+            ++Executed[Old->Statements[Index].Text];
+    }
+
+    for(std::size_t Index = 0; Index < New->Statements.size(); ++Index)
+    {
+        config_statement *Statement = &New->Statements[Index];
+        if(Statement->Type != Config_Exec)
+            continue;
+
+        std::map<std::string, int>::iterator It = Executed.find(Statement->Text);
+        if(It != Executed.end() && It->second > 0)
+            --It->second;
+        else
+            Commands.push_back(Statement->Text);
+    }
+
+    return Commands;
+}
+
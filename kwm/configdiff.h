@@ -0,0 +1,21 @@
+#ifndef CONFIGDIFF_H
+#define CONFIGDIFF_H
+
+#include "statement.h"
+
+/* NOTE(koekeishiya): A reload diffs the new config against the live one, section by section,
+ *                    and only rebuilds the sections that changed. Statements keep the order
+ *                    they have in the file, so two sections are equal when their statements
+ *                    are equal one by one. */
+typedef bool (*config_section)(config_statement *Statement);
+
+bool KwmIsSpaceStatement(config_statement *Statement);
+bool KwmIsBindingStatement(config_statement *Statement);
+bool KwmIsRuleStatement(config_statement *Statement);
+bool KwmIsGlobalStatement(config_statement *Statement);
+
+bool KwmConfigStatementsAreEqual(config_statement *A, config_statement *B);
+bool KwmConfigSectionChanged(kwm_config *Old, kwm_config *New, config_section Section);
+std::vector<std::string> KwmNewConfigExecs(kwm_config *Old, kwm_config *New);
+
+#endif
@@ -1,6 +1,7 @@
 #include "container.h"
 #include "node.h"
 #include "space.h"
+#include "axlib/trace.h"
 
 #define internal static
 
@@ -167,6 +168,7 @@ void ResizeLinkNodeContainers(tree_node *Root)
 
 void CreateNodeContainers(ax_display *Display, tree_node *Node, bool OptimalSplit)
 {
+    AXLibTraceFunction("layout");
     if(Node && Node->LeftChild && Node->RightChild)
     {
         Node->SplitMode = OptimalSplit ? GetOptimalSplitMode(Node) : Node->SplitMode;
@@ -177,6 +179,30 @@ void CreateNodeContainers(ax_display *Display, tree_node *Node, bool OptimalSpli
     }
 }
 
+internal void
+ResizeAllLinkNodeContainers(tree_node *Node)
+{
+    ResizeLinkNodeContainers(Node);
+    if(Node->LeftChild && Node->RightChild)
+    {
+        ResizeAllLinkNodeContainers(Node->LeftChild);
+        ResizeAllLinkNodeContainers(Node->RightChild);
+    }
+}
+
+/* NOTE(koekeishiya): Compute every container of a tree that was built from a saved or earlier
+ *                    copy. The split mode of the root is kept when it has one. */
+void CreateNodeTreeContainers(ax_display *Display, tree_node *Root)
+{
+    split_type SplitMode = Root->SplitMode;
+    SetRootNodeContainer(Display, Root);
+    if(SplitMode == SPLIT_VERTICAL || SplitMode == SPLIT_HORIZONTAL)
+        Root->SplitMode = SplitMode;
+
+    CreateNodeContainers(Display, Root, false);
+    ResizeAllLinkNodeContainers(Root);
+}
+
 void CreateDeserializedNodeContainer(ax_display *Display, tree_node *Node)
 {
     int SplitMode = Node->Parent->SplitMode;
@@ -12,5 +12,6 @@ void ResizeNodeContainer(ax_display *Display, tree_node *Node);
 void ResizeLinkNodeContainers(tree_node *Root);
 void CreateNodeContainers(ax_display *Display, tree_node *Node, bool OptimalSplit);
 void CreateDeserializedNodeContainer(ax_display *Display, tree_node *Node);
+void CreateNodeTreeContainers(ax_display *Display, tree_node *Root);
 
 #endif
@@ -1,14 +1,40 @@
 #include "cursor.h"
 #include "axlib/axlib.h"
 #include "space.h"
+#include <atomic>
 
 #define internal static
-extern ax_state AXState;
 extern ax_application *FocusedApplication;
 extern kwm_settings KWMSettings;
+extern kwm_metrics KWMMetrics;
+
+internal std::atomic_flag MouseMovedPending = ATOMIC_FLAG_INIT;
+
+/* NOTE(koekeishiya): At most one AXEvent_MouseMoved is queued at any time. The event does not carry a
+                      position; the cursor is read when it is processed, so it always acts on the latest
+                      sample and mouse moves that arrive in the meantime are simply dropped. If the event
+                      could not be queued the flag is cleared again, or mouse moves would stop for good. */
+void QueueMouseMoved()
+{
+    if(!MouseMovedPending.test_and_set())
+    {
+        ax_event Event = {};
+        Event.Handle = &Callback_AXEvent_MouseMoved;
+        Event.Name = "AXEvent_MouseMoved";
+        if(AXLibAddEvent(Event))
+            ++KWMMetrics.MouseMovedQueued;
+        else
+            MouseMovedPending.clear();
+    }
+    else
+    {
+        ++KWMMetrics.MouseMovedCoalesced;
+    }
+}
 
 EVENT_CALLBACK(Callback_AXEvent_MouseMoved)
 {
+    MouseMovedPending.clear();
     FocusWindowBelowCursor();
 }
 
@@ -66,27 +92,14 @@ void FocusWindowBelowCursor()
     if(WindowID == 0)
         return;
 
-    std::map<pid_t, ax_application>::iterator It;
-    for(It = AXState.Applications.begin(); It != AXState.Applications.end(); ++It)
+    ax_window *Window = AXLibFindWindow(WindowID);
+    if(Window)
     {
-        ax_application *Application = &It->second;
-        ax_window *Window = AXLibFindApplicationWindow(Application, WindowID);
-        if(Window)
+        if((AXLibIsWindowStandard(Window)) ||
+           (AXLibIsWindowCustom(Window)))
         {
-            if((AXLibIsWindowStandard(Window)) ||
-               (AXLibIsWindowCustom(Window)))
-            {
-                if(Application == Window->Application)
-                {
-                    if(FocusedWindow != Window)
-                        AXLibSetFocusedWindow(Window);
-                }
-                else
-                {
-                    AXLibSetFocusedWindow(Window);
-                }
-            }
-            return;
+            if(FocusedWindow != Window)
+                AXLibSetFocusedWindow(Window);
         }
     }
 }
@@ -4,6 +4,7 @@
 #include "axlib/window.h"
 #include <Carbon/Carbon.h>
 
+void QueueMouseMoved();
 void FocusWindowBelowCursor();
 void MoveCursorToCenterOfWindow(ax_window *Window);
 void MoveCursorToCenterOfFocusedWindow();
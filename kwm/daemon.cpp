@@ -1,57 +1,429 @@
 #include "daemon.h"
 #include "interpreter.h"
+#include "poller.h"
+#include "axlib/trace.h"
 
 #define internal static
 
+#define KWM_DAEMON_MAX_MESSAGE 65536
+#define KWM_DAEMON_MAX_PENDING 256
+#define KWM_DAEMON_READ_TIMEOUT 5000
+#define KWM_DAEMON_REPLY_TIMEOUT 30000
+#define KWM_DAEMON_POLL_INTERVAL 1000
+
+/* NOTE(koekeishiya): A client that sends this line first switches its connection to batch mode. Every
+ *                    following line is a command, and each reply, empty or not, is written back in
+ *                    command order terminated by a NUL byte. The connection is closed once the client
+ *                    has shut down its write side and every reply has been flushed. */
+#define KWM_DAEMON_BATCH "@batch"
+
+struct kwm_connection
+{
+    int SockFD;
+    uint32_t ID;
+    uint32_t Interest;
+    std::chrono::steady_clock::time_point Deadline;
+
+    bool Batch;
+    bool ReadClosed;
+    bool WriteBlocked;
+    uint32_t NextSequence;
+    uint32_t FlushSequence;
+    std::map<uint32_t, std::string> Replies;
+
+    std::string ReadBuffer;
+    std::string WriteBuffer;
+};
+
+struct kwm_request
+{
+    int SockFD;
+    uint32_t Connection;
+    uint32_t Sequence;
+};
+
 internal int KwmSockFD;
 internal bool KwmDaemonIsRunning;
 internal int KwmDaemonPort = 3020;
 internal pthread_t KwmDaemonThread;
 
-std::string KwmReadFromSocket(int ClientSockFD)
+internal kwm_poller KwmPoller;
+internal int KwmWakeupFD[2];
+
+/* NOTE(koekeishiya): Commands are identified by a handle instead of the raw socket. Query replies are
+ *                    produced asynchronously on the event thread, and the client may have timed out and
+ *                    its descriptor been reused by the time the reply arrives. A handle records which
+ *                    connection instance it belongs to, so a late reply is dropped instead. */
+internal pthread_mutex_t KwmDaemonLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::map<int, kwm_connection> KwmConnections;
+internal std::map<int, kwm_request> KwmHandles;
+internal int KwmNextHandle = 1;
+internal uint32_t KwmNextConnection = 1;
+
+internal inline std::chrono::steady_clock::time_point
+KwmDaemonDeadline(int Milliseconds)
+{
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(Milliseconds);
+}
+
+internal bool
+KwmSetNonBlocking(int SockFD)
+{
+    int Flags = fcntl(SockFD, F_GETFL, 0);
+    if(Flags == -1)
+        return false;
+
+    fcntl(SockFD, F_SETFD, FD_CLOEXEC);
+    return fcntl(SockFD, F_SETFL, Flags | O_NONBLOCK) != -1;
+}
+
+internal void
+KwmWakeDaemon()
+{
+    char Byte = 0;
+    write(KwmWakeupFD[1], &Byte, 1);
+}
+
+internal inline uint32_t
+KwmPendingRequests(kwm_connection *Connection)
+{
+    return Connection->NextSequence - Connection->FlushSequence;
+}
+
+/* NOTE(koekeishiya): A connection may sit idle for a short while before sending its command. Batch
+ *                    connections and connections with outstanding commands get the longer reply timeout. */
+internal inline void
+KwmRefreshDeadline(kwm_connection *Connection)
+{
+    if(Connection->Batch || KwmPendingRequests(Connection) != 0)
+        Connection->Deadline = KwmDaemonDeadline(KWM_DAEMON_REPLY_TIMEOUT);
+    else
+        Connection->Deadline = KwmDaemonDeadline(KWM_DAEMON_READ_TIMEOUT);
+}
+
+/* NOTE(koekeishiya): Must be called with KwmDaemonLock held. */
+internal void
+KwmCloseConnection(std::map<int, kwm_connection>::iterator It)
+{
+    kwm_connection *Connection = &It->second;
+    KwmPollerUpdate(&KwmPoller, Connection->SockFD, Connection->Interest, 0);
+
+    if(KwmPendingRequests(Connection) != 0)
+    {
+        std::map<int, kwm_request>::iterator Request = KwmHandles.begin();
+        while(Request != KwmHandles.end())
+        {
+            if(Request->second.Connection == Connection->ID)
+                KwmHandles.erase(Request++);
+            else
+                ++Request;
+        }
+    }
+
+    shutdown(Connection->SockFD, SHUT_RDWR);
+    close(Connection->SockFD);
+    KwmConnections.erase(It);
+}
+
+/* NOTE(koekeishiya): Must be called with KwmDaemonLock held. Flushes whatever is ready to be written,
+ *                    closes the connection when it has nothing left to do, and otherwise recomputes
+ *                    which readiness events it is interested in. */
+internal void
+KwmUpdateConnection(std::map<int, kwm_connection>::iterator It)
 {
-    char Cur;
-    std::string Message;
-    while(recv(ClientSockFD, &Cur, 1, 0))
+    kwm_connection *Connection = &It->second;
+    Connection->WriteBlocked = false;
+    while(!Connection->WriteBuffer.empty())
     {
-        if(Cur == '\n')
+#ifdef MSG_NOSIGNAL
+        ssize_t Bytes = send(Connection->SockFD, Connection->WriteBuffer.data(), Connection->WriteBuffer.size(), MSG_NOSIGNAL);
+#else
+        ssize_t Bytes = send(Connection->SockFD, Connection->WriteBuffer.data(), Connection->WriteBuffer.size(), 0);
+#endif
+        if(Bytes > 0)
+        {
+            Connection->WriteBuffer.erase(0, Bytes);
+        }
+        else if(Bytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            Connection->WriteBlocked = true;
             break;
-        Message += Cur;
+        }
+        else
+        {
+            KwmCloseConnection(It);
+            return;
+        }
+    }
+
+    uint32_t Pending = KwmPendingRequests(Connection);
+    bool Flushed = Connection->WriteBuffer.empty();
+    bool Finished = Connection->ReadClosed || (!Connection->Batch && Connection->NextSequence != 0);
+    if(Finished && Pending == 0 && Flushed)
+    {
+        KwmCloseConnection(It);
+        return;
+    }
+
+    uint32_t Interest = 0;
+    if(Connection->WriteBlocked)
+        Interest |= KwmPoller_Write;
+
+    if(!Connection->ReadClosed &&
+       (Connection->Batch ? Pending < KWM_DAEMON_MAX_PENDING : Connection->NextSequence == 0))
+        Interest |= KwmPoller_Read;
+
+    if(Connection->Interest != Interest)
+    {
+        KwmPollerUpdate(&KwmPoller, Connection->SockFD, Connection->Interest, Interest);
+        Connection->Interest = Interest;
     }
-    return Message;
 }
 
-void KwmWriteToSocket(std::string Msg, int ClientSockFD)
+internal void
+KwmAcceptConnections()
+{
+    while(true)
+    {
+        int ClientSockFD = accept(KwmSockFD, NULL, NULL);
+        if(ClientSockFD == -1)
+            break;
+
+        if(!KwmSetNonBlocking(ClientSockFD))
+        {
+            close(ClientSockFD);
+            continue;
+        }
+
+#ifdef SO_NOSIGPIPE
+        int _True = 1;
+        setsockopt(ClientSockFD, SOL_SOCKET, SO_NOSIGPIPE, &_True, sizeof(int));
+#endif
+
+        pthread_mutex_lock(&KwmDaemonLock);
+        kwm_connection *Connection = &KwmConnections[ClientSockFD];
+        Connection->SockFD = ClientSockFD;
+        Connection->ID = KwmNextConnection++;
+        Connection->Interest = 0;
+        Connection->Deadline = KwmDaemonDeadline(KWM_DAEMON_READ_TIMEOUT);
+        KwmUpdateConnection(KwmConnections.find(ClientSockFD));
+        pthread_mutex_unlock(&KwmDaemonLock);
+    }
+}
+
+/* NOTE(koekeishiya): Drain the socket into the read buffer and split off every complete command. A
+ *                    client that closes its end without a trailing newline still has whatever it sent
+ *                    interpreted, matching the old blocking reader. Outside of batch mode only the
+ *                    first command of a connection is taken. Blank lines in batch mode are
+ *                    not commands and get no reply. */
+internal inline bool
+IsBlankMessage(std::string &Message)
+{
+    return Message.find_first_not_of(" \t\r") == std::string::npos;
+}
+
+internal void
+KwmReadConnection(kwm_connection *Connection, std::vector<std::string> &Messages)
+{
+    char Buffer[4096];
+    ssize_t Bytes;
+
+    while((Bytes = recv(Connection->SockFD, Buffer, sizeof(Buffer), 0)) > 0)
+        Connection->ReadBuffer.append(Buffer, Bytes);
+
+    if(Bytes == 0 || (Bytes == -1 && errno != EAGAIN && errno != EWOULDBLOCK))
+        Connection->ReadClosed = true;
+
+    std::size_t Start = 0, Newline;
+    while((Newline = Connection->ReadBuffer.find('\n', Start)) != std::string::npos)
+    {
+        std::string Message = Connection->ReadBuffer.substr(Start, Newline - Start);
+        Start = Newline + 1;
+
+        if(Connection->NextSequence == 0 && !Connection->Batch && Message == KWM_DAEMON_BATCH)
+        {
+            Connection->Batch = true;
+            continue;
+        }
+
+        if(Connection->Batch && IsBlankMessage(Message))
+            continue;
+
+        Messages.push_back(Message);
+        if(!Connection->Batch)
+            break;
+    }
+
+    Connection->ReadBuffer.erase(0, Start);
+    if(Connection->ReadClosed && !Connection->ReadBuffer.empty() &&
+       (Connection->Batch || Messages.empty()))
+    {
+        if(!Connection->Batch || !IsBlankMessage(Connection->ReadBuffer))
+            Messages.push_back(Connection->ReadBuffer);
+        Connection->ReadBuffer.clear();
+    }
+
+    if(!Connection->Batch && !Messages.empty())
+        Connection->ReadBuffer.clear();
+}
+
+internal void
+KwmHandleReadable(int ClientSockFD)
+{
+    std::vector<std::string> Messages;
+    std::vector<int> Handles;
+
+    pthread_mutex_lock(&KwmDaemonLock);
+    std::map<int, kwm_connection>::iterator It = KwmConnections.find(ClientSockFD);
+    if(It == KwmConnections.end())
+    {
+        pthread_mutex_unlock(&KwmDaemonLock);
+        return;
+    }
+
+    kwm_connection *Connection = &It->second;
+    KwmReadConnection(Connection, Messages);
+    if(Connection->ReadBuffer.size() > KWM_DAEMON_MAX_MESSAGE)
+    {
+        KwmCloseConnection(It);
+        pthread_mutex_unlock(&KwmDaemonLock);
+        return;
+    }
+
+    for(std::size_t Index = 0; Index < Messages.size(); ++Index)
+    {
+        int Handle = KwmNextHandle;
+        KwmNextHandle = KwmNextHandle == INT_MAX ? 1 : KwmNextHandle + 1;
+
+        kwm_request Request = { ClientSockFD, Connection->ID, Connection->NextSequence++ };
+        KwmHandles[Handle] = Request;
+        Handles.push_back(Handle);
+    }
+
+    KwmRefreshDeadline(Connection);
+    KwmUpdateConnection(It);
+    pthread_mutex_unlock(&KwmDaemonLock);
+
+    /* NOTE(koekeishiya): The interpreter may reply synchronously through KwmWriteToSocket,
+     *                    so the lock must not be held while it runs. */
+    for(std::size_t Index = 0; Index < Messages.size(); ++Index)
+        KwmInterpretCommand(Messages[Index], Handles[Index]);
+}
+
+internal void
+KwmHandleWritable(int ClientSockFD)
+{
+    pthread_mutex_lock(&KwmDaemonLock);
+    std::map<int, kwm_connection>::iterator It = KwmConnections.find(ClientSockFD);
+    if(It != KwmConnections.end())
+        KwmUpdateConnection(It);
+    pthread_mutex_unlock(&KwmDaemonLock);
+}
+
+/* NOTE(koekeishiya): Flush replies handed over by other threads and drop
+ *                    connections that exceeded their read or reply deadline. */
+internal void
+KwmServiceConnections()
 {
-    send(ClientSockFD, Msg.c_str(), Msg.size(), 0);
-    shutdown(ClientSockFD, SHUT_RDWR);
-    close(ClientSockFD);
+    char Buffer[64];
+    while(read(KwmWakeupFD[0], Buffer, sizeof(Buffer)) > 0);
+
+    std::chrono::steady_clock::time_point Now = std::chrono::steady_clock::now();
+    pthread_mutex_lock(&KwmDaemonLock);
+    std::map<int, kwm_connection>::iterator It = KwmConnections.begin();
+    while(It != KwmConnections.end())
+    {
+        std::map<int, kwm_connection>::iterator Current = It++;
+        kwm_connection *Connection = &Current->second;
+
+        if(Now >= Connection->Deadline)
+            KwmCloseConnection(Current);
+        else if(!Connection->WriteBlocked)
+            KwmUpdateConnection(Current);
+    }
+    pthread_mutex_unlock(&KwmDaemonLock);
 }
 
 internal void *
 KwmDaemonHandleConnectionBG(void *)
 {
+    AXLibSetTraceThreadName("daemon");
+    kwm_poller_event Events[KWM_POLLER_MAX_EVENTS];
     while(KwmDaemonIsRunning)
     {
-        int ClientSockFD;
-        struct sockaddr_in ClientAddr;
-        socklen_t SinSize = sizeof(struct sockaddr);
-
-        ClientSockFD = accept(KwmSockFD, (struct sockaddr*)&ClientAddr, &SinSize);
-        if(ClientSockFD != -1)
+        int Ready = KwmPollerWait(&KwmPoller, Events, KWM_POLLER_MAX_EVENTS, KWM_DAEMON_POLL_INTERVAL);
+        for(int Index = 0; Index < Ready; ++Index)
         {
-            std::string Message = KwmReadFromSocket(ClientSockFD);
-            KwmInterpretCommand(Message, ClientSockFD);
+            if(Events[Index].FD == KwmSockFD)
+                KwmAcceptConnections();
+            else if(Events[Index].FD == KwmWakeupFD[0])
+                continue;
+            else if(Events[Index].Flags & KwmPoller_Write)
+                KwmHandleWritable(Events[Index].FD);
+            else if(Events[Index].Flags & (KwmPoller_Read | KwmPoller_Hangup))
+                KwmHandleReadable(Events[Index].FD);
         }
+
+        KwmServiceConnections();
     }
 
+    pthread_mutex_lock(&KwmDaemonLock);
+    while(!KwmConnections.empty())
+        KwmCloseConnection(KwmConnections.begin());
+    pthread_mutex_unlock(&KwmDaemonLock);
+
+    KwmPollerDestroy(&KwmPoller);
+    close(KwmSockFD);
     return NULL;
 }
 
+/* NOTE(koekeishiya): Hand a reply to the daemon thread. Replies are released to the client in the order
+ *                    the commands were received, regardless of the order they complete in. Safe to call
+ *                    from any thread. Replies for unknown handles, such as commands issued by the config
+ *                    parser or for connections that have already timed out, are discarded. */
+void KwmWriteToSocket(std::string Msg, int ClientSockFD)
+{
+    pthread_mutex_lock(&KwmDaemonLock);
+    std::map<int, kwm_request>::iterator It = KwmHandles.find(ClientSockFD);
+    if(It != KwmHandles.end())
+    {
+        kwm_request Request = It->second;
+        KwmHandles.erase(It);
+
+        std::map<int, kwm_connection>::iterator Owner = KwmConnections.find(Request.SockFD);
+        if(Owner != KwmConnections.end() && Owner->second.ID == Request.Connection)
+        {
+            kwm_connection *Connection = &Owner->second;
+            if(Connection->Batch)
+                Msg.push_back('\0');
+
+            Connection->Replies[Request.Sequence] = Msg;
+            std::map<uint32_t, std::string>::iterator Reply;
+            while((Reply = Connection->Replies.find(Connection->FlushSequence)) != Connection->Replies.end())
+            {
+                Connection->WriteBuffer += Reply->second;
+                Connection->Replies.erase(Reply);
+                ++Connection->FlushSequence;
+            }
+
+            KwmRefreshDeadline(Connection);
+            KwmWakeDaemon();
+        }
+    }
+    pthread_mutex_unlock(&KwmDaemonLock);
+}
+
+void KwmCloseSocket(int ClientSockFD)
+{
+    KwmWriteToSocket("", ClientSockFD);
+}
+
+/* NOTE(koekeishiya): Returns once the daemon thread has closed every connection. */
 void KwmTerminateDaemon()
 {
     KwmDaemonIsRunning = false;
-    close(KwmSockFD);
+    KwmWakeDaemon();
+    pthread_join(KwmDaemonThread, NULL);
 }
 
 bool KwmStartDaemon()
@@ -73,9 +445,24 @@ bool KwmStartDaemon()
     if(bind(KwmSockFD, (struct sockaddr*)&SrvAddr, sizeof(struct sockaddr)) == -1)
         return false;
 
-    if(listen(KwmSockFD, 10) == -1)
+    if(listen(KwmSockFD, SOMAXCONN) == -1)
         return false;
 
+    if(!KwmSetNonBlocking(KwmSockFD))
+        return false;
+
+    if(pipe(KwmWakeupFD) == -1)
+        return false;
+
+    KwmSetNonBlocking(KwmWakeupFD[0]);
+    KwmSetNonBlocking(KwmWakeupFD[1]);
+
+    if(!KwmPollerCreate(&KwmPoller))
+        return false;
+
+    KwmPollerUpdate(&KwmPoller, KwmSockFD, 0, KwmPoller_Read);
+    KwmPollerUpdate(&KwmPoller, KwmWakeupFD[0], 0, KwmPoller_Read);
+
     KwmDaemonIsRunning = true;
     pthread_create(&KwmDaemonThread, NULL, &KwmDaemonHandleConnectionBG, NULL);
     return true;
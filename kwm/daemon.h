@@ -6,14 +6,20 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <limits.h>
 #include <pthread.h>
 #include <string.h>
 #include <string>
+#include <map>
+#include <vector>
+#include <chrono>
 
 bool KwmStartDaemon();
 void KwmTerminateDaemon();
 
-std::string KwmReadFromSocket(int ClientSockFD);
 void KwmWriteToSocket(std::string Msg, int ClientSockFD);
+void KwmCloseSocket(int ClientSockFD);
 
 #endif
@@ -5,8 +5,11 @@
 #include "window.h"
 #include "cursor.h"
 
+#define internal static
+
 extern std::map<std::string, space_info> WindowTree;
 extern kwm_settings KWMSettings;
+extern ax_state AXState;
 
 void SetDefaultPaddingOfDisplay(container_offset Offset)
 {
@@ -64,6 +67,7 @@ void ChangePaddingOfDisplay(const std::string &Side, int Offset)
             Space->Settings.Offset.PaddingBottom += Offset;
     }
 
+    Space->Overrides |= SpaceOverride_Offset;
     UpdateSpaceOfDisplay(Display, Space);
 }
 
@@ -93,6 +97,7 @@ void ChangeGapOfDisplay(const std::string &Side, int Offset)
             Space->Settings.Offset.HorizontalGap += Offset;
     }
 
+    Space->Overrides |= SpaceOverride_Offset;
     UpdateSpaceOfDisplay(Display, Space);
 }
 
@@ -128,6 +133,19 @@ space_settings *GetSpaceSettingsForDisplay(unsigned int ScreenID)
         return NULL;
 }
 
+space_settings *GetOrCreateSpaceSettingsForDisplay(unsigned int ScreenID)
+{
+    space_settings *DisplaySettings = GetSpaceSettingsForDisplay(ScreenID);
+    if(!DisplaySettings)
+    {
+        space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", "" };
+        KWMSettings.DisplaySettings[ScreenID] = NULLSpaceSettings;
+        DisplaySettings = &KWMSettings.DisplaySettings[ScreenID];
+    }
+
+    return DisplaySettings;
+}
+
 void UpdateSpaceOfDisplay(ax_display *Display, space_info *Space)
 {
     if(Space->RootNode)
@@ -152,6 +170,62 @@ void UpdateSpaceOfDisplay(ax_display *Display, space_info *Space)
     }
 }
 
+internal inline bool
+ContainerOffsetsAreEqual(container_offset *A, container_offset *B)
+{
+    return A->PaddingTop == B->PaddingTop &&
+           A->PaddingBottom == B->PaddingBottom &&
+           A->PaddingLeft == B->PaddingLeft &&
+           A->PaddingRight == B->PaddingRight &&
+           A->VerticalGap == B->VerticalGap &&
+           A->HorizontalGap == B->HorizontalGap;
+}
+
+/* NOTE(koekeishiya): Called after the space and display settings have been replaced. Only spaces
+ *                    whose resolved settings differ from what Previous resolves to are touched,
+ *                    and only those are laid out again; the active space of a display right away,
+ *                    the others when they are next visited. The tiling mode of a space that already
+ *                    has a tree is left alone, since changing it means rebuilding that tree.
+ *                    Returns the number of spaces that were changed. */
+int UpdateSpaceSettings(kwm_settings *Previous)
+{
+    int Result = 0;
+    std::map<CGDirectDisplayID, ax_display>::iterator DisplayIt;
+    for(DisplayIt = AXState.Displays.begin(); DisplayIt != AXState.Displays.end(); ++DisplayIt)
+    {
+        ax_display *Display = &DisplayIt->second;
+        std::map<CGSSpaceID, ax_space>::iterator SpaceIt;
+        for(SpaceIt = Display->Spaces.begin(); SpaceIt != Display->Spaces.end(); ++SpaceIt)
+        {
+            ax_space *Space = &SpaceIt->second;
+            std::map<std::string, space_info>::iterator It = WindowTree.find(Space->Identifier);
+            if(It == WindowTree.end() || !It->second.Initialized)
+                continue;
+
+            int DesktopID = AXLibDesktopIDFromCGSSpaceID(Display, Space->ID);
+            space_settings Old = ResolveSpaceSettings(Previous, Display->ArrangementID, DesktopID);
+            space_settings New = ResolveSpaceSettings(&KWMSettings, Display->ArrangementID, DesktopID);
+            if(ContainerOffsetsAreEqual(&Old.Offset, &New.Offset) &&
+               Old.Name == New.Name && Old.Layout == New.Layout)
+                continue;
+
+            space_info *SpaceInfo = &It->second;
+            SpaceInfo->Settings.Offset = New.Offset;
+            SpaceInfo->Settings.Name = New.Name;
+            SpaceInfo->Settings.Layout = New.Layout;
+            SpaceInfo->Overrides &= ~(SpaceOverride_Offset | SpaceOverride_Name);
+            ++Result;
+
+            if(Space == Display->Space)
+                UpdateSpaceOfDisplay(Display, SpaceInfo);
+            else
+                SpaceInfo->ResolutionChanged = true;
+        }
+    }
+
+    return Result;
+}
+
 void FocusDisplay(ax_display *Display)
 {
     if(Display)
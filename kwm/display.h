@@ -5,11 +5,13 @@
 #include "axlib/axlib.h"
 
 void UpdateSpaceOfDisplay(ax_display *Display, space_info *Space);
+int UpdateSpaceSettings(kwm_settings *Previous);
 void SetDefaultPaddingOfDisplay(container_offset Offset);
 void SetDefaultGapOfDisplay(container_offset Offset);
 void ChangePaddingOfDisplay(const std::string &Side, int Offset);
 void ChangeGapOfDisplay(const std::string &Side, int Offset);
 space_settings *GetSpaceSettingsForDisplay(unsigned int ScreenID);
+space_settings *GetOrCreateSpaceSettingsForDisplay(unsigned int ScreenID);
 container_offset CreateDefaultDisplayOffset();
 void MoveWindowToDisplay(ax_window *Window, int Shift, bool Relative);
 void FocusDisplay(ax_display *Display);
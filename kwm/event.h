@@ -42,6 +42,12 @@ extern EVENT_CALLBACK(Callback_KWMEvent_QueryNodePosition);
 extern EVENT_CALLBACK(Callback_KWMEvent_QueryParentNodeState);
 extern EVENT_CALLBACK(Callback_KWMEvent_QueryWindowIdInDirectionOfFocusedWindow);
 extern EVENT_CALLBACK(Callback_KWMEvent_QueryScratchpad);
+extern EVENT_CALLBACK(Callback_KWMEvent_QueryMetrics);
+extern EVENT_CALLBACK(Callback_KWMEvent_QueryLog);
+extern EVENT_CALLBACK(Callback_KWMEvent_QueryExec);
+
+extern EVENT_CALLBACK(Callback_KWMEvent_SaveState);
+extern EVENT_CALLBACK(Callback_KWMEvent_PrefixTimeout);
 
 enum kwm_event_type
 {
@@ -83,6 +89,12 @@ enum kwm_event_type
     KWMEvent_QueryParentNodeState,
     KWMEvent_QueryWindowIdInDirectionOfFocusedWindow,
     KWMEvent_QueryScratchpad,
+    KWMEvent_QueryMetrics,
+    KWMEvent_QueryLog,
+    KWMEvent_QueryExec,
+
+    KWMEvent_SaveState,
+    KWMEvent_PrefixTimeout,
 };
 
 inline void *
@@ -99,7 +111,18 @@ KwmCreateContext(int Id)
          Event.Context = EventContext; \
          Event.Intrinsic = false; \
          Event.Handle = &Callback_##EventType; \
+         Event.Name = #EventType; \
          AXLibAddEvent(Event); \
        } while(0)
 
+/* NOTE(koekeishiya): As KwmConstructEvent, but the event is posted after the given number of seconds. */
+#define KwmConstructTimedEvent(EventTimer, Seconds, EventType, EventContext) \
+    do { ax_event Event = {}; \
+         Event.Context = EventContext; \
+         Event.Intrinsic = false; \
+         Event.Handle = &Callback_##EventType; \
+         Event.Name = #EventType; \
+         AXLibScheduleEvent(EventTimer, Seconds, Event); \
+       } while(0)
+
 #endif
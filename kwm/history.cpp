@@ -0,0 +1,254 @@
+#include "history.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include <vector>
+
+#define internal static
+
+/* NOTE(koekeishiya): Versions of a tree are immutable and share every subtree that did not
+ *                    change between them, so a new version only costs the nodes on the
+ *                    paths that were modified. Nodes are reference counted and freed once
+ *                    no version points to them anymore. */
+struct layout_version_node
+{
+    int RefCount;
+    uint32_t WindowID;
+    node_type Type;
+    split_type SplitMode;
+    double SplitRatio;
+    std::vector<uint32_t> Links;
+
+    layout_version_node *LeftChild;
+    layout_version_node *RightChild;
+};
+
+struct layout_version
+{
+    space_tiling_option Mode;
+    layout_version_node *Root;
+};
+
+struct layout_history
+{
+    std::vector<layout_version> Versions;
+    std::size_t Current;
+};
+
+internal pthread_mutex_t LayoutHistoryLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::map<std::string, layout_history> LayoutHistory;
+internal uint64_t LayoutHistoryVersions;
+internal uint64_t LayoutHistoryNodes;
+
+internal void
+ReleaseLayoutNode(layout_version_node *Node)
+{
+    if(Node && --Node->RefCount == 0)
+    {
+        ReleaseLayoutNode(Node->LeftChild);
+        ReleaseLayoutNode(Node->RightChild);
+        delete Node;
+        --LayoutHistoryNodes;
+    }
+}
+
+/* NOTE(koekeishiya): The split of a leaf is only used once it is split again and is not
+ *                    part of its layout, so it is ignored when comparing leaves. */
+internal bool
+LayoutNodeMatches(layout_version_node *Version, tree_node *Node)
+{
+    if(Version->WindowID != Node->WindowID || Version->Type != Node->Type)
+        return false;
+
+    if(Node->LeftChild && Node->RightChild &&
+       (Version->SplitMode != Node->SplitMode || Version->SplitRatio != Node->SplitRatio))
+        return false;
+
+    std::size_t Index = 0;
+    for(link_node *Link = Node->List; Link; Link = Link->Next, ++Index)
+    {
+        if(Index == Version->Links.size() || Version->Links[Index] != Link->WindowID)
+            return false;
+    }
+
+    return Index == Version->Links.size();
+}
+
+/* NOTE(koekeishiya): Returns a referenced version of Node. Subtrees that match the previous
+ *                    version are shared instead of copied. */
+internal layout_version_node *
+CaptureLayoutNode(tree_node *Node, layout_version_node *Previous)
+{
+    layout_version_node *LeftChild = NULL;
+    layout_version_node *RightChild = NULL;
+    if(Node->LeftChild && Node->RightChild)
+    {
+        LeftChild = CaptureLayoutNode(Node->LeftChild, Previous ? Previous->LeftChild : NULL);
+        RightChild = CaptureLayoutNode(Node->RightChild, Previous ? Previous->RightChild : NULL);
+    }
+
+    if(Previous &&
+       Previous->LeftChild == LeftChild &&
+       Previous->RightChild == RightChild &&
+       LayoutNodeMatches(Previous, Node))
+    {
+        ReleaseLayoutNode(LeftChild);
+        ReleaseLayoutNode(RightChild);
+        ++Previous->RefCount;
+        return Previous;
+    }
+
+    layout_version_node *Version = new layout_version_node;
+    Version->RefCount = 1;
+    Version->WindowID = Node->WindowID;
+    Version->Type = Node->Type;
+    Version->SplitMode = Node->SplitMode;
+    Version->SplitRatio = Node->SplitRatio;
+    Version->LeftChild = LeftChild;
+    Version->RightChild = RightChild;
+
+    for(link_node *Link = Node->List; Link; Link = Link->Next)
+        Version->Links.push_back(Link->WindowID);
+
+    ++LayoutHistoryNodes;
+    return Version;
+}
+
+internal tree_node *
+CreateTreeFromLayoutNode(layout_version_node *Version, tree_node *Parent)
+{
+    tree_node *Node = (tree_node *) malloc(sizeof(tree_node));
+    memset(Node, 0, sizeof(tree_node));
+
+    Node->Parent = Parent;
+    Node->WindowID = Version->WindowID;
+    Node->Type = Version->Type;
+    Node->SplitMode = Version->SplitMode;
+    Node->SplitRatio = Version->SplitRatio;
+
+    link_node *Prev = NULL;
+    for(std::size_t Index = 0; Index < Version->Links.size(); ++Index)
+    {
+        link_node *Link = (link_node *) malloc(sizeof(link_node));
+        memset(Link, 0, sizeof(link_node));
+
+        Link->WindowID = Version->Links[Index];
+        Link->Prev = Prev;
+
+        if(Prev)
+            Prev->Next = Link;
+        else
+            Node->List = Link;
+
+        Prev = Link;
+    }
+
+    if(Version->LeftChild && Version->RightChild)
+    {
+        Node->LeftChild = CreateTreeFromLayoutNode(Version->LeftChild, Node);
+        Node->RightChild = CreateTreeFromLayoutNode(Version->RightChild, Node);
+    }
+
+    return Node;
+}
+
+/* NOTE(koekeishiya): Adds the tree as a new version after the one we are at, unless it is equal to
+ *                    that version. When DropUndone is set the versions that were undone are
+ *                    dropped first; otherwise they are kept after the new version, so that they
+ *                    can still be redone. Once the history is full the oldest version is dropped,
+ *                    or the newest one if the version we are at is the oldest. */
+internal bool
+AddLayoutVersion(layout_history *History, tree_node *RootNode, space_tiling_option Mode, bool DropUndone)
+{
+    layout_version *Current = History->Versions.empty() ? NULL : &History->Versions[History->Current];
+
+    layout_version Version = { Mode, NULL };
+    Version.Root = CaptureLayoutNode(RootNode, Current ? Current->Root : NULL);
+    if(Current && Current->Root == Version.Root && Current->Mode == Version.Mode)
+    {
+        ReleaseLayoutNode(Version.Root);
+        return false;
+    }
+
+    while(DropUndone && History->Versions.size() > History->Current + 1)
+    {
+        ReleaseLayoutNode(History->Versions.back().Root);
+        History->Versions.pop_back();
+        --LayoutHistoryVersions;
+    }
+
+    if(History->Versions.size() == KWM_LAYOUT_HISTORY_LIMIT)
+    {
+        if(History->Current > 0)
+        {
+            ReleaseLayoutNode(History->Versions.front().Root);
+            History->Versions.erase(History->Versions.begin());
+            --History->Current;
+        }
+        else
+        {
+            ReleaseLayoutNode(History->Versions.back().Root);
+            History->Versions.pop_back();
+        }
+
+        --LayoutHistoryVersions;
+    }
+
+    std::size_t Index = History->Versions.empty() ? 0 : History->Current + 1;
+    History->Versions.insert(History->Versions.begin() + Index, Version);
+    History->Current = Index;
+    ++LayoutHistoryVersions;
+    return true;
+}
+
+/* NOTE(koekeishiya): Adds the current tree of the space as a new version. Versions that were
+ *                    undone are dropped, as the tree was changed after undoing them. */
+bool RecordLayoutHistory(std::string Space, tree_node *RootNode, space_tiling_option Mode)
+{
+    if(!RootNode)
+        return false;
+
+    pthread_mutex_lock(&LayoutHistoryLock);
+    bool Result = AddLayoutVersion(&LayoutHistory[Space], RootNode, Mode, true);
+    pthread_mutex_unlock(&LayoutHistoryLock);
+    return Result;
+}
+
+/* NOTE(koekeishiya): Moves Step versions back or forth in the history of the space and returns
+ *                    a new tree for that version, or NULL if there is none. The current tree
+ *                    is added first, so that changes made since the last version can be
+ *                    undone as well, but without dropping the versions that can be redone.
+ *                    If the space has no tree, undo returns to the version we are at. */
+tree_node *StepLayoutHistory(std::string Space, tree_node *RootNode, space_tiling_option *Mode, int Step)
+{
+    tree_node *Result = NULL;
+    pthread_mutex_lock(&LayoutHistoryLock);
+
+    layout_history *History = &LayoutHistory[Space];
+    if(RootNode)
+        AddLayoutVersion(History, RootNode, *Mode, false);
+
+    if(!RootNode && Step < 0)
+        ++Step;
+
+    int Target = (int) History->Current + Step;
+    if(!History->Versions.empty() && Target >= 0 && Target < (int) History->Versions.size())
+    {
+        History->Current = Target;
+        *Mode = History->Versions[Target].Mode;
+        Result = CreateTreeFromLayoutNode(History->Versions[Target].Root, NULL);
+    }
+
+    pthread_mutex_unlock(&LayoutHistoryLock);
+    return Result;
+}
+
+void GetLayoutHistoryUsage(uint64_t *Versions, uint64_t *Nodes)
+{
+    pthread_mutex_lock(&LayoutHistoryLock);
+    *Versions = LayoutHistoryVersions;
+    *Nodes = LayoutHistoryNodes;
+    pthread_mutex_unlock(&LayoutHistoryLock);
+}
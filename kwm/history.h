@@ -0,0 +1,15 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "statement.h"
+#include "treenode.h"
+
+#define KWM_LAYOUT_HISTORY_LIMIT 64
+
+/* NOTE(koekeishiya): The history of every space is keyed by its identifier. These functions are
+ *                    called from both the daemon and the event thread, and lock the history. */
+bool RecordLayoutHistory(std::string Space, tree_node *RootNode, space_tiling_option Mode);
+tree_node *StepLayoutHistory(std::string Space, tree_node *RootNode, space_tiling_option *Mode, int Step);
+void GetLayoutHistoryUsage(uint64_t *Versions, uint64_t *Nodes);
+
+#endif
@@ -24,6 +24,7 @@ extern std::map<std::string, space_info> WindowTree;
 extern ax_application *FocusedApplication;
 extern ax_window *MarkedWindow;
 
+extern kwm_path KWMPath;
 extern kwm_settings KWMSettings;;
 extern kwm_border FocusedBorder;
 extern kwm_border MarkedBorder;
@@ -35,6 +36,27 @@ KwmConfigCommand(std::vector<std::string> &Tokens)
     {
         KwmReloadConfig();
     }
+    else if(Tokens[1] == "watch")
+    {
+        if(Tokens[2] == "on")
+            KwmSetConfigWatch(true);
+        else if(Tokens[2] == "off")
+            KwmSetConfigWatch(false);
+    }
+    else if(Tokens[1] == "log-level")
+    {
+        kwm_log_level Level;
+        if(KwmParseLogLevel(Tokens[2], &Level))
+            KwmSetLogLevel(Level);
+    }
+    else if(Tokens[1] == "log-category")
+    {
+        uint32_t Category = KwmParseLogCategory(Tokens[2]);
+        if(Tokens[3] == "on")
+            KwmSetLogCategory(Category, true);
+        else if(Tokens[3] == "off")
+            KwmSetLogCategory(Category, false);
+    }
     else if(Tokens[1] == "optimal-ratio")
     {
         KWMSettings.OptimalRatio = ConvertStringToDouble(Tokens[2]);
@@ -130,19 +152,7 @@ KwmConfigCommand(std::vector<std::string> &Tokens)
     {
         int ScreenID = ConvertStringToInt(Tokens[2]);
         int DesktopID = ConvertStringToInt(Tokens[3]);
-        space_settings *SpaceSettings = GetSpaceSettingsForDesktopID(ScreenID, DesktopID);
-        if(!SpaceSettings)
-        {
-            space_identifier Lookup = { ScreenID, DesktopID };
-            space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", ""};
-
-            space_settings *ScreenSettings = GetSpaceSettingsForDisplay(ScreenID);
-            if(ScreenSettings)
-                NULLSpaceSettings = *ScreenSettings;
-
-            KWMSettings.SpaceSettings[Lookup] = NULLSpaceSettings;
-            SpaceSettings = &KWMSettings.SpaceSettings[Lookup];
-        }
+        space_settings *SpaceSettings = GetOrCreateSpaceSettingsForDesktopID(ScreenID, DesktopID);
 
         if(Tokens[4] == "mode")
         {
@@ -177,13 +187,7 @@ KwmConfigCommand(std::vector<std::string> &Tokens)
     else if(Tokens[1] == "display")
     {
         int ScreenID = ConvertStringToInt(Tokens[2]);
-        space_settings *DisplaySettings = GetSpaceSettingsForDisplay(ScreenID);
-        if(!DisplaySettings)
-        {
-            space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", "" };
-            KWMSettings.DisplaySettings[ScreenID] = NULLSpaceSettings;
-            DisplaySettings = &KWMSettings.DisplaySettings[ScreenID];
-        }
+        space_settings *DisplaySettings = GetOrCreateSpaceSettingsForDisplay(ScreenID);
 
         if(Tokens[3] == "mode")
         {
@@ -295,143 +299,180 @@ KwmConfigCommand(std::vector<std::string> &Tokens)
     }
 }
 
-internal void
+/* NOTE(koekeishiya): Missing arguments read as an empty token, so a short query falls through to
+                      the unmatched case instead of indexing past the end of Tokens. */
+internal inline std::string
+KwmQueryToken(std::vector<std::string> &Tokens, std::size_t Index)
+{
+    return Index < Tokens.size() ? Tokens[Index] : std::string();
+}
+
+/* NOTE(koekeishiya): Queue a query event, which replies to the client, and return from KwmQueryCommand. */
+#define KwmQueryEvent(EventType, ClientSockFD) \
+    do { KwmConstructEvent(EventType, KwmCreateContext(ClientSockFD)); \
+         return true; \
+       } while(0)
+
+/* NOTE(koekeishiya): Returns true if an event was queued that will reply to the client. Every
+                      other query is answered with an empty reply by the caller, so that a batch
+                      connection never waits on a slot that will not be filled. */
+internal bool
 KwmQueryCommand(std::vector<std::string> &Tokens, int ClientSockFD)
 {
-    if(Tokens[1] == "tiling")
-    {
-        if(Tokens[2] == "mode")
-            KwmConstructEvent(KWMEvent_QueryTilingMode, KwmCreateContext(ClientSockFD));
-        else if(Tokens[2] == "spawn")
-            KwmConstructEvent(KWMEvent_QuerySpawnPosition, KwmCreateContext(ClientSockFD));
-        else if(Tokens[2] == "split-mode")
-            KwmConstructEvent(KWMEvent_QuerySplitMode, KwmCreateContext(ClientSockFD));
-        else if(Tokens[2] == "split-ratio")
-            KwmConstructEvent(KWMEvent_QuerySplitRatio, KwmCreateContext(ClientSockFD));
-    }
-    else if(Tokens[1] == "window")
-    {
-        if(Tokens[2] == "focused")
-        {
-            if(Tokens[3] == "id")
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowId, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "name")
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowName, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "split")
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowSplit, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "float")
-                KwmConstructEvent(KWMEvent_QueryFocusedWindowFloat, KwmCreateContext(ClientSockFD));
-            else
+    std::string Object = KwmQueryToken(Tokens, 1);
+    std::string Property = KwmQueryToken(Tokens, 2);
+    std::string Value = KwmQueryToken(Tokens, 3);
+
+    if(Object == "tiling")
+    {
+        if(Property == "mode")
+            KwmQueryEvent(KWMEvent_QueryTilingMode, ClientSockFD);
+        else if(Property == "spawn")
+            KwmQueryEvent(KWMEvent_QuerySpawnPosition, ClientSockFD);
+        else if(Property == "split-mode")
+            KwmQueryEvent(KWMEvent_QuerySplitMode, ClientSockFD);
+        else if(Property == "split-ratio")
+            KwmQueryEvent(KWMEvent_QuerySplitRatio, ClientSockFD);
+    }
+    else if(Object == "window")
+    {
+        if(Property == "focused")
+        {
+            if(Value == "id")
+                KwmQueryEvent(KWMEvent_QueryFocusedWindowId, ClientSockFD);
+            else if(Value == "name")
+                KwmQueryEvent(KWMEvent_QueryFocusedWindowName, ClientSockFD);
+            else if(Value == "split")
+                KwmQueryEvent(KWMEvent_QueryFocusedWindowSplit, ClientSockFD);
+            else if(Value == "float")
+                KwmQueryEvent(KWMEvent_QueryFocusedWindowFloat, ClientSockFD);
+            else if(Value == "north" || Value == "east" ||
+                    Value == "south" || Value == "west")
             {
                 int *Args = (int *) malloc(sizeof(int) * 2);
                 *Args = ClientSockFD;
 
-                if(Tokens[3] == "north")
+                if(Value == "north")
                     *(Args + 1) = 0;
-                else if(Tokens[3] == "east")
+                else if(Value == "east")
                     *(Args + 1) = 90;
-                else if(Tokens[3] == "south")
+                else if(Value == "south")
                     *(Args + 1) = 180;
-                else if(Tokens[3] == "west")
+                else if(Value == "west")
                     *(Args + 1) = 270;
-                else
-                    *(Args + 1) = 0;
 
                 KwmConstructEvent(KWMEvent_QueryWindowIdInDirectionOfFocusedWindow, Args);
+                return true;
             }
         }
-        else if(Tokens[2] == "marked")
+        else if(Property == "marked")
         {
-            if(Tokens[3] == "id")
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowId, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "name")
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowName, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "split")
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowSplit, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "float")
-                KwmConstructEvent(KWMEvent_QueryMarkedWindowFloat, KwmCreateContext(ClientSockFD));
+            if(Value == "id")
+                KwmQueryEvent(KWMEvent_QueryMarkedWindowId, ClientSockFD);
+            else if(Value == "name")
+                KwmQueryEvent(KWMEvent_QueryMarkedWindowName, ClientSockFD);
+            else if(Value == "split")
+                KwmQueryEvent(KWMEvent_QueryMarkedWindowSplit, ClientSockFD);
+            else if(Value == "float")
+                KwmQueryEvent(KWMEvent_QueryMarkedWindowFloat, ClientSockFD);
         }
-        else if(Tokens[2] == "parent")
+        else if(Property == "parent" && Tokens.size() > 4)
         {
             int *Args = (int *) malloc(sizeof(int) * 3);
             *Args = ClientSockFD;
             *(Args + 1) = ConvertStringToInt(Tokens[3]);
             *(Args + 2) = ConvertStringToInt(Tokens[4]);
             KwmConstructEvent(KWMEvent_QueryParentNodeState, Args);
+            return true;
         }
-        else if(Tokens[2] == "child")
+        else if(Property == "child" && Tokens.size() > 3)
         {
             int *Args = (int *) malloc(sizeof(int) * 2);
             *Args = ClientSockFD;
             *(Args + 1) = ConvertStringToInt(Tokens[3]);
             KwmConstructEvent(KWMEvent_QueryNodePosition, Args);
+            return true;
         }
-        else if(Tokens[2] == "list")
+        else if(Property == "list")
         {
-            KwmConstructEvent(KWMEvent_QueryWindowList, KwmCreateContext(ClientSockFD));
+            KwmQueryEvent(KWMEvent_QueryWindowList, ClientSockFD);
         }
     }
-    else if(Tokens[1] == "scratchpad")
+    else if(Object == "scratchpad")
     {
-        if(Tokens[2] == "list")
-        {
-            KwmConstructEvent(KWMEvent_QueryScratchpad, KwmCreateContext(ClientSockFD));
-        }
+        if(Property == "list")
+            KwmQueryEvent(KWMEvent_QueryScratchpad, ClientSockFD);
     }
-    else if(Tokens[1] == "space")
+    else if(Object == "space")
     {
-        if(Tokens[2] == "active")
+        if(Property == "active")
         {
-            if(Tokens[3] == "tag")
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceTag, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "name")
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceName, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "id")
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceId, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "mode")
-                KwmConstructEvent(KWMEvent_QueryCurrentSpaceMode, KwmCreateContext(ClientSockFD));
+            if(Value == "tag")
+                KwmQueryEvent(KWMEvent_QueryCurrentSpaceTag, ClientSockFD);
+            else if(Value == "name")
+                KwmQueryEvent(KWMEvent_QueryCurrentSpaceName, ClientSockFD);
+            else if(Value == "id")
+                KwmQueryEvent(KWMEvent_QueryCurrentSpaceId, ClientSockFD);
+            else if(Value == "mode")
+                KwmQueryEvent(KWMEvent_QueryCurrentSpaceMode, ClientSockFD);
         }
-        else if(Tokens[2] == "previous")
+        else if(Property == "previous")
         {
-            if(Tokens[3] == "name")
-                KwmConstructEvent(KWMEvent_QueryPreviousSpaceName, KwmCreateContext(ClientSockFD));
-            else if(Tokens[3] == "id")
-                KwmConstructEvent(KWMEvent_QueryPreviousSpaceId, KwmCreateContext(ClientSockFD));
+            if(Value == "name")
+                KwmQueryEvent(KWMEvent_QueryPreviousSpaceName, ClientSockFD);
+            else if(Value == "id")
+                KwmQueryEvent(KWMEvent_QueryPreviousSpaceId, ClientSockFD);
+        }
+        else if(Property == "list")
+        {
+            KwmQueryEvent(KWMEvent_QuerySpaces, ClientSockFD);
         }
-        else if(Tokens[2] == "list")
-            KwmConstructEvent(KWMEvent_QuerySpaces, KwmCreateContext(ClientSockFD));
     }
-    else if(Tokens[1] == "border")
+    else if(Object == "border")
     {
-        if(Tokens[2] == "focused")
-            KwmConstructEvent(KWMEvent_QueryFocusedBorder, KwmCreateContext(ClientSockFD));
-        else if(Tokens[2] == "marked")
-            KwmConstructEvent(KWMEvent_QueryMarkedBorder, KwmCreateContext(ClientSockFD));
+        if(Property == "focused")
+            KwmQueryEvent(KWMEvent_QueryFocusedBorder, ClientSockFD);
+        else if(Property == "marked")
+            KwmQueryEvent(KWMEvent_QueryMarkedBorder, ClientSockFD);
     }
-    else if(Tokens[1] == "cycle-focus")
+    else if(Object == "cycle-focus")
     {
-        KwmConstructEvent(KWMEvent_QueryCycleFocus, KwmCreateContext(ClientSockFD));
+        KwmQueryEvent(KWMEvent_QueryCycleFocus, ClientSockFD);
     }
-    else if(Tokens[1] == "float-non-resizable")
+    else if(Object == "float-non-resizable")
     {
-        KwmConstructEvent(KWMEvent_QueryFloatNonResizable, KwmCreateContext(ClientSockFD));
+        KwmQueryEvent(KWMEvent_QueryFloatNonResizable, ClientSockFD);
     }
-    else if(Tokens[1] == "lock-to-container")
+    else if(Object == "lock-to-container")
     {
-        KwmConstructEvent(KWMEvent_QueryLockToContainer, KwmCreateContext(ClientSockFD));
+        KwmQueryEvent(KWMEvent_QueryLockToContainer, ClientSockFD);
     }
-    else if(Tokens[1] == "standby-on-float")
+    else if(Object == "standby-on-float")
     {
-        KwmConstructEvent(KWMEvent_QueryStandbyOnFloat, KwmCreateContext(ClientSockFD));
+        KwmQueryEvent(KWMEvent_QueryStandbyOnFloat, ClientSockFD);
     }
-    else if(Tokens[1] == "focus-follows-mouse")
+    else if(Object == "focus-follows-mouse")
     {
-        KwmConstructEvent(KWMEvent_QueryFocusFollowsMouse, KwmCreateContext(ClientSockFD));
+        KwmQueryEvent(KWMEvent_QueryFocusFollowsMouse, ClientSockFD);
     }
-    else if(Tokens[1] == "mouse-follows-focus")
+    else if(Object == "mouse-follows-focus")
+    {
+        KwmQueryEvent(KWMEvent_QueryMouseFollowsFocus, ClientSockFD);
+    }
+    else if(Object == "metrics")
+    {
+        KwmQueryEvent(KWMEvent_QueryMetrics, ClientSockFD);
+    }
+    else if(Object == "log")
     {
-        KwmConstructEvent(KWMEvent_QueryMouseFollowsFocus, KwmCreateContext(ClientSockFD));
+        KwmQueryEvent(KWMEvent_QueryLog, ClientSockFD);
     }
+    else if(Object == "exec")
+    {
+        KwmQueryEvent(KWMEvent_QueryExec, ClientSockFD);
+    }
+
+    return false;
 }
 
 internal void
@@ -480,6 +521,7 @@ KwmBindCommand(std::vector<std::string> &Tokens, bool Passthrough)
 internal void
 KwmWindowCommand(std::vector<std::string> &Tokens)
 {
+    AXLibTraceFunction("interpreter");
     if(Tokens[1] == "-f")
     {
         if(Tokens[2] == "north")
@@ -669,6 +711,7 @@ KwmWindowCommand(std::vector<std::string> &Tokens)
 internal void
 KwmSpaceCommand(std::vector<std::string> &Tokens)
 {
+    AXLibTraceFunction("interpreter");
     if(Tokens[1] == "-fExperimental")
     {
         if(Tokens[2] == "previous")
@@ -739,6 +782,7 @@ KwmSpaceCommand(std::vector<std::string> &Tokens)
 internal void
 KwmDisplayCommand(std::vector<std::string> &Tokens)
 {
+    AXLibTraceFunction("interpreter");
     if(Tokens[1] == "-f")
     {
         if(Tokens[2] == "prev")
@@ -775,6 +819,7 @@ KwmDisplayCommand(std::vector<std::string> &Tokens)
 internal void
 KwmTreeCommand(std::vector<std::string> &Tokens)
 {
+    AXLibTraceFunction("interpreter");
     if(Tokens[1] == "-pseudo")
     {
         if(Tokens[2] == "create")
@@ -799,6 +844,14 @@ KwmTreeCommand(std::vector<std::string> &Tokens)
     {
         LoadWindowNodeTree(AXLibMainDisplay(), Tokens[2]);
     }
+    else if(Tokens[1] == "undo")
+    {
+        StepWindowNodeTree(AXLibMainDisplay(), -1);
+    }
+    else if(Tokens[1] == "redo")
+    {
+        StepWindowNodeTree(AXLibMainDisplay(), 1);
+    }
 }
 
 internal void
@@ -830,16 +883,64 @@ KwmScratchpadCommand(std::vector<std::string> &Tokens, int ClientSockFD)
     }
 }
 
+/* NOTE(koekeishiya): 'trace start' discards any previous trace. 'trace stop' writes the spans
+ *                    as Chrome trace-event JSON to the given file, or to trace.json in the
+ *                    kwm home directory. */
+internal void
+KwmTraceCommand(std::vector<std::string> &Tokens)
+{
+    if(Tokens.size() < 2)
+        return;
+
+    if(Tokens[1] == "start")
+    {
+        AXLibStartTrace();
+        LOG_INFO(LogCategory_General, "Trace: started");
+    }
+    else if(Tokens[1] == "stop")
+    {
+        std::string File = Tokens.size() > 2 ? CreateStringFromTokens(Tokens, 2) : KWMPath.Home + "/trace.json";
+        if(AXLibStopTrace(File))
+            LOG_INFO(LogCategory_General, "Trace: written to " << File);
+        else
+            LOG_ERROR(LogCategory_General, "Trace: could not write " << File);
+    }
+}
+
+/* NOTE(koekeishiya): Commands that may change the tree of the active space. The tree is
+ *                    recorded in the layout history before and after these run. */
+internal inline bool
+IsLayoutCommand(std::vector<std::string> &Tokens)
+{
+    if(Tokens.size() < 2)
+        return false;
+
+    return Tokens[0] == "window" ||
+           Tokens[0] == "space" ||
+           (Tokens[0] == "tree" && Tokens[1] != "undo" && Tokens[1] != "redo" && Tokens[1] != "save");
+}
+
 void KwmInterpretCommand(std::string Message, int ClientSockFD)
 {
+    AXLibTraceFunction("interpreter");
     std::vector<std::string> Tokens = SplitString(Message, ' ');
+    if(Tokens.empty())
+    {
+        KwmCloseSocket(ClientSockFD);
+        return;
+    }
 
+    bool LayoutCommand = IsLayoutCommand(Tokens);
+    if(LayoutCommand)
+        RecordWindowNodeTree(AXLibMainDisplay());
+
+    bool Replied = false;
     if(Tokens[0] == "quit")
         KwmQuit();
     else if(Tokens[0] == "config")
         KwmConfigCommand(Tokens);
     else if(Tokens[0] == "query")
-        KwmQueryCommand(Tokens, ClientSockFD);
+        Replied = KwmQueryCommand(Tokens, ClientSockFD);
     else if(Tokens[0] == "window")
         KwmWindowCommand(Tokens);
     else if(Tokens[0] == "space")
@@ -866,10 +967,12 @@ void KwmInterpretCommand(std::string Message, int ClientSockFD)
         KwmScratchpadCommand(Tokens, ClientSockFD);
     else if(Tokens[0] == "whitelist")
         CarbonWhitelistProcess(CreateStringFromTokens(Tokens, 1));
+    else if(Tokens[0] == "trace")
+        KwmTraceCommand(Tokens);
 
-    if(Tokens[0] != "query")
-    {
-        shutdown(ClientSockFD, SHUT_RDWR);
-        close(ClientSockFD);
-    }
+    if(LayoutCommand)
+        RecordWindowNodeTree(AXLibMainDisplay());
+
+    if(!Replied)
+        KwmCloseSocket(ClientSockFD);
 }
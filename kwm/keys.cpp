@@ -2,7 +2,8 @@
 #include "helpers.h"
 #include "interpreter.h"
 #include "border.h"
-#include "axlib/event.h"
+#include "launcher.h"
+#include "event.h"
 
 #define internal static
 #define local_persist static
@@ -11,6 +12,8 @@ extern ax_application *FocusedApplication;
 extern kwm_hotkeys KWMHotkeys;
 extern kwm_border FocusedBorder;
 
+internal ax_event_timer PrefixTimer;
+
 internal inline bool
 HasFlags(hotkey *Hotkey, uint32_t Flag)
 {
@@ -250,18 +253,29 @@ HotkeysAreEqual(hotkey *A, hotkey *B)
     return false;
 }
 
+/* NOTE(koekeishiya): A prefix mode is left once it has gone unused for its timeout. There is a single
+ *                    timer, which every command in the mode pushes back, and which is cancelled
+ *                    when a mode without a prefix is activated. */
 internal void
-CheckPrefixTimeout()
+ResetPrefixTimeout(mode *BindingMode)
+{
+    if(BindingMode->Prefix)
+        KwmConstructTimedEvent(&PrefixTimer, BindingMode->Timeout, KWMEvent_PrefixTimeout, NULL);
+    else
+        AXLibCancelEvent(&PrefixTimer);
+}
+
+/* NOTE(koekeishiya): A hotkey that was handled after this event was queued re-arms the timer,
+ *                    in which case this timeout is stale and the prefix mode stays active. */
+EVENT_CALLBACK(Callback_KWMEvent_PrefixTimeout)
 {
+    if(AXLibIsEventPending(&PrefixTimer))
+        return;
+
     if(KWMHotkeys.ActiveMode->Prefix)
     {
-        kwm_time_point NewPrefixTime = std::chrono::steady_clock::now();
-        std::chrono::duration<double> Diff = NewPrefixTime - KWMHotkeys.ActiveMode->Time;
-        if(Diff.count() > KWMHotkeys.ActiveMode->Timeout)
-        {
-            DEBUG("Prefix timeout expired. Switching to mode " << KWMHotkeys.ActiveMode->Restore);
-            KwmActivateBindingMode(KWMHotkeys.ActiveMode->Restore);
-        }
+        LOG_DEBUG(LogCategory_Hotkey, "Prefix timeout expired. Switching to mode " << KWMHotkeys.ActiveMode->Restore);
+        KwmActivateBindingMode(KWMHotkeys.ActiveMode->Restore);
     }
 }
 
@@ -297,27 +311,22 @@ KwmExecuteHotkey(hotkey *Hotkey)
     if(Hotkey->Command.empty())
         return;
 
+    AXLibTraceFunction("hotkey");
     std::vector<std::string> Commands = SplitString(Hotkey->Command, ';');
-    DEBUG("KwmExecuteHotkey: Number of commands " << Commands.size());
+    LOG_DEBUG(LogCategory_Hotkey, "KwmExecuteHotkey: Number of commands " << Commands.size());
     for(int CmdIndex = 0; CmdIndex < Commands.size(); ++CmdIndex)
     {
         std::string &Command = TrimString(Commands[CmdIndex]);
         if(!Command.empty())
         {
-            DEBUG("KwmExecuteHotkey() " << Command);
+            LOG_DEBUG(LogCategory_Hotkey, "KwmExecuteHotkey() " << Command);
             if(IsPrefixOfString(Command, "exec"))
                 KwmExecuteSystemCommand(Command);
             else
                 KwmInterpretCommand(Command, 0);
 
             if(KWMHotkeys.ActiveMode->Prefix)
-            {
-                KWMHotkeys.ActiveMode->Time = std::chrono::steady_clock::now();
-                dispatch_after(dispatch_time(DISPATCH_TIME_NOW, KWMHotkeys.ActiveMode->Timeout * NSEC_PER_SEC), dispatch_get_main_queue(),
-                ^{
-                    CheckPrefixTimeout();
-                });
-            }
+                ResetPrefixTimeout(KWMHotkeys.ActiveMode);
         }
     }
 }
@@ -400,7 +409,7 @@ KwmParseHotkey(std::string KeySym, std::string Command, hotkey *Hotkey, bool Pas
     {
         Result = true;
         Keycode = ConvertHexStringToInt(KeyTokens[1]);
-        DEBUG("bindcode: " << Keycode);
+        LOG_DEBUG(LogCategory_Hotkey, "bindcode: " << Keycode);
     }
     else
     {
@@ -413,12 +422,42 @@ KwmParseHotkey(std::string KeySym, std::string Command, hotkey *Hotkey, bool Pas
     return Result;
 }
 
-void KwmAddHotkey(std::string KeySym, std::string Command, bool Passthrough, bool KeycodeInHex)
+internal bool
+FindHotkeyInMode(mode *BindingMode, uint32_t Flags, CGKeyCode Keycode, hotkey *Hotkey)
+{
+    hotkey TempHotkey = {};
+    TempHotkey.Flags = Flags;
+    TempHotkey.Key = Keycode;
+
+    for(std::size_t HotkeyIndex = 0; HotkeyIndex < BindingMode->Hotkeys.size(); ++HotkeyIndex)
+    {
+        hotkey *CheckHotkey = &BindingMode->Hotkeys[HotkeyIndex];
+        if(HotkeysAreEqual(CheckHotkey, &TempHotkey))
+        {
+            if(Hotkey)
+                *Hotkey = *CheckHotkey;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void KwmAddHotkey(std::map<std::string, mode> &Modes, std::string KeySym, std::string Command, bool Passthrough, bool KeycodeInHex)
 {
     hotkey Hotkey = {};
-    if(KwmParseHotkey(KeySym, Command, &Hotkey, Passthrough, KeycodeInHex) &&
-       !HotkeyExists(Hotkey.Flags, Hotkey.Key, NULL, Hotkey.Mode))
-        KWMHotkeys.Modes[Hotkey.Mode].Hotkeys.push_back(Hotkey);
+    if(KwmParseHotkey(KeySym, Command, &Hotkey, Passthrough, KeycodeInHex))
+    {
+        mode *BindingMode = GetBindingMode(Modes, Hotkey.Mode);
+        if(!FindHotkeyInMode(BindingMode, Hotkey.Flags, Hotkey.Key, NULL))
+            BindingMode->Hotkeys.push_back(Hotkey);
+    }
+}
+
+void KwmAddHotkey(std::string KeySym, std::string Command, bool Passthrough, bool KeycodeInHex)
+{
+    KwmAddHotkey(KWMHotkeys.Modes, KeySym, Command, Passthrough, KeycodeInHex);
 }
 
 void KwmRemoveHotkey(std::string KeySym, bool KeycodeInHex)
@@ -439,17 +478,43 @@ void KwmRemoveHotkey(std::string KeySym, bool KeycodeInHex)
     }
 }
 
-mode *GetBindingMode(std::string Mode)
+mode *GetBindingMode(std::map<std::string, mode> &Modes, std::string Mode)
 {
-    std::map<std::string, mode>::iterator It = KWMHotkeys.Modes.find(Mode);
-    if(It == KWMHotkeys.Modes.end())
+    std::map<std::string, mode>::iterator It = Modes.find(Mode);
+    if(It == Modes.end())
     {
         mode NewMode = {};
         NewMode.Name = Mode;
-        KWMHotkeys.Modes[Mode] = NewMode;
+        Modes[Mode] = NewMode;
     }
 
-    return &KWMHotkeys.Modes[Mode];
+    return &Modes[Mode];
+}
+
+mode *GetBindingMode(std::string Mode)
+{
+    return GetBindingMode(KWMHotkeys.Modes, Mode);
+}
+
+/* NOTE(koekeishiya): Replace the binding modes with a set that was built off to the side.
+ *                    The active mode is looked up again by name. A pending prefix timeout
+ *                    is left as it is, and applies to the new mode of that name. */
+void KwmSetBindingModes(std::map<std::string, mode> &Modes)
+{
+    std::string ActiveMode = "default";
+    if(KWMHotkeys.ActiveMode)
+        ActiveMode = KWMHotkeys.ActiveMode->Name;
+
+    KWMHotkeys.Modes.swap(Modes);
+    GetBindingMode("default");
+
+    if(!DoesBindingModeExist(ActiveMode))
+        ActiveMode = "default";
+
+    KWMHotkeys.ActiveMode = GetBindingMode(ActiveMode);
+
+    if(FocusedApplication)
+        UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
 }
 
 void KwmActivateBindingMode(std::string Mode)
@@ -460,14 +525,7 @@ void KwmActivateBindingMode(std::string Mode)
 
     KWMHotkeys.ActiveMode = BindingMode;
     UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
-    if(BindingMode->Prefix)
-    {
-        BindingMode->Time = std::chrono::steady_clock::now();
-        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, BindingMode->Timeout * NSEC_PER_SEC), dispatch_get_main_queue(),
-        ^{
-            CheckPrefixTimeout();
-        });
-    }
+    ResetPrefixTimeout(BindingMode);
 }
 
 bool HotkeyForCGEvent(CGEventRef Event, hotkey *Hotkey)
@@ -514,30 +572,13 @@ bool HotkeyForCGEvent(CGEventRef Event, hotkey *Hotkey)
 
 bool HotkeyExists(uint32_t Flags, CGKeyCode Keycode, hotkey *Hotkey, std::string &Mode)
 {
-    hotkey TempHotkey = {};
-    TempHotkey.Flags = Flags;
-    TempHotkey.Key = Keycode;
-
-    mode *BindingMode = GetBindingMode(Mode);
-    for(std::size_t HotkeyIndex = 0; HotkeyIndex < BindingMode->Hotkeys.size(); ++HotkeyIndex)
-    {
-        hotkey *CheckHotkey = &BindingMode->Hotkeys[HotkeyIndex];
-        if(HotkeysAreEqual(CheckHotkey, &TempHotkey))
-        {
-            if(Hotkey)
-                *Hotkey = *CheckHotkey;
-
-            return true;
-        }
-    }
-
-    return false;
+    return FindHotkeyInMode(GetBindingMode(Mode), Flags, Keycode, Hotkey);
 }
 
 EVENT_CALLBACK(Callback_AXEvent_HotkeyPressed)
 {
     hotkey *Hotkey = (hotkey *) Event->Context;
-    DEBUG("AXEvent_HotkeyPressed: Hotkey activated");
+    LOG_DEBUG(LogCategory_Hotkey, "AXEvent_HotkeyPressed: Hotkey activated");
 
     if(IsHotkeyStateReqFulfilled(Hotkey))
         KwmExecuteHotkey(Hotkey);
@@ -626,24 +667,4 @@ void KwmEmitKeystroke(std::string KeySym)
     KwmEmitKeystroke(Flags, KeyTokens[1]);
 }
 
-void KwmExecuteSystemCommand(std::string Command)
-{
-    int ChildPID = fork();
-    if(ChildPID == 0)
-    {
-        DEBUG("Exec: FORK SUCCESS");
-        std::vector<std::string> Tokens = SplitString(Command, ' ');
-
-        const char *ExecArgs[Tokens.size()+1];
-        for(int Index = 0; Index < Tokens.size(); ++Index)
-        {
-            ExecArgs[Index] = Tokens[Index].c_str();
-            DEBUG("Exec argument " << Index << ": " << ExecArgs[Index]);
-        }
 
-        ExecArgs[Tokens.size()] = NULL;
-        int StatusCode = execvp(ExecArgs[0], (char **)ExecArgs);
-        DEBUG("Exec failed with code: " << StatusCode);
-        exit(StatusCode);
-    }
-}
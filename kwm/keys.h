@@ -48,13 +48,15 @@ enum hotkey_modifier_flag
 bool HotkeyForCGEvent(CGEventRef Event, hotkey *Hotkey);
 
 void KwmAddHotkey(std::string KeySym, std::string Command, bool Passthrough, bool KeycodeInHex);
+void KwmAddHotkey(std::map<std::string, mode> &Modes, std::string KeySym, std::string Command, bool Passthrough, bool KeycodeInHex);
 void KwmRemoveHotkey(std::string KeySym, bool KeycodeInHex);
 bool HotkeyExists(uint32_t Flags, CGKeyCode Keycode, hotkey *Hotkey, std::string &Mode);
 void KwmEmitKeystrokes(std::string Text);
 void KwmEmitKeystroke(std::string KeySym);
 
 mode *GetBindingMode(std::string Mode);
+mode *GetBindingMode(std::map<std::string, mode> &Modes, std::string Mode);
+void KwmSetBindingModes(std::map<std::string, mode> &Modes);
 void KwmActivateBindingMode(std::string Mode);
-void KwmExecuteSystemCommand(std::string Command);
 
 #endif
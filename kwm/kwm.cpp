@@ -6,8 +6,13 @@
 #include "scratchpad.h"
 #include "border.h"
 #include "config.h"
+#include "state.h"
+#include "launcher.h"
+#include "cursor.h"
 #include "axlib/axlib.h"
 #include <getopt.h>
+#include <unistd.h>
+#include <chrono>
 
 #define internal static
 const char *KwmVersion = "Kwm Version 3.0.7";
@@ -21,6 +26,7 @@ ax_window *MarkedWindow = NULL;
 kwm_mach KWMMach = {};
 kwm_path KWMPath = {};
 kwm_settings KWMSettings = {};
+kwm_metrics KWMMetrics = {};
 kwm_hotkeys KWMHotkeys = {};
 kwm_border FocusedBorder = {};
 kwm_border MarkedBorder = {};
@@ -34,7 +40,7 @@ CGEventCallback(CGEventTapProxy Proxy, CGEventType Type, CGEventRef Event, void
         case kCGEventTapDisabledByTimeout:
         case kCGEventTapDisabledByUserInput:
         {
-            DEBUG("Notice: Restarting Event Tap");
+            LOG_WARN(LogCategory_General, "Notice: Restarting Event Tap");
             CGEventTapEnable(KWMMach.EventTap, true);
         } break;
         case kCGEventKeyDown:
@@ -57,10 +63,16 @@ CGEventCallback(CGEventTapProxy Proxy, CGEventType Type, CGEventRef Event, void
                 }
             }
         } break;
+        case kCGEventLeftMouseDown:
+        case kCGEventRightMouseDown:
+        {
+            /* NOTE(koekeishiya): Clicks open menus and raise windows without an AX notification. */
+            AXLibInvalidateWindowBelowCursor();
+        } break;
         case kCGEventMouseMoved:
         {
             if(KWMSettings.Focus == FocusModeAutoraise)
-                AXLibConstructEvent(AXEvent_MouseMoved, NULL, false);
+                QueueMouseMoved();
         } break;
         default: {} break;
     }
@@ -114,14 +126,22 @@ KwmExecuteInitScript()
 
     struct stat Buffer;
     if(stat(KWMPath.Init.c_str(), &Buffer) == 0)
-        KwmExecuteSystemCommand(KWMPath.Init);
+    {
+        std::vector<std::string> Args(1, KWMPath.Init);
+        KwmExecuteProcess(Args);
+    }
 }
 
 internal void
 SignalHandler(int Signum)
 {
+    /* NOTE(koekeishiya): The logger formats through a std::ostream into a per-thread ring that the
+                          interrupted code may be writing to, which is not safe inside a signal
+                          handler, so only a fixed message is written straight to stderr. */
+    const char Message[] = "kwm: caught signal, exiting\n";
+    write(STDERR_FILENO, Message, sizeof(Message) - 1);
+
     ShowAllScratchpadWindows();
-    DEBUG("SignalHandler() " << Signum);
 
     CloseBorder(&FocusedBorder);
     CloseBorder(&MarkedBorder);
@@ -141,7 +161,6 @@ KwmInit()
     if(!CheckPrivileges())
         Fatal("Error: Could not access OSX Accessibility!");
 
-    signal(SIGCHLD, SIG_IGN);
 #ifndef DEBUG_BUILD
     signal(SIGSEGV, SignalHandler);
     signal(SIGABRT, SignalHandler);
@@ -153,37 +172,21 @@ KwmInit()
     printf("Notice: Signal handlers disabled!\n");
 #endif
 
-    KWMSettings.SplitRatio = 0.5;
-    KWMSettings.SplitMode = SPLIT_OPTIMAL;
-    KWMSettings.DefaultOffset = CreateDefaultDisplayOffset();
-    KWMSettings.OptimalRatio = 1.618;
-
-    AddFlags(&KWMSettings,
-            Settings_MouseFollowsFocus |
-            Settings_BuiltinHotkeys |
-            Settings_StandbyOnFloat |
-            Settings_CenterOnFloat |
-            Settings_LockToContainer);
-
-    KWMSettings.Space = SpaceModeBSP;
-    KWMSettings.Focus = FocusModeAutoraise;
-    KWMSettings.Cycle = CycleModeScreen;
-
-    FocusedBorder.Radius = -1;
     FocusedBorder.Type = BORDER_FOCUSED;
-    MarkedBorder.Radius = -1;
     MarkedBorder.Type = BORDER_MARKED;
 
     char *HomeP = std::getenv("HOME");
     if(HomeP)
     {
         KWMPath.EnvHome = HomeP;
-        KWMPath.Home = KWMPath.EnvHome + "/.kwm";
-        KWMPath.Include = KWMPath.Home;
-        KWMPath.Layouts = KWMPath.Home + "/layouts";
+        KwmSetDefaultSettings();
 
         if(KWMPath.Config.empty())
             KWMPath.Config = KWMPath.Home + "/kwmrc";
+
+        KWMPath.Cache = KWMPath.Home + "/kwmrc.cache";
+        KWMPath.State = KWMPath.Home + "/state";
+        KWMPath.Log = KWMPath.Home + "/kwm.log";
     }
     else
     {
@@ -192,14 +195,18 @@ KwmInit()
 
     KWMHotkeys.ActiveMode = GetBindingMode("default");
     GetKwmFilePath();
+    KwmStartLogger(KWMPath.Log);
+    KwmStartLauncher();
 }
 
 void KwmQuit()
 {
+    KwmSaveState();
     ShowAllScratchpadWindows();
     CloseBorder(&FocusedBorder);
     CloseBorder(&MarkedBorder);
 
+    KwmStopLogger();
     exit(0);
 }
 
@@ -227,7 +234,7 @@ ParseArguments(int argc, char **argv)
             } break;
             case 'c':
             {
-                DEBUG("Notice: Using config file " << optarg);
+                LOG_INFO(LogCategory_General, "Notice: Using config file " << optarg);
                 KWMPath.Config = optarg;
             } break;
         }
@@ -240,7 +247,9 @@ internal inline void
 ConfigureRunLoop()
 {
     KWMMach.EventMask = ((1 << kCGEventKeyDown) |
-                         (1 << kCGEventMouseMoved));
+                         (1 << kCGEventMouseMoved) |
+                         (1 << kCGEventLeftMouseDown) |
+                         (1 << kCGEventRightMouseDown));
 
     KWMMach.EventTap = CGEventTapCreate(kCGSessionEventTap, kCGHeadInsertEventTap, kCGEventTapOptionDefault, KWMMach.EventMask, CGEventCallback, NULL);
     if(!KWMMach.EventTap || !CGEventTapIsEnabled(KWMMach.EventTap))
@@ -256,11 +265,15 @@ int main(int argc, char **argv)
     if(ParseArguments(argc, argv))
         return 0;
 
+    AXLibSetTraceThreadName("main");
+    std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+
     NSApplicationLoad();
     if(!AXLibDisplayHasSeparateSpaces())
         Fatal("Error: 'Displays have separate spaces' must be enabled!");
 
     AXLibInit(&AXState);
+    KWMMetrics.ApplicationInitTime = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
     AXLibStartEventLoop();
     if(!KwmStartDaemon())
         Fatal("Error: Could not start daemon!");
@@ -282,7 +295,11 @@ int main(int argc, char **argv)
     KwmParseConfig(KWMPath.Config);
     KwmExecuteInitScript();
 
+    KwmLoadState();
     CreateWindowNodeTree(MainDisplay);
+    RestoreWindowState();
+    KWMMetrics.TimeToFirstTile = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+    LOG_INFO(LogCategory_General, "Time to first tile: " << KWMMetrics.TimeToFirstTile << "ms");
     UpdateBorder(&FocusedBorder, FocusedApplication->Focus);
 
     if(CGSIsSecureEventInputSet())
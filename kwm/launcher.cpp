@@ -0,0 +1,340 @@
+#include "launcher.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+#endif
+
+#define internal static
+
+extern char **environ;
+
+/* NOTE(koekeishiya): A process started by kwm. Error is set when it could not be spawned,
+ *                    and Status holds the wait status once it has been reaped. */
+struct kwm_process
+{
+    pid_t PID;
+    std::string Command;
+    bool Running;
+    int Status;
+    int Error;
+};
+
+internal pthread_mutex_t LauncherLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::vector<kwm_process> LauncherProcesses;
+internal posix_spawnattr_t LauncherAttributes;
+internal posix_spawn_file_actions_t LauncherFileActions;
+internal bool LauncherInitialized;
+internal std::atomic<uint64_t> LauncherSpawned(0);
+internal std::atomic<uint64_t> LauncherFailed(0);
+
+#ifdef __APPLE__
+internal dispatch_source_t LauncherSignalSource;
+#endif
+
+/* NOTE(koekeishiya): Children get the default handler for every signal and an empty signal
+ *                    mask, since kwm installs its own handlers. They are put in their own
+ *                    process group, so that they outlive an interrupted kwm, and only inherit
+ *                    stdin, stdout and stderr. */
+internal void
+KwmInitializeLauncher()
+{
+    if(LauncherInitialized)
+        return;
+
+    sigset_t Signals;
+    short Flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP;
+
+    posix_spawnattr_init(&LauncherAttributes);
+    sigfillset(&Signals);
+    posix_spawnattr_setsigdefault(&LauncherAttributes, &Signals);
+    sigemptyset(&Signals);
+    posix_spawnattr_setsigmask(&LauncherAttributes, &Signals);
+    posix_spawnattr_setpgroup(&LauncherAttributes, 0);
+
+    posix_spawn_file_actions_init(&LauncherFileActions);
+#ifdef POSIX_SPAWN_CLOEXEC_DEFAULT
+    Flags |= POSIX_SPAWN_CLOEXEC_DEFAULT;
+    posix_spawn_file_actions_addinherit_np(&LauncherFileActions, STDIN_FILENO);
+    posix_spawn_file_actions_addinherit_np(&LauncherFileActions, STDOUT_FILENO);
+    posix_spawn_file_actions_addinherit_np(&LauncherFileActions, STDERR_FILENO);
+#endif
+
+    posix_spawnattr_setflags(&LauncherAttributes, Flags);
+    LauncherInitialized = true;
+}
+
+/* NOTE(koekeishiya): Only the processes we launched are waited on, so that children owned by
+ *                    someone else, like the border overlay opened by popen, are left alone. */
+internal void
+KwmReapProcessesLocked()
+{
+    for(std::size_t Index = 0; Index < LauncherProcesses.size(); ++Index)
+    {
+        kwm_process *Process = &LauncherProcesses[Index];
+        if(!Process->Running)
+            continue;
+
+        int Status;
+        pid_t Result = waitpid(Process->PID, &Status, WNOHANG);
+        if(Result == Process->PID)
+        {
+            Process->Running = false;
+            Process->Status = Status;
+        }
+        else if(Result == -1 && errno == ECHILD)
+        {
+            Process->Running = false;
+            Process->Status = -1;
+        }
+    }
+}
+
+#ifdef __APPLE__
+internal void
+KwmReapProcesses()
+{
+    pthread_mutex_lock(&LauncherLock);
+    KwmReapProcessesLocked();
+    pthread_mutex_unlock(&LauncherLock);
+}
+#endif
+
+/* NOTE(koekeishiya): Drop the oldest processes that have finished once the history is full.
+ *                    Processes that are still running are kept, so they can be reaped. */
+internal void
+KwmTrimProcessHistoryLocked()
+{
+    std::size_t Index = 0;
+    while(LauncherProcesses.size() > KWM_LAUNCHER_HISTORY && Index < LauncherProcesses.size())
+    {
+        if(LauncherProcesses[Index].Running)
+            ++Index;
+        else
+            LauncherProcesses.erase(LauncherProcesses.begin() + Index);
+    }
+}
+
+internal std::string
+KwmJoinCommandLine(std::vector<std::string> &Args)
+{
+    std::string Result;
+    for(std::size_t Index = 0; Index < Args.size(); ++Index)
+    {
+        if(Index > 0)
+            Result += " ";
+
+        Result += Args[Index];
+    }
+
+    return Result;
+}
+
+internal void
+KwmSpawnProcessLocked(std::vector<std::string> &Args)
+{
+    kwm_process Process = {};
+    Process.Command = KwmJoinCommandLine(Args);
+
+    std::vector<char *> Argv;
+    for(std::size_t Index = 0; Index < Args.size(); ++Index)
+        Argv.push_back((char *) Args[Index].c_str());
+
+    Argv.push_back(NULL);
+
+    Process.Error = posix_spawnp(&Process.PID, Argv[0], &LauncherFileActions, &LauncherAttributes, &Argv[0], environ);
+    if(Process.Error == 0)
+    {
+        Process.Running = true;
+        LauncherSpawned.fetch_add(1, std::memory_order_relaxed);
+        LOG_DEBUG(LogCategory_Hotkey, "Exec: " << Process.Command << " (pid " << Process.PID << ")");
+    }
+    else
+    {
+        LauncherFailed.fetch_add(1, std::memory_order_relaxed);
+        LOG_ERROR(LogCategory_Hotkey, "Exec: " << Process.Command << " failed: " << strerror(Process.Error));
+    }
+
+    LauncherProcesses.push_back(Process);
+}
+
+/* NOTE(koekeishiya): SIGCHLD used to be ignored, which has the kernel reap children for us and
+ *                    leaves no exit status to report. It is restored to the default, which
+ *                    still does not interrupt us, and the children are reaped when it fires.
+ *                    Without dispatch they are reaped by the next launch or status query. */
+void KwmStartLauncher()
+{
+    signal(SIGCHLD, SIG_DFL);
+
+    pthread_mutex_lock(&LauncherLock);
+    KwmInitializeLauncher();
+    pthread_mutex_unlock(&LauncherLock);
+
+#ifdef __APPLE__
+    if(!LauncherSignalSource)
+    {
+        LauncherSignalSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGCHLD, 0,
+                                                      dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_LOW, 0));
+        dispatch_source_set_event_handler(LauncherSignalSource, ^{ KwmReapProcesses(); });
+        dispatch_resume(LauncherSignalSource);
+    }
+#endif
+}
+
+/* NOTE(koekeishiya): Splits a command the way a shell splits words, without any expansion.
+ *                    Single quotes keep everything literal, double quotes allow \" and \\,
+ *                    and a backslash outside of quotes escapes the next character. Returns
+ *                    false for an unterminated quote or a trailing backslash. */
+bool KwmSplitCommandLine(std::string Command, std::vector<std::string> *Args)
+{
+    std::string Arg;
+    bool InArg = false;
+    char Quote = 0;
+
+    for(std::size_t Index = 0; Index < Command.size(); ++Index)
+    {
+        char C = Command[Index];
+        if(Quote == '\'')
+        {
+            if(C == '\'')
+                Quote = 0;
+            else
+                Arg += C;
+        }
+        else if(Quote == '"')
+        {
+            if(C == '"')
+                Quote = 0;
+            else if(C == '\\' && Index + 1 < Command.size() &&
+                    (Command[Index + 1] == '"' || Command[Index + 1] == '\\'))
+                Arg += Command[++Index];
+            else
+                Arg += C;
+        }
+        else if(C == '\'' || C == '"')
+        {
+            Quote = C;
+            InArg = true;
+        }
+        else if(C == '\\')
+        {
+            if(++Index == Command.size())
+                return false;
+
+            Arg += Command[Index];
+            InArg = true;
+        }
+        else if(C == ' ' || C == '\t' || C == '\n')
+        {
+            if(InArg)
+            {
+                Args->push_back(Arg);
+                Arg.clear();
+                InArg = false;
+            }
+        }
+        else
+        {
+            Arg += C;
+            InArg = true;
+        }
+    }
+
+    if(Quote)
+        return false;
+
+    if(InArg)
+        Args->push_back(Arg);
+
+    return true;
+}
+
+void KwmExecuteProcess(std::vector<std::string> &Args)
+{
+    if(Args.empty())
+        return;
+
+    pthread_mutex_lock(&LauncherLock);
+    KwmInitializeLauncher();
+    KwmReapProcessesLocked();
+    KwmSpawnProcessLocked(Args);
+    KwmTrimProcessHistoryLocked();
+    pthread_mutex_unlock(&LauncherLock);
+}
+
+void KwmExecuteSystemCommand(std::string Command)
+{
+    std::vector<std::string> Commands(1, Command);
+    KwmExecuteSystemCommands(Commands);
+}
+
+/* NOTE(koekeishiya): Launches every command under a single lock, so a config with many exec
+ *                    lines reaps and trims the process history once. */
+void KwmExecuteSystemCommands(std::vector<std::string> &Commands)
+{
+    if(Commands.empty())
+        return;
+
+    pthread_mutex_lock(&LauncherLock);
+    KwmInitializeLauncher();
+    KwmReapProcessesLocked();
+
+    for(std::size_t Index = 0; Index < Commands.size(); ++Index)
+    {
+        std::vector<std::string> Args;
+        if(!KwmSplitCommandLine(Commands[Index], &Args))
+            LOG_ERROR(LogCategory_Hotkey, "Exec: unterminated quote or escape in " << Commands[Index]);
+        else if(!Args.empty())
+            KwmSpawnProcessLocked(Args);
+    }
+
+    KwmTrimProcessHistoryLocked();
+    pthread_mutex_unlock(&LauncherLock);
+}
+
+/* NOTE(koekeishiya): One line per process, oldest first: the pid, its state, and the command.
+ *                    The state is 'running', 'exit <code>', 'signal <number>', 'failed', or
+ *                    'unknown' if the process was reaped by someone else. */
+std::string KwmGetProcessStatus()
+{
+    std::string Output;
+    pthread_mutex_lock(&LauncherLock);
+    KwmReapProcessesLocked();
+
+    for(std::size_t Index = 0; Index < LauncherProcesses.size(); ++Index)
+    {
+        kwm_process *Process = &LauncherProcesses[Index];
+        std::string State;
+        if(Process->Running)
+            State = "running";
+        else if(Process->Error)
+            State = "failed";
+        else if(Process->Status == -1)
+            State = "unknown";
+        else if(WIFEXITED(Process->Status))
+            State = "exit " + std::to_string(WEXITSTATUS(Process->Status));
+        else if(WIFSIGNALED(Process->Status))
+            State = "signal " + std::to_string(WTERMSIG(Process->Status));
+
+        if(!Output.empty())
+            Output += "\n";
+
+        Output += std::to_string(Process->PID) + " " + State + " " + Process->Command;
+    }
+
+    pthread_mutex_unlock(&LauncherLock);
+    return Output;
+}
+
+void KwmGetLauncherUsage(uint64_t *Spawned, uint64_t *Failed)
+{
+    *Spawned = LauncherSpawned.load(std::memory_order_relaxed);
+    *Failed = LauncherFailed.load(std::memory_order_relaxed);
+}
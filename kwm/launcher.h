@@ -0,0 +1,22 @@
+#ifndef LAUNCHER_H
+#define LAUNCHER_H
+
+#include "log.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#define KWM_LAUNCHER_HISTORY 32
+
+void KwmStartLauncher();
+
+bool KwmSplitCommandLine(std::string Command, std::vector<std::string> *Args);
+void KwmExecuteSystemCommand(std::string Command);
+void KwmExecuteSystemCommands(std::vector<std::string> &Commands);
+void KwmExecuteProcess(std::vector<std::string> &Args);
+
+std::string KwmGetProcessStatus();
+void KwmGetLauncherUsage(uint64_t *Spawned, uint64_t *Failed);
+
+#endif
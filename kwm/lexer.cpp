@@ -0,0 +1,118 @@
+#include "lexer.h"
+
+#define internal static
+
+internal inline bool
+IsDefineCharacter(char C)
+{
+    bool Result = ((IsAlpha(C)) ||
+                   (IsNumeric(C)) ||
+                   (C == '_'));
+
+    return Result;
+}
+
+/* NOTE(koekeishiya): Replace every whole word in Text that names a define. Define values
+ *                    are expanded when they are created, so a single pass is enough. */
+internal std::string
+KwmExpandDefines(config_lexer *Lexer, const std::string &Text)
+{
+    if(Lexer->Defines.empty())
+        return Text;
+
+    std::string Result;
+    Result.reserve(Text.size());
+
+    std::size_t Index = 0;
+    while(Index < Text.size())
+    {
+        if(!IsDefineCharacter(Text[Index]))
+        {
+            Result += Text[Index++];
+            continue;
+        }
+
+        std::size_t Start = Index;
+        while(Index < Text.size() && IsDefineCharacter(Text[Index]))
+            ++Index;
+
+        std::string Word = Text.substr(Start, Index - Start);
+        std::unordered_map<std::string, std::string>::iterator It = Lexer->Defines.find(Word);
+        Result += It != Lexer->Defines.end() ? It->second : Word;
+    }
+
+    return Result;
+}
+
+/* NOTE(koekeishiya): Identifiers that name a define are replaced by the tokens of its value. */
+token KwmConfigToken(config_lexer *Lexer)
+{
+    while(true)
+    {
+        if(Lexer->Expansion.At)
+        {
+            token Token = GetToken(&Lexer->Expansion);
+            if(Token.Type != Token_EndOfStream)
+                return Token;
+
+            Lexer->Expansion.At = NULL;
+        }
+
+        token Token = GetToken(&Lexer->File);
+        if(Token.Type == Token_Identifier && !Lexer->Defines.empty())
+        {
+            std::unordered_map<std::string, std::string>::iterator It;
+            It = Lexer->Defines.find(std::string(Token.Text, Token.TextLength));
+            if(It != Lexer->Defines.end())
+            {
+                Lexer->Expansion.At = const_cast<char*>(It->second.c_str());
+                continue;
+            }
+        }
+
+        return Token;
+    }
+}
+
+bool KwmRequireConfigToken(config_lexer *Lexer, token_type DesiredType)
+{
+    token Token = KwmConfigToken(Lexer);
+    bool Result = Token.Type == DesiredType;
+    return Result;
+}
+
+std::string KwmConfigLine(config_lexer *Lexer)
+{
+    std::string Line;
+    if(Lexer->Expansion.At)
+    {
+        EatAllWhiteSpace(&Lexer->Expansion);
+        std::string Expanded = Lexer->Expansion.At;
+        Lexer->Expansion.At = NULL;
+
+        char *Start = Lexer->File.At;
+        while(Lexer->File.At[0] && !IsEndOfLine(Lexer->File.At[0]))
+            ++Lexer->File.At;
+
+        Line = Expanded + KwmExpandDefines(Lexer, std::string(Start, Lexer->File.At - Start));
+    }
+    else
+    {
+        Line = KwmExpandDefines(Lexer, GetTextTilEndOfLine(&Lexer->File));
+    }
+
+    Line.erase(Line.find_last_not_of(" \t\r\n") + 1);
+    return Line;
+}
+
+/* NOTE(koekeishiya): Defines are file-scoped and take effect from the line they appear on.
+ *                    The name is read straight from the file so that a define can be redefined. */
+void KwmParseDefine(config_lexer *Lexer)
+{
+    token Token = GetToken(&Lexer->File);
+    std::string Variable(Token.Text, Token.TextLength);
+    std::string Value = KwmConfigLine(Lexer);
+
+    Lexer->Expansion.At = NULL;
+    Lexer->Defines[Variable] = Value;
+}
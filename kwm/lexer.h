@@ -0,0 +1,19 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+#include "tokenizer.h"
+#include <unordered_map>
+
+struct config_lexer
+{
+    tokenizer File;
+    tokenizer Expansion;
+    std::unordered_map<std::string, std::string> Defines;
+};
+
+token KwmConfigToken(config_lexer *Lexer);
+bool KwmRequireConfigToken(config_lexer *Lexer, token_type DesiredType);
+std::string KwmConfigLine(config_lexer *Lexer);
+void KwmParseDefine(config_lexer *Lexer);
+
+#endif
@@ -0,0 +1,382 @@
+#include "library.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <map>
+#include <vector>
+
+#define internal static
+
+#define KWM_LAYOUT_LIBRARY_MAGIC 0x4c4d574b
+#define KWM_LAYOUT_LIBRARY_TAIL_LIMIT (16 * 1024)
+
+/* NOTE(koekeishiya): A layout library is a header, an open addressed hash table of slots
+ *                    and the names and encoded layouts the slots point at. The table has
+ *                    a power of two size and is at most three quarters full, so a lookup
+ *                    touches a few slots no matter how many layouts are stored.
+ *
+ *                    Layouts saved after the table was built are appended as records behind
+ *                    the part the table covers, which ends at Size. A record replaces any
+ *                    earlier layout of the same name. The tail is rebuilt into the table once
+ *                    it reaches 16KB, which bounds both what a lookup walks before it probes
+ *                    the table and how often a save has to rewrite the whole library. */
+struct layout_library_header
+{
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t Count;
+    uint32_t SlotCount;
+    uint32_t Size;
+};
+
+struct layout_library_record
+{
+    uint32_t Checksum;
+    uint16_t NameSize;
+    uint16_t DataSize;
+};
+
+/* NOTE(koekeishiya): An appended record, once it has been read from the library. */
+struct layout_library_entry
+{
+    uint32_t Checksum;
+    uint16_t NameSize;
+    uint16_t DataSize;
+    const char *Name;
+};
+
+struct layout_library_slot
+{
+    uint32_t Hash;
+    uint32_t Offset;
+    uint16_t NameSize;
+    uint16_t DataSize;
+};
+
+struct layout_library_map
+{
+    void *Data;
+    std::size_t Size;
+};
+
+internal uint32_t
+HashLayoutName(const char *Name, std::size_t Size)
+{
+    uint32_t Hash = 2166136261U;
+    for(std::size_t Index = 0; Index < Size; ++Index)
+    {
+        Hash ^= (unsigned char) Name[Index];
+        Hash *= 16777619U;
+    }
+
+    return Hash;
+}
+
+internal uint32_t
+ChecksumLayoutRecord(const char *Entry, std::size_t Size)
+{
+    return HashLayoutName(Entry, Size);
+}
+
+internal bool
+MapLayoutLibrary(std::string Library, layout_library_map *Map)
+{
+    int FD = open(Library.c_str(), O_RDONLY);
+    if(FD == -1)
+        return false;
+
+    struct stat Buffer;
+    if(fstat(FD, &Buffer) == -1 || Buffer.st_size < (off_t) sizeof(layout_library_header))
+    {
+        close(FD);
+        return false;
+    }
+
+    Map->Size = Buffer.st_size;
+    Map->Data = mmap(NULL, Map->Size, PROT_READ, MAP_PRIVATE, FD, 0);
+    close(FD);
+
+    return Map->Data != MAP_FAILED;
+}
+
+internal layout_library_slot *
+GetLayoutLibrarySlots(layout_library_map *Map)
+{
+    layout_library_header *Header = (layout_library_header *) Map->Data;
+    if(Header->Magic != KWM_LAYOUT_LIBRARY_MAGIC ||
+       Header->Version != KWM_LAYOUT_LIBRARY_VERSION ||
+       Header->SlotCount == 0 ||
+       (Header->SlotCount & (Header->SlotCount - 1)) != 0 ||
+       Header->SlotCount > (Map->Size - sizeof(layout_library_header)) / sizeof(layout_library_slot) ||
+       Header->Size < sizeof(layout_library_header) + Header->SlotCount * sizeof(layout_library_slot) ||
+       Header->Size > Map->Size)
+        return NULL;
+
+    return (layout_library_slot *) ((char *) Map->Data + sizeof(layout_library_header));
+}
+
+internal inline bool
+IsLayoutLibrarySlotValid(layout_library_map *Map, layout_library_slot *Slot)
+{
+    layout_library_header *Header = (layout_library_header *) Map->Data;
+    return (std::size_t) Slot->Offset + Slot->NameSize + Slot->DataSize <= Header->Size;
+}
+
+/* NOTE(koekeishiya): Reads the appended record at Offset and moves Offset past it. Returns false
+ *                    once the records end; a record cut short by an interrupted append ends them. */
+internal bool
+ReadLayoutLibraryRecord(const char *Data, std::size_t Size, std::size_t *Offset, layout_library_entry *Entry)
+{
+    layout_library_record Record;
+    if(Size - *Offset < sizeof(Record))
+        return false;
+
+    memcpy(&Record, Data + *Offset, sizeof(Record));
+    if(Size - *Offset - sizeof(Record) < (std::size_t) Record.NameSize + Record.DataSize)
+        return false;
+
+    Entry->Checksum = Record.Checksum;
+    Entry->NameSize = Record.NameSize;
+    Entry->DataSize = Record.DataSize;
+    Entry->Name = Data + *Offset + sizeof(Record);
+    *Offset += sizeof(Record) + Record.NameSize + Record.DataSize;
+    return true;
+}
+
+internal inline bool
+IsLayoutLibraryEntryValid(layout_library_entry *Entry)
+{
+    return Entry->NameSize != 0 &&
+           Entry->Checksum == ChecksumLayoutRecord(Entry->Name, Entry->NameSize + Entry->DataSize);
+}
+
+/* NOTE(koekeishiya): Where the valid records at the start of Data end. */
+internal std::size_t
+GetLayoutLibraryTailEnd(const char *Data, std::size_t Size)
+{
+    std::size_t Offset = 0, End = 0;
+    layout_library_entry Entry;
+    while(ReadLayoutLibraryRecord(Data, Size, &Offset, &Entry) && IsLayoutLibraryEntryValid(&Entry))
+        End = Offset;
+
+    return End;
+}
+
+/* NOTE(koekeishiya): The newest appended record for Name, if any. Only a matching record has
+ *                    its checksum verified; the first invalid one ends the tail. */
+internal bool
+FindLayoutLibraryRecord(layout_library_map *Map, std::string &Name, layout_library_entry *Result)
+{
+    bool Found = false;
+    std::size_t Offset = ((layout_library_header *) Map->Data)->Size;
+
+    layout_library_entry Entry;
+    while(ReadLayoutLibraryRecord((const char *) Map->Data, Map->Size, &Offset, &Entry))
+    {
+        if(Entry.NameSize == Name.size() &&
+           memcmp(Entry.Name, Name.c_str(), Name.size()) == 0)
+        {
+            if(!IsLayoutLibraryEntryValid(&Entry))
+                break;
+
+            *Result = Entry;
+            Found = true;
+        }
+    }
+
+    return Found;
+}
+
+bool ReadLayoutFromLibrary(std::string Library, std::string Name, std::string *Data)
+{
+    layout_library_map Map;
+    if(Name.empty() || !MapLayoutLibrary(Library, &Map))
+        return false;
+
+    bool Result = false;
+    layout_library_slot *Slots = GetLayoutLibrarySlots(&Map);
+    layout_library_entry Entry;
+    if(Slots && FindLayoutLibraryRecord(&Map, Name, &Entry))
+    {
+        Data->assign(Entry.Name + Entry.NameSize, Entry.DataSize);
+        Result = true;
+    }
+    else if(Slots)
+    {
+        uint32_t Mask = ((layout_library_header *) Map.Data)->SlotCount - 1;
+        uint32_t Hash = HashLayoutName(Name.c_str(), Name.size());
+        for(uint32_t Probe = 0; Probe <= Mask; ++Probe)
+        {
+            layout_library_slot *Slot = &Slots[(Hash + Probe) & Mask];
+            if(Slot->NameSize == 0 || !IsLayoutLibrarySlotValid(&Map, Slot))
+                break;
+
+            const char *Entry = (const char *) Map.Data + Slot->Offset;
+            if(Slot->Hash == Hash && Slot->NameSize == Name.size() &&
+               memcmp(Entry, Name.c_str(), Name.size()) == 0)
+            {
+                Data->assign(Entry + Slot->NameSize, Slot->DataSize);
+                Result = true;
+                break;
+            }
+        }
+    }
+
+    munmap(Map.Data, Map.Size);
+    return Result;
+}
+
+internal void
+ReadLayoutLibrary(std::string Library, std::map<std::string, std::string> &Layouts)
+{
+    layout_library_map Map;
+    if(!MapLayoutLibrary(Library, &Map))
+        return;
+
+    layout_library_slot *Slots = GetLayoutLibrarySlots(&Map);
+    if(Slots)
+    {
+        uint32_t SlotCount = ((layout_library_header *) Map.Data)->SlotCount;
+        for(uint32_t Index = 0; Index < SlotCount; ++Index)
+        {
+            layout_library_slot *Slot = &Slots[Index];
+            if(Slot->NameSize == 0 || !IsLayoutLibrarySlotValid(&Map, Slot))
+                continue;
+
+            const char *Entry = (const char *) Map.Data + Slot->Offset;
+            Layouts[std::string(Entry, Slot->NameSize)].assign(Entry + Slot->NameSize, Slot->DataSize);
+        }
+
+        std::size_t Offset = ((layout_library_header *) Map.Data)->Size;
+        layout_library_entry Entry;
+        while(ReadLayoutLibraryRecord((const char *) Map.Data, Map.Size, &Offset, &Entry) &&
+              IsLayoutLibraryEntryValid(&Entry))
+            Layouts[std::string(Entry.Name, Entry.NameSize)].assign(Entry.Name + Entry.NameSize, Entry.DataSize);
+    }
+
+    munmap(Map.Data, Map.Size);
+}
+
+internal bool
+WriteLayoutLibraryFile(int FD, const void *Data, std::size_t Size)
+{
+    std::size_t Written = 0;
+    while(Written < Size)
+    {
+        ssize_t Result = write(FD, (const char *) Data + Written, Size - Written);
+        if(Result <= 0)
+            return false;
+
+        Written += Result;
+    }
+
+    return true;
+}
+
+/* NOTE(koekeishiya): Fails if there is no valid library yet, if the record would grow the tail
+ *                    past its limit, or if an earlier append was interrupted, since a record
+ *                    behind it could never be read. An append that fails part way is cut off. */
+internal bool
+AppendLayoutToLibrary(std::string Library, const std::string &Record)
+{
+    int FD = open(Library.c_str(), O_RDWR | O_APPEND);
+    if(FD == -1)
+        return false;
+
+    bool Result = false;
+    struct stat Buffer;
+    layout_library_header Header;
+    if(fstat(FD, &Buffer) == 0 &&
+       pread(FD, &Header, sizeof(Header), 0) == sizeof(Header) &&
+       Header.Magic == KWM_LAYOUT_LIBRARY_MAGIC &&
+       Header.Version == KWM_LAYOUT_LIBRARY_VERSION &&
+       Header.Size <= Buffer.st_size &&
+       Buffer.st_size - Header.Size + Record.size() <= KWM_LAYOUT_LIBRARY_TAIL_LIMIT)
+    {
+        std::string Tail(Buffer.st_size - Header.Size, '\0');
+        if(pread(FD, &Tail[0], Tail.size(), Header.Size) == (ssize_t) Tail.size() &&
+           GetLayoutLibraryTailEnd(Tail.data(), Tail.size()) == Tail.size())
+        {
+            Result = WriteLayoutLibraryFile(FD, Record.data(), Record.size());
+            if(!Result)
+                ftruncate(FD, Buffer.st_size);
+        }
+    }
+
+    close(FD);
+    return Result;
+}
+
+/* NOTE(koekeishiya): Layouts are appended to the library. When there is no library yet, or the
+ *                    appended records have reached their limit, the library is rebuilt as a
+ *                    whole and renamed into place instead, so a lookup never sees a partially
+ *                    written table. */
+bool WriteLayoutToLibrary(std::string Library, std::string Name, const std::string &Data)
+{
+    if(Name.empty() || Name.size() > UINT16_MAX || Data.size() > UINT16_MAX)
+        return false;
+
+    std::string Entry = Name + Data;
+    layout_library_record RecordHeader = { ChecksumLayoutRecord(Entry.c_str(), Entry.size()),
+                                           (uint16_t) Name.size(),
+                                           (uint16_t) Data.size() };
+
+    std::string Record((const char *) &RecordHeader, sizeof(RecordHeader));
+    Record += Entry;
+    if(AppendLayoutToLibrary(Library, Record))
+        return true;
+
+    std::map<std::string, std::string> Layouts;
+    ReadLayoutLibrary(Library, Layouts);
+    Layouts[Name] = Data;
+
+    layout_library_header Header = { KWM_LAYOUT_LIBRARY_MAGIC, KWM_LAYOUT_LIBRARY_VERSION, (uint32_t) Layouts.size(), 1, 0 };
+    while(Header.SlotCount * 3 < Header.Count * 4)
+        Header.SlotCount <<= 1;
+
+    std::vector<layout_library_slot> Slots(Header.SlotCount, layout_library_slot());
+    std::string Entries;
+    uint32_t Offset = sizeof(layout_library_header) + Header.SlotCount * sizeof(layout_library_slot);
+    uint32_t Mask = Header.SlotCount - 1;
+
+    std::map<std::string, std::string>::iterator It;
+    for(It = Layouts.begin(); It != Layouts.end(); ++It)
+    {
+        layout_library_slot Slot = { HashLayoutName(It->first.c_str(), It->first.size()),
+                                     Offset + (uint32_t) Entries.size(),
+                                     (uint16_t) It->first.size(),
+                                     (uint16_t) It->second.size() };
+
+        uint32_t Index = Slot.Hash & Mask;
+        while(Slots[Index].NameSize != 0)
+            Index = (Index + 1) & Mask;
+
+        Slots[Index] = Slot;
+        Entries += It->first;
+        Entries += It->second;
+    }
+
+    Header.Size = Offset + Entries.size();
+
+    std::string Temporary = Library + ".tmp";
+    FILE *Handle = fopen(Temporary.c_str(), "wb");
+    if(!Handle)
+        return false;
+
+    bool Written = fwrite(&Header, sizeof(Header), 1, Handle) == 1 &&
+                   fwrite(&Slots[0], sizeof(layout_library_slot), Slots.size(), Handle) == Slots.size() &&
+                   (Entries.empty() || fwrite(Entries.data(), Entries.size(), 1, Handle) == 1);
+    Written = (fclose(Handle) == 0) && Written;
+
+    if(!Written || rename(Temporary.c_str(), Library.c_str()) != 0)
+    {
+        unlink(Temporary.c_str());
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,13 @@
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <stdint.h>
+#include <string>
+
+#define KWM_LAYOUT_LIBRARY_VERSION 2
+#define KWM_LAYOUT_LIBRARY_FILE "library.kwml"
+
+bool ReadLayoutFromLibrary(std::string Library, std::string Name, std::string *Data);
+bool WriteLayoutToLibrary(std::string Library, std::string Name, const std::string &Data);
+
+#endif
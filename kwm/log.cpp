@@ -0,0 +1,433 @@
+#include "log.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <streambuf>
+#include <chrono>
+#include <sys/time.h>
+
+#define internal static
+
+#ifdef DEBUG_BUILD
+#define KWM_LOG_DEFAULT_LEVEL LogLevel_Debug
+#else
+#define KWM_LOG_DEFAULT_LEVEL LogLevel_Info
+#endif
+
+struct kwm_log_record
+{
+    uint64_t Time;
+    uint16_t Level;
+    uint16_t Category;
+    uint32_t Length;
+    char Message[KWM_LOG_MESSAGE_SIZE];
+};
+
+/* NOTE(koekeishiya): Writes into the message of a record, and silently drops whatever does not fit. */
+struct kwm_log_buffer : public std::streambuf
+{
+    void Reset(char *Base, std::size_t Size) { setp(Base, Base + Size); }
+    std::size_t Length() { return pptr() - pbase(); }
+};
+
+/* NOTE(koekeishiya): Head is only written by the thread that owns the ring, and Tail only by
+ *                    the flusher. When the ring is full, the message is written to Scratch
+ *                    and counted as dropped instead. */
+struct kwm_log_ring
+{
+    kwm_log_record Records[KWM_LOG_RING_SIZE];
+    std::atomic<uint32_t> Head;
+    std::atomic<uint32_t> Tail;
+    std::atomic<uint64_t> Dropped;
+    std::atomic<bool> Orphaned;
+
+    kwm_log_record Scratch;
+    kwm_log_record *Record;
+    kwm_log_buffer Buffer;
+    std::ostream Stream;
+
+    uint32_t Thread;
+    uint64_t DroppedReported;
+    kwm_log_ring *Next;
+
+    kwm_log_ring() : Head(0), Tail(0), Dropped(0), Orphaned(false),
+                     Record(NULL), Stream(&Buffer), Thread(0), DroppedReported(0), Next(NULL) {}
+};
+
+std::atomic<uint32_t> KWMLogMask[LogLevel_Count] =
+{
+    {0},
+    {LogCategory_All},
+    {LogCategory_All},
+    {KWM_LOG_DEFAULT_LEVEL >= LogLevel_Info ? LogCategory_All : 0},
+    {KWM_LOG_DEFAULT_LEVEL >= LogLevel_Debug ? LogCategory_All : 0},
+};
+
+internal const char *LogLevelNames[LogLevel_Count] = { "off", "error", "warn", "info", "debug" };
+internal const char *LogCategoryNames[] = { "general", "event", "window", "tree", "hotkey", "config", "state" };
+#define KWM_LOG_CATEGORY_COUNT (sizeof(LogCategoryNames) / sizeof(LogCategoryNames[0]))
+
+internal kwm_log_level LogLevel = KWM_LOG_DEFAULT_LEVEL;
+internal uint32_t LogCategories = LogCategory_All;
+internal pthread_mutex_t LogSettingsLock = PTHREAD_MUTEX_INITIALIZER;
+
+internal __thread kwm_log_ring *LogRing;
+internal pthread_key_t LogRingKey;
+internal pthread_once_t LogRingKeyOnce = PTHREAD_ONCE_INIT;
+internal pthread_mutex_t LogRingLock = PTHREAD_MUTEX_INITIALIZER;
+internal kwm_log_ring *LogRings;
+internal uint32_t LogRingThreads;
+
+internal pthread_t LogFlusher;
+internal pthread_mutex_t LogFlusherLock = PTHREAD_MUTEX_INITIALIZER;
+internal pthread_cond_t LogFlusherState = PTHREAD_COND_INITIALIZER;
+internal bool LogFlusherRunning;
+
+internal std::string LogFile;
+internal FILE *LogHandle;
+internal long LogFileSize;
+internal time_t LogStampTime = -1;
+internal char LogStamp[32];
+
+/* NOTE(koekeishiya): Only the flusher updates these, but they are read by queries on other threads. */
+internal std::atomic<uint64_t> LogRecordsWritten(0);
+internal std::atomic<uint64_t> LogRecordsDropped(0);
+
+/* NOTE(koekeishiya): Called when a thread exits. The ring is freed by the flusher once it has
+ *                    been drained. */
+internal void
+KwmOrphanLogRing(void *Ring)
+{
+    ((kwm_log_ring *) Ring)->Orphaned.store(true, std::memory_order_release);
+}
+
+internal void
+KwmCreateLogRingKey()
+{
+    pthread_key_create(&LogRingKey, KwmOrphanLogRing);
+}
+
+internal inline kwm_log_ring *
+KwmGetLogRing()
+{
+    if(!LogRing)
+    {
+        pthread_once(&LogRingKeyOnce, KwmCreateLogRingKey);
+        LogRing = new kwm_log_ring;
+
+        pthread_mutex_lock(&LogRingLock);
+        LogRing->Thread = ++LogRingThreads;
+        LogRing->Next = LogRings;
+        LogRings = LogRing;
+        pthread_mutex_unlock(&LogRingLock);
+
+        pthread_setspecific(LogRingKey, LogRing);
+    }
+
+    return LogRing;
+}
+
+std::ostream &KwmBeginLogRecord()
+{
+    kwm_log_ring *Ring = KwmGetLogRing();
+    uint32_t Head = Ring->Head.load(std::memory_order_relaxed);
+    uint32_t Tail = Ring->Tail.load(std::memory_order_acquire);
+    if(Head - Tail < KWM_LOG_RING_SIZE)
+        Ring->Record = &Ring->Records[Head % KWM_LOG_RING_SIZE];
+    else
+        Ring->Record = &Ring->Scratch;
+
+    Ring->Buffer.Reset(Ring->Record->Message, KWM_LOG_MESSAGE_SIZE);
+    Ring->Stream.clear();
+    return Ring->Stream;
+}
+
+void KwmCommitLogRecord(kwm_log_level Level, uint32_t Category)
+{
+    kwm_log_ring *Ring = LogRing;
+    if(Ring->Record == &Ring->Scratch)
+    {
+        Ring->Dropped.store(Ring->Dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    std::chrono::microseconds Now = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch());
+    kwm_log_record *Record = Ring->Record;
+    Record->Time = Now.count();
+    Record->Level = Level;
+    Record->Category = Category;
+    Record->Length = Ring->Buffer.Length();
+
+    uint32_t Head = Ring->Head.load(std::memory_order_relaxed) + 1;
+    Ring->Head.store(Head, std::memory_order_release);
+
+    /* NOTE(koekeishiya): Wake the flusher early when a burst fills half of the ring. */
+    if(Head - Ring->Tail.load(std::memory_order_relaxed) == KWM_LOG_RING_SIZE / 2)
+        pthread_cond_signal(&LogFlusherState);
+}
+
+internal void
+KwmOpenLogFile()
+{
+    LogFileSize = 0;
+    LogHandle = fopen(LogFile.c_str(), "a");
+    if(LogHandle)
+    {
+        fseek(LogHandle, 0, SEEK_END);
+        LogFileSize = ftell(LogHandle);
+    }
+}
+
+/* NOTE(koekeishiya): The current file becomes <file>.1, and the oldest of the
+ *                    KWM_LOG_FILE_COUNT rotated files is overwritten. */
+internal void
+KwmRotateLogFile()
+{
+    fclose(LogHandle);
+    for(int Index = KWM_LOG_FILE_COUNT - 1; Index > 0; --Index)
+    {
+        std::string From = LogFile + "." + std::to_string(Index);
+        std::string To = LogFile + "." + std::to_string(Index + 1);
+        rename(From.c_str(), To.c_str());
+    }
+
+    rename(LogFile.c_str(), (LogFile + ".1").c_str());
+    KwmOpenLogFile();
+}
+
+internal const char *
+KwmLogCategoryString(uint32_t Category)
+{
+    for(std::size_t Index = 0; Index < KWM_LOG_CATEGORY_COUNT; ++Index)
+    {
+        if(Category == (uint32_t) (1 << Index))
+            return LogCategoryNames[Index];
+    }
+
+    return "unknown";
+}
+
+internal void
+KwmWriteLogRecord(kwm_log_ring *Ring, kwm_log_record *Record)
+{
+    time_t Seconds = Record->Time / 1000000;
+    if(Seconds != LogStampTime)
+    {
+        struct tm Local;
+        localtime_r(&Seconds, &Local);
+        strftime(LogStamp, sizeof(LogStamp), "%Y-%m-%d %H:%M:%S", &Local);
+        LogStampTime = Seconds;
+    }
+
+    char Header[128];
+    int Length = snprintf(Header, sizeof(Header), "%s.%03d %-5s %-7s [%u] ",
+                          LogStamp, (int) ((Record->Time / 1000) % 1000),
+                          LogLevelNames[Record->Level],
+                          KwmLogCategoryString(Record->Category),
+                          Ring->Thread);
+
+#ifdef DEBUG_BUILD
+    printf("%.*s\n", (int) Record->Length, Record->Message);
+#endif
+
+    if(LogHandle)
+    {
+        fwrite(Header, 1, Length, LogHandle);
+        fwrite(Record->Message, 1, Record->Length, LogHandle);
+        fputc('\n', LogHandle);
+
+        LogFileSize += Length + Record->Length + 1;
+        if(LogFileSize >= KWM_LOG_FILE_SIZE)
+            KwmRotateLogFile();
+    }
+
+    LogRecordsWritten.fetch_add(1, std::memory_order_relaxed);
+}
+
+internal void
+KwmDrainLogRings()
+{
+    pthread_mutex_lock(&LogRingLock);
+    kwm_log_ring **Link = &LogRings;
+    while(*Link)
+    {
+        kwm_log_ring *Ring = *Link;
+        bool Orphaned = Ring->Orphaned.load(std::memory_order_acquire);
+        uint32_t Head = Ring->Head.load(std::memory_order_acquire);
+        uint32_t Tail = Ring->Tail.load(std::memory_order_relaxed);
+        for(; Tail != Head; ++Tail)
+            KwmWriteLogRecord(Ring, &Ring->Records[Tail % KWM_LOG_RING_SIZE]);
+
+        Ring->Tail.store(Tail, std::memory_order_release);
+
+        uint64_t Dropped = Ring->Dropped.load(std::memory_order_relaxed);
+        LogRecordsDropped.fetch_add(Dropped - Ring->DroppedReported, std::memory_order_relaxed);
+        Ring->DroppedReported = Dropped;
+
+        if(Orphaned)
+        {
+            *Link = Ring->Next;
+            delete Ring;
+        }
+        else
+        {
+            Link = &Ring->Next;
+        }
+    }
+    pthread_mutex_unlock(&LogRingLock);
+
+    if(LogHandle)
+        fflush(LogHandle);
+}
+
+internal void *
+KwmProcessLogRings(void *)
+{
+    pthread_mutex_lock(&LogFlusherLock);
+    while(LogFlusherRunning)
+    {
+        pthread_mutex_unlock(&LogFlusherLock);
+        KwmDrainLogRings();
+        pthread_mutex_lock(&LogFlusherLock);
+
+        if(LogFlusherRunning)
+        {
+            struct timeval Now;
+            gettimeofday(&Now, NULL);
+
+            uint64_t Nanoseconds = (uint64_t) Now.tv_usec * 1000 + (uint64_t) (KWM_LOG_FLUSH_INTERVAL * 1000000000.0);
+            struct timespec Deadline;
+            Deadline.tv_sec = Now.tv_sec + Nanoseconds / 1000000000;
+            Deadline.tv_nsec = Nanoseconds % 1000000000;
+            pthread_cond_timedwait(&LogFlusherState, &LogFlusherLock, &Deadline);
+        }
+    }
+    pthread_mutex_unlock(&LogFlusherLock);
+
+    KwmDrainLogRings();
+    return NULL;
+}
+
+/* NOTE(koekeishiya): Messages logged before the logger is started are kept in their ring,
+ *                    and are written once the flusher runs. */
+void KwmStartLogger(std::string File)
+{
+    if(LogFlusherRunning)
+        return;
+
+    LogFile = File;
+    KwmOpenLogFile();
+
+    LogFlusherRunning = true;
+    pthread_create(&LogFlusher, NULL, &KwmProcessLogRings, NULL);
+}
+
+void KwmStopLogger()
+{
+    if(!LogFlusherRunning)
+        return;
+
+    pthread_mutex_lock(&LogFlusherLock);
+    LogFlusherRunning = false;
+    pthread_cond_signal(&LogFlusherState);
+    pthread_mutex_unlock(&LogFlusherLock);
+    pthread_join(LogFlusher, NULL);
+
+    if(LogHandle)
+    {
+        fclose(LogHandle);
+        LogHandle = NULL;
+    }
+}
+
+internal void
+KwmUpdateLogMask()
+{
+    for(int Level = LogLevel_Error; Level < LogLevel_Count; ++Level)
+        KWMLogMask[Level].store(Level <= LogLevel ? LogCategories : 0, std::memory_order_relaxed);
+}
+
+void KwmSetLogLevel(kwm_log_level Level)
+{
+    pthread_mutex_lock(&LogSettingsLock);
+    LogLevel = Level;
+    KwmUpdateLogMask();
+    pthread_mutex_unlock(&LogSettingsLock);
+}
+
+void KwmSetLogCategory(uint32_t Category, bool Enabled)
+{
+    pthread_mutex_lock(&LogSettingsLock);
+    if(Enabled)
+        LogCategories |= Category;
+    else
+        LogCategories &= ~Category;
+
+    KwmUpdateLogMask();
+    pthread_mutex_unlock(&LogSettingsLock);
+}
+
+void KwmResetLogSettings()
+{
+    pthread_mutex_lock(&LogSettingsLock);
+    LogLevel = KWM_LOG_DEFAULT_LEVEL;
+    LogCategories = LogCategory_All;
+    KwmUpdateLogMask();
+    pthread_mutex_unlock(&LogSettingsLock);
+}
+
+kwm_log_level KwmGetLogLevel()
+{
+    return LogLevel;
+}
+
+uint32_t KwmGetLogCategories()
+{
+    return LogCategories;
+}
+
+bool KwmParseLogLevel(std::string Name, kwm_log_level *Level)
+{
+    for(int Index = LogLevel_Off; Index < LogLevel_Count; ++Index)
+    {
+        if(Name == LogLevelNames[Index])
+        {
+            *Level = (kwm_log_level) Index;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* NOTE(koekeishiya): Returns 0 for an unknown category. */
+uint32_t KwmParseLogCategory(std::string Name)
+{
+    if(Name == "all")
+        return LogCategory_All;
+
+    for(std::size_t Index = 0; Index < KWM_LOG_CATEGORY_COUNT; ++Index)
+    {
+        if(Name == LogCategoryNames[Index])
+            return 1 << Index;
+    }
+
+    return 0;
+}
+
+std::string KwmLogLevelName(kwm_log_level Level)
+{
+    return LogLevelNames[Level];
+}
+
+std::string KwmLogCategoryName(uint32_t Category)
+{
+    return KwmLogCategoryString(Category);
+}
+
+void KwmGetLogUsage(uint64_t *Written, uint64_t *Dropped)
+{
+    *Written = LogRecordsWritten.load(std::memory_order_relaxed);
+    *Dropped = LogRecordsDropped.load(std::memory_order_relaxed);
+}
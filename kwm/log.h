@@ -0,0 +1,90 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <stdint.h>
+
+/*
+ * NOTE(koekeishiya):
+ *        Every thread that logs gets its own ring buffer, which only that thread writes to,
+ *        so logging takes no locks. A message is streamed straight into its slot in the ring,
+ *        and the timestamp, level and category are formatted by a background thread that
+ *        drains the rings and appends them to a rotating log file.
+ *
+ *        A message that is below the active level, or belongs to a disabled category, costs
+ *        a single relaxed load; its arguments are never evaluated.
+ * */
+
+#define KWM_LOG_RING_SIZE 256
+#define KWM_LOG_MESSAGE_SIZE 240
+#define KWM_LOG_FILE_SIZE (1 << 20)
+#define KWM_LOG_FILE_COUNT 3
+#define KWM_LOG_FLUSH_INTERVAL 0.1
+
+enum kwm_log_level
+{
+    LogLevel_Off,
+    LogLevel_Error,
+    LogLevel_Warn,
+    LogLevel_Info,
+    LogLevel_Debug,
+
+    LogLevel_Count
+};
+
+enum kwm_log_category
+{
+    LogCategory_General = (1 << 0),
+    LogCategory_Event = (1 << 1),
+    LogCategory_Window = (1 << 2),
+    LogCategory_Tree = (1 << 3),
+    LogCategory_Hotkey = (1 << 4),
+    LogCategory_Config = (1 << 5),
+    LogCategory_State = (1 << 6),
+
+    LogCategory_All = (1 << 7) - 1
+};
+
+/* NOTE(koekeishiya): The categories that are enabled at each level. */
+extern std::atomic<uint32_t> KWMLogMask[LogLevel_Count];
+
+inline bool
+KwmLogEnabled(kwm_log_level Level, uint32_t Category)
+{
+    return (KWMLogMask[Level].load(std::memory_order_relaxed) & Category) != 0;
+}
+
+std::ostream &KwmBeginLogRecord();
+void KwmCommitLogRecord(kwm_log_level Level, uint32_t Category);
+
+#define KwmLog(Level, Category, x) \
+    do { if(KwmLogEnabled(Level, Category)) \
+         { \
+             KwmBeginLogRecord() << x; \
+             KwmCommitLogRecord(Level, Category); \
+         } \
+       } while(0)
+
+#define LOG_ERROR(Category, x) KwmLog(LogLevel_Error, Category, x)
+#define LOG_WARN(Category, x) KwmLog(LogLevel_Warn, Category, x)
+#define LOG_INFO(Category, x) KwmLog(LogLevel_Info, Category, x)
+#define LOG_DEBUG(Category, x) KwmLog(LogLevel_Debug, Category, x)
+
+void KwmStartLogger(std::string File);
+void KwmStopLogger();
+
+void KwmSetLogLevel(kwm_log_level Level);
+void KwmSetLogCategory(uint32_t Category, bool Enabled);
+void KwmResetLogSettings();
+kwm_log_level KwmGetLogLevel();
+uint32_t KwmGetLogCategories();
+
+bool KwmParseLogLevel(std::string Name, kwm_log_level *Level);
+uint32_t KwmParseLogCategory(std::string Name);
+std::string KwmLogLevelName(kwm_log_level Level);
+std::string KwmLogCategoryName(uint32_t Category);
+void KwmGetLogUsage(uint64_t *Written, uint64_t *Dropped);
+
+#endif
@@ -3,6 +3,7 @@
 #include "tree.h"
 #include "space.h"
 #include "window.h"
+#include "state.h"
 #include "axlib/axlib.h"
 
 extern std::map<std::string, space_info> WindowTree;
@@ -258,7 +259,7 @@ void SwapNodeWindowIDs(tree_node *A, tree_node *B)
 {
     if(A && B)
     {
-        DEBUG("SwapNodeWindowIDs() " << A->WindowID << " with " << B->WindowID);
+        LOG_DEBUG(LogCategory_Tree, "SwapNodeWindowIDs() " << A->WindowID << " with " << B->WindowID);
         int TempWindowID = A->WindowID;
         A->WindowID = B->WindowID;
         B->WindowID = TempWindowID;
@@ -282,7 +283,7 @@ void SwapNodeWindowIDs(link_node *A, link_node *B)
 {
     if(A && B)
     {
-        DEBUG("SwapNodeWindowIDs() " << A->WindowID << " with " << B->WindowID);
+        LOG_DEBUG(LogCategory_Tree, "SwapNodeWindowIDs() " << A->WindowID << " with " << B->WindowID);
         int TempWindowID = A->WindowID;
         A->WindowID = B->WindowID;
         B->WindowID = TempWindowID;
@@ -304,6 +305,8 @@ void ResizeWindowToContainerSize(tree_node *Node)
         SetWindowDimensions(Window, Node->Container.X, Node->Container.Y,
                             Node->Container.Width, Node->Container.Height);
     }
+
+    KwmMarkStateDirty();
 }
 
 void ResizeWindowToContainerSize(link_node *Link)
@@ -314,6 +317,8 @@ void ResizeWindowToContainerSize(link_node *Link)
         SetWindowDimensions(Window, Link->Container.X, Link->Container.Y,
                             Link->Container.Width, Link->Container.Height);
     }
+
+    KwmMarkStateDirty();
 }
 
 void ResizeWindowToContainerSize(ax_window *Window)
@@ -0,0 +1,127 @@
+#include "poller.h"
+
+#include <unistd.h>
+#include <errno.h>
+
+#if defined(__APPLE__)
+#include <sys/event.h>
+#include <sys/time.h>
+#elif defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
+#if defined(__APPLE__)
+
+bool KwmPollerCreate(kwm_poller *Poller)
+{
+    Poller->FD = kqueue();
+    return Poller->FD != -1;
+}
+
+/* NOTE(koekeishiya): kqueue tracks one filter per direction, so only the
+ *                    difference between the old and new interest set is submitted. */
+bool KwmPollerUpdate(kwm_poller *Poller, int FD, uint32_t OldFlags, uint32_t NewFlags)
+{
+    struct kevent Changes[2];
+    int Count = 0;
+
+    uint32_t Added = NewFlags & ~OldFlags;
+    uint32_t Removed = OldFlags & ~NewFlags;
+
+    if(Added & KwmPoller_Read)
+        EV_SET(&Changes[Count++], FD, EVFILT_READ, EV_ADD, 0, 0, NULL);
+    else if(Removed & KwmPoller_Read)
+        EV_SET(&Changes[Count++], FD, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+
+    if(Added & KwmPoller_Write)
+        EV_SET(&Changes[Count++], FD, EVFILT_WRITE, EV_ADD, 0, 0, NULL);
+    else if(Removed & KwmPoller_Write)
+        EV_SET(&Changes[Count++], FD, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+
+    if(Count == 0)
+        return true;
+
+    return kevent(Poller->FD, Changes, Count, NULL, 0, NULL) != -1;
+}
+
+int KwmPollerWait(kwm_poller *Poller, kwm_poller_event *Events, int Count, int Timeout)
+{
+    struct kevent Result[KWM_POLLER_MAX_EVENTS];
+    if(Count > KWM_POLLER_MAX_EVENTS)
+        Count = KWM_POLLER_MAX_EVENTS;
+
+    struct timespec Time = { Timeout / 1000, (Timeout % 1000) * 1000000 };
+
+    int Ready = kevent(Poller->FD, NULL, 0, Result, Count, Timeout < 0 ? NULL : &Time);
+    for(int Index = 0; Index < Ready; ++Index)
+    {
+        Events[Index].FD = (int) Result[Index].ident;
+        Events[Index].Flags = Result[Index].filter == EVFILT_WRITE ? KwmPoller_Write : KwmPoller_Read;
+        if(Result[Index].flags & (EV_EOF | EV_ERROR))
+            Events[Index].Flags |= KwmPoller_Hangup;
+    }
+
+    return Ready == -1 && errno == EINTR ? 0 : Ready;
+}
+
+#elif defined(__linux__)
+
+bool KwmPollerCreate(kwm_poller *Poller)
+{
+    Poller->FD = epoll_create1(EPOLL_CLOEXEC);
+    return Poller->FD != -1;
+}
+
+bool KwmPollerUpdate(kwm_poller *Poller, int FD, uint32_t OldFlags, uint32_t NewFlags)
+{
+    if(OldFlags == NewFlags)
+        return true;
+
+    struct epoll_event Event = {};
+    Event.data.fd = FD;
+    if(NewFlags & KwmPoller_Read)
+        Event.events |= EPOLLIN | EPOLLRDHUP;
+    if(NewFlags & KwmPoller_Write)
+        Event.events |= EPOLLOUT;
+
+    int Operation = EPOLL_CTL_MOD;
+    if(OldFlags == 0)
+        Operation = EPOLL_CTL_ADD;
+    else if(NewFlags == 0)
+        Operation = EPOLL_CTL_DEL;
+
+    return epoll_ctl(Poller->FD, Operation, FD, &Event) != -1;
+}
+
+int KwmPollerWait(kwm_poller *Poller, kwm_poller_event *Events, int Count, int Timeout)
+{
+    struct epoll_event Result[KWM_POLLER_MAX_EVENTS];
+    if(Count > KWM_POLLER_MAX_EVENTS)
+        Count = KWM_POLLER_MAX_EVENTS;
+
+    int Ready = epoll_wait(Poller->FD, Result, Count, Timeout);
+    for(int Index = 0; Index < Ready; ++Index)
+    {
+        Events[Index].FD = Result[Index].data.fd;
+        Events[Index].Flags = 0;
+        if(Result[Index].events & EPOLLIN)
+            Events[Index].Flags |= KwmPoller_Read;
+        if(Result[Index].events & EPOLLOUT)
+            Events[Index].Flags |= KwmPoller_Write;
+        if(Result[Index].events & (EPOLLHUP | EPOLLRDHUP | EPOLLERR))
+            Events[Index].Flags |= KwmPoller_Hangup;
+    }
+
+    return Ready == -1 && errno == EINTR ? 0 : Ready;
+}
+
+#endif
+
+void KwmPollerDestroy(kwm_poller *Poller)
+{
+    if(Poller->FD != -1)
+    {
+        close(Poller->FD);
+        Poller->FD = -1;
+    }
+}
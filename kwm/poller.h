@@ -0,0 +1,34 @@
+#ifndef POLLER_H
+#define POLLER_H
+
+#include <stdint.h>
+
+/* NOTE(koekeishiya): Thin readiness-notification layer used by the daemon.
+ *                    kqueue is used on OSX, epoll on Linux. */
+
+#define KWM_POLLER_MAX_EVENTS 64
+
+enum kwm_poller_flags
+{
+    KwmPoller_Read = (1 << 0),
+    KwmPoller_Write = (1 << 1),
+    KwmPoller_Hangup = (1 << 2),
+};
+
+struct kwm_poller_event
+{
+    int FD;
+    uint32_t Flags;
+};
+
+struct kwm_poller
+{
+    int FD;
+};
+
+bool KwmPollerCreate(kwm_poller *Poller);
+void KwmPollerDestroy(kwm_poller *Poller);
+bool KwmPollerUpdate(kwm_poller *Poller, int FD, uint32_t OldFlags, uint32_t NewFlags);
+int KwmPollerWait(kwm_poller *Poller, kwm_poller_event *Events, int Count, int Timeout);
+
+#endif
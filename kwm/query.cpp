@@ -4,6 +4,8 @@
 #include "daemon.h"
 #include "tree.h"
 #include "node.h"
+#include "launcher.h"
+#include "history.h"
 
 #include "axlib/axlib.h"
 
@@ -13,6 +15,8 @@ extern std::map<std::string, space_info> WindowTree;
 extern ax_window *MarkedWindow;
 
 extern kwm_settings KWMSettings;
+extern kwm_metrics KWMMetrics;
+extern ax_state AXState;
 extern kwm_border FocusedBorder;
 extern kwm_border MarkedBorder;
 extern scratchpad Scratchpad;
@@ -238,7 +242,7 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryCurrentSpaceTag)
     {
         Output += " " + Application->Name;
         ax_window *Window = Application->Focus;
-        if(Window && Window->Name)
+        if(Window && AXLibWindowName(Window))
             Output += " - " + std::string(Window->Name);
     }
 
@@ -307,7 +311,9 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryFocusedWindowName)
 
 
     ax_application *Application = AXLibGetFocusedApplication();
-    std::string Output = Application && Application->Focus ? Application->Focus->Name : "";
+    std::string Output;
+    if(Application && Application->Focus && AXLibWindowName(Application->Focus))
+        Output = Application->Focus->Name;
     KwmWriteToSocket(Output, *SockFD);
     free(SockFD);
 }
@@ -345,7 +351,8 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryMarkedWindowName)
 {
     int *SockFD = (int *) Event->Context;
 
-    std::string Output = MarkedWindow && MarkedWindow->Name ? MarkedWindow->Name : "";
+    char *Name = MarkedWindow ? AXLibWindowName(MarkedWindow) : NULL;
+    std::string Output = Name ? Name : "";
     KwmWriteToSocket(Output, *SockFD);
     free(SockFD);
 }
@@ -378,8 +385,9 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryWindowList)
     {
         ax_window *Window = Windows[Index];
         Output += std::to_string(Window->ID) + ", " + Window->Application->Name;
-        if(Window->Name)
-            Output +=  ", " + std::string(Window->Name);
+        char *Name = AXLibWindowName(Window);
+        if(Name)
+            Output +=  ", " + std::string(Name);
         if(Index < Windows.size() - 1)
             Output += "\n";
     }
@@ -455,10 +463,11 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryScratchpad)
     std::map<int, ax_window*>::iterator It;
     for(It = Scratchpad.Windows.begin(); It != Scratchpad.Windows.end(); ++It)
     {
+        char *Name = AXLibWindowName(It->second);
         Result += std::to_string(It->first) + ": " +
                   std::to_string(It->second->ID) + ", " +
                   It->second->Application->Name + ", " +
-                  It->second->Name;
+                  (Name ? Name : "");
 
         if(Index++ < Scratchpad.Windows.size() - 1)
             Result += "\n";
@@ -467,3 +476,88 @@ EVENT_CALLBACK(Callback_KWMEvent_QueryScratchpad)
     KwmWriteToSocket(Result, *SockFD);
     free(SockFD);
 }
+
+EVENT_CALLBACK(Callback_KWMEvent_QueryMetrics)
+{
+    int *SockFD = (int *) Event->Context;
+    std::string Output;
+
+    uint64_t RuleLookups = KWMMetrics.RuleCacheHits + KWMMetrics.RuleCacheMisses;
+    uint64_t LayoutHistoryVersions, LayoutHistoryNodes;
+    GetLayoutHistoryUsage(&LayoutHistoryVersions, &LayoutHistoryNodes);
+    uint64_t LogRecordsWritten, LogRecordsDropped;
+    KwmGetLogUsage(&LogRecordsWritten, &LogRecordsDropped);
+    uint64_t ExecSpawned, ExecFailed;
+    KwmGetLauncherUsage(&ExecSpawned, &ExecFailed);
+    double RuleHitRate = RuleLookups ? (double) KWMMetrics.RuleCacheHits / RuleLookups : 0.0;
+    Output += "rule-cache-hits " + std::to_string(KWMMetrics.RuleCacheHits) + "\n";
+    Output += "rule-cache-misses " + std::to_string(KWMMetrics.RuleCacheMisses) + "\n";
+    Output += "rule-cache-hit-rate " + std::to_string(RuleHitRate) + "\n";
+    Output += "visible-window-full-scans " + std::to_string(AXLibVisibleWindowsFullScans()) + "\n";
+    Output += "visible-window-cached-scans " + std::to_string(AXLibVisibleWindowsCachedScans()) + "\n";
+    Output += "startup-application-init-ms " + std::to_string(KWMMetrics.ApplicationInitTime) + "\n";
+    Output += "startup-time-to-first-tile-ms " + std::to_string(KWMMetrics.TimeToFirstTile) + "\n";
+    Output += "config-load-ms " + std::to_string(KWMMetrics.ConfigLoadTime) + "\n";
+    Output += "config-cache-hits " + std::to_string(KWMMetrics.ConfigCacheHits) + "\n";
+    Output += "config-cache-misses " + std::to_string(KWMMetrics.ConfigCacheMisses) + "\n";
+    Output += "config-spaces-updated " + std::to_string(KWMMetrics.ConfigSpacesUpdated) + "\n";
+    Output += "state-saves " + std::to_string(KWMMetrics.StateSaves) + "\n";
+    Output += "state-restored-spaces " + std::to_string(KWMMetrics.StateRestoredSpaces) + "\n";
+    Output += "state-restored-windows " + std::to_string(KWMMetrics.StateRestoredWindows) + "\n";
+    Output += "layout-history-versions " + std::to_string(LayoutHistoryVersions) + "\n";
+    Output += "layout-history-nodes " + std::to_string(LayoutHistoryNodes) + "\n";
+    Output += "log-records-written " + std::to_string(LogRecordsWritten) + "\n";
+    Output += "log-records-dropped " + std::to_string(LogRecordsDropped) + "\n";
+    Output += "exec-spawned " + std::to_string(ExecSpawned) + "\n";
+    Output += "exec-failed " + std::to_string(ExecFailed) + "\n";
+
+    Output += "mouse-moved-queued " + std::to_string(KWMMetrics.MouseMovedQueued) + "\n";
+    Output += "mouse-moved-coalesced " + std::to_string(KWMMetrics.MouseMovedCoalesced) + "\n";
+
+    double MouseMoveMinutes = AXLibMouseMoveSeconds() / 60.0;
+    uint64_t WindowListCopies = AXLibWindowListCopies();
+    Output += "hit-test-samples " + std::to_string(AXLibHitTestSamples()) + "\n";
+    Output += "hit-test-window-list-copies " + std::to_string(WindowListCopies) + "\n";
+    Output += "hit-test-copies-per-minute " + std::to_string(MouseMoveMinutes > 0 ? WindowListCopies / MouseMoveMinutes : 0.0) + "\n";
+
+    std::string Degraded;
+    std::map<pid_t, ax_application>::iterator It;
+    for(It = AXState.Applications.begin(); It != AXState.Applications.end(); ++It)
+    {
+        ax_application *Application = &It->second;
+        if(AXLibIsApplicationDegraded(Application))
+        {
+            if(!Degraded.empty())
+                Degraded += ", ";
+
+            Degraded += Application->Name + " (" + std::to_string((int) AXLibApplicationLatency(Application)) + "ms)";
+        }
+    }
+
+    Output += "degraded-applications " + Degraded;
+
+    KwmWriteToSocket(Output, *SockFD);
+    free(SockFD);
+}
+
+EVENT_CALLBACK(Callback_KWMEvent_QueryLog)
+{
+    int *SockFD = (int *) Event->Context;
+    std::string Output = "level " + KwmLogLevelName(KwmGetLogLevel());
+
+    uint32_t Categories = KwmGetLogCategories();
+    for(uint32_t Category = 1; Category & LogCategory_All; Category <<= 1)
+        Output += "\n" + KwmLogCategoryName(Category) + ((Categories & Category) ? " on" : " off");
+
+    KwmWriteToSocket(Output, *SockFD);
+    free(SockFD);
+}
+
+EVENT_CALLBACK(Callback_KWMEvent_QueryExec)
+{
+    int *SockFD = (int *) Event->Context;
+
+    std::string Output = KwmGetProcessStatus();
+    KwmWriteToSocket(Output, *SockFD);
+    free(SockFD);
+}
@@ -6,10 +6,35 @@
 #include "tree.h"
 #include "helpers.h"
 #include "scratchpad.h"
-#include <regex>
+#include <unordered_map>
+#include <algorithm>
 
 #define internal static
 extern kwm_settings KWMSettings;
+extern kwm_metrics KWMMetrics;
+
+#define KWM_RULE_CACHE_SIZE 4096
+
+/* NOTE(koekeishiya): Rules whose owner is a plain application name are bucketed by that name, so a
+ *                    window is only tested against the rules that can possibly apply to it. Rules with
+ *                    a regex owner are guarded by a single alternation of all those patterns; when it
+ *                    does not match the application name, none of them have to be tested individually. */
+struct window_rule_index
+{
+    std::unordered_map<std::string, std::vector<std::size_t> > Owners;
+    std::vector<std::size_t> Unconditional;
+    std::vector<std::size_t> Patterns;
+
+    std::regex PatternFilter;
+    bool HasPatternFilter;
+    bool Dirty;
+
+    bool UsesRoles;
+    bool UsesTitles;
+    std::unordered_map<std::string, std::vector<std::size_t> > Cache;
+};
+
+internal window_rule_index RuleIndex;
 
 internal inline void
 ReportInvalidRule(const std::string &Command)
@@ -171,119 +196,389 @@ KwmParseRule(std::string RuleSym, window_rule *Rule)
     return Result;
 }
 
+internal inline bool
+IsLiteralPattern(const std::string &Pattern)
+{
+    return Pattern.find_first_of("\\^$.|?*+()[]{}") == std::string::npos;
+}
+
+/* NOTE(koekeishiya): Patterns containing backreferences would be renumbered when
+ *                    joined into one alternation, so those disable the filter. */
+internal inline bool
+CanCombinePattern(const std::string &Pattern)
+{
+    for(std::size_t Index = 0; Index + 1 < Pattern.size(); ++Index)
+    {
+        if(Pattern[Index] == '\\')
+        {
+            if(Pattern[Index + 1] >= '1' && Pattern[Index + 1] <= '9')
+                return false;
+
+            ++Index;
+        }
+    }
+
+    return true;
+}
+
 internal bool
-MatchWindowRule(window_rule *Rule, ax_window *Window)
+CompileWindowRule(window_rule *Rule)
 {
-    if(!Window)
+    try
+    {
+        Rule->OwnerIsLiteral = IsLiteralPattern(Rule->Owner);
+        if(!Rule->Owner.empty() && !Rule->OwnerIsLiteral)
+            Rule->OwnerExp.assign(Rule->Owner, std::regex::optimize);
+
+        if(!Rule->Name.empty())
+            Rule->NameExp.assign(Rule->Name, std::regex::optimize);
+
+        if(!Rule->Except.empty())
+            Rule->ExceptExp.assign(Rule->Except, std::regex::optimize);
+    }
+    catch(const std::regex_error &Error)
+    {
+        ReportInvalidRule("Invalid regular expression: " + std::string(Error.what()));
         return false;
+    }
+
+    if(!Rule->Role.empty())
+        Rule->AXRole = CFStringCreateWithCString(NULL, Rule->Role.c_str(), kCFStringEncodingMacRoman);
+
+    if(!Rule->CustomRole.empty())
+        Rule->AXCustomRole = CFStringCreateWithCString(NULL, Rule->CustomRole.c_str(), kCFStringEncodingMacRoman);
+
+    if(!Rule->Properties.Role.empty())
+        Rule->AXPropertyRole = CFStringCreateWithCString(NULL, Rule->Properties.Role.c_str(), kCFStringEncodingMacRoman);
+
+    return true;
+}
+
+internal void
+IndexWindowRule(window_rule *Rule, std::size_t Index)
+{
+    RuleIndex.Cache.clear();
+    if(Rule->AXRole || Rule->AXCustomRole || Rule->AXPropertyRole)
+        RuleIndex.UsesRoles = true;
+
+    if(!Rule->Name.empty() || !Rule->Except.empty())
+        RuleIndex.UsesTitles = true;
+
+    if(Rule->Owner.empty())
+    {
+        RuleIndex.Unconditional.push_back(Index);
+    }
+    else if(Rule->OwnerIsLiteral)
+    {
+        RuleIndex.Owners[Rule->Owner].push_back(Index);
+    }
+    else
+    {
+        RuleIndex.Patterns.push_back(Index);
+        RuleIndex.Dirty = true;
+    }
+}
+
+internal void
+BuildPatternFilter()
+{
+    RuleIndex.HasPatternFilter = false;
+    RuleIndex.Dirty = false;
+
+    std::string Combined;
+    for(std::size_t Index = 0; Index < RuleIndex.Patterns.size(); ++Index)
+    {
+        const std::string &Owner = KWMSettings.WindowRules[RuleIndex.Patterns[Index]].Owner;
+        if(!CanCombinePattern(Owner))
+            return;
 
-    bool Match = true;
+        if(!Combined.empty())
+            Combined += "|";
+
+        Combined += "(?:" + Owner + ")";
+    }
+
+    try
+    {
+        RuleIndex.PatternFilter.assign(Combined, std::regex::optimize | std::regex::nosubs);
+        RuleIndex.HasPatternFilter = true;
+    }
+    catch(const std::regex_error &) { }
+}
+
+/* NOTE(koekeishiya): Collect the rules that may match an application, in the order they were added. */
+internal void
+GetCandidateRules(const std::string &Owner, std::vector<std::size_t> &Candidates)
+{
+    Candidates = RuleIndex.Unconditional;
+
+    std::unordered_map<std::string, std::vector<std::size_t> >::iterator It = RuleIndex.Owners.find(Owner);
+    if(It != RuleIndex.Owners.end())
+        Candidates.insert(Candidates.end(), It->second.begin(), It->second.end());
+
+    if(!RuleIndex.Patterns.empty())
+    {
+        if(RuleIndex.Dirty)
+            BuildPatternFilter();
+
+        if(!RuleIndex.HasPatternFilter || std::regex_match(Owner, RuleIndex.PatternFilter))
+            Candidates.insert(Candidates.end(), RuleIndex.Patterns.begin(), RuleIndex.Patterns.end());
+    }
+
+    std::sort(Candidates.begin(), Candidates.end());
+}
+
+internal bool
+MatchWindowRule(window_rule *Rule, ax_window *Window, const char *Name, CFStringRef CustomRole)
+{
     if(!Rule->Owner.empty())
     {
-        std::regex Exp(Rule->Owner);
-        Match = std::regex_match(Window->Application->Name, Exp);
+        if(Rule->OwnerIsLiteral && Rule->Owner != Window->Application->Name)
+            return false;
+
+        if(!Rule->OwnerIsLiteral && !std::regex_match(Window->Application->Name, Rule->OwnerExp))
+            return false;
     }
 
-    if(!Rule->Name.empty() && Window->Name)
+    if(!Rule->Name.empty() && Name &&
+       !std::regex_match(Name, Rule->NameExp))
+        return false;
+
+    if(Rule->AXRole && !AXLibWindowHasRole(Window, Rule->AXRole))
+        return false;
+
+    if(Rule->AXCustomRole && (!CustomRole || !CFEqual(Rule->AXCustomRole, CustomRole)))
+        return false;
+
+    if(!Rule->Except.empty() && Name &&
+       std::regex_match(Name, Rule->ExceptExp))
+        return false;
+
+    return true;
+}
+
+internal inline void
+AppendCFString(std::string &Key, CFStringRef String)
+{
+    Key += '\x1f';
+    if(!String)
+        return;
+
+    const char *CString = CFStringGetCStringPtr(String, kCFStringEncodingUTF8);
+    if(CString)
     {
-        std::regex Exp(Rule->Name);
-        Match = Match && std::regex_match(Window->Name, Exp);
+        Key += CString;
     }
+    else
+    {
+        char *Copy = CopyCFStringToC(String, true);
+        if(Copy)
+        {
+            Key += Copy;
+            free(Copy);
+        }
+    }
+}
 
-    if(!Rule->Role.empty())
+/* NOTE(koekeishiya): The result of evaluating the rules depends only on the application name, the
+ *                    window title and the roles of the window, so windows that share these also share
+ *                    the set of rules that match. Roles are only part of the key when a rule uses them. */
+internal std::string
+GetRuleCacheKey(ax_window *Window, const char *Name)
+{
+    std::string Key = Window->Application->Name;
+    Key += '\x1f';
+    if(Name)
     {
-        CFTypeRef AXRole = CFStringCreateWithCString(NULL, Rule->Role.c_str(), kCFStringEncodingMacRoman);
-        Match = Match && AXLibWindowHasRole(Window, AXRole);
-        CFRelease(AXRole);
+        Key += '+';
+        Key += Name;
     }
 
-    if(!Rule->CustomRole.empty())
+    if(RuleIndex.UsesRoles)
     {
-        CFTypeRef AXRole = CFStringCreateWithCString(NULL, Rule->CustomRole.c_str(), kCFStringEncodingMacRoman);
-        Match = Match && AXLibWindowHasCustomRole(Window, AXRole);
-        CFRelease(AXRole);
+        AppendCFString(Key, (CFStringRef) Window->Type.Role);
+        AppendCFString(Key, (CFStringRef) Window->Type.Subrole);
+        AppendCFString(Key, (CFStringRef) Window->Type.CustomRole);
     }
 
-    if(!Rule->Except.empty() && Window->Name)
+    return Key;
+}
+
+/* NOTE(koekeishiya): Returns the indices of the rules that match the window, in the order they apply.
+ *                    A matching rule that assigns a custom role changes what later 'crole' rules see,
+ *                    which is why the role is threaded through the evaluation instead of read from the
+ *                    window. The returned pointer is valid until the next call. */
+internal std::vector<std::size_t> *
+ResolveWindowRules(ax_window *Window, const char *Name)
+{
+    std::string Key = GetRuleCacheKey(Window, Name);
+    std::unordered_map<std::string, std::vector<std::size_t> >::iterator It = RuleIndex.Cache.find(Key);
+    if(It != RuleIndex.Cache.end())
     {
-        std::regex Exp(Rule->Except);
-        Match = Match && !std::regex_match(Window->Name, Exp);
+        ++KWMMetrics.RuleCacheHits;
+        return &It->second;
     }
 
-    return Match;
+    ++KWMMetrics.RuleCacheMisses;
+    if(RuleIndex.Cache.size() >= KWM_RULE_CACHE_SIZE)
+        RuleIndex.Cache.clear();
+
+    std::vector<std::size_t> *Matches = &RuleIndex.Cache[Key];
+    std::vector<std::size_t> Candidates;
+    GetCandidateRules(Window->Application->Name, Candidates);
+
+    CFStringRef CustomRole = (CFStringRef) Window->Type.CustomRole;
+    for(std::size_t Candidate = 0; Candidate < Candidates.size(); ++Candidate)
+    {
+        window_rule *Rule = &KWMSettings.WindowRules[Candidates[Candidate]];
+        if(MatchWindowRule(Rule, Window, Name, CustomRole))
+        {
+            Matches->push_back(Candidates[Candidate]);
+            if(Rule->AXPropertyRole)
+                CustomRole = Rule->AXPropertyRole;
+        }
+    }
+
+    return Matches;
+}
+
+/* NOTE(koekeishiya): Returns true if the window was moved away or hidden and should not be tiled. */
+internal bool
+ApplyWindowRule(window_rule *Rule, ax_window *Window)
+{
+    bool Skip = false;
+    if(Rule->Properties.Float == 1)
+        AXLibAddFlags(Window, AXWindow_Floating);
+
+    if(Rule->AXPropertyRole)
+    {
+        if(Window->Type.CustomRole)
+            CFRelease(Window->Type.CustomRole);
+
+        Window->Type.CustomRole = CFRetain(Rule->AXPropertyRole);
+    }
+
+    if(Rule->Properties.Scratchpad != -1)
+    {
+        AddWindowToScratchpad(Window);
+        if(Rule->Properties.Scratchpad == 0)
+        {
+            HideScratchpadWindow(GetScratchpadSlotOfWindow(Window));
+            Skip = true;
+        }
+    }
+
+    if(Rule->Properties.Display != -1 && Rule->Properties.Space == -1)
+    {
+        if(!AXLibIsWindowStandard(Window) &&
+           !AXLibIsWindowCustom(Window))
+            return Skip;
+
+        ax_display *Display = AXLibArrangementDisplay(Rule->Properties.Display);
+        if(Display && Display != AXLibWindowDisplay(Window))
+        {
+            MoveWindowToDisplay(Window, Display->ArrangementID, false);
+            Skip = true;
+        }
+    }
+
+    if(Rule->Properties.Space != -1)
+    {
+        if(!AXLibIsWindowStandard(Window) &&
+           !AXLibIsWindowCustom(Window))
+            return Skip;
+
+        int Display = Rule->Properties.Display == -1 ? 0 : Rule->Properties.Display;
+        ax_display *SourceDisplay = AXLibWindowDisplay(Window);
+        ax_display *DestinationDisplay = AXLibArrangementDisplay(Display);
+        int TotalSpaces = AXLibDisplaySpacesCount(DestinationDisplay);
+        if(Rule->Properties.Space <= TotalSpaces && Rule->Properties.Space >= 1)
+        {
+            int SourceCGSSpaceID = SourceDisplay->Space->ID;
+            int DestinationCGSSpaceID = AXLibCGSSpaceIDFromDesktopID(DestinationDisplay, Rule->Properties.Space);
+            if(!AXLibSpaceHasWindow(Window, DestinationCGSSpaceID))
+            {
+                AXLibSpaceAddWindow(DestinationCGSSpaceID, Window->ID);
+                AXLibSpaceRemoveWindow(SourceCGSSpaceID, Window->ID);
+                Skip = true;
+            }
+        }
+    }
+
+    return Skip;
 }
 
 void KwmAddRule(std::string RuleSym)
 {
     window_rule Rule = {};
-    if(!RuleSym.empty() && KwmParseRule(RuleSym, &Rule))
+    if(!RuleSym.empty() && KwmParseRule(RuleSym, &Rule) && CompileWindowRule(&Rule))
+    {
         KWMSettings.WindowRules.push_back(Rule);
+        IndexWindowRule(&KWMSettings.WindowRules.back(), KWMSettings.WindowRules.size() - 1);
+    }
+}
+
+void KwmClearRules()
+{
+    for(std::size_t Index = 0; Index < KWMSettings.WindowRules.size(); ++Index)
+    {
+        window_rule *Rule = &KWMSettings.WindowRules[Index];
+        if(Rule->AXRole)
+            CFRelease(Rule->AXRole);
+
+        if(Rule->AXCustomRole)
+            CFRelease(Rule->AXCustomRole);
+
+        if(Rule->AXPropertyRole)
+            CFRelease(Rule->AXPropertyRole);
+    }
+
+    KWMSettings.WindowRules.clear();
+    RuleIndex.Owners.clear();
+    RuleIndex.Unconditional.clear();
+    RuleIndex.Patterns.clear();
+    RuleIndex.HasPatternFilter = false;
+    RuleIndex.Dirty = false;
+    RuleIndex.UsesRoles = false;
+    RuleIndex.UsesTitles = false;
+    RuleIndex.Cache.clear();
 }
 
 /* TODO(koekeishiya): This entire system is just stupid. Reimplement in a proper way. */
 bool ApplyWindowRules(ax_window *Window)
 {
     bool Skip = false;
-    for(int Index = 0; Index < KWMSettings.WindowRules.size(); ++Index)
-    {
-        window_rule *Rule = &KWMSettings.WindowRules[Index];
-        if(MatchWindowRule(Rule, Window))
-        {
-            if(Rule->Properties.Float == 1)
-                AXLibAddFlags(Window, AXWindow_Floating);
+    if(!Window || KWMSettings.WindowRules.empty())
+        return Skip;
 
-            if(!Rule->Properties.Role.empty())
-                Window->Type.CustomRole = CFStringCreateWithCString(NULL,
-                                                                    Rule->Properties.Role.c_str(),
-                                                                    kCFStringEncodingMacRoman);
+    const char *Name = RuleIndex.UsesTitles ? AXLibWindowName(Window) : NULL;
+    std::vector<std::size_t> Matches = *ResolveWindowRules(Window, Name);
+    for(std::size_t Index = 0; Index < Matches.size(); ++Index)
+    {
+        if(ApplyWindowRule(&KWMSettings.WindowRules[Matches[Index]], Window))
+            Skip = true;
+    }
 
-            if(Rule->Properties.Scratchpad != -1)
-            {
-                AddWindowToScratchpad(Window);
-                if(Rule->Properties.Scratchpad == 0)
-                {
-                    HideScratchpadWindow(GetScratchpadSlotOfWindow(Window));
-                    Skip = true;
-                }
-            }
+    return Skip;
+}
 
-            if(Rule->Properties.Display != -1 && Rule->Properties.Space == -1)
-            {
-                if(!AXLibIsWindowStandard(Window) &&
-                   !AXLibIsWindowCustom(Window))
-                    continue;
+/* NOTE(koekeishiya): Only rules that match the new title but did not match the previous one are
+ *                    applied, so a window is not floated or moved again every time its title changes. */
+bool ApplyWindowRulesForTitleChange(ax_window *Window, const char *PreviousName)
+{
+    bool Skip = false;
+    if(!Window || !RuleIndex.UsesTitles)
+        return Skip;
 
-                ax_display *Display = AXLibArrangementDisplay(Rule->Properties.Display);
-                if(Display && Display != AXLibWindowDisplay(Window))
-                {
-                    MoveWindowToDisplay(Window, Display->ArrangementID, false);
-                    Skip = true;
-                }
-            }
+    std::vector<std::size_t> Previous = *ResolveWindowRules(Window, PreviousName);
+    std::vector<std::size_t> Current = *ResolveWindowRules(Window, AXLibWindowName(Window));
+    for(std::size_t Index = 0; Index < Current.size(); ++Index)
+    {
+        if(std::find(Previous.begin(), Previous.end(), Current[Index]) != Previous.end())
+            continue;
 
-            if(Rule->Properties.Space != -1)
-            {
-                if(!AXLibIsWindowStandard(Window) &&
-                   !AXLibIsWindowCustom(Window))
-                    continue;
-
-                int Display = Rule->Properties.Display == -1 ? 0 : Rule->Properties.Display;
-                ax_display *SourceDisplay = AXLibWindowDisplay(Window);
-                ax_display *DestinationDisplay = AXLibArrangementDisplay(Display);
-                int TotalSpaces = AXLibDisplaySpacesCount(DestinationDisplay);
-                if(Rule->Properties.Space <= TotalSpaces && Rule->Properties.Space >= 1)
-                {
-                    int SourceCGSSpaceID = SourceDisplay->Space->ID;
-                    int DestinationCGSSpaceID = AXLibCGSSpaceIDFromDesktopID(DestinationDisplay, Rule->Properties.Space);
-                    if(!AXLibSpaceHasWindow(Window, DestinationCGSSpaceID))
-                    {
-                        AXLibSpaceAddWindow(DestinationCGSSpaceID, Window->ID);
-                        AXLibSpaceRemoveWindow(SourceCGSSpaceID, Window->ID);
-                        Skip = true;
-                    }
-                }
-            }
-        }
+        if(ApplyWindowRule(&KWMSettings.WindowRules[Current[Index]], Window))
+            Skip = true;
     }
 
     return Skip;
@@ -5,6 +5,8 @@
 #include "axlib/axlib.h"
 
 bool ApplyWindowRules(ax_window *Window);
+bool ApplyWindowRulesForTitleChange(ax_window *Window, const char *PreviousName);
 void KwmAddRule(std::string RuleSym);
+void KwmClearRules();
 
 #endif
@@ -2,6 +2,7 @@
 #include "display.h"
 #include "space.h"
 #include "window.h"
+#include "state.h"
 #include "axlib/axlib.h"
 
 #define internal static
@@ -30,9 +31,9 @@ int GetScratchpadSlotOfWindow(ax_window *Window)
     }
 
     if(Window->Name)
-        DEBUG("GetScratchpadSlotOfWindow() " << Window->Name  << " " << Slot);
+        LOG_DEBUG(LogCategory_Window, "GetScratchpadSlotOfWindow() " << Window->Name  << " " << Slot);
     else
-        DEBUG("GetScratchpadSlotOfWindow() " << "[Unknown]" << " " << Slot);
+        LOG_DEBUG(LogCategory_Window, "GetScratchpadSlotOfWindow() " << "[Unknown]" << " " << Slot);
     return Slot;
 }
 
@@ -63,7 +64,8 @@ void AddWindowToScratchpad(ax_window *Window)
     {
         int Slot = GetFirstAvailableScratchpadSlot();
         Scratchpad.Windows[Slot] = Window;
-        DEBUG("AddWindowToScratchpad() " << Slot);
+        KwmMarkStateDirty();
+        LOG_DEBUG(LogCategory_Window, "AddWindowToScratchpad() " << Slot);
     }
 }
 
@@ -88,7 +90,8 @@ void RemoveWindowFromScratchpad(ax_window *Window)
 
         int Slot = GetScratchpadSlotOfWindow(Window);
         Scratchpad.Windows.erase(Slot);
-        DEBUG("RemoveWindowFromScratchpad() " << Slot);
+        KwmMarkStateDirty();
+        LOG_DEBUG(LogCategory_Window, "RemoveWindowFromScratchpad() " << Slot);
     }
 }
 
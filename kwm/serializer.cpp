@@ -5,6 +5,7 @@
 #include "space.h"
 #include "border.h"
 #include "helpers.h"
+#include "library.h"
 #include "axlib/display.h"
 
 #define internal static
@@ -56,17 +57,17 @@ DeserializeParentNode(tree_node *Parent, ax_display *Display, std::vector<std::s
         if(Tokens[2] == "split-mode")
         {
             Parent->SplitMode = (split_type)ConvertStringToInt(Tokens[3]);
-            DEBUG("Root: SplitMode Found " + Tokens[3]);
+            LOG_DEBUG(LogCategory_Tree, "Root: SplitMode Found " + Tokens[3]);
         }
         else if(Tokens[2] == "split-ratio")
         {
             Parent->SplitRatio = ConvertStringToDouble(Tokens[3]);
-            DEBUG("Root: SplitRatio Found " + Tokens[3]);
+            LOG_DEBUG(LogCategory_Tree, "Root: SplitRatio Found " + Tokens[3]);
         }
         else if(Tokens[2] == "child")
         {
-            DEBUG("Root: Child Found");
-            DEBUG("Parent: " << Parent->SplitMode << "|" << Parent->SplitRatio);
+            LOG_DEBUG(LogCategory_Tree, "Root: Child Found");
+            LOG_DEBUG(LogCategory_Tree, "Parent: " << Parent->SplitMode << "|" << Parent->SplitRatio);
             LineNumber = DeserializeChildNode(Parent, Display, Serialized, LineNumber+1);
         }
 
@@ -86,7 +87,7 @@ DeserializeChildNode(tree_node *Parent, ax_display *Display, std::vector<std::st
         std::string Line = Serialized[LineNumber];
         if(Line == "kwmc tree root create left")
         {
-            DEBUG("Child: Create root");
+            LOG_DEBUG(LogCategory_Tree, "Child: Create root");
             Parent->LeftChild = CreateLeafNode(Display, Parent, 0, CONTAINER_LEFT);
             CreateDeserializedNodeContainer(Display, Parent->LeftChild);
             LineNumber = DeserializeParentNode(Parent->LeftChild, Display, Serialized, LineNumber+1);
@@ -94,7 +95,7 @@ DeserializeChildNode(tree_node *Parent, ax_display *Display, std::vector<std::st
         }
         else if(Line == "kwmc tree root create right")
         {
-            DEBUG("Child: Create root");
+            LOG_DEBUG(LogCategory_Tree, "Child: Create root");
             Parent->RightChild = CreateLeafNode(Display, Parent, 0, CONTAINER_RIGHT);
             CreateDeserializedNodeContainer(Display, Parent->RightChild);
             LineNumber = DeserializeParentNode(Parent->RightChild, Display, Serialized, LineNumber+1);
@@ -102,14 +103,14 @@ DeserializeChildNode(tree_node *Parent, ax_display *Display, std::vector<std::st
         }
         else if(Line == "kwmc tree leaf create left")
         {
-            DEBUG("Child: Create left leaf");
+            LOG_DEBUG(LogCategory_Tree, "Child: Create left leaf");
             Parent->LeftChild = CreateLeafNode(Display, Parent, 0, CONTAINER_LEFT);
             CreateDeserializedNodeContainer(Display, Parent->LeftChild);
             return LineNumber;
         }
         else if(Line == "kwmc tree leaf create right")
         {
-            DEBUG("Child: Create right leaf");
+            LOG_DEBUG(LogCategory_Tree, "Child: Create right leaf");
             Parent->RightChild = CreateLeafNode(Display, Parent, 0, CONTAINER_RIGHT);
             CreateDeserializedNodeContainer(Display, Parent->RightChild);
             return LineNumber;
@@ -125,13 +126,181 @@ DeserializeNodeTree(std::vector<std::string> &Serialized, ax_display *Display)
     if(Serialized.empty() || Serialized[0] != "kwmc tree root create parent")
         return NULL;
 
-    DEBUG("Deserialize: Create Master");
+    LOG_DEBUG(LogCategory_Tree, "Deserialize: Create Master");
     tree_node *RootNode = CreateRootNode();
     SetRootNodeContainer(Display, RootNode);
     DeserializeParentNode(RootNode, Display, Serialized, 1);
     return RootNode;
 }
 
+/* NOTE(koekeishiya): The binary encoding of a layout is the number of parent nodes, a bit
+ *                    stream and the split ratios. The stream walks the tree in pre-order,
+ *                    with one bit per node telling a parent from a leaf, followed by two
+ *                    bits of split mode for every parent. Split ratios are quantized to
+ *                    16 bits, which is finer than the six decimals the text format keeps. */
+struct layout_writer
+{
+    std::string Bits;
+    std::string Ratios;
+    uint32_t BitCount;
+    uint32_t Parents;
+};
+
+struct layout_reader
+{
+    const unsigned char *Bits;
+    uint32_t BitCount;
+    uint32_t BitIndex;
+
+    const char *Ratios;
+    uint32_t Parents;
+    uint32_t ParentIndex;
+};
+
+internal inline uint32_t
+EncodeSplitMode(split_type SplitMode)
+{
+    return SplitMode == SPLIT_OPTIMAL ? 3 : (uint32_t) SplitMode;
+}
+
+internal inline split_type
+DecodeSplitMode(uint32_t Value)
+{
+    return Value == 3 ? SPLIT_OPTIMAL : (split_type) Value;
+}
+
+internal void
+WriteLayoutBits(layout_writer *Writer, uint32_t Value, int Count)
+{
+    for(int Bit = 0; Bit < Count; ++Bit, ++Writer->BitCount)
+    {
+        if(Writer->BitCount % 8 == 0)
+            Writer->Bits.push_back(0);
+
+        if(Value & (1 << Bit))
+            Writer->Bits[Writer->Bits.size() - 1] |= 1 << (Writer->BitCount % 8);
+    }
+}
+
+internal bool
+ReadLayoutBits(layout_reader *Reader, int Count, uint32_t *Value)
+{
+    if(Reader->BitIndex + Count > Reader->BitCount)
+        return false;
+
+    *Value = 0;
+    for(int Bit = 0; Bit < Count; ++Bit, ++Reader->BitIndex)
+    {
+        if(Reader->Bits[Reader->BitIndex / 8] & (1 << (Reader->BitIndex % 8)))
+            *Value |= 1 << Bit;
+    }
+
+    return true;
+}
+
+internal void
+EncodeLayoutNode(tree_node *Node, layout_writer *Writer)
+{
+    if(IsLeafNode(Node))
+    {
+        WriteLayoutBits(Writer, 0, 1);
+        return;
+    }
+
+    WriteLayoutBits(Writer, 1, 1);
+    WriteLayoutBits(Writer, EncodeSplitMode(Node->SplitMode), 2);
+
+    double SplitRatio = std::min(std::max(Node->SplitRatio, 0.0), 1.0);
+    uint16_t Ratio = (uint16_t) (SplitRatio * UINT16_MAX + 0.5);
+    Writer->Ratios.append((const char *) &Ratio, sizeof(Ratio));
+    ++Writer->Parents;
+
+    EncodeLayoutNode(Node->LeftChild, Writer);
+    EncodeLayoutNode(Node->RightChild, Writer);
+}
+
+internal bool
+EncodeLayout(tree_node *Root, std::string *Data)
+{
+    layout_writer Writer = {};
+    EncodeLayoutNode(Root, &Writer);
+
+    Data->clear();
+    Data->append((const char *) &Writer.Parents, sizeof(Writer.Parents));
+    Data->append(Writer.Bits);
+    Data->append(Writer.Ratios);
+    return Data->size() <= UINT16_MAX;
+}
+
+internal bool
+DecodeLayoutParent(tree_node *Parent, ax_display *Display, layout_reader *Reader)
+{
+    uint32_t SplitMode;
+    uint16_t Ratio;
+    if(!ReadLayoutBits(Reader, 2, &SplitMode) || Reader->ParentIndex == Reader->Parents)
+        return false;
+
+    memcpy(&Ratio, Reader->Ratios + Reader->ParentIndex++ * sizeof(Ratio), sizeof(Ratio));
+    Parent->SplitMode = DecodeSplitMode(SplitMode);
+    Parent->SplitRatio = (double) Ratio / UINT16_MAX;
+
+    uint32_t IsParent;
+    if(!ReadLayoutBits(Reader, 1, &IsParent))
+        return false;
+
+    Parent->LeftChild = CreateLeafNode(Display, Parent, 0, CONTAINER_LEFT);
+    CreateDeserializedNodeContainer(Display, Parent->LeftChild);
+    if(IsParent && !DecodeLayoutParent(Parent->LeftChild, Display, Reader))
+        return false;
+
+    if(!ReadLayoutBits(Reader, 1, &IsParent))
+        return false;
+
+    Parent->RightChild = CreateLeafNode(Display, Parent, 0, CONTAINER_RIGHT);
+    CreateDeserializedNodeContainer(Display, Parent->RightChild);
+    if(IsParent && !DecodeLayoutParent(Parent->RightChild, Display, Reader))
+        return false;
+
+    return true;
+}
+
+internal tree_node *
+DecodeLayout(const std::string &Data, ax_display *Display)
+{
+    layout_reader Reader = {};
+    if(Data.size() < sizeof(Reader.Parents))
+        return NULL;
+
+    memcpy(&Reader.Parents, Data.data(), sizeof(Reader.Parents));
+    std::size_t BitBytes = (4 * (std::size_t) Reader.Parents + 1 + 7) / 8;
+    if(Reader.Parents == 0 || Data.size() != sizeof(Reader.Parents) + BitBytes + Reader.Parents * sizeof(uint16_t))
+        return NULL;
+
+    Reader.Bits = (const unsigned char *) Data.data() + sizeof(Reader.Parents);
+    Reader.BitCount = BitBytes * 8;
+    Reader.Ratios = Data.data() + sizeof(Reader.Parents) + BitBytes;
+
+    uint32_t IsParent;
+    if(!ReadLayoutBits(&Reader, 1, &IsParent) || !IsParent)
+        return NULL;
+
+    tree_node *RootNode = CreateRootNode();
+    SetRootNodeContainer(Display, RootNode);
+    if(!DecodeLayoutParent(RootNode, Display, &Reader) || Reader.ParentIndex != Reader.Parents)
+    {
+        DestroyNodeTree(RootNode);
+        return NULL;
+    }
+
+    return RootNode;
+}
+
+internal inline std::string
+GetLayoutLibraryPath()
+{
+    return KWMPath.Layouts + "/" + KWM_LAYOUT_LIBRARY_FILE;
+}
+
 void SaveBSPTreeToFile(ax_display *Display, space_info *SpaceInfo, std::string Name)
 {
     if(SpaceInfo->Settings.Mode != SpaceModeBSP || IsLeafNode(SpaceInfo->RootNode))
@@ -142,25 +311,31 @@ void SaveBSPTreeToFile(ax_display *Display, space_info *SpaceInfo, std::string N
     if (stat(TempPath.c_str(), &Buffer) == -1)
         mkdir(TempPath.c_str(), 0700);
 
-    std::ofstream OutFD(TempPath + "/" + Name);
-    if(OutFD.fail())
-        return;
-
-    tree_node *Root = SpaceInfo->RootNode;
-    std::vector<std::string> SerializedTree;
-    SerializeParentNode(Root, "parent", SerializedTree);
-
-    for(std::size_t LineNumber = 0; LineNumber < SerializedTree.size(); ++LineNumber)
-        OutFD << SerializedTree[LineNumber] << std::endl;
-
-    OutFD.close();
+    std::string Data;
+    if(EncodeLayout(SpaceInfo->RootNode, &Data))
+        WriteLayoutToLibrary(GetLayoutLibraryPath(), Name, Data);
 }
 
+/* NOTE(koekeishiya): Layouts are looked up in the library first. A layout that is only found
+ *                    as a text file in the layouts directory is imported into the library
+ *                    the first time it is loaded. */
 void LoadBSPTreeFromFile(ax_display *Display, space_info *SpaceInfo, std::string Name)
 {
     if(SpaceInfo->Settings.Mode != SpaceModeBSP)
         return;
 
+    std::string Data;
+    if(ReadLayoutFromLibrary(GetLayoutLibraryPath(), Name, &Data))
+    {
+        tree_node *RootNode = DecodeLayout(Data, Display);
+        if(RootNode)
+        {
+            DestroyNodeTree(SpaceInfo->RootNode);
+            SpaceInfo->RootNode = RootNode;
+            return;
+        }
+    }
+
     std::string TempPath = KWMPath.Layouts;
     std::ifstream InFD(TempPath + "/" + Name);
     if(InFD.fail())
@@ -173,4 +348,7 @@ void LoadBSPTreeFromFile(ax_display *Display, space_info *SpaceInfo, std::string
 
     DestroyNodeTree(SpaceInfo->RootNode);
     SpaceInfo->RootNode = DeserializeNodeTree(SerializedTree, Display);
+
+    if(SpaceInfo->RootNode && !IsLeafNode(SpaceInfo->RootNode) && EncodeLayout(SpaceInfo->RootNode, &Data))
+        WriteLayoutToLibrary(GetLayoutLibraryPath(), Name, Data);
 }
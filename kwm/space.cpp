@@ -99,6 +99,46 @@ space_settings *GetSpaceSettingsForDesktopID(int ScreenID, int DesktopID)
         return NULL;
 }
 
+space_settings *GetOrCreateSpaceSettingsForDesktopID(int ScreenID, int DesktopID)
+{
+    space_settings *SpaceSettings = GetSpaceSettingsForDesktopID(ScreenID, DesktopID);
+    if(!SpaceSettings)
+    {
+        space_identifier Lookup = { ScreenID, DesktopID };
+        space_settings NULLSpaceSettings = { KWMSettings.DefaultOffset, SpaceModeDefault, {0, 0}, "", ""};
+
+        space_settings *ScreenSettings = GetSpaceSettingsForDisplay(ScreenID);
+        if(ScreenSettings)
+            NULLSpaceSettings = *ScreenSettings;
+
+        KWMSettings.SpaceSettings[Lookup] = NULLSpaceSettings;
+        SpaceSettings = &KWMSettings.SpaceSettings[Lookup];
+    }
+
+    return SpaceSettings;
+}
+
+/* NOTE(koekeishiya): The settings a space ends up with; a space override wins over a display
+ *                    override, which wins over the global defaults. Settings is passed in so
+ *                    that a staged set of settings can be compared with the live one. */
+space_settings ResolveSpaceSettings(kwm_settings *Settings, unsigned int ScreenID, int DesktopID)
+{
+    space_settings Result = { Settings->DefaultOffset, SpaceModeDefault, {0, 0}, "", "" };
+
+    space_identifier Lookup = { (int) ScreenID, DesktopID };
+    std::map<space_identifier, space_settings>::iterator SpaceIt = Settings->SpaceSettings.find(Lookup);
+    std::map<unsigned int, space_settings>::iterator DisplayIt = Settings->DisplaySettings.find(ScreenID);
+    if(SpaceIt != Settings->SpaceSettings.end())
+        Result = SpaceIt->second;
+    else if(DisplayIt != Settings->DisplaySettings.end())
+        Result = DisplayIt->second;
+
+    if(Result.Mode == SpaceModeDefault)
+        Result.Mode = Settings->Space;
+
+    return Result;
+}
+
 int GetSpaceFromName(ax_display *Display, std::string Name)
 {
     std::map<CGSSpaceID, ax_space>::iterator It;
@@ -116,7 +156,8 @@ int GetSpaceFromName(ax_display *Display, std::string Name)
 void SetNameOfActiveSpace(ax_display *Display, std::string Name)
 {
     space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
-    if(SpaceInfo) SpaceInfo->Settings.Name = Name;
+    SpaceInfo->Settings.Name = Name;
+    SpaceInfo->Overrides |= SpaceOverride_Name;
 }
 
 std::string GetNameOfSpace(ax_display *Display, ax_space *Space)
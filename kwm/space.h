@@ -9,6 +9,8 @@ void GetTagForCurrentSpace(std::string &Tag);
 
 void GoToPreviousSpace(bool MoveFocusedWindow);
 space_settings *GetSpaceSettingsForDesktopID(int ScreenID, int DesktopID);
+space_settings *GetOrCreateSpaceSettingsForDesktopID(int ScreenID, int DesktopID);
+space_settings ResolveSpaceSettings(kwm_settings *Settings, unsigned int ScreenID, int DesktopID);
 int GetSpaceFromName(ax_display *Display, std::string Name);
 void SetNameOfActiveSpace(ax_display *Display, std::string Name);
 std::string GetNameOfSpace(ax_display *Display, ax_space *Space);
@@ -0,0 +1,525 @@
+#include "state.h"
+#include "cache.h"
+#include "event.h"
+#include "node.h"
+#include "tree.h"
+#include "container.h"
+#include "window.h"
+#include "axlib/axlib.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <atomic>
+
+#define internal static
+
+#define KWM_STATE_MAGIC 0x534d574b
+#define KWM_STATE_SAVE_DELAY 0.5
+#define KWM_STATE_JOURNAL_LIMIT (256 * 1024)
+#define KWM_STATE_MAX_DEPTH 64
+
+extern std::map<std::string, space_info> WindowTree;
+extern ax_application *FocusedApplication;
+extern ax_window *MarkedWindow;
+extern scratchpad Scratchpad;
+extern kwm_path KWMPath;
+extern kwm_metrics KWMMetrics;
+
+enum saved_node_flags
+{
+    SavedNode_Parent = (1 << 0),
+    SavedNode_Link = (1 << 1),
+};
+
+/* NOTE(koekeishiya): A tree is stored as its nodes in pre-order. Parents are followed by
+ *                    their left and right subtree, leaves carry the windows of their
+ *                    link list. */
+struct saved_node
+{
+    uint8_t Flags;
+    uint32_t WindowID;
+    int32_t SplitMode;
+    double SplitRatio;
+    std::vector<uint32_t> Links;
+};
+
+/* NOTE(koekeishiya): Only the settings that were changed at runtime are kept; the others are
+ *                    resolved from the kwmrc again when the space is restored. */
+struct saved_space
+{
+    uint8_t Overrides;
+    space_settings Settings;
+    std::vector<saved_node> Nodes;
+};
+
+struct saved_state
+{
+    std::map<std::string, saved_space> Spaces;
+    std::map<int, uint32_t> Scratchpad;
+    int32_t ScratchpadLastFocus;
+    uint32_t MarkedWindow;
+    uint32_t FocusedWindow;
+};
+
+/* NOTE(koekeishiya): The state read at startup. Spaces are taken out as they are restored,
+ *                    the ones we have not visited yet are written back unchanged. */
+internal saved_state RestoredState = {};
+internal std::atomic<bool> StateSavePending(false);
+internal bool StateJournalCompacted = false;
+
+internal void
+SaveTreeNode(tree_node *Node, std::vector<saved_node> &Nodes)
+{
+    bool IsParent = Node->LeftChild && Node->RightChild;
+
+    saved_node Saved = {};
+    Saved.Flags = (IsParent ? SavedNode_Parent : 0) |
+                  (Node->Type == NodeTypeLink ? SavedNode_Link : 0);
+    Saved.WindowID = Node->WindowID;
+    Saved.SplitMode = Node->SplitMode;
+    Saved.SplitRatio = Node->SplitRatio;
+
+    for(link_node *Link = Node->List; Link; Link = Link->Next)
+        Saved.Links.push_back(Link->WindowID);
+
+    Nodes.push_back(Saved);
+    if(IsParent)
+    {
+        SaveTreeNode(Node->LeftChild, Nodes);
+        SaveTreeNode(Node->RightChild, Nodes);
+    }
+}
+
+internal void
+WriteSavedState(std::string &Buffer, saved_state *State)
+{
+    KwmCacheWrite<uint32_t>(Buffer, State->Spaces.size());
+    std::map<std::string, saved_space>::iterator It;
+    for(It = State->Spaces.begin(); It != State->Spaces.end(); ++It)
+    {
+        space_settings *Settings = &It->second.Settings;
+        KwmCacheWriteString(Buffer, It->first);
+        KwmCacheWrite<uint8_t>(Buffer, It->second.Overrides);
+        KwmCacheWrite<container_offset>(Buffer, Settings->Offset);
+        KwmCacheWrite<uint32_t>(Buffer, Settings->Mode);
+        KwmCacheWriteString(Buffer, Settings->Name);
+
+        std::vector<saved_node> &Nodes = It->second.Nodes;
+        KwmCacheWrite<uint32_t>(Buffer, Nodes.size());
+        for(std::size_t Index = 0; Index < Nodes.size(); ++Index)
+        {
+            saved_node *Node = &Nodes[Index];
+            KwmCacheWrite<uint8_t>(Buffer, Node->Flags);
+            KwmCacheWrite<uint32_t>(Buffer, Node->WindowID);
+            KwmCacheWrite<int32_t>(Buffer, Node->SplitMode);
+            KwmCacheWrite<double>(Buffer, Node->SplitRatio);
+
+            KwmCacheWrite<uint32_t>(Buffer, Node->Links.size());
+            for(std::size_t Link = 0; Link < Node->Links.size(); ++Link)
+                KwmCacheWrite<uint32_t>(Buffer, Node->Links[Link]);
+        }
+    }
+
+    KwmCacheWrite<uint32_t>(Buffer, State->Scratchpad.size());
+    std::map<int, uint32_t>::iterator Slot;
+    for(Slot = State->Scratchpad.begin(); Slot != State->Scratchpad.end(); ++Slot)
+    {
+        KwmCacheWrite<int32_t>(Buffer, Slot->first);
+        KwmCacheWrite<uint32_t>(Buffer, Slot->second);
+    }
+
+    KwmCacheWrite<int32_t>(Buffer, State->ScratchpadLastFocus);
+    KwmCacheWrite<uint32_t>(Buffer, State->MarkedWindow);
+    KwmCacheWrite<uint32_t>(Buffer, State->FocusedWindow);
+}
+
+internal bool
+ReadSavedNode(config_cache_reader *Reader, saved_node *Node)
+{
+    uint32_t LinkCount;
+    if(!KwmCacheRead(Reader, &Node->Flags) ||
+       !KwmCacheRead(Reader, &Node->WindowID) ||
+       !KwmCacheRead(Reader, &Node->SplitMode) ||
+       !KwmCacheRead(Reader, &Node->SplitRatio) ||
+       !KwmCacheRead(Reader, &LinkCount) ||
+       LinkCount > (Reader->End - Reader->At) / sizeof(uint32_t))
+        return false;
+
+    Node->Links.resize(LinkCount);
+    for(uint32_t Index = 0; Index < LinkCount; ++Index)
+        KwmCacheRead(Reader, &Node->Links[Index]);
+
+    return Node->SplitMode >= SPLIT_OPTIMAL && Node->SplitMode <= SPLIT_HORIZONTAL &&
+           Node->SplitRatio >= 0 && Node->SplitRatio < 1;
+}
+
+internal bool
+ReadSavedSpace(config_cache_reader *Reader, saved_space *Space)
+{
+    uint32_t Mode, NodeCount;
+    space_settings *Settings = &Space->Settings;
+
+    if(!KwmCacheRead(Reader, &Space->Overrides) ||
+       !KwmCacheRead(Reader, &Settings->Offset) ||
+       !KwmCacheRead(Reader, &Mode) || Mode > SpaceModeDefault ||
+       !KwmCacheReadString(Reader, &Settings->Name) ||
+       !KwmCacheRead(Reader, &NodeCount))
+        return false;
+
+    Settings->Mode = (space_tiling_option) Mode;
+
+    Space->Nodes.resize(NodeCount < 4096 ? NodeCount : 0);
+    for(uint32_t Index = 0; Index < Space->Nodes.size(); ++Index)
+    {
+        if(!ReadSavedNode(Reader, &Space->Nodes[Index]))
+            return false;
+    }
+
+    return Space->Nodes.size() == NodeCount;
+}
+
+internal bool
+ReadSavedState(config_cache_reader *Reader, saved_state *State)
+{
+    uint32_t SpaceCount, SlotCount;
+    if(!KwmCacheRead(Reader, &SpaceCount))
+        return false;
+
+    for(uint32_t Index = 0; Index < SpaceCount; ++Index)
+    {
+        std::string Identifier;
+        if(!KwmCacheReadString(Reader, &Identifier) ||
+           !ReadSavedSpace(Reader, &State->Spaces[Identifier]))
+            return false;
+    }
+
+    if(!KwmCacheRead(Reader, &SlotCount))
+        return false;
+
+    for(uint32_t Index = 0; Index < SlotCount; ++Index)
+    {
+        int32_t Slot;
+        uint32_t WindowID;
+        if(!KwmCacheRead(Reader, &Slot) || !KwmCacheRead(Reader, &WindowID))
+            return false;
+
+        State->Scratchpad[Slot] = WindowID;
+    }
+
+    return KwmCacheRead(Reader, &State->ScratchpadLastFocus) &&
+           KwmCacheRead(Reader, &State->MarkedWindow) &&
+           KwmCacheRead(Reader, &State->FocusedWindow) &&
+           Reader->At == Reader->End;
+}
+
+/* NOTE(koekeishiya): The journal is a header followed by records of a size, a checksum and
+ *                    a complete snapshot. The newest record that is intact wins; a record
+ *                    that was torn by a crash ends the journal. */
+internal bool
+ReadStateJournal(std::string File, saved_state *State)
+{
+    int FD = open(File.c_str(), O_RDONLY);
+    if(FD == -1)
+        return false;
+
+    struct stat Buffer;
+    if(fstat(FD, &Buffer) == -1 || Buffer.st_size == 0)
+    {
+        close(FD);
+        return false;
+    }
+
+    void *Data = mmap(NULL, Buffer.st_size, PROT_READ, MAP_PRIVATE, FD, 0);
+    close(FD);
+
+    if(Data == MAP_FAILED)
+        return false;
+
+    config_cache_reader Reader = { (const char *) Data, (const char *) Data + Buffer.st_size };
+    config_cache_reader Snapshot = {};
+
+    uint32_t Magic, Version;
+    if(KwmCacheRead(&Reader, &Magic) && Magic == KWM_STATE_MAGIC &&
+       KwmCacheRead(&Reader, &Version) && Version == KWM_STATE_VERSION)
+    {
+        uint32_t Size;
+        uint64_t Checksum;
+        while(KwmCacheRead(&Reader, &Size) &&
+              KwmCacheRead(&Reader, &Checksum) &&
+              (uint32_t) (Reader.End - Reader.At) >= Size &&
+              KwmHashBytes(KWM_CONFIG_HASH_SEED, Reader.At, Size) == Checksum)
+        {
+            Snapshot.At = Reader.At;
+            Snapshot.End = Reader.At + Size;
+            Reader.At += Size;
+        }
+    }
+
+    bool Result = Snapshot.At && ReadSavedState(&Snapshot, State);
+    munmap(Data, Buffer.st_size);
+
+    if(!Result)
+        *State = saved_state();
+
+    return Result;
+}
+
+internal bool
+WriteStateFile(int FD, const std::string &Buffer)
+{
+    std::size_t Written = 0;
+    while(Written < Buffer.size())
+    {
+        ssize_t Result = write(FD, Buffer.data() + Written, Buffer.size() - Written);
+        if(Result <= 0)
+            return false;
+
+        Written += Result;
+    }
+
+    return true;
+}
+
+/* NOTE(koekeishiya): Records are appended to the journal. The first save of a session, and
+ *                    any save that would grow the journal past its limit, rewrites it
+ *                    with the new record only and renames it into place instead. */
+internal void
+AppendStateJournal(std::string File, const std::string &Snapshot)
+{
+    std::string Record;
+    KwmCacheWrite<uint32_t>(Record, Snapshot.size());
+    KwmCacheWrite<uint64_t>(Record, KwmHashBytes(KWM_CONFIG_HASH_SEED, Snapshot.data(), Snapshot.size()));
+    Record += Snapshot;
+
+    struct stat Buffer;
+    if(StateJournalCompacted &&
+       stat(File.c_str(), &Buffer) == 0 &&
+       Buffer.st_size + Record.size() <= KWM_STATE_JOURNAL_LIMIT)
+    {
+        int FD = open(File.c_str(), O_WRONLY | O_APPEND);
+        if(FD != -1)
+        {
+            bool Written = WriteStateFile(FD, Record);
+            close(FD);
+            if(Written)
+                return;
+        }
+    }
+
+    std::string Journal;
+    KwmCacheWrite<uint32_t>(Journal, KWM_STATE_MAGIC);
+    KwmCacheWrite<uint32_t>(Journal, KWM_STATE_VERSION);
+    Journal += Record;
+
+    std::string Temporary = File + ".tmp";
+    int FD = open(Temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if(FD == -1)
+        return;
+
+    bool Written = WriteStateFile(FD, Journal);
+    Written = (close(FD) == 0) && Written;
+
+    if(!Written || rename(Temporary.c_str(), File.c_str()) != 0)
+        unlink(Temporary.c_str());
+    else
+        StateJournalCompacted = true;
+}
+
+void KwmSaveState()
+{
+    saved_state State = {};
+    State.Spaces = RestoredState.Spaces;
+
+    std::map<std::string, space_info>::iterator It;
+    for(It = WindowTree.begin(); It != WindowTree.end(); ++It)
+    {
+        if(!It->second.Initialized)
+            continue;
+
+        saved_space *Space = &State.Spaces[It->first];
+        Space->Overrides = It->second.Overrides;
+        Space->Settings = It->second.Settings;
+        Space->Nodes.clear();
+
+        if(It->second.RootNode)
+            SaveTreeNode(It->second.RootNode, Space->Nodes);
+    }
+
+    std::map<int, ax_window *>::iterator Slot;
+    for(Slot = Scratchpad.Windows.begin(); Slot != Scratchpad.Windows.end(); ++Slot)
+        State.Scratchpad[Slot->first] = Slot->second->ID;
+
+    State.ScratchpadLastFocus = Scratchpad.LastFocus;
+    State.MarkedWindow = MarkedWindow ? MarkedWindow->ID : 0;
+    State.FocusedWindow = (FocusedApplication && FocusedApplication->Focus) ? FocusedApplication->Focus->ID : 0;
+
+    std::string Snapshot;
+    WriteSavedState(Snapshot, &State);
+    AppendStateJournal(KWMPath.State, Snapshot);
+    ++KWMMetrics.StateSaves;
+}
+
+/* NOTE(koekeishiya): Any number of changes made in quick succession are written as a single
+ *                    record. The save itself runs as an event, so that it is serialized
+ *                    with the events that modify the trees. */
+void KwmMarkStateDirty()
+{
+    if(StateSavePending.exchange(true))
+        return;
+
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, KWM_STATE_SAVE_DELAY * NSEC_PER_SEC), dispatch_get_main_queue(),
+    ^{
+        KwmConstructEvent(KWMEvent_SaveState, NULL);
+    });
+}
+
+EVENT_CALLBACK(Callback_KWMEvent_SaveState)
+{
+    StateSavePending = false;
+    KwmSaveState();
+}
+
+void KwmLoadState()
+{
+    if(ReadStateJournal(KWMPath.State, &RestoredState))
+        LOG_INFO(LogCategory_State, "KwmLoadState() " << RestoredState.Spaces.size() << " spaces");
+}
+
+/* NOTE(koekeishiya): Nodes are saved in pre-order. Check that they describe exactly one tree
+ *                    that is no deeper than KWM_STATE_MAX_DEPTH before restoring it, because
+ *                    RestoreTreeNode can not stop halfway without scrambling the rest. */
+internal bool
+IsSavedTreeValid(saved_space *Space)
+{
+    std::vector<int> Pending(1, 0);
+    std::size_t Index = 0;
+    while(!Pending.empty())
+    {
+        int Depth = Pending.back();
+        Pending.pop_back();
+
+        if(Index >= Space->Nodes.size() || Depth > KWM_STATE_MAX_DEPTH)
+            return false;
+
+        if(Space->Nodes[Index++].Flags & SavedNode_Parent)
+        {
+            Pending.push_back(Depth + 1);
+            Pending.push_back(Depth + 1);
+        }
+    }
+
+    return Index == Space->Nodes.size();
+}
+
+internal tree_node *
+RestoreTreeNode(saved_space *Space, std::size_t *Index, tree_node *Parent, int Depth)
+{
+    if(*Index >= Space->Nodes.size() || Depth > KWM_STATE_MAX_DEPTH)
+        return NULL;
+
+    saved_node *Saved = &Space->Nodes[(*Index)++];
+    tree_node *Node = CreateRootNode();
+    Node->Parent = Parent;
+    Node->WindowID = Saved->WindowID;
+    Node->Type = (Saved->Flags & SavedNode_Link) ? NodeTypeLink : NodeTypeTree;
+    Node->SplitMode = (split_type) Saved->SplitMode;
+    Node->SplitRatio = Saved->SplitRatio;
+
+    link_node *Prev = NULL;
+    for(std::size_t Link = 0; Link < Saved->Links.size(); ++Link)
+    {
+        link_node *Next = CreateLinkNode();
+        Next->WindowID = Saved->Links[Link];
+        Next->Prev = Prev;
+
+        if(Prev)
+            Prev->Next = Next;
+        else
+            Node->List = Next;
+
+        Prev = Next;
+    }
+
+    if(Saved->Flags & SavedNode_Parent)
+    {
+        Node->LeftChild = RestoreTreeNode(Space, Index, Node, Depth + 1);
+        Node->RightChild = RestoreTreeNode(Space, Index, Node, Depth + 1);
+    }
+
+    return Node;
+}
+
+/* NOTE(koekeishiya): Rebuild the tree of a space from the saved state, and put the settings
+ *                    that were changed at runtime back on top of the kwmrc settings that the
+ *                    caller has loaded. Only windows that are still on the space are put back
+ *                    into the tree, and these are removed from Windows so that the caller can
+ *                    add the rest. Returns false if nothing was saved for this space, or if its
+ *                    saved tree is malformed, in which case the space starts from a fresh tree. */
+bool RestoreSpaceInfo(ax_display *Display, space_info *SpaceInfo, std::vector<uint32_t> *Windows)
+{
+    std::map<std::string, saved_space>::iterator It = RestoredState.Spaces.find(Display->Space->Identifier);
+    if(It == RestoredState.Spaces.end())
+        return false;
+
+    saved_space Saved = It->second;
+    RestoredState.Spaces.erase(It);
+    if(!Saved.Nodes.empty() && !IsSavedTreeValid(&Saved))
+    {
+        LOG_WARN(LogCategory_State, "RestoreSpaceInfo() discarding malformed tree for " << Display->Space->Identifier);
+        return false;
+    }
+
+    if(Saved.Overrides & SpaceOverride_Offset)
+        SpaceInfo->Settings.Offset = Saved.Settings.Offset;
+    if(Saved.Overrides & SpaceOverride_Mode)
+        SpaceInfo->Settings.Mode = Saved.Settings.Mode;
+    if(Saved.Overrides & SpaceOverride_Name)
+        SpaceInfo->Settings.Name = Saved.Settings.Name;
+    SpaceInfo->Overrides = Saved.Overrides;
+
+    if((SpaceInfo->Settings.Mode == SpaceModeFloating) ||
+       (Display->Space->Type != kCGSSpaceUser) ||
+       (Saved.Nodes.empty()))
+        return true;
+
+    std::size_t Index = 0;
+    std::size_t WindowCount = Windows->size();
+    tree_node *Root = PruneNodeTree(RestoreTreeNode(&Saved, &Index, NULL, 0), Windows);
+    if(Root)
+    {
+        CreateNodeTreeContainers(Display, Root);
+        KWMMetrics.StateRestoredWindows += WindowCount - Windows->size();
+    }
+
+    SpaceInfo->RootNode = Root;
+    ++KWMMetrics.StateRestoredSpaces;
+    return true;
+}
+
+/* NOTE(koekeishiya): Put back the scratchpad, the marked window and the focus once the
+ *                    trees have been restored. */
+void RestoreWindowState()
+{
+    std::map<int, uint32_t>::iterator It;
+    for(It = RestoredState.Scratchpad.begin(); It != RestoredState.Scratchpad.end(); ++It)
+    {
+        ax_window *Window = GetWindowByID(It->second);
+        if(Window && Scratchpad.Windows.find(It->first) == Scratchpad.Windows.end())
+            Scratchpad.Windows[It->first] = Window;
+    }
+
+    if(RestoredState.ScratchpadLastFocus > 0 && GetWindowByID(RestoredState.ScratchpadLastFocus))
+        Scratchpad.LastFocus = RestoredState.ScratchpadLastFocus;
+
+    ax_window *Marked = RestoredState.MarkedWindow ? GetWindowByID(RestoredState.MarkedWindow) : NULL;
+    if(Marked && Marked != MarkedWindow)
+        MarkWindowContainer(Marked);
+
+    ax_window *Focused = FocusedApplication ? FocusedApplication->Focus : NULL;
+    if(RestoredState.FocusedWindow && (!Focused || Focused->ID != RestoredState.FocusedWindow))
+        FocusWindowByID(RestoredState.FocusedWindow);
+
+    RestoredState.Scratchpad.clear();
+    RestoredState.MarkedWindow = 0;
+    RestoredState.FocusedWindow = 0;
+}
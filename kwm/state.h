@@ -0,0 +1,16 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include "types.h"
+#include "axlib/display.h"
+
+#define KWM_STATE_VERSION 2
+
+void KwmMarkStateDirty();
+void KwmSaveState();
+void KwmLoadState();
+
+bool RestoreSpaceInfo(ax_display *Display, space_info *SpaceInfo, std::vector<uint32_t> *Windows);
+void RestoreWindowState();
+
+#endif
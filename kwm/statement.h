@@ -0,0 +1,99 @@
+#ifndef STATEMENT_H
+#define STATEMENT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+enum space_tiling_option
+{
+    SpaceModeBSP,
+    SpaceModeMonocle,
+    SpaceModeFloating,
+    SpaceModeDefault
+};
+
+/* NOTE(koekeishiya): A config file is compiled into a flat list of typed statements,
+ *                    in file order, with includes inlined and defines already expanded. */
+enum config_statement_type
+{
+    Config_Tiling,
+    Config_Hotkeys,
+    Config_Padding,
+    Config_Gap,
+    Config_FocusFollowsMouse,
+    Config_MouseFollowsFocus,
+    Config_StandbyOnFloat,
+    Config_CenterOnFloat,
+    Config_FloatNonResizable,
+    Config_LockToContainer,
+    Config_CycleFocus,
+    Config_SplitRatio,
+    Config_OptimalRatio,
+    Config_Spawn,
+    Config_Watch,
+    Config_LogLevel,
+    Config_LogCategory,
+
+    Config_BorderEnabled,
+    Config_BorderSize,
+    Config_BorderRadius,
+    Config_BorderColor,
+
+    Config_SpaceMode,
+    Config_SpacePadding,
+    Config_SpaceGap,
+    Config_SpaceName,
+    Config_SpaceTree,
+
+    Config_DisplayMode,
+    Config_DisplayPadding,
+    Config_DisplayGap,
+    Config_DisplayFloatDim,
+
+    Config_ModeActivate,
+    Config_ModePrefix,
+    Config_ModeTimeout,
+    Config_ModeColor,
+    Config_ModeRestore,
+
+    Config_Bind,
+    Config_Rule,
+    Config_Whitelist,
+    Config_Exec,
+
+    Config_HomePath,
+    Config_IncludePath,
+    Config_LayoutsPath,
+};
+
+enum config_statement_flags
+{
+    ConfigFlag_MarkedBorder = (1 << 0),
+    ConfigFlag_Passthrough = (1 << 1),
+    ConfigFlag_Keycode = (1 << 2),
+};
+
+struct config_statement
+{
+    config_statement_type Type;
+    uint32_t Flags;
+
+    bool Enabled;
+    space_tiling_option Mode;
+    int Display, Space;
+    double Values[4];
+    unsigned int Color;
+
+    std::string Text;
+    std::string Argument;
+};
+
+struct kwm_config
+{
+    std::vector<config_statement> Statements;
+    std::vector<std::string> Files;
+    uint64_t Hash;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef TOKEN_H
+#define TOKEN_H
+
+enum token_type
+{
+    Token_Colon,
+    Token_SemiColon,
+    Token_Equals,
+    Token_Dash,
+
+    Token_OpenParen,
+    Token_CloseParen,
+    Token_OpenBracket,
+    Token_CloseBracket,
+    Token_OpenBrace,
+    Token_CloseBrace,
+
+    Token_Identifier,
+    Token_String,
+    Token_Digit,
+    Token_Comment,
+    Token_Hex,
+
+    Token_EndOfStream,
+    Token_Unknown,
+};
+
+struct token
+{
+    token_type Type;
+
+    int TextLength;
+    char *Text;
+};
+
+struct tokenizer
+{
+    char *At;
+};
+
+#endif
@@ -1,7 +1,8 @@
 #ifndef TOKENIZER_H
 #define TOKENIZER_H
 
-#include "types.h"
+#include "token.h"
+#include <string>
 
 inline bool
 IsDot(char C)
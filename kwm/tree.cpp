@@ -8,6 +8,8 @@
 #include "border.h"
 #include "axlib/axlib.h"
 
+#include <set>
+
 #define internal static
 extern std::map<std::string, space_info> WindowTree;
 
@@ -31,7 +33,7 @@ CreateBSPTree(tree_node *RootNode, ax_display *Display, std::vector<uint32_t> *W
                     Root = Root->LeftChild;
             }
 
-            DEBUG("CreateBSPTree() Create pair of leafs");
+            LOG_DEBUG(LogCategory_Tree, "CreateBSPTree() Create pair of leafs");
             CreateLeafNodePair(Display, Root, Root->WindowID, Windows[Index], GetOptimalSplitMode(Root));
             Root = RootNode;
         }
@@ -332,20 +334,26 @@ tree_node *GetFirstPseudoLeafNode(tree_node *Node)
     return Leaf;
 }
 
+/* NOTE(koekeishiya): The windows of a container are resized in a single batch; every application
+                      applies its updates concurrently and we only wait once for all of them. */
 void ApplyLinkNodeContainer(link_node *Link)
 {
     if(Link)
     {
+        AXLibBeginBatch();
         ResizeWindowToContainerSize(Link);
         if(Link->Next)
             ApplyLinkNodeContainer(Link->Next);
+        AXLibEndBatch();
     }
 }
 
 void ApplyTreeNodeContainer(tree_node *Node)
 {
+    AXLibTraceFunction("layout");
     if(Node)
     {
+        AXLibBeginBatch();
         if(Node->WindowID != 0)
             ResizeWindowToContainerSize(Node);
 
@@ -357,7 +365,124 @@ void ApplyTreeNodeContainer(tree_node *Node)
 
         if(Node->RightChild)
             ApplyTreeNodeContainer(Node->RightChild);
+        AXLibEndBatch();
+    }
+}
+
+internal tree_node *
+PruneNodeTreeWindows(tree_node *Node, std::set<uint32_t> &Windows)
+{
+    if(!Node)
+        return NULL;
+
+    link_node *Link = Node->List;
+    while(Link)
+    {
+        link_node *Next = Link->Next;
+        if(Windows.find(Link->WindowID) == Windows.end())
+        {
+            if(Link->Prev)
+                Link->Prev->Next = Next;
+            else
+                Node->List = Next;
+
+            if(Next)
+                Next->Prev = Link->Prev;
+
+            free(Link);
+        }
+
+        Link = Next;
+    }
+
+    if(Node->LeftChild || Node->RightChild)
+    {
+        if(Node->WindowID != 0 && Windows.find(Node->WindowID) == Windows.end())
+            Node->WindowID = 0;
+
+        Node->LeftChild = PruneNodeTreeWindows(Node->LeftChild, Windows);
+        Node->RightChild = PruneNodeTreeWindows(Node->RightChild, Windows);
+        if(Node->LeftChild && Node->RightChild)
+            return Node;
+
+        tree_node *Child = Node->LeftChild ? Node->LeftChild : Node->RightChild;
+        if(Child)
+            Child->Parent = Node->Parent;
+
+        Node->LeftChild = NULL;
+        Node->RightChild = NULL;
+        DestroyNodeTree(Node);
+        return Child;
+    }
+
+    if(Node->WindowID != 0 && Windows.find(Node->WindowID) == Windows.end())
+    {
+        Node->WindowID = 0;
+        if(Node->List)
+        {
+            link_node *First = Node->List;
+            Node->WindowID = First->WindowID;
+            Node->List = First->Next;
+            if(Node->List)
+                Node->List->Prev = NULL;
+
+            free(First);
+        }
+        else
+        {
+            free(Node);
+            return NULL;
+        }
     }
+
+    return Node;
+}
+
+internal void
+EraseNodeTreeWindows(tree_node *Node, std::set<uint32_t> &Windows)
+{
+    Windows.erase(Node->WindowID);
+    for(link_node *Link = Node->List; Link; Link = Link->Next)
+        Windows.erase(Link->WindowID);
+
+    if(Node->LeftChild && Node->RightChild)
+    {
+        EraseNodeTreeWindows(Node->LeftChild, Windows);
+        EraseNodeTreeWindows(Node->RightChild, Windows);
+    }
+}
+
+/* NOTE(koekeishiya): Drop the windows that are not in Windows from a tree that was built
+ *                    from a saved or earlier copy. A parent that is left with a single child
+ *                    is replaced by that child, and a leaf whose window is gone hands its
+ *                    place to the first window of its link list. The windows that remain in
+ *                    the tree are removed from Windows, so that the caller can add the rest. */
+tree_node *PruneNodeTree(tree_node *Root, std::vector<uint32_t> *Windows)
+{
+    std::set<uint32_t> Live(Windows->begin(), Windows->end());
+    Root = PruneNodeTreeWindows(Root, Live);
+
+    if(Root && Root->WindowID == 0 && !Root->List && !Root->LeftChild)
+    {
+        free(Root);
+        Root = NULL;
+    }
+
+    if(Root)
+    {
+        EraseNodeTreeWindows(Root, Live);
+
+        std::vector<uint32_t> Remaining;
+        for(std::size_t Index = 0; Index < Windows->size(); ++Index)
+        {
+            if(Live.find((*Windows)[Index]) != Live.end())
+                Remaining.push_back((*Windows)[Index]);
+        }
+
+        Windows->swap(Remaining);
+    }
+
+    return Root;
 }
 
 internal void
@@ -397,7 +522,7 @@ RotateTree(tree_node *Node, int Deg)
     if (Node == NULL || IsLeafNode(Node))
         return;
 
-    DEBUG("RotateTree() " << Deg << " degrees");
+    LOG_DEBUG(LogCategory_Tree, "RotateTree() " << Deg << " degrees");
 
     if((Deg == 90 && Node->SplitMode == SPLIT_VERTICAL) ||
        (Deg == 270 && Node->SplitMode == SPLIT_HORIZONTAL) ||
@@ -457,7 +582,7 @@ void FillDeserializedTree(tree_node *RootNode, ax_display *Display, std::vector<
                     Root = Root->LeftChild;
             }
 
-            DEBUG("FillDeserializedTree() Create pair of leafs");
+            LOG_DEBUG(LogCategory_Tree, "FillDeserializedTree() Create pair of leafs");
             CreateLeafNodePair(Display, Root, Root->WindowID, Windows[Counter], GetOptimalSplitMode(Root));
             Root = RootNode;
         }
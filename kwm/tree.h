@@ -23,5 +23,6 @@ tree_node *GetFirstPseudoLeafNode(tree_node *Node);
 void ApplyLinkNodeContainer(link_node *Link);
 void ApplyTreeNodeContainer(tree_node *Node);
 void DestroyNodeTree(tree_node *Node);
+tree_node *PruneNodeTree(tree_node *Root, std::vector<uint32_t> *Windows);
 
 #endif
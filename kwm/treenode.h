@@ -0,0 +1,63 @@
+#ifndef TREENODE_H
+#define TREENODE_H
+
+#include <stdint.h>
+
+enum split_type
+{
+    SPLIT_NONE = 0,
+    SPLIT_OPTIMAL = -1,
+    SPLIT_VERTICAL = 1,
+    SPLIT_HORIZONTAL = 2
+};
+
+enum container_type
+{
+    CONTAINER_NONE = 0,
+
+    CONTAINER_LEFT = 1,
+    CONTAINER_RIGHT = 2,
+
+    CONTAINER_UPPER = 3,
+    CONTAINER_LOWER = 4
+};
+
+enum node_type
+{
+    NodeTypeTree,
+    NodeTypeLink
+};
+
+struct node_container
+{
+    double X, Y;
+    double Width, Height;
+    container_type Type;
+};
+
+struct link_node
+{
+    uint32_t WindowID;
+    node_container Container;
+
+    link_node *Prev;
+    link_node *Next;
+};
+
+struct tree_node
+{
+    uint32_t WindowID;
+    node_type Type;
+    node_container Container;
+
+    link_node *List;
+
+    tree_node *Parent;
+    tree_node *LeftChild;
+    tree_node *RightChild;
+
+    split_type SplitMode;
+    double SplitRatio;
+};
+
+#endif
@@ -8,10 +8,12 @@
 #include <queue>
 #include <stack>
 #include <map>
+#include <unordered_map>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <chrono>
+#include <regex>
 
 #include <stdlib.h>
 #include <string.h>
@@ -25,8 +27,11 @@
 #include <sys/types.h>
 #include <time.h>
 
-struct token;
-struct tokenizer;
+#include "log.h"
+#include "statement.h"
+#include "treenode.h"
+#include "token.h"
+
 struct space_identifier;
 struct color;
 struct mode;
@@ -37,8 +42,6 @@ struct container_offset;
 struct window_properties;
 struct window_rule;
 struct space_info;
-struct node_container;
-struct tree_node;
 struct scratchpad;
 
 struct kwm_mach;
@@ -46,9 +49,9 @@ struct kwm_border;
 struct kwm_hotkeys;
 struct kwm_path;
 struct kwm_settings;
+struct kwm_metrics;
 
 #ifdef DEBUG_BUILD
-    #define DEBUG(x) std::cout << x << std::endl
     #define Assert(Expression) do \
                                { if(!(Expression)) \
                                    {\
@@ -57,7 +60,6 @@ struct kwm_settings;
                                    } \
                                } while(0)
 #else
-    #define DEBUG(x) do {} while(0)
     #define Assert(Expression) do {} while(0)
 #endif
 
@@ -76,39 +78,6 @@ enum cycle_focus_option
     CycleModeDisabled
 };
 
-enum space_tiling_option
-{
-    SpaceModeBSP,
-    SpaceModeMonocle,
-    SpaceModeFloating,
-    SpaceModeDefault
-};
-
-enum split_type
-{
-    SPLIT_NONE = 0,
-    SPLIT_OPTIMAL = -1,
-    SPLIT_VERTICAL = 1,
-    SPLIT_HORIZONTAL = 2
-};
-
-enum container_type
-{
-    CONTAINER_NONE = 0,
-
-    CONTAINER_LEFT = 1,
-    CONTAINER_RIGHT = 2,
-
-    CONTAINER_UPPER = 3,
-    CONTAINER_LOWER = 4
-};
-
-enum node_type
-{
-    NodeTypeTree,
-    NodeTypeLink
-};
-
 enum border_type
 {
     BORDER_FOCUSED,
@@ -122,43 +91,6 @@ enum hotkey_state
     HotkeyStateExclude
 };
 
-enum token_type
-{
-    Token_Colon,
-    Token_SemiColon,
-    Token_Equals,
-    Token_Dash,
-
-    Token_OpenParen,
-    Token_CloseParen,
-    Token_OpenBracket,
-    Token_CloseBracket,
-    Token_OpenBrace,
-    Token_CloseBrace,
-
-    Token_Identifier,
-    Token_String,
-    Token_Digit,
-    Token_Comment,
-    Token_Hex,
-
-    Token_EndOfStream,
-    Token_Unknown,
-};
-
-struct token
-{
-    token_type Type;
-
-    int TextLength;
-    char *Text;
-};
-
-struct tokenizer
-{
-    char *At;
-};
-
 struct space_identifier
 {
     int ScreenID, SpaceID;
@@ -208,39 +140,6 @@ struct mode
     bool Prefix;
     double Timeout;
     std::string Restore;
-    kwm_time_point Time;
-};
-
-struct node_container
-{
-    double X, Y;
-    double Width, Height;
-    container_type Type;
-};
-
-struct link_node
-{
-    uint32_t WindowID;
-    node_container Container;
-
-    link_node *Prev;
-    link_node *Next;
-};
-
-struct tree_node
-{
-    uint32_t WindowID;
-    node_type Type;
-    node_container Container;
-
-    link_node *List;
-
-    tree_node *Parent;
-    tree_node *LeftChild;
-    tree_node *RightChild;
-
-    split_type SplitMode;
-    double SplitRatio;
 };
 
 struct window_properties
@@ -260,6 +159,14 @@ struct window_rule
     std::string Name;
     std::string Role;
     std::string CustomRole;
+
+    bool OwnerIsLiteral;
+    std::regex OwnerExp;
+    std::regex NameExp;
+    std::regex ExceptExp;
+    CFStringRef AXRole;
+    CFStringRef AXCustomRole;
+    CFStringRef AXPropertyRole;
 };
 
 struct ax_window;
@@ -278,9 +185,19 @@ struct space_settings
     std::string Name;
 };
 
+/* NOTE(koekeishiya): Settings of a space that were changed at runtime, and so take precedence
+ *                    over the kwmrc when the space is restored after a restart. */
+enum space_override
+{
+    SpaceOverride_Offset = (1 << 0),
+    SpaceOverride_Mode = (1 << 1),
+    SpaceOverride_Name = (1 << 2),
+};
+
 struct space_info
 {
     space_settings Settings;
+    uint8_t Overrides;
     bool ResolutionChanged;
     bool Initialized;
 
@@ -317,6 +234,9 @@ struct kwm_path
     std::string EnvHome;
 
     std::string Config;
+    std::string Cache;
+    std::string State;
+    std::string Log;
     std::string Init;
 
     std::string Home;
@@ -341,6 +261,27 @@ struct kwm_settings
     std::vector<window_rule> WindowRules;
 };
 
+struct kwm_metrics
+{
+    uint64_t RuleCacheHits;
+    uint64_t RuleCacheMisses;
+
+    uint64_t MouseMovedQueued;
+    uint64_t MouseMovedCoalesced;
+
+    /* NOTE(koekeishiya): Milliseconds since launch. */
+    double ApplicationInitTime;
+    double TimeToFirstTile;
+    double ConfigLoadTime;
+    uint64_t ConfigCacheHits;
+    uint64_t ConfigCacheMisses;
+    uint64_t ConfigSpacesUpdated;
+
+    uint64_t StateSaves;
+    uint64_t StateRestoredSpaces;
+    uint64_t StateRestoredWindows;
+};
+
 enum kwm_toggleable
 {
     Settings_MouseFollowsFocus = (1 << 0),
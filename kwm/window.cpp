@@ -10,6 +10,8 @@
 #include "serializer.h"
 #include "cursor.h"
 #include "scratchpad.h"
+#include "state.h"
+#include "history.h"
 #include "axlib/axlib.h"
 
 #include <cmath>
@@ -95,12 +97,12 @@ ClearBorderIfFullscreenSpace(ax_display *Display)
 /* TODO(koekeishiya): Event context is a pointer to the new display. */
 EVENT_CALLBACK(Callback_AXEvent_DisplayAdded)
 {
-    DEBUG("AXEvent_DisplayAdded");
+    LOG_DEBUG(LogCategory_Event, "AXEvent_DisplayAdded");
 }
 
 EVENT_CALLBACK(Callback_AXEvent_DisplayRemoved)
 {
-    DEBUG("AXEvent_DisplayRemoved");
+    LOG_DEBUG(LogCategory_Event, "AXEvent_DisplayRemoved");
 }
 
 internal inline void
@@ -122,7 +124,7 @@ ResizeDisplay(ax_display *Display)
 EVENT_CALLBACK(Callback_AXEvent_DisplayResized)
 {
     ax_display *Display = (ax_display *) Event->Context;
-    DEBUG("AXEvent_DisplayResized");
+    LOG_DEBUG(LogCategory_Event, "AXEvent_DisplayResized");
     ResizeDisplay(Display);
 }
 
@@ -130,7 +132,7 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayResized)
 EVENT_CALLBACK(Callback_AXEvent_DisplayMoved)
 {
     ax_display *Display = (ax_display *) Event->Context;
-    DEBUG("AXEvent_DisplayMoved");
+    LOG_DEBUG(LogCategory_Event, "AXEvent_DisplayMoved");
     ResizeDisplay(Display);
 }
 
@@ -144,7 +146,7 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayChanged)
     if(FocusedDisplay->Space != PrevSpace)
         FocusedDisplay->PrevSpace = PrevSpace;
 
-    DEBUG("AXEvent_DisplayChanged: " << FocusedDisplay->ArrangementID);
+    LOG_DEBUG(LogCategory_Event, "AXEvent_DisplayChanged: " << FocusedDisplay->ArrangementID);
 
     AXLibRunningApplications();
     CreateWindowNodeTree(FocusedDisplay);
@@ -157,7 +159,7 @@ EVENT_CALLBACK(Callback_AXEvent_DisplayChanged)
 EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
 {
     ax_display *Display = (ax_display *) Event->Context;
-    DEBUG("AXEvent_SpaceChanged");
+    LOG_DEBUG(LogCategory_Event, "AXEvent_SpaceChanged");
 
     ClearBorder(&FocusedBorder);
     ClearMarkedWindow();
@@ -185,14 +187,14 @@ EVENT_CALLBACK(Callback_AXEvent_SpaceChanged)
         ax_window *Window = GetWindowByID(Display->Space->FocusedWindow);
         if(Window && AXLibSpaceHasWindow(Window, Display->Space->ID))
         {
-            DEBUG("FastTransition: Found window");
+            LOG_DEBUG(LogCategory_Event, "FastTransition: Found window");
             AXLibSetFocusedWindow(Window);
             DrawFocusedBorder(Display, Window);
             MoveCursorToCenterOfWindow(Window);
         }
         else
         {
-            DEBUG("FastTransition: No window found");
+            LOG_DEBUG(LogCategory_Event, "FastTransition: No window found");
             ClearBorder(&FocusedBorder);
             FocusFirstLeafNode(Display);
         }
@@ -225,7 +227,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationLaunched)
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationLaunched: " << Application->Name);
+        LOG_DEBUG(LogCategory_Event, "AXEvent_ApplicationLaunched: " << Application->Name);
 
         std::map<uint32_t, ax_window *>::iterator It;
         for(It = Application->Windows.begin(); It != Application->Windows.end(); ++It)
@@ -253,7 +255,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationHidden)
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationHidden: " << Application->Name);
+        LOG_DEBUG(LogCategory_Event, "AXEvent_ApplicationHidden: " << Application->Name);
 
         std::map<uint32_t, ax_window *>::iterator It;
         for(It = Application->Windows.begin(); It != Application->Windows.end(); ++It)
@@ -274,7 +276,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationVisible)
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationVisible: " << Application->Name);
+        LOG_DEBUG(LogCategory_Event, "AXEvent_ApplicationVisible: " << Application->Name);
 
         std::map<uint32_t, ax_window *>::iterator It;
         for(It = Application->Windows.begin(); It != Application->Windows.end(); ++It)
@@ -295,7 +297,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationTerminated)
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationTerminated");
+        LOG_DEBUG(LogCategory_Event, "AXEvent_ApplicationTerminated");
 
         /* TODO(koekeishiya): We probably want to flag every display for an update, as the application
            in question could have had windows on several displays and spaces. */
@@ -320,7 +322,7 @@ EVENT_CALLBACK(Callback_AXEvent_ApplicationActivated)
 
     if(Application)
     {
-        DEBUG("AXEvent_ApplicationActivated: " << Application->Name);
+        LOG_DEBUG(LogCategory_Event, "AXEvent_ApplicationActivated: " << Application->Name);
 
         FocusedApplication = Application;
         if(Application->Focus)
@@ -352,9 +354,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowCreated)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowCreated: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowCreated: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowCreated: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowCreated: " << Window->Application->Name << " - [Unknown]");
 
         if(ApplyWindowRules(Window))
             return;
@@ -382,9 +384,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowDestroyed)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowDestroyed: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowDestroyed: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowDestroyed: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowDestroyed: " << Window->Application->Name << " - [Unknown]");
 
         ax_display *Display = AXLibWindowDisplay(Window);
         if(Display)
@@ -420,9 +422,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowMinimized)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowMinimized: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowMinimized: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowMinimized: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowMinimized: " << Window->Application->Name << " - [Unknown]");
 
         ax_display *Display = AXLibWindowDisplay(Window);
         Assert(Display != NULL);
@@ -444,9 +446,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowDeminimized)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowDeminimized: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowDeminimized: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowDeminimized: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowDeminimized: " << Window->Application->Name << " - [Unknown]");
 
         ax_display *Display = AXLibWindowDisplay(Window);
         Assert(Display != NULL);
@@ -469,9 +471,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowFocused)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowFocused: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowFocused: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowFocused: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowFocused: " << Window->Application->Name << " - [Unknown]");
 
         if((AXLibIsWindowStandard(Window) || AXLibIsWindowCustom(Window)))
         {
@@ -487,6 +489,7 @@ EVENT_CALLBACK(Callback_AXEvent_WindowFocused)
                     StandbyOnFloat(Window);
                     DrawFocusedBorder(Display, Window);
                     Display->Space->FocusedWindow = Window->ID;
+                    KwmMarkStateDirty();
                 }
             }
         }
@@ -503,9 +506,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowMoved)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowMoved: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowMoved: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowMoved: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowMoved: " << Window->Application->Name << " - [Unknown]");
 
         if(!Event->Intrinsic && HasFlags(&KWMSettings, Settings_LockToContainer))
             LockWindowToContainerSize(Window);
@@ -533,9 +536,9 @@ EVENT_CALLBACK(Callback_AXEvent_WindowResized)
     if(Window)
     {
         if(Window->Name)
-            DEBUG("AXEvent_WindowResized: " << Window->Application->Name << " - " << Window->Name);
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowResized: " << Window->Application->Name << " - " << Window->Name);
         else
-            DEBUG("AXEvent_WindowResized: " << Window->Application->Name << " - [Unknown]");
+            LOG_DEBUG(LogCategory_Event, "AXEvent_WindowResized: " << Window->Application->Name << " - [Unknown]");
 
         if(!Event->Intrinsic && HasFlags(&KWMSettings, Settings_LockToContainer))
             LockWindowToContainerSize(Window);
@@ -562,13 +565,17 @@ EVENT_CALLBACK(Callback_AXEvent_WindowTitleChanged)
 
     if(Window)
     {
-        if(Window->Name)
-        {
-            free(Window->Name);
-            Window->Name = NULL;
-        }
+        /* NOTE(koekeishiya): The new title is only fetched if a rule actually looks at it. */
+        char *PreviousName = AXLibTakeWindowName(Window);
+
+        ax_display *Display = AXLibWindowDisplay(Window);
+        bool Floating = AXLibHasFlags(Window, AXWindow_Floating);
+        bool Skip = ApplyWindowRulesForTitleChange(Window, PreviousName);
+        if(Display && (Skip || (!Floating && AXLibHasFlags(Window, AXWindow_Floating))))
+            RemoveWindowFromNodeTree(Display, Window->ID);
 
-        Window->Name = AXLibGetWindowTitle(Window->Ref);
+        if(PreviousName)
+            free(PreviousName);
     }
 }
 
@@ -634,7 +641,8 @@ GetAllAXWindowIDsToRemoveFromTree(std::vector<ax_window *> &VisibleWindows, std:
 internal std::vector<ax_window *>
 GetAllAXWindowsNotInTree(ax_display *Display, std::vector<ax_window *> &VisibleWindows, std::vector<uint32_t> &WindowIDsInTree)
 {
-    std::vector<ax_window *> Windows;
+    std::vector<ax_window *> Candidates;
+    std::vector<uint32_t> CandidateIDs;
     for(std::size_t WindowIndex = 0; WindowIndex < VisibleWindows.size(); ++WindowIndex)
     {
         bool Found = false;
@@ -648,10 +656,19 @@ GetAllAXWindowsNotInTree(ax_display *Display, std::vector<ax_window *> &VisibleW
             }
         }
 
-        if((!Found) &&
-           (AXLibSpaceHasWindow(Window, Display->Space->ID)) &&
-           (!AXLibStickyWindow(Window)))
-            Windows.push_back(Window);
+        if(!Found)
+        {
+            Candidates.push_back(Window);
+            CandidateIDs.push_back(Window->ID);
+        }
+    }
+
+    std::vector<ax_window *> Windows;
+    ax_window_spaces WindowSpaces = AXLibSpacesForWindows(CandidateIDs);
+    for(std::size_t Index = 0; Index < Candidates.size(); ++Index)
+    {
+        if(AXLibWindowOnlyOnSpace(WindowSpaces[Candidates[Index]->ID], Display->Space->ID))
+            Windows.push_back(Candidates[Index]);
     }
 
     return Windows;
@@ -660,7 +677,7 @@ GetAllAXWindowsNotInTree(ax_display *Display, std::vector<ax_window *> &VisibleW
 internal std::vector<uint32_t>
 GetAllWindowIDSOnDisplay(ax_display *Display)
 {
-    std::vector<uint32_t> Windows;
+    std::vector<uint32_t> Candidates;
     std::vector<ax_window*> VisibleWindows = AXLibGetAllVisibleWindows();
     for(int Index = 0; Index < VisibleWindows.size(); ++Index)
     {
@@ -678,12 +695,18 @@ GetAllWindowIDSOnDisplay(ax_display *Display)
                     continue;
             }
 
-            if((AXLibSpaceHasWindow(Window, Display->Space->ID)) &&
-               (!AXLibStickyWindow(Window)))
-                Windows.push_back(Window->ID);
+            Candidates.push_back(Window->ID);
         }
     }
 
+    std::vector<uint32_t> Windows;
+    ax_window_spaces WindowSpaces = AXLibSpacesForWindows(Candidates);
+    for(std::size_t Index = 0; Index < Candidates.size(); ++Index)
+    {
+        if(AXLibWindowOnlyOnSpace(WindowSpaces[Candidates[Index]], Display->Space->ID))
+            Windows.push_back(Candidates[Index]);
+    }
+
     return Windows;
 }
 
@@ -699,22 +722,7 @@ internal void
 LoadSpaceSettings(ax_display *Display, space_info *SpaceInfo)
 {
     int DesktopID = AXLibDesktopIDFromCGSSpaceID(Display, Display->Space->ID);
-
-    /* NOTE(koekeishiya): Load global default display settings. */
-    SpaceInfo->Settings.Offset = KWMSettings.DefaultOffset;
-    SpaceInfo->Settings.Mode = SpaceModeDefault;
-    SpaceInfo->Settings.Layout = "";
-    SpaceInfo->Settings.Name = "";
-
-    /* NOTE(koekeishiya): The space in question may have overloaded settings. */
-    space_settings *SpaceSettings = NULL;
-    if((SpaceSettings = GetSpaceSettingsForDesktopID(Display->ArrangementID, DesktopID)))
-        SpaceInfo->Settings = *SpaceSettings;
-    else if((SpaceSettings = GetSpaceSettingsForDisplay(Display->ArrangementID)))
-        SpaceInfo->Settings = *SpaceSettings;
-
-    if(SpaceInfo->Settings.Mode == SpaceModeDefault)
-        SpaceInfo->Settings.Mode = KWMSettings.Space;
+    SpaceInfo->Settings = ResolveSpaceSettings(&KWMSettings, Display->ArrangementID, DesktopID);
 }
 
 internal void
@@ -945,8 +953,31 @@ CreateSpaceInfoWithWindowTree(ax_display *Display, space_info *SpaceInfo, std::v
         ApplyTreeNodeContainer(SpaceInfo->RootNode);
 }
 
+/* NOTE(koekeishiya): The restored tree is applied as a whole. Windows that are already where
+ *                    the tree puts them are not touched, see SetWindowDimensions. Windows
+ *                    that were opened while kwm was not running are added afterwards. */
+internal void
+FillRestoredSpaceInfo(ax_display *Display, space_info *SpaceInfo, std::vector<uint32_t> *Windows)
+{
+    if(!SpaceInfo->RootNode)
+    {
+        CreateSpaceInfoWithWindowTree(Display, SpaceInfo, Windows);
+        return;
+    }
+
+    ApplyTreeNodeContainer(SpaceInfo->RootNode);
+    for(std::size_t Index = 0; Index < Windows->size(); ++Index)
+    {
+        if(SpaceInfo->Settings.Mode == SpaceModeBSP)
+            AddWindowToBSPTree(Display, SpaceInfo, (*Windows)[Index]);
+        else if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
+            AddWindowToMonocleTree(Display, SpaceInfo, (*Windows)[Index]);
+    }
+}
+
 void CreateWindowNodeTree(ax_display *Display)
 {
+    AXLibTraceFunction("layout");
     space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     if(!SpaceInfo->Initialized && !SpaceInfo->RootNode)
     {
@@ -958,9 +989,12 @@ void CreateWindowNodeTree(ax_display *Display)
         }
 
         SpaceInfo->Initialized = true;
-        LoadSpaceSettings(Display, SpaceInfo);
         std::vector<uint32_t> Windows = GetAllWindowIDSOnDisplay(Display);
-        CreateSpaceInfoWithWindowTree(Display, SpaceInfo, &Windows);
+        LoadSpaceSettings(Display, SpaceInfo);
+        if(RestoreSpaceInfo(Display, SpaceInfo, &Windows))
+            FillRestoredSpaceInfo(Display, SpaceInfo, &Windows);
+        else
+            CreateSpaceInfoWithWindowTree(Display, SpaceInfo, &Windows);
     }
     else if(SpaceInfo->Initialized && !SpaceInfo->RootNode)
     {
@@ -999,12 +1033,52 @@ void ResetWindowNodeTree(ax_display *Display, space_tiling_option Mode)
         SpaceInfo->RootNode = NULL;
         SpaceInfo->Initialized = true;
         SpaceInfo->Settings.Mode = Mode;
+        SpaceInfo->Overrides |= SpaceOverride_Mode;
         CreateWindowNodeTree(Display);
     }
 }
 
+void RecordWindowNodeTree(ax_display *Display)
+{
+    if(Display)
+    {
+        space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+        RecordLayoutHistory(Display->Space->Identifier, SpaceInfo->RootNode, SpaceInfo->Settings.Mode);
+    }
+}
+
+/* NOTE(koekeishiya): Replace the tree of the active space with an earlier (Step < 0) or later
+ *                    (Step > 0) version from its layout history. The whole tree is applied
+ *                    in one batch, and only windows whose frame differs are touched. */
+void StepWindowNodeTree(ax_display *Display, int Step)
+{
+    AXLibTraceFunction("layout");
+    if(!Display || AXLibIsSpaceTransitionInProgress() || Display->Space->Type != kCGSSpaceUser)
+        return;
+
+    space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
+    space_tiling_option Mode = SpaceInfo->Settings.Mode;
+    tree_node *RootNode = StepLayoutHistory(Display->Space->Identifier, SpaceInfo->RootNode, &Mode, Step);
+    if(!RootNode)
+        return;
+
+    AXLibBeginBatch();
+    std::vector<uint32_t> Windows = GetAllWindowIDSOnDisplay(Display);
+    DestroyNodeTree(SpaceInfo->RootNode);
+    SpaceInfo->Settings.Mode = Mode;
+    SpaceInfo->Overrides |= SpaceOverride_Mode;
+    SpaceInfo->RootNode = PruneNodeTree(RootNode, &Windows);
+
+    if(SpaceInfo->RootNode)
+        CreateNodeTreeContainers(Display, SpaceInfo->RootNode);
+
+    FillRestoredSpaceInfo(Display, SpaceInfo, &Windows);
+    AXLibEndBatch();
+}
+
 void AddWindowToNodeTree(ax_display *Display, uint32_t WindowID)
 {
+    AXLibTraceFunction("layout");
     space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     if(!SpaceInfo->RootNode)
         CreateWindowNodeTree(Display);
@@ -1018,11 +1092,14 @@ void AddWindowToNodeTree(ax_display *Display, uint32_t WindowID)
 
 void RemoveWindowFromNodeTree(ax_display *Display, uint32_t WindowID)
 {
+    AXLibTraceFunction("layout");
     space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     if(SpaceInfo->Settings.Mode == SpaceModeBSP)
         RemoveWindowFromBSPTree(Display, WindowID);
     else if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
         RemoveWindowFromMonocleTree(Display, WindowID);
+
+    KwmMarkStateDirty();
 }
 
 internal void
@@ -1038,13 +1115,13 @@ RebalanceBSPTree(ax_display *Display)
 
         for(std::size_t WindowIndex = 0; WindowIndex < WindowsToRemove.size(); ++WindowIndex)
         {
-            DEBUG("RebalanceBSPTree() Remove Window " << WindowsToRemove[WindowIndex]);
+            LOG_DEBUG(LogCategory_Tree, "RebalanceBSPTree() Remove Window " << WindowsToRemove[WindowIndex]);
             RemoveWindowFromBSPTree(Display, WindowsToRemove[WindowIndex]);
         }
 
         for(std::size_t WindowIndex = 0; WindowIndex < WindowsToAdd.size(); ++WindowIndex)
         {
-            DEBUG("RebalanceBSPTree() Add Window " << WindowsToAdd[WindowIndex]->ID);
+            LOG_DEBUG(LogCategory_Tree, "RebalanceBSPTree() Add Window " << WindowsToAdd[WindowIndex]->ID);
             TileWindow(Display, WindowsToAdd[WindowIndex]);
         }
     }
@@ -1063,13 +1140,13 @@ RebalanceMonocleTree(ax_display *Display)
 
         for(std::size_t WindowIndex = 0; WindowIndex < WindowsToRemove.size(); ++WindowIndex)
         {
-            DEBUG("RebalanceMonocleTree() Remove Window " << WindowsToRemove[WindowIndex]);
+            LOG_DEBUG(LogCategory_Tree, "RebalanceMonocleTree() Remove Window " << WindowsToRemove[WindowIndex]);
             RemoveWindowFromMonocleTree(Display, WindowsToRemove[WindowIndex]);
         }
 
         for(std::size_t WindowIndex = 0; WindowIndex < WindowsToAdd.size(); ++WindowIndex)
         {
-            DEBUG("RebalanceMonocleTree() Add Window " << WindowsToAdd[WindowIndex]->ID);
+            LOG_DEBUG(LogCategory_Tree, "RebalanceMonocleTree() Add Window " << WindowsToAdd[WindowIndex]->ID);
             TileWindow(Display, WindowsToAdd[WindowIndex]);
         }
     }
@@ -1080,6 +1157,7 @@ RebalanceMonocleTree(ax_display *Display)
  * Also attempt to tile any untiled window that is not marked as  floating. */
 void RebalanceNodeTree(ax_display *Display)
 {
+    AXLibTraceFunction("layout");
     space_info *SpaceInfo = &WindowTree[Display->Space->Identifier];
     if(!SpaceInfo->Initialized)
         return;
@@ -1116,7 +1194,7 @@ void AddWindowToInactiveNodeTree(ax_display *Display, uint32_t WindowID)
     }
     else if(SpaceInfo->Settings.Mode == SpaceModeBSP)
     {
-        DEBUG("AddWindowToInactiveNodeTree() BSP Space");
+        LOG_DEBUG(LogCategory_Tree, "AddWindowToInactiveNodeTree() BSP Space");
         tree_node *CurrentNode = NULL;
         GetFirstLeafNode(SpaceInfo->RootNode, (void**)&CurrentNode);
         split_type SplitMode = KWMSettings.SplitMode == SPLIT_OPTIMAL ? GetOptimalSplitMode(CurrentNode) : KWMSettings.SplitMode;
@@ -1126,7 +1204,7 @@ void AddWindowToInactiveNodeTree(ax_display *Display, uint32_t WindowID)
     }
     else if(SpaceInfo->Settings.Mode == SpaceModeMonocle)
     {
-        DEBUG("AddWindowToInactiveNodeTree() Monocle Space");
+        LOG_DEBUG(LogCategory_Tree, "AddWindowToInactiveNodeTree() Monocle Space");
         link_node *Link = SpaceInfo->RootNode->List;
         while(Link->Next)
             Link = Link->Next;
@@ -1201,13 +1279,13 @@ void ToggleFocusedWindowParentContainer()
     {
         if(IsLeafNode(Node) && Node->Parent->WindowID == 0)
         {
-            DEBUG("ToggleFocusedWindowParentContainer() Set Parent Container");
+            LOG_DEBUG(LogCategory_Tree, "ToggleFocusedWindowParentContainer() Set Parent Container");
             Node->Parent->WindowID = Node->WindowID;
             ResizeWindowToContainerSize(Node->Parent);
         }
         else
         {
-            DEBUG("ToggleFocusedWindowParentContainer() Restore Window Container");
+            LOG_DEBUG(LogCategory_Tree, "ToggleFocusedWindowParentContainer() Restore Window Container");
             Node->Parent->WindowID = 0;
             ResizeWindowToContainerSize(Node);
         }
@@ -1237,14 +1315,14 @@ void ToggleFocusedWindowFullscreen()
         Node = GetTreeNodeFromWindowID(Space->RootNode, Window->ID);
         if(Node)
         {
-            DEBUG("ToggleFocusedWindowFullscreen() Set fullscreen");
+            LOG_DEBUG(LogCategory_Tree, "ToggleFocusedWindowFullscreen() Set fullscreen");
             Space->RootNode->WindowID = Node->WindowID;
             ResizeWindowToContainerSize(Space->RootNode);
         }
     }
     else
     {
-        DEBUG("ToggleFocusedWindowFullscreen() Restore old size");
+        LOG_DEBUG(LogCategory_Tree, "ToggleFocusedWindowFullscreen() Restore old size");
         Space->RootNode->WindowID = 0;
         Node = GetTreeNodeFromWindowID(Space->RootNode, Window->ID);
         if(Node)
@@ -1447,8 +1525,7 @@ void SwapFocusedWindowDirected(int Degrees)
             if(NewFocusNode)
             {
                 SwapNodeWindowIDs(TreeNode, NewFocusNode);
-                Window->Position = AXLibGetWindowPosition(Window->Ref);
-                Window->Size = AXLibGetWindowSize(Window->Ref);
+                AXLibRefreshWindowAttributes(Window, AXWindowAttribute_Position | AXWindowAttribute_Size);
                 MoveCursorToCenterOfWindow(Window);
             }
         }
@@ -1754,6 +1831,7 @@ void ClearMarkedWindow()
 {
     MarkedWindow = NULL;
     ClearBorder(&MarkedBorder);
+    KwmMarkStateDirty();
 }
 
 void MarkWindowContainer(ax_window *Window)
@@ -1762,14 +1840,15 @@ void MarkWindowContainer(ax_window *Window)
     {
         if(MarkedWindow && MarkedWindow->ID == Window->ID)
         {
-            DEBUG("MarkWindowContainer() Unmarked " << Window->Name);
+            LOG_DEBUG(LogCategory_Window, "MarkWindowContainer() Unmarked " << (AXLibWindowName(Window) ? Window->Name : "[Unknown]"));
             ClearMarkedWindow();
         }
         else
         {
-            DEBUG("MarkWindowContainer() Marked " << Window->Name);
+            LOG_DEBUG(LogCategory_Window, "MarkWindowContainer() Marked " << (AXLibWindowName(Window) ? Window->Name : "[Unknown]"));
             MarkedWindow = Window;
             UpdateBorder(&MarkedBorder, MarkedWindow);
+            KwmMarkStateDirty();
         }
     }
 }
@@ -1786,7 +1865,7 @@ void SetWindowFocusByNode(tree_node *Node)
         ax_window *Window = GetWindowByID(Node->WindowID);
         if(Window)
         {
-            DEBUG("SetWindowFocusByNode()");
+            LOG_DEBUG(LogCategory_Window, "SetWindowFocusByNode()");
             AXLibSetFocusedWindow(Window);
         }
     }
@@ -1799,17 +1878,15 @@ void SetWindowFocusByNode(link_node *Link)
         ax_window *Window = GetWindowByID(Link->WindowID);
         if(Window)
         {
-            DEBUG("SetWindowFocusByNode()");
+            LOG_DEBUG(LogCategory_Window, "SetWindowFocusByNode()");
             AXLibSetFocusedWindow(Window);
         }
     }
 }
 
-void CenterWindowInsideNodeContainer(ax_window *Window, int *Xptr, int *Yptr, int *Wptr, int *Hptr)
+internal void
+CenterWindowInsideFrame(ax_window *Window, CGPoint WindowOrigin, CGSize WindowOGSize, int *Xptr, int *Yptr, int *Wptr, int *Hptr)
 {
-    CGPoint WindowOrigin = AXLibGetWindowPosition(Window->Ref);
-    CGSize WindowOGSize = AXLibGetWindowSize(Window->Ref);
-
     int &X = *Xptr, &Y = *Yptr, &Width = *Wptr, &Height = *Hptr;
     int XDiff = (X + Width) - (WindowOrigin.x + WindowOGSize.width);
     int YDiff = (Y + Height) - (WindowOrigin.y + WindowOGSize.height);
@@ -1825,24 +1902,59 @@ void CenterWindowInsideNodeContainer(ax_window *Window, int *Xptr, int *Yptr, in
         Height -= YOff > 0 ? YOff : 0;
 
         AXLibAddFlags(Window, AXWindow_MoveIntrinsic);
-        if(!AXLibSetWindowPosition(Window->Ref, X, Y))
+        if(!AXLibMoveWindow(Window, X, Y))
             AXLibClearFlags(Window, AXWindow_MoveIntrinsic);
 
         AXLibAddFlags(Window, AXWindow_SizeIntrinsic);
-        if(!AXLibSetWindowSize(Window->Ref, Width, Height))
+        if(!AXLibResizeWindow(Window, Width, Height))
             AXLibClearFlags(Window, AXWindow_SizeIntrinsic);
     }
 }
 
+void CenterWindowInsideNodeContainer(ax_window *Window, int *Xptr, int *Yptr, int *Wptr, int *Hptr)
+{
+    CGPoint WindowOrigin = AXLibGetWindowPosition(Window->Ref);
+    CGSize WindowOGSize = AXLibGetWindowSize(Window->Ref);
+    CenterWindowInsideFrame(Window, WindowOrigin, WindowOGSize, Xptr, Yptr, Wptr, Hptr);
+}
+
+struct window_container
+{
+    uint32_t WindowID;
+    int X, Y;
+    int Width, Height;
+};
+
+/* NOTE(koekeishiya): Runs on the thread that called SetWindowDimensions(..), after the frame it requested
+                      has been applied. Inside a batch that is once the batch has ended, by which time the
+                      window may have been destroyed, so it is looked up again. */
+internal AX_FRAME_CALLBACK(CenterWindowInsideReadFrame)
+{
+    window_container *Container = (window_container *) Context;
+    ax_window *Window = GetWindowByID(Container->WindowID);
+    if((Window) &&
+       (Result == AXFrame_Success))
+    {
+        CGPoint WindowOrigin = CGPointMake(Frame->X, Frame->Y);
+        CGSize WindowOGSize = CGSizeMake(Frame->Width, Frame->Height);
+        CenterWindowInsideFrame(Window, WindowOrigin, WindowOGSize,
+                                &Container->X, &Container->Y,
+                                &Container->Width, &Container->Height);
+    }
+
+    free(Container);
+}
+
 void SetWindowDimensions(ax_window *Window, int X, int Y, int Width, int Height)
 {
+    AXLibTraceFunction("layout");
     bool Changed = false;
     if((Window->Position.x != X) ||
        (Window->Position.y != Y))
     {
         Changed = true;
         AXLibAddFlags(Window, AXWindow_MoveIntrinsic);
-        if(!AXLibSetWindowPosition(Window->Ref, X, Y))
+        if(!AXLibMoveWindow(Window, X, Y))
             AXLibClearFlags(Window, AXWindow_MoveIntrinsic);
     }
 
@@ -1851,12 +1963,25 @@ void SetWindowDimensions(ax_window *Window, int X, int Y, int Width, int Height)
     {
         Changed = true;
         AXLibAddFlags(Window, AXWindow_SizeIntrinsic);
-        if(!AXLibSetWindowSize(Window->Ref, Width, Height))
+        if(!AXLibResizeWindow(Window, Width, Height))
             AXLibClearFlags(Window, AXWindow_SizeIntrinsic);
     }
 
-    if(Changed)
-        CenterWindowInsideNodeContainer(Window, &X, &Y, &Width, &Height);
+    /* NOTE(koekeishiya): The frame of a degraded application is applied asynchronously, so reading
+                          it back here would see the old frame. Otherwise the read is queued behind the
+                          update on the application queue, and only the read runs there; the correction
+                          itself is applied from this thread, see CenterWindowInsideReadFrame(..). */
+    if((Changed) &&
+       (!AXLibIsApplicationDegraded(Window->Application)))
+    {
+        window_container *Container = (window_container *) malloc(sizeof(window_container));
+        Container->WindowID = Window->ID;
+        Container->X = X;
+        Container->Y = Y;
+        Container->Width = Width;
+        Container->Height = Height;
+        AXLibReadWindowFrame(Window, &CenterWindowInsideReadFrame, Container);
+    }
 }
 
 void CenterWindow(ax_display *Display, ax_window *Window)
@@ -1887,18 +2012,7 @@ void CenterWindow(ax_display *Display, ax_window *Window)
 
 ax_window *GetWindowByID(uint32_t WindowID)
 {
-    std::map<pid_t, ax_application>::iterator It;
-    for(It = AXState.Applications.begin();
-        It != AXState.Applications.end();
-        ++It)
-    {
-        ax_application *Application = &It->second;
-        ax_window *Window = AXLibFindApplicationWindow(Application, WindowID);
-        if(Window)
-            return Window;
-    }
-
-    return NULL;
+    return AXLibFindWindow(WindowID);
 }
 
 void MoveFloatingWindow(int X, int Y)
@@ -1909,8 +2023,8 @@ void MoveFloatingWindow(int X, int Y)
 
     if(AXLibHasFlags(Window, AXWindow_Floating))
     {
-        AXLibSetWindowPosition(Window->Ref,
-                               Window->Position.x + X,
-                               Window->Position.y + Y);
+        AXLibMoveWindow(Window,
+                        Window->Position.x + X,
+                        Window->Position.y + Y);
     }
 }
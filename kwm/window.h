@@ -9,6 +9,8 @@ void CreateWindowNodeTree(ax_display *Display);
 void CreateInactiveWindowNodeTree(ax_display *Display, std::vector<uint32_t> *Windows);
 void LoadWindowNodeTree(ax_display *Display, std::string Layout);
 void ResetWindowNodeTree(ax_display *Display, space_tiling_option Mode);
+void RecordWindowNodeTree(ax_display *Display);
+void StepWindowNodeTree(ax_display *Display, int Step);
 void AddWindowToNodeTree(ax_display *Display, uint32_t WindowID);
 void RemoveWindowFromNodeTree(ax_display *Display, uint32_t WindowID);
 void RebalanceNodeTree(ax_display *Display);
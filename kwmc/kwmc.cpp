@@ -5,10 +5,14 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
-#include <netdb.h>
+#include <netinet/tcp.h>
 #include <unistd.h>
+#include <poll.h>
+#include <errno.h>
+#include <cstring>
 
 #define KwmDaemonPort 3020
+#define KwmDaemonBatch "@batch"
 
 int KwmcSockFD;
 
@@ -21,18 +25,39 @@ void Fatal(const std::string &err)
 std::string ReadFromSocket(int SockFD)
 {
     std::string Message;
-    char Cur;
+    char Buffer[4096];
+    ssize_t Bytes;
 
-    while(recv(SockFD, &Cur, 1, 0))
-        Message += Cur;
+    while((Bytes = recv(SockFD, Buffer, sizeof(Buffer), 0)) > 0)
+        Message.append(Buffer, Bytes);
 
     return Message;
 }
 
+bool SendToSocket(int SockFD, const char *Data, size_t Size)
+{
+    while(Size > 0)
+    {
+        ssize_t Bytes = send(SockFD, Data, Size, 0);
+        if(Bytes == -1)
+        {
+            if(errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        Data += Bytes;
+        Size -= Bytes;
+    }
+
+    return true;
+}
+
 void WriteToSocket(std::string Msg)
 {
     Msg += "\n";
-    send(KwmcSockFD, Msg.c_str(), Msg.size(), 0);
+    SendToSocket(KwmcSockFD, Msg.c_str(), Msg.size());
 
     std::string Response = ReadFromSocket(KwmcSockFD);
     if(!Response.empty())
@@ -56,24 +81,113 @@ void KwmcForwardMessageThroughSocket(int argc, char **argv)
     WriteToSocket(Msg);
 }
 
+/* NOTE(koekeishiya): Connect straight to the loopback address; resolving
+ *                    "localhost" on every invocation is needless latency. */
 void KwmcConnectToDaemon()
 {
     struct sockaddr_in srv_addr;
-    struct hostent *server;
+    int _True = 1;
 
     if((KwmcSockFD = socket(PF_INET, SOCK_STREAM, 0)) == -1)
         Fatal("Could not create socket!");
 
-    server = gethostbyname("localhost");
+    setsockopt(KwmcSockFD, IPPROTO_TCP, TCP_NODELAY, &_True, sizeof(int));
+#ifdef SO_NOSIGPIPE
+    setsockopt(KwmcSockFD, SOL_SOCKET, SO_NOSIGPIPE, &_True, sizeof(int));
+#endif
+
     srv_addr.sin_family = AF_INET;
     srv_addr.sin_port = htons(KwmDaemonPort);
-    std::memcpy(&srv_addr.sin_addr.s_addr, server->h_addr, server->h_length);
+    srv_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
     std::memset(&srv_addr.sin_zero, '\0', 8);
 
     if(connect(KwmcSockFD, (struct sockaddr*) &srv_addr, sizeof(struct sockaddr)) == -1)
         Fatal("Connection failed!");
 }
 
+/* NOTE(koekeishiya): Print every complete NUL-terminated reply in Buffer
+ *                    and keep whatever partial reply is left over. Every
+ *                    command gets one line, so an empty reply prints an
+ *                    empty line and the output lines up with the input. */
+void KwmcPrintBatchReplies(std::string &Buffer)
+{
+    std::string Output;
+    std::size_t Start = 0, End;
+    while((End = Buffer.find('\0', Start)) != std::string::npos)
+    {
+        Output.append(Buffer, Start, End - Start);
+        Output += "\n";
+        Start = End + 1;
+    }
+
+    Buffer.erase(0, Start);
+    if(!Output.empty())
+    {
+        std::cout << Output;
+        std::cout.flush();
+    }
+}
+
+/* NOTE(koekeishiya): Stream newline separated commands from stdin over a single connection.
+ *                    The daemon answers every command in order, so stdin and the socket are
+ *                    serviced together and replies are printed as soon as they arrive. */
+void KwmcBatch()
+{
+    KwmcConnectToDaemon();
+
+    std::string Header = KwmDaemonBatch "\n";
+    if(!SendToSocket(KwmcSockFD, Header.c_str(), Header.size()))
+        Fatal("Connection failed!");
+
+    std::string Replies;
+    char Buffer[8192];
+    bool InputOpen = true;
+
+    while(true)
+    {
+        struct pollfd Fds[2];
+        Fds[0].fd = KwmcSockFD;
+        Fds[0].events = POLLIN;
+        Fds[1].fd = STDIN_FILENO;
+        Fds[1].events = POLLIN;
+
+        if(poll(Fds, InputOpen ? 2 : 1, -1) == -1)
+        {
+            if(errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        if(Fds[0].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            ssize_t Bytes = recv(KwmcSockFD, Buffer, sizeof(Buffer), 0);
+            if(Bytes <= 0)
+                break;
+
+            Replies.append(Buffer, Bytes);
+            KwmcPrintBatchReplies(Replies);
+        }
+
+        if(InputOpen && (Fds[1].revents & (POLLIN | POLLHUP | POLLERR)))
+        {
+            ssize_t Bytes = read(STDIN_FILENO, Buffer, sizeof(Buffer));
+            if(Bytes > 0)
+            {
+                if(!SendToSocket(KwmcSockFD, Buffer, Bytes))
+                    break;
+            }
+            else
+            {
+                InputOpen = false;
+                shutdown(KwmcSockFD, SHUT_WR);
+            }
+        }
+    }
+
+    close(KwmcSockFD);
+}
+
 void KwmcInterpreter()
 {
     while(true)
@@ -95,6 +209,8 @@ int main(int argc, char **argv)
         std::string Command = argv[1];
         if(Command == "interpret")
             KwmcInterpreter();
+        else if(Command == "-" && argc == 2)
+            KwmcBatch();
         else
         {
             KwmcConnectToDaemon();
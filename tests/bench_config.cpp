@@ -0,0 +1,173 @@
+#include "../kwm/lexer.h"
+
+#include <stdio.h>
+#include <chrono>
+#include <map>
+
+#define internal static
+#define LINE_COUNT 5000
+#define DEFINE_COUNT 200
+#define RUN_COUNT 5
+
+internal double
+ElapsedMilliseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+}
+
+internal uint64_t
+HashText(uint64_t Hash, const char *Text, std::size_t Length)
+{
+    for(std::size_t Index = 0; Index < Length; ++Index)
+        Hash = (Hash ^ (uint8_t) Text[Index]) * 1099511628211ULL;
+
+    return (Hash ^ '\n') * 1099511628211ULL;
+}
+
+/* NOTE(koekeishiya): 200 defines followed by config options, binds, rules and comments
+                      that use them, 5,000 lines in total. */
+internal std::string
+GenerateConfig()
+{
+    std::string Config;
+    char Line[256];
+    for(int Index = 0; Index < DEFINE_COUNT; ++Index)
+    {
+        if(Index % 2)
+            snprintf(Line, sizeof(Line), "define var_%03d %d\n", Index, Index % 40);
+        else
+            snprintf(Line, sizeof(Line), "define var_%03d cmd+ctrl+alt%s\n", Index, Index % 4 ? "" : "+shift");
+        Config += Line;
+    }
+
+    for(int Index = DEFINE_COUNT; Index < LINE_COUNT; ++Index)
+    {
+        int Define = Index % DEFINE_COUNT;
+        int Number = Define | 1, Modifier = Define & ~1;
+        switch(Index % 4)
+        {
+            case 0: snprintf(Line, sizeof(Line), "kwmc config space 0 %d padding var_%03d var_%03d 10 10\n", Index % 10, Number, Number); break;
+            case 1: snprintf(Line, sizeof(Line), "kwmc bindsym var_%03d-%c window -f west\n", Modifier, 'a' + Index % 26); break;
+            case 2: snprintf(Line, sizeof(Line), "kwmc rule owner=\"App %d\" properties={float=\"true\"; space=\"var_%03d\"}\n", Index, Number); break;
+            case 3: snprintf(Line, sizeof(Line), "// comment %d about var_%03d\n", Index, Define); break;
+        }
+        Config += Line;
+    }
+
+    return Config;
+}
+
+/* NOTE(koekeishiya): Rest-of-line statements are read as text; everything else token by token. */
+internal inline bool
+IsLineStatement(token Token)
+{
+    return TokenEquals(Token, "bindsym") || TokenEquals(Token, "rule");
+}
+
+internal uint64_t
+LexConfig(std::string &Config)
+{
+    config_lexer Lexer = {};
+    Lexer.File.At = const_cast<char*>(Config.c_str());
+
+    uint64_t Hash = 0;
+    while(true)
+    {
+        token Token = KwmConfigToken(&Lexer);
+        if(Token.Type == Token_EndOfStream)
+            break;
+
+        if(Token.Type == Token_Comment)
+            continue;
+
+        if(Token.Type == Token_Identifier && TokenEquals(Token, "define"))
+        {
+            KwmParseDefine(&Lexer);
+            continue;
+        }
+
+        Hash = HashText(Hash, Token.Text, Token.TextLength);
+        if(Token.Type == Token_Identifier && IsLineStatement(Token))
+        {
+            std::string Line = KwmConfigLine(&Lexer);
+            Hash = HashText(Hash, Line.c_str(), Line.size());
+        }
+    }
+
+    return Hash;
+}
+
+/* NOTE(koekeishiya): What the config loader used to do: collect the defines, replace each of them
+                      across the whole text, then tokenize the result. */
+internal uint64_t
+FindReplaceConfig(std::string Config)
+{
+    std::map<std::string, std::string> Defines;
+    tokenizer Tokenizer = {};
+    Tokenizer.At = const_cast<char*>(Config.c_str());
+    for(token Token = GetToken(&Tokenizer); Token.Type != Token_EndOfStream; Token = GetToken(&Tokenizer))
+    {
+        if(Token.Type == Token_Identifier && TokenEquals(Token, "define"))
+        {
+            token Name = GetToken(&Tokenizer);
+            Defines[std::string(Name.Text, Name.TextLength)] = GetTextTilEndOfLine(&Tokenizer);
+        }
+    }
+
+    std::map<std::string, std::string>::iterator It;
+    for(It = Defines.begin(); It != Defines.end(); ++It)
+    {
+        std::size_t Pos = Config.find(It->first);
+        while(Pos != std::string::npos)
+        {
+            Config.replace(Pos, It->first.size(), It->second);
+            Pos = Config.find(It->first, Pos + It->second.size() + 1);
+        }
+    }
+
+    uint64_t Hash = 0;
+    Tokenizer.At = const_cast<char*>(Config.c_str());
+    for(token Token = GetToken(&Tokenizer); Token.Type != Token_EndOfStream; Token = GetToken(&Tokenizer))
+    {
+        if(Token.Type == Token_Comment)
+            continue;
+
+        if(Token.Type == Token_Identifier && TokenEquals(Token, "define"))
+        {
+            GetTextTilEndOfLine(&Tokenizer);
+            continue;
+        }
+
+        Hash = HashText(Hash, Token.Text, Token.TextLength);
+        if(Token.Type == Token_Identifier && IsLineStatement(Token))
+        {
+            std::string Line = GetTextTilEndOfLine(&Tokenizer);
+            Line.erase(Line.find_last_not_of(" \t\r\n") + 1);
+            Hash = HashText(Hash, Line.c_str(), Line.size());
+        }
+    }
+
+    return Hash;
+}
+
+int main()
+{
+    std::string Config = GenerateConfig();
+
+    double Lexer = 0, FindReplace = 0;
+    uint64_t LexerHash = 0, FindReplaceHash = 0;
+    for(int Run = 0; Run < RUN_COUNT; ++Run)
+    {
+        std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+        LexerHash = LexConfig(Config);
+        Lexer += ElapsedMilliseconds(Start);
+
+        Start = std::chrono::steady_clock::now();
+        FindReplaceHash = FindReplaceConfig(Config);
+        FindReplace += ElapsedMilliseconds(Start);
+    }
+
+    printf("lexer        %8.2f ms for %d lines, %d defines\n", Lexer / RUN_COUNT, LINE_COUNT, DEFINE_COUNT);
+    printf("find/replace %8.2f ms for %d lines, %d defines\n", FindReplace / RUN_COUNT, LINE_COUNT, DEFINE_COUNT);
+    return LexerHash == FindReplaceHash ? 0 : 1;
+}
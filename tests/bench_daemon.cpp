@@ -0,0 +1,173 @@
+#include "../kwm/daemon.h"
+#include "../kwm/interpreter.h"
+
+#include <netinet/tcp.h>
+#include <algorithm>
+#include <atomic>
+#include <queue>
+
+#define internal static
+#define CLIENT_COUNT 64
+#define REQUESTS_PER_CLIENT 200
+#define STUCK_CLIENT_COUNT 4
+
+struct pending_command
+{
+    std::string Message;
+    int Handle;
+};
+
+/* NOTE(koekeishiya): Stands in for the interpreter. Every command is answered from a separate
+ *                    thread, the way queries are answered from the event thread, except for
+ *                    "stuck" commands, which are never answered at all. */
+internal pthread_mutex_t CommandLock = PTHREAD_MUTEX_INITIALIZER;
+internal pthread_cond_t CommandReady = PTHREAD_COND_INITIALIZER;
+internal std::queue<pending_command> Commands;
+
+void KwmInterpretCommand(std::string Message, int ClientSockFD)
+{
+    if(Message == "stuck")
+        return;
+
+    pending_command Command = { Message, ClientSockFD };
+    pthread_mutex_lock(&CommandLock);
+    Commands.push(Command);
+    pthread_cond_signal(&CommandReady);
+    pthread_mutex_unlock(&CommandLock);
+}
+
+internal void *
+AnswerCommands(void *)
+{
+    while(true)
+    {
+        pthread_mutex_lock(&CommandLock);
+        while(Commands.empty())
+            pthread_cond_wait(&CommandReady, &CommandLock);
+
+        pending_command Command = Commands.front();
+        Commands.pop();
+        pthread_mutex_unlock(&CommandLock);
+
+        KwmWriteToSocket("reply " + Command.Message, Command.Handle);
+    }
+
+    return NULL;
+}
+
+internal int
+ConnectToDaemon()
+{
+    int SockFD = socket(PF_INET, SOCK_STREAM, 0);
+    int _True = 1;
+    setsockopt(SockFD, IPPROTO_TCP, TCP_NODELAY, &_True, sizeof(int));
+
+    struct sockaddr_in Address = {};
+    Address.sin_family = AF_INET;
+    Address.sin_port = htons(3020);
+    Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if(connect(SockFD, (struct sockaddr *) &Address, sizeof(Address)) == -1)
+    {
+        close(SockFD);
+        return -1;
+    }
+
+    return SockFD;
+}
+
+/* NOTE(koekeishiya): One command per connection, read until the daemon closes it, like kwmc. */
+internal bool
+SendCommand(std::string Message)
+{
+    int SockFD = ConnectToDaemon();
+    if(SockFD == -1)
+        return false;
+
+    std::string Line = Message + "\n";
+    bool Result = send(SockFD, Line.data(), Line.size(), 0) == (ssize_t) Line.size();
+
+    std::string Reply;
+    char Buffer[256];
+    ssize_t Bytes;
+    while(Result && (Bytes = recv(SockFD, Buffer, sizeof(Buffer), 0)) > 0)
+        Reply.append(Buffer, Bytes);
+
+    close(SockFD);
+    return Result && Reply == "reply " + Message;
+}
+
+struct bench_client
+{
+    int ID;
+    std::vector<double> Latencies;
+    int Failures;
+};
+
+internal void *
+RunClient(void *Context)
+{
+    bench_client *Client = (bench_client *) Context;
+    for(int Request = 0; Request < REQUESTS_PER_CLIENT; ++Request)
+    {
+        std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+        if(!SendCommand("query " + std::to_string(Client->ID) + " " + std::to_string(Request)))
+            ++Client->Failures;
+
+        std::chrono::duration<double, std::micro> Elapsed = std::chrono::steady_clock::now() - Start;
+        Client->Latencies.push_back(Elapsed.count());
+    }
+
+    return NULL;
+}
+
+/* NOTE(koekeishiya): 64 clients send 200 commands each while four other clients hold connections
+ *                    whose commands never complete. */
+int main()
+{
+    if(!KwmStartDaemon())
+    {
+        printf("could not start the daemon on port 3020\n");
+        return 1;
+    }
+
+    pthread_t Answerer;
+    pthread_create(&Answerer, NULL, &AnswerCommands, NULL);
+
+    int Stuck[STUCK_CLIENT_COUNT];
+    for(int Index = 0; Index < STUCK_CLIENT_COUNT; ++Index)
+    {
+        Stuck[Index] = ConnectToDaemon();
+        send(Stuck[Index], "stuck\n", 6, 0);
+    }
+
+    bench_client Clients[CLIENT_COUNT];
+    pthread_t Threads[CLIENT_COUNT];
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < CLIENT_COUNT; ++Index)
+    {
+        Clients[Index].ID = Index;
+        Clients[Index].Failures = 0;
+        pthread_create(&Threads[Index], NULL, &RunClient, &Clients[Index]);
+    }
+
+    std::vector<double> Latencies;
+    int Failures = 0;
+    for(int Index = 0; Index < CLIENT_COUNT; ++Index)
+    {
+        pthread_join(Threads[Index], NULL);
+        Latencies.insert(Latencies.end(), Clients[Index].Latencies.begin(), Clients[Index].Latencies.end());
+        Failures += Clients[Index].Failures;
+    }
+    std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+
+    for(int Index = 0; Index < STUCK_CLIENT_COUNT; ++Index)
+        close(Stuck[Index]);
+    KwmTerminateDaemon();
+
+    std::sort(Latencies.begin(), Latencies.end());
+    printf("throughput %8.0f commands/s over %d clients\n", Latencies.size() / Elapsed.count(), CLIENT_COUNT);
+    printf("latency    %8.1f us p50, %.1f us p99\n",
+           Latencies[Latencies.size() / 2], Latencies[(Latencies.size() * 99) / 100]);
+    printf("failures   %8d\n", Failures);
+    return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,69 @@
+#include "../kwm/history.h"
+#include "layout.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+#define internal static
+#define WINDOW_COUNT 64
+#define EDIT_COUNT 10000
+
+internal double
+ElapsedNanoseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+internal int
+StepThroughHistory(tree_node **Live, int Step)
+{
+    int Steps = 0;
+    space_tiling_option Mode = SpaceModeBSP;
+    tree_node *Result;
+    while((Result = StepLayoutHistory("bench", *Live, &Mode, Step)))
+    {
+        DestroyTestTree(*Live);
+        *Live = Result;
+        ++Steps;
+    }
+
+    return Steps;
+}
+
+/* NOTE(koekeishiya): 10k edits of the split ratio of a random node in a 64 window tree, each
+ *                    recorded as a version, after which the whole history is undone and redone. */
+int main()
+{
+    tree_node *Live = CreateTestTree(WINDOW_COUNT);
+    srand(1);
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < EDIT_COUNT; ++Index)
+    {
+        tree_node *Leaf = GetTestLeaf(Live, 1 + rand() % WINDOW_COUNT);
+        if(Leaf->Parent)
+            Leaf->Parent->SplitRatio = 0.1 + (rand() % 800) / 1000.0;
+
+        RecordLayoutHistory("bench", Live, SpaceModeBSP);
+    }
+    double Record = ElapsedNanoseconds(Start);
+
+    Start = std::chrono::steady_clock::now();
+    int Undone = StepThroughHistory(&Live, -1);
+    double Undo = ElapsedNanoseconds(Start);
+
+    Start = std::chrono::steady_clock::now();
+    int Redone = StepThroughHistory(&Live, 1);
+    double Redo = ElapsedNanoseconds(Start);
+
+    uint64_t Versions, Nodes;
+    GetLayoutHistoryUsage(&Versions, &Nodes);
+    DestroyTestTree(Live);
+
+    printf("record  %8.1f ns/edit\n", Record / EDIT_COUNT);
+    printf("undo    %8.1f ns/step, %d steps\n", Undo / Undone, Undone);
+    printf("redo    %8.1f ns/step, %d steps\n", Redo / Redone, Redone);
+    printf("history %8d versions, %d nodes for %d nodes per tree\n", (int) Versions, (int) Nodes, 2 * WINDOW_COUNT - 1);
+    return Undone == KWM_LAYOUT_HISTORY_LIMIT - 1 && Redone == Undone ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include "../kwm/launcher.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <chrono>
+
+#define internal static
+#define PROCESS_COUNT 1000
+#define RESIDENT_SIZE (64 << 20)
+
+internal double
+ElapsedMicroseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): What KwmExecuteSystemCommand used to do: fork the whole process and exec
+ *                    the command in the child. The children are reaped once all have started. */
+internal double
+LaunchWithFork(int Count)
+{
+    std::vector<pid_t> Children;
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < Count; ++Index)
+    {
+        pid_t ChildPID = fork();
+        if(ChildPID == 0)
+        {
+            execlp("true", "true", (char *) NULL);
+            _exit(127);
+        }
+
+        Children.push_back(ChildPID);
+    }
+    double Elapsed = ElapsedMicroseconds(Start);
+
+    for(std::size_t Index = 0; Index < Children.size(); ++Index)
+        waitpid(Children[Index], NULL, 0);
+
+    return Elapsed / Count;
+}
+
+internal double
+LaunchWithLauncher(int Count)
+{
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < Count; ++Index)
+        KwmExecuteSystemCommand("true");
+
+    return ElapsedMicroseconds(Start) / Count;
+}
+
+/* NOTE(koekeishiya): The way a config with many exec lines is launched. */
+internal double
+LaunchBatchWithLauncher(int Count)
+{
+    std::vector<std::string> Commands(Count, "true");
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    KwmExecuteSystemCommands(Commands);
+    return ElapsedMicroseconds(Start) / Count;
+}
+
+/* NOTE(koekeishiya): Polls the process status until nothing is running, and returns false if
+ *                    one of the processes that are still listed did not exit with status 0. */
+internal bool
+WaitForLauncher()
+{
+    std::string Status = KwmGetProcessStatus();
+    while(Status.find(" running ") != std::string::npos)
+    {
+        usleep(1000);
+        Status = KwmGetProcessStatus();
+    }
+
+    std::size_t Lines = 1, Exited = 0;
+    for(std::size_t Index = 0; Index < Status.size(); ++Index)
+    {
+        if(Status[Index] == '\n')
+            ++Lines;
+    }
+
+    for(std::size_t Index = Status.find(" exit 0 "); Index != std::string::npos; Index = Status.find(" exit 0 ", Index + 1))
+        ++Exited;
+
+    return Lines == Exited;
+}
+
+/* NOTE(koekeishiya): Starts 1,000 'true' processes each way from a process with 64MB resident,
+ *                    which every fork has to map into the child. */
+int main()
+{
+    KwmSetLogLevel(LogLevel_Off);
+    KwmStartLauncher();
+
+    char *Resident = (char *) malloc(RESIDENT_SIZE);
+    memset(Resident, 1, RESIDENT_SIZE);
+
+    double Forked = LaunchWithFork(PROCESS_COUNT);
+    double Spawned = LaunchWithLauncher(PROCESS_COUNT);
+    bool SpawnedExited = WaitForLauncher();
+    double Batched = LaunchBatchWithLauncher(PROCESS_COUNT);
+    bool BatchedExited = WaitForLauncher();
+
+    uint64_t Launched, Failed;
+    KwmGetLauncherUsage(&Launched, &Failed);
+    free(Resident);
+
+    printf("fork       %8.1f us per process\n", Forked);
+    printf("spawn      %8.1f us per process\n", Spawned);
+    printf("batched    %8.1f us per process\n", Batched);
+    printf("launched   %8d, failed %d\n", (int) Launched, (int) Failed);
+    return SpawnedExited && BatchedExited && Launched == 2 * PROCESS_COUNT && Failed == 0 ? 0 : 1;
+}
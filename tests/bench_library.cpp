@@ -0,0 +1,79 @@
+#include "../kwm/library.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <vector>
+
+#define internal static
+#define LAYOUT_COUNT 10000
+
+internal double
+ElapsedNanoseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): About the size of an encoded layout with 8 to 24 windows. */
+internal std::string
+GenerateLayout(int Index)
+{
+    std::string Data(16 + Index % 32, '\0');
+    for(std::size_t Byte = 0; Byte < Data.size(); ++Byte)
+        Data[Byte] = (char) ((Index * 31 + Byte * 7) & 0xff);
+
+    return Data;
+}
+
+/* NOTE(koekeishiya): Stores 10,000 layouts one at a time, the way 'tree save' does, then looks
+                      every one of them up in random order. */
+int main()
+{
+    char Template[] = "/tmp/kwm-bench-library-XXXXXX";
+    if(!mkdtemp(Template))
+        return 1;
+
+    std::string Library = std::string(Template) + "/" + KWM_LAYOUT_LIBRARY_FILE;
+    std::vector<std::string> Names, Layouts;
+    for(int Index = 0; Index < LAYOUT_COUNT; ++Index)
+    {
+        Names.push_back("layout-" + std::to_string(Index));
+        Layouts.push_back(GenerateLayout(Index));
+    }
+
+    int Failures = 0;
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < LAYOUT_COUNT; ++Index)
+    {
+        if(!WriteLayoutToLibrary(Library, Names[Index], Layouts[Index]))
+            ++Failures;
+    }
+    double Store = ElapsedNanoseconds(Start);
+
+    std::vector<int> Order(LAYOUT_COUNT);
+    srand(1);
+    for(int Index = 0; Index < LAYOUT_COUNT; ++Index)
+        Order[Index] = rand() % LAYOUT_COUNT;
+
+    std::string Data;
+    Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < LAYOUT_COUNT; ++Index)
+    {
+        if(!ReadLayoutFromLibrary(Library, Names[Order[Index]], &Data) || Data != Layouts[Order[Index]])
+            ++Failures;
+    }
+    double Lookup = ElapsedNanoseconds(Start);
+
+    struct stat Buffer = {};
+    stat(Library.c_str(), &Buffer);
+    unlink(Library.c_str());
+    rmdir(Template);
+
+    printf("store    %8.1f us/layout\n", Store / LAYOUT_COUNT / 1000.0);
+    printf("lookup   %8.1f us/layout\n", Lookup / LAYOUT_COUNT / 1000.0);
+    printf("library  %8.1f bytes/layout, %d layouts\n", (double) Buffer.st_size / LAYOUT_COUNT, LAYOUT_COUNT);
+    printf("failures %8d\n", Failures);
+    return Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+#include "../kwm/log.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+
+#define internal static
+#define EVENT_COUNT 200000
+#define THREAD_COUNT 4
+
+internal double
+ElapsedNanoseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): The kind of message the tree builders log for every node. */
+internal double
+LogEvents(int Count)
+{
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < Count; ++Index)
+        LOG_DEBUG(LogCategory_Tree, "CreateLeafNode: window " << Index << " ratio " << 0.5 << " split vertical");
+
+    return ElapsedNanoseconds(Start) / Count;
+}
+
+internal void *
+LogEventsOnThread(void *)
+{
+    LogEvents(EVENT_COUNT);
+    return NULL;
+}
+
+/* NOTE(koekeishiya): What DEBUG(x) used to do: format and flush every message on the calling thread. */
+internal double
+LogEventsSynchronously(std::string File, int Count)
+{
+    std::ofstream Stream(File.c_str());
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < Count; ++Index)
+        Stream << "CreateLeafNode: window " << Index << " ratio " << 0.5 << " split vertical" << std::endl;
+
+    return ElapsedNanoseconds(Start) / Count;
+}
+
+int main()
+{
+    char Template[] = "/tmp/kwm-bench-log-XXXXXX";
+    if(!mkdtemp(Template))
+        return 1;
+
+    std::string Directory = Template;
+    KwmStartLogger(Directory + "/kwm.log");
+
+    KwmSetLogLevel(LogLevel_Info);
+    double Disabled = LogEvents(EVENT_COUNT);
+
+    KwmSetLogLevel(LogLevel_Debug);
+    double Enabled = LogEvents(EVENT_COUNT);
+
+    /* NOTE(koekeishiya): Reported as wall time over all events, so the result does not depend
+                          on how many cores the threads actually get to run on. */
+    pthread_t Threads[THREAD_COUNT];
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < THREAD_COUNT; ++Index)
+        pthread_create(&Threads[Index], NULL, &LogEventsOnThread, NULL);
+
+    for(int Index = 0; Index < THREAD_COUNT; ++Index)
+        pthread_join(Threads[Index], NULL);
+    double Concurrent = ElapsedNanoseconds(Start) / (EVENT_COUNT * THREAD_COUNT);
+
+    KwmStopLogger();
+    double Synchronous = LogEventsSynchronously(Directory + "/sync.log", EVENT_COUNT);
+    system(("rm -rf " + Directory).c_str());
+
+    uint64_t Written, Dropped;
+    KwmGetLogUsage(&Written, &Dropped);
+    uint64_t Logged = (uint64_t) EVENT_COUNT * (THREAD_COUNT + 1);
+
+    printf("disabled     %8.1f ns/event\n", Disabled);
+    printf("enabled      %8.1f ns/event\n", Enabled);
+    printf("%d threads    %8.1f ns/event\n", THREAD_COUNT, Concurrent);
+    printf("synchronous  %8.1f ns/event\n", Synchronous);
+    printf("records      %8llu written, %llu dropped\n", (unsigned long long) Written, (unsigned long long) Dropped);
+    return Written + Dropped == Logged ? 0 : 1;
+}
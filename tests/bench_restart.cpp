@@ -0,0 +1,119 @@
+#include "../kwm/axlib/frame.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#define internal static
+#define APPLICATION_COUNT 16
+#define WINDOWS_PER_APPLICATION 4
+#define BACKEND_LATENCY 1.0
+
+internal std::atomic<int> FramesApplied(0);
+
+internal AX_FRAME_BACKEND_SET(CountSetFrame)
+{
+    ++FramesApplied;
+    return AXFrame_Success;
+}
+
+internal AX_FRAME_BACKEND_GET(EmptyGetFrame)
+{
+    *Frame = ax_frame();
+    return AXFrame_Success;
+}
+
+internal AX_FRAME_BACKEND_RETAIN(IgnoreRetain)
+{
+}
+
+internal AX_FRAME_BACKEND_RELEASE(IgnoreRelease)
+{
+}
+
+internal AX_FRAME_BACKEND_LATENCY(IgnoreLatency)
+{
+}
+
+internal ax_frame_backend BenchBackend =
+{
+    &CountSetFrame,
+    &EmptyGetFrame,
+    &IgnoreRetain,
+    &IgnoreRelease,
+    &IgnoreLatency,
+};
+
+internal AX_QUEUE_WORK(DoNothing)
+{
+}
+
+internal double
+ElapsedMilliseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): Put every window of a restored layout back into its container, the way
+ *                    ApplyTreeNodeContainer does once the saved trees have been read. */
+internal double
+RestoreLayout(std::vector<ax_frame_target> &Targets, bool Batched)
+{
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    if(Batched)
+        AXLibBeginBatch();
+
+    for(std::size_t Index = 0; Index < Targets.size(); ++Index)
+    {
+        ax_frame Frame = { true, (double) Index * 10, 0, true, 640, 480 };
+        AXLibSubmitFrame(&Targets[Index], &Frame);
+    }
+
+    if(Batched)
+        AXLibEndBatch();
+    return ElapsedMilliseconds(Start);
+}
+
+/* NOTE(koekeishiya): 16 applications with four windows each and 1ms per AX call. The first run
+ *                    waits for every window in turn, the second runs the applications concurrently,
+ *                    and the third does the same with one application marked as degraded. */
+int main()
+{
+    AXLibSetFrameBackend(&BenchBackend);
+    AXLibSetFrameBackendLatency(BACKEND_LATENCY);
+
+    std::vector<ax_queue *> Queues;
+    std::vector<ax_frame_target> Targets;
+    for(int Application = 0; Application < APPLICATION_COUNT; ++Application)
+    {
+        Queues.push_back(AXLibCreateQueue("bench"));
+        for(int Window = 0; Window < WINDOWS_PER_APPLICATION; ++Window)
+        {
+            ax_frame_target Target = {};
+            Target.WindowID = Application * WINDOWS_PER_APPLICATION + Window + 1;
+            Target.PID = Application + 1;
+            Target.Queue = Queues.back();
+            Targets.push_back(Target);
+        }
+    }
+
+    double Sequential = RestoreLayout(Targets, false);
+    double Batched = RestoreLayout(Targets, true);
+
+    for(int Window = 0; Window < WINDOWS_PER_APPLICATION; ++Window)
+        Targets[Window].Degraded = true;
+    double Degraded = RestoreLayout(Targets, true);
+
+    for(std::size_t Index = 0; Index < Queues.size(); ++Index)
+    {
+        AXLibQueueSync(Queues[Index], &DoNothing, NULL);
+        AXLibDestroyQueue(Queues[Index]);
+    }
+
+    printf("sequential %8.1f ms for %d windows\n", Sequential, (int) Targets.size());
+    printf("batched    %8.1f ms for %d windows\n", Batched, (int) Targets.size());
+    printf("degraded   %8.1f ms for %d windows\n", Degraded, (int) Targets.size());
+    return FramesApplied == 3 * (int) Targets.size() ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "../kwm/axlib/timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+#define internal static
+#define TIMER_COUNT 100000
+
+internal double
+ElapsedNanoseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): 100k timers spread over ten minutes of 10ms ticks, which is the range the
+ *                    event loop uses. Half of them are cancelled and a quarter re-armed before
+ *                    the wheel is advanced through all of them. */
+int main()
+{
+    std::vector<ax_timer> Timers(TIMER_COUNT);
+    std::vector<uint64_t> Expiries(TIMER_COUNT);
+    srand(1);
+    for(int Index = 0; Index < TIMER_COUNT; ++Index)
+        Expiries[Index] = 1 + rand() % 60000;
+
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 0);
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < TIMER_COUNT; ++Index)
+        AXLibAddTimer(&Wheel, &Timers[Index], Expiries[Index]);
+    double Insert = ElapsedNanoseconds(Start);
+
+    Start = std::chrono::steady_clock::now();
+    for(int Index = 0; Index < TIMER_COUNT; Index += 2)
+        AXLibRemoveTimer(&Wheel, &Timers[Index]);
+    double Cancel = ElapsedNanoseconds(Start);
+
+    Start = std::chrono::steady_clock::now();
+    for(int Index = 1; Index < TIMER_COUNT; Index += 4)
+        AXLibAddTimer(&Wheel, &Timers[Index], Expiries[Index] + 100);
+    double Rearm = ElapsedNanoseconds(Start);
+
+    int Expired = 0;
+    Start = std::chrono::steady_clock::now();
+    for(uint64_t Tick = 0; Tick <= 60100; ++Tick)
+    {
+        AXLibAdvanceTimerWheel(&Wheel, Tick);
+        while(AXLibPopExpiredTimer(&Wheel))
+            ++Expired;
+    }
+    double Advance = ElapsedNanoseconds(Start);
+
+    printf("insert  %8.1f ns/timer\n", Insert / TIMER_COUNT);
+    printf("cancel  %8.1f ns/timer\n", Cancel / (TIMER_COUNT / 2));
+    printf("re-arm  %8.1f ns/timer\n", Rearm / (TIMER_COUNT / 4));
+    printf("advance %8.1f ns/tick, %d timers expired\n", Advance / 60101, Expired);
+    return Expired == TIMER_COUNT / 2 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include "../kwm/axlib/trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+#define internal static
+#define CALL_COUNT 200000
+#define RUN_COUNT 5
+#define DISABLED_OVERHEAD_LIMIT 5.0
+
+internal double Checksum;
+
+/* NOTE(koekeishiya): About as much work as the cheapest of the traced layout functions. */
+internal inline double
+SplitFrame(double Width, int Index)
+{
+    return Width * 0.5 + (Index & 7);
+}
+
+internal inline double
+TracedSplitFrame(double Width, int Index)
+{
+    AXLibTraceFunction("layout");
+    return Width * 0.5 + (Index & 7);
+}
+
+internal double
+ElapsedNanoseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): The fastest of a few runs, so that a descheduled run does not count. */
+internal double
+TimeCalls(bool Traced)
+{
+    double Best = 0;
+    for(int Run = 0; Run < RUN_COUNT; ++Run)
+    {
+        double Sum = 0;
+        std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+        for(int Index = 0; Index < CALL_COUNT; ++Index)
+            Sum += Traced ? TracedSplitFrame(1440, Index) : SplitFrame(1440, Index);
+
+        double Elapsed = ElapsedNanoseconds(Start) / CALL_COUNT;
+        Checksum += Sum;
+        if(Run == 0 || Elapsed < Best)
+            Best = Elapsed;
+    }
+
+    return Best;
+}
+
+internal std::size_t
+CountSpans(std::string File)
+{
+    std::ifstream Stream(File.c_str());
+    std::stringstream Contents;
+    Contents << Stream.rdbuf();
+
+    std::string Trace = Contents.str();
+    std::size_t Count = 0;
+    for(std::size_t Index = Trace.find("\"ph\":\"X\""); Index != std::string::npos; Index = Trace.find("\"ph\":\"X\"", Index + 1))
+        ++Count;
+
+    return Count;
+}
+
+/* NOTE(koekeishiya): A span while no trace is running must cost no more than a load and a branch,
+ *                    so the difference to the untraced function is required to stay within a few
+ *                    nanoseconds. Every span of the traced run has to show up in the export. */
+int main()
+{
+    char Template[] = "/tmp/kwm-bench-trace-XXXXXX";
+    if(!mkdtemp(Template))
+        return 1;
+
+    std::string Directory = Template;
+    double Untraced = TimeCalls(false);
+    double Disabled = TimeCalls(true);
+
+    AXLibStartTrace();
+    double Enabled = TimeCalls(true);
+    bool Stopped = AXLibStopTrace(Directory + "/trace.json");
+    std::size_t Spans = CountSpans(Directory + "/trace.json");
+    system(("rm -rf " + Directory).c_str());
+
+    printf("untraced   %8.2f ns/call\n", Untraced);
+    printf("disabled   %8.2f ns/call\n", Disabled);
+    printf("enabled    %8.2f ns/call\n", Enabled);
+    printf("spans      %8d exported (checksum %.0f)\n", (int) Spans, Checksum);
+    return Stopped && Spans == RUN_COUNT * CALL_COUNT &&
+           Disabled - Untraced < DISABLED_OVERHEAD_LIMIT ? 0 : 1;
+}
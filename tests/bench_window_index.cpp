@@ -0,0 +1,73 @@
+#include "../kwm/axlib/windowindex.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#define internal static
+#define APPLICATION_COUNT 80
+#define WINDOWS_PER_APPLICATION 4
+#define LOOKUP_COUNT 1000000
+
+struct ax_window
+{
+    uint32_t ID;
+};
+
+internal double
+ElapsedNanoseconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/* NOTE(koekeishiya): What GetWindowByID used to do: probe the window map of every application. */
+internal ax_window *
+ScanApplications(std::vector<std::map<uint32_t, ax_window *> > &Applications, uint32_t WID)
+{
+    for(std::size_t Index = 0; Index < Applications.size(); ++Index)
+    {
+        std::map<uint32_t, ax_window *>::iterator It = Applications[Index].find(WID);
+        if(It != Applications[Index].end())
+            return It->second;
+    }
+
+    return NULL;
+}
+
+/* NOTE(koekeishiya): 80 applications with four windows each; every lookup is for a random window. */
+int main()
+{
+    std::vector<ax_window> Windows(APPLICATION_COUNT * WINDOWS_PER_APPLICATION);
+    std::vector<std::map<uint32_t, ax_window *> > Applications(APPLICATION_COUNT);
+    ax_window_index Index;
+    AXLibInitWindowIndex(&Index);
+
+    for(std::size_t Window = 0; Window < Windows.size(); ++Window)
+    {
+        Windows[Window].ID = 100 + Window * 7;
+        Applications[Window / WINDOWS_PER_APPLICATION][Windows[Window].ID] = &Windows[Window];
+        AXLibInsertWindow(&Index, Windows[Window].ID, &Windows[Window]);
+    }
+
+    std::vector<uint32_t> Lookups(LOOKUP_COUNT);
+    srand(1);
+    for(int Lookup = 0; Lookup < LOOKUP_COUNT; ++Lookup)
+        Lookups[Lookup] = Windows[rand() % Windows.size()].ID;
+
+    int Mismatches = 0;
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    for(int Lookup = 0; Lookup < LOOKUP_COUNT; ++Lookup)
+        Mismatches += ScanApplications(Applications, Lookups[Lookup])->ID != Lookups[Lookup];
+    double Scan = ElapsedNanoseconds(Start);
+
+    Start = std::chrono::steady_clock::now();
+    for(int Lookup = 0; Lookup < LOOKUP_COUNT; ++Lookup)
+        Mismatches += AXLibLookupWindow(&Index, Lookups[Lookup])->ID != Lookups[Lookup];
+    double Indexed = ElapsedNanoseconds(Start);
+
+    printf("scan    %8.1f ns/lookup over %d applications\n", Scan / LOOKUP_COUNT, APPLICATION_COUNT);
+    printf("index   %8.1f ns/lookup\n", Indexed / LOOKUP_COUNT);
+    return Mismatches == 0 ? 0 : 1;
+}
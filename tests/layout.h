@@ -0,0 +1,79 @@
+#ifndef KWM_TEST_LAYOUT_H
+#define KWM_TEST_LAYOUT_H
+
+#include "../kwm/treenode.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* NOTE(koekeishiya): Builds trees the way kwm does without a display, for the layout history. */
+inline tree_node *
+CreateTestNode(tree_node *Parent, uint32_t WindowID)
+{
+    tree_node *Node = (tree_node *) malloc(sizeof(tree_node));
+    memset(Node, 0, sizeof(tree_node));
+    Node->Parent = Parent;
+    Node->WindowID = WindowID;
+    Node->SplitMode = SPLIT_VERTICAL;
+    Node->SplitRatio = 0.5;
+    return Node;
+}
+
+/* NOTE(koekeishiya): Splits the leaf that holds the window into a pair with the new window. */
+inline void
+SplitTestNode(tree_node *Leaf, uint32_t WindowID)
+{
+    Leaf->LeftChild = CreateTestNode(Leaf, Leaf->WindowID);
+    Leaf->RightChild = CreateTestNode(Leaf, WindowID);
+    Leaf->WindowID = 0;
+}
+
+/* NOTE(koekeishiya): A tree where every new window splits the rightmost leaf. */
+inline tree_node *
+CreateTestTree(uint32_t WindowCount)
+{
+    tree_node *Root = CreateTestNode(NULL, 1);
+    tree_node *Leaf = Root;
+    for(uint32_t WindowID = 2; WindowID <= WindowCount; ++WindowID)
+    {
+        SplitTestNode(Leaf, WindowID);
+        Leaf = Leaf->RightChild;
+    }
+
+    return Root;
+}
+
+inline tree_node *
+GetTestLeaf(tree_node *Node, uint32_t WindowID)
+{
+    if(!Node)
+        return NULL;
+
+    if(!Node->LeftChild && Node->WindowID == WindowID)
+        return Node;
+
+    tree_node *Result = GetTestLeaf(Node->LeftChild, WindowID);
+    return Result ? Result : GetTestLeaf(Node->RightChild, WindowID);
+}
+
+inline void
+DestroyTestTree(tree_node *Node)
+{
+    if(Node)
+    {
+        DestroyTestTree(Node->LeftChild);
+        DestroyTestTree(Node->RightChild);
+
+        link_node *Link = Node->List;
+        while(Link)
+        {
+            link_node *Next = Link->Next;
+            free(Link);
+            Link = Next;
+        }
+
+        free(Node);
+    }
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef KWM_TEST_H
+#define KWM_TEST_H
+
+#include <stdio.h>
+#include <vector>
+
+/*
+ * NOTE(koekeishiya):
+ *        A minimal test harness for the parts of kwm that do not depend on macOS. Every
+ *        TEST registers itself before main runs, and RunTests executes them in order and
+ *        returns a non-zero exit code if any EXPECT failed.
+ * */
+
+#define internal static
+
+typedef void (test_function)(bool *Failed);
+
+struct kwm_test
+{
+    const char *Name;
+    test_function *Function;
+};
+
+inline std::vector<kwm_test> &
+KwmTests()
+{
+    static std::vector<kwm_test> Tests;
+    return Tests;
+}
+
+struct kwm_test_registration
+{
+    kwm_test_registration(const char *Name, test_function *Function)
+    {
+        kwm_test Test = { Name, Function };
+        KwmTests().push_back(Test);
+    }
+};
+
+#define TEST(Name) \
+    internal void Test_##Name(bool *Failed); \
+    internal kwm_test_registration Registration_##Name(#Name, &Test_##Name); \
+    internal void Test_##Name(bool *Failed)
+
+#define EXPECT(Condition) \
+    do { if(!(Condition)) { \
+             printf("    %s:%d: EXPECT(%s) failed\n", __FILE__, __LINE__, #Condition); \
+             *Failed = true; \
+         } \
+       } while(0)
+
+inline int
+RunTests()
+{
+    int Failures = 0;
+    std::vector<kwm_test> &Tests = KwmTests();
+    for(std::size_t Index = 0; Index < Tests.size(); ++Index)
+    {
+        bool Failed = false;
+        Tests[Index].Function(&Failed);
+        printf("%s %s\n", Failed ? "FAIL" : "ok  ", Tests[Index].Name);
+        if(Failed)
+            ++Failures;
+    }
+
+    printf("%d/%d passed\n", (int) (Tests.size() - Failures), (int) Tests.size());
+    return Failures == 0 ? 0 : 1;
+}
+
+#endif
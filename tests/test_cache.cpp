@@ -0,0 +1,225 @@
+#include "../kwm/cache.h"
+#include "test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+internal std::string TestDirectory;
+
+internal void
+WriteTestFile(std::string File, std::string Contents)
+{
+    FILE *Handle = fopen(File.c_str(), "wb");
+    fwrite(Contents.data(), Contents.size(), 1, Handle);
+    fclose(Handle);
+}
+
+internal std::string
+ReadTestFile(std::string File)
+{
+    std::string Contents;
+    FILE *Handle = fopen(File.c_str(), "rb");
+    char Buffer[4096];
+    std::size_t Bytes;
+    while((Bytes = fread(Buffer, 1, sizeof(Buffer), Handle)) > 0)
+        Contents.append(Buffer, Bytes);
+
+    fclose(Handle);
+    return Contents;
+}
+
+internal config_statement
+Statement(config_statement_type Type, std::string Text, std::string Argument)
+{
+    config_statement Result = {};
+    Result.Type = Type;
+    Result.Flags = ConfigFlag_Passthrough;
+    Result.Enabled = true;
+    Result.Mode = SpaceModeMonocle;
+    Result.Display = 1;
+    Result.Space = 3;
+    Result.Values[0] = 0.25;
+    Result.Values[3] = 40;
+    Result.Color = 0xffaabbcc;
+    Result.Text = Text;
+    Result.Argument = Argument;
+    return Result;
+}
+
+/* NOTE(koekeishiya): A kwmrc with one include, compiled to three statements, and hashed the
+                      way KwmCompileConfig hashes the files it reads. */
+internal kwm_config
+CompiledConfig(std::string *File)
+{
+    *File = TestDirectory + "/kwmrc";
+    std::string Include = TestDirectory + "/binds";
+    WriteTestFile(*File, "kwmc config tiling monocle\ninclude binds\n");
+    WriteTestFile(Include, "kwmc bindsym cmd-h window -f west\n");
+
+    kwm_config Config = {};
+    Config.Files.push_back(*File);
+    Config.Files.push_back(Include);
+    Config.Hash = KWM_CONFIG_HASH_SEED;
+    for(std::size_t Index = 0; Index < Config.Files.size(); ++Index)
+    {
+        char *Contents;
+        Config.Hash = KwmHashConfigFile(Config.Hash, Config.Files[Index], &Contents);
+        free(Contents);
+    }
+
+    Config.Statements.push_back(Statement(Config_Tiling, "", ""));
+    Config.Statements.push_back(Statement(Config_Bind, "cmd-h", "window -f west"));
+    Config.Statements.push_back(Statement(Config_Rule, "owner=\"Finder\"", std::string("a\0b", 3)));
+    return Config;
+}
+
+internal bool
+SameStatement(config_statement *A, config_statement *B)
+{
+    return A->Type == B->Type && A->Flags == B->Flags && A->Enabled == B->Enabled &&
+           A->Mode == B->Mode && A->Display == B->Display && A->Space == B->Space &&
+           memcmp(A->Values, B->Values, sizeof(A->Values)) == 0 && A->Color == B->Color &&
+           A->Text == B->Text && A->Argument == B->Argument;
+}
+
+internal bool
+IsCleared(kwm_config *Config)
+{
+    return Config->Statements.empty() && Config->Files.empty() && Config->Hash == 0;
+}
+
+/* NOTE(koekeishiya): Where the file count is stored: magic, version, file, include and hash. */
+internal std::size_t
+FileCountOffset(std::string File, std::string Include)
+{
+    return 2 * sizeof(uint32_t) + sizeof(uint32_t) + File.size() + sizeof(uint32_t) + Include.size() + sizeof(uint64_t);
+}
+
+internal void
+OverwriteCount(std::string Cache, std::size_t Offset, uint32_t Count)
+{
+    std::string Contents = ReadTestFile(Cache);
+    memcpy(&Contents[Offset], &Count, sizeof(Count));
+    WriteTestFile(Cache, Contents);
+}
+
+TEST(RoundTrip)
+{
+    std::string File, Cache = TestDirectory + "/cache";
+    kwm_config Saved = CompiledConfig(&File);
+    KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+    EXPECT(access((Cache + ".tmp").c_str(), F_OK) == -1);
+
+    kwm_config Loaded = {};
+    EXPECT(KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+    EXPECT(Loaded.Hash == Saved.Hash);
+    EXPECT(Loaded.Files == Saved.Files);
+    EXPECT(Loaded.Statements.size() == Saved.Statements.size());
+    for(std::size_t Index = 0; Index < Loaded.Statements.size(); ++Index)
+        EXPECT(SameStatement(&Loaded.Statements[Index], &Saved.Statements[Index]));
+}
+
+TEST(RejectsOtherConfigOrIncludeDirectory)
+{
+    std::string File, Cache = TestDirectory + "/cache";
+    kwm_config Saved = CompiledConfig(&File);
+    KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+
+    kwm_config Loaded = {};
+    EXPECT(!KwmLoadConfigCache(Cache, File + "2", TestDirectory, &Loaded));
+    EXPECT(!KwmLoadConfigCache(Cache, File, TestDirectory + "/other", &Loaded));
+    EXPECT(!KwmLoadConfigCache(TestDirectory + "/missing", File, TestDirectory, &Loaded));
+    EXPECT(IsCleared(&Loaded));
+}
+
+TEST(RejectsChangedInclude)
+{
+    std::string File, Cache = TestDirectory + "/cache";
+    kwm_config Saved = CompiledConfig(&File);
+    KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+
+    WriteTestFile(Saved.Files[1], "kwmc bindsym cmd-l window -f east\n");
+    kwm_config Loaded = {};
+    EXPECT(!KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+    EXPECT(IsCleared(&Loaded));
+
+    unlink(Saved.Files[1].c_str());
+    EXPECT(!KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+}
+
+TEST(RejectsEveryTruncation)
+{
+    std::string File, Cache = TestDirectory + "/cache";
+    kwm_config Saved = CompiledConfig(&File);
+    KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+    std::string Contents = ReadTestFile(Cache);
+
+    std::string Truncated = TestDirectory + "/truncated";
+    for(std::size_t Size = 0; Size < Contents.size(); ++Size)
+    {
+        WriteTestFile(Truncated, Contents.substr(0, Size));
+        kwm_config Loaded = {};
+        EXPECT(!KwmLoadConfigCache(Truncated, File, TestDirectory, &Loaded));
+        EXPECT(IsCleared(&Loaded));
+    }
+
+    WriteTestFile(Truncated, Contents + "x");
+    kwm_config Loaded = {};
+    EXPECT(!KwmLoadConfigCache(Truncated, File, TestDirectory, &Loaded));
+}
+
+TEST(RejectsCorruptCounts)
+{
+    std::string File, Cache = TestDirectory + "/cache";
+    kwm_config Saved = CompiledConfig(&File);
+    std::size_t FileCount = FileCountOffset(File, TestDirectory);
+    std::size_t StatementCount = FileCount + sizeof(uint32_t);
+    for(std::size_t Index = 0; Index < Saved.Files.size(); ++Index)
+        StatementCount += sizeof(uint32_t) + Saved.Files[Index].size();
+
+    uint32_t Counts[] = { 0, 1, 4, 1000, 0x7fffffff, 0xffffffff };
+    for(std::size_t Index = 0; Index < sizeof(Counts) / sizeof(Counts[0]); ++Index)
+    {
+        kwm_config Loaded = {};
+        KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+        OverwriteCount(Cache, FileCount, Counts[Index]);
+        EXPECT(!KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+        EXPECT(IsCleared(&Loaded));
+
+        KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+        OverwriteCount(Cache, StatementCount, Counts[Index]);
+        EXPECT(!KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+        EXPECT(IsCleared(&Loaded));
+    }
+
+    /* NOTE(koekeishiya): The unmodified counts are still accepted. */
+    kwm_config Loaded = {};
+    KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+    OverwriteCount(Cache, StatementCount, Saved.Statements.size());
+    EXPECT(KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+}
+
+TEST(RejectsUnknownStatementType)
+{
+    std::string File, Cache = TestDirectory + "/cache";
+    kwm_config Saved = CompiledConfig(&File);
+    Saved.Statements[0].Type = (config_statement_type) (Config_LayoutsPath + 1);
+    KwmSaveConfigCache(Cache, File, TestDirectory, &Saved);
+
+    kwm_config Loaded = {};
+    EXPECT(!KwmLoadConfigCache(Cache, File, TestDirectory, &Loaded));
+    EXPECT(IsCleared(&Loaded));
+}
+
+int main()
+{
+    char Template[] = "/tmp/kwm-test-cache-XXXXXX";
+    if(!mkdtemp(Template))
+        return 1;
+
+    TestDirectory = Template;
+    int Result = RunTests();
+    system(("rm -rf " + TestDirectory).c_str());
+    return Result;
+}
@@ -0,0 +1,207 @@
+#include "../kwm/configdiff.h"
+#include "test.h"
+
+internal config_statement
+Statement(config_statement_type Type, double Value = 0, std::string Text = "")
+{
+    config_statement Result = {};
+    Result.Type = Type;
+    Result.Values[0] = Value;
+    Result.Text = Text;
+    return Result;
+}
+
+/* NOTE(koekeishiya): One statement from every section, plus an exec line. */
+internal kwm_config
+BaseConfig()
+{
+    kwm_config Config = {};
+    Config.Statements.push_back(Statement(Config_Tiling));
+    Config.Statements.push_back(Statement(Config_Gap, 10));
+    Config.Statements.push_back(Statement(Config_SpaceName, 0, "code"));
+    Config.Statements.push_back(Statement(Config_SplitRatio, 0.5));
+    Config.Statements.push_back(Statement(Config_Bind, 0, "cmd-h"));
+    Config.Statements.push_back(Statement(Config_ModeTimeout, 1, "swap"));
+    Config.Statements.push_back(Statement(Config_Rule, 0, "owner=\"Finder\""));
+    Config.Statements.push_back(Statement(Config_Exec, 0, "open -a Terminal"));
+    return Config;
+}
+
+struct section_changes
+{
+    bool Space, Binding, Rule, Global;
+};
+
+internal section_changes
+ChangedSections(kwm_config *Old, kwm_config *New)
+{
+    section_changes Changes;
+    Changes.Space = KwmConfigSectionChanged(Old, New, KwmIsSpaceStatement);
+    Changes.Binding = KwmConfigSectionChanged(Old, New, KwmIsBindingStatement);
+    Changes.Rule = KwmConfigSectionChanged(Old, New, KwmIsRuleStatement);
+    Changes.Global = KwmConfigSectionChanged(Old, New, KwmIsGlobalStatement);
+    return Changes;
+}
+
+internal bool
+OnlyChanged(kwm_config *Old, kwm_config *New, config_section Section)
+{
+    section_changes Changes = ChangedSections(Old, New);
+    return Changes.Space == (Section == KwmIsSpaceStatement) &&
+           Changes.Binding == (Section == KwmIsBindingStatement) &&
+           Changes.Rule == (Section == KwmIsRuleStatement) &&
+           Changes.Global == (Section == KwmIsGlobalStatement);
+}
+
+internal void
+RemoveStatement(kwm_config *Config, config_statement_type Type)
+{
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        if(Config->Statements[Index].Type == Type)
+        {
+            Config->Statements.erase(Config->Statements.begin() + Index);
+            return;
+        }
+    }
+}
+
+internal config_statement *
+FindStatement(kwm_config *Config, config_statement_type Type)
+{
+    for(std::size_t Index = 0; Index < Config->Statements.size(); ++Index)
+    {
+        if(Config->Statements[Index].Type == Type)
+            return &Config->Statements[Index];
+    }
+
+    return NULL;
+}
+
+TEST(UnchangedConfig)
+{
+    kwm_config Old = BaseConfig(), New = BaseConfig();
+    EXPECT(OnlyChanged(&Old, &New, NULL));
+    EXPECT(KwmNewConfigExecs(&Old, &New).empty());
+}
+
+TEST(FirstConfigAppliesEverySection)
+{
+    kwm_config Empty = {}, New = BaseConfig();
+    section_changes Changes = ChangedSections(&Empty, &New);
+    EXPECT(Changes.Space && Changes.Binding && Changes.Rule && Changes.Global);
+    EXPECT(KwmNewConfigExecs(&Empty, &New).size() == 1);
+}
+
+TEST(SpaceSection)
+{
+    kwm_config Old = BaseConfig();
+
+    kwm_config Added = BaseConfig();
+    Added.Statements.push_back(Statement(Config_Padding, 20));
+    EXPECT(OnlyChanged(&Old, &Added, KwmIsSpaceStatement));
+
+    kwm_config Removed = BaseConfig();
+    RemoveStatement(&Removed, Config_Gap);
+    EXPECT(OnlyChanged(&Old, &Removed, KwmIsSpaceStatement));
+
+    kwm_config Modified = BaseConfig();
+    FindStatement(&Modified, Config_SpaceName)->Text = "web";
+    EXPECT(OnlyChanged(&Old, &Modified, KwmIsSpaceStatement));
+}
+
+TEST(BindingSection)
+{
+    kwm_config Old = BaseConfig();
+
+    kwm_config Added = BaseConfig();
+    Added.Statements.push_back(Statement(Config_Bind, 0, "cmd-l"));
+    EXPECT(OnlyChanged(&Old, &Added, KwmIsBindingStatement));
+
+    kwm_config Removed = BaseConfig();
+    RemoveStatement(&Removed, Config_ModeTimeout);
+    EXPECT(OnlyChanged(&Old, &Removed, KwmIsBindingStatement));
+
+    kwm_config Modified = BaseConfig();
+    FindStatement(&Modified, Config_Bind)->Argument = "window -f west";
+    EXPECT(OnlyChanged(&Old, &Modified, KwmIsBindingStatement));
+}
+
+TEST(RuleSection)
+{
+    kwm_config Old = BaseConfig();
+
+    kwm_config Added = BaseConfig();
+    Added.Statements.push_back(Statement(Config_Rule, 0, "owner=\"Safari\""));
+    EXPECT(OnlyChanged(&Old, &Added, KwmIsRuleStatement));
+
+    kwm_config Removed = BaseConfig();
+    RemoveStatement(&Removed, Config_Rule);
+    EXPECT(OnlyChanged(&Old, &Removed, KwmIsRuleStatement));
+
+    kwm_config Modified = BaseConfig();
+    FindStatement(&Modified, Config_Rule)->Text = "owner=\"Mail\"";
+    EXPECT(OnlyChanged(&Old, &Modified, KwmIsRuleStatement));
+}
+
+TEST(GlobalSection)
+{
+    kwm_config Old = BaseConfig();
+
+    kwm_config Added = BaseConfig();
+    Added.Statements.push_back(Statement(Config_OptimalRatio, 1.5));
+    EXPECT(OnlyChanged(&Old, &Added, KwmIsGlobalStatement));
+
+    kwm_config Removed = BaseConfig();
+    RemoveStatement(&Removed, Config_Tiling);
+    EXPECT(OnlyChanged(&Old, &Removed, KwmIsGlobalStatement));
+
+    kwm_config Modified = BaseConfig();
+    FindStatement(&Modified, Config_SplitRatio)->Values[0] = 0.6;
+    EXPECT(OnlyChanged(&Old, &Modified, KwmIsGlobalStatement));
+}
+
+TEST(FocusedBorderColorIsGlobalAndBinding)
+{
+    kwm_config Old = BaseConfig(), New = BaseConfig();
+    config_statement Color = Statement(Config_BorderColor);
+    Color.Color = 0xffaabbcc;
+    New.Statements.push_back(Color);
+
+    section_changes Changes = ChangedSections(&Old, &New);
+    EXPECT(Changes.Global && Changes.Binding && !Changes.Space && !Changes.Rule);
+
+    Color.Flags = ConfigFlag_MarkedBorder;
+    New.Statements.back() = Color;
+    EXPECT(OnlyChanged(&Old, &New, KwmIsGlobalStatement));
+}
+
+TEST(ExecOnlyRunsNewLines)
+{
+    kwm_config Old = BaseConfig(), New = BaseConfig();
+    New.Statements.push_back(Statement(Config_Exec, 0, "open -a Mail"));
+
+    std::vector<std::string> Commands = KwmNewConfigExecs(&Old, &New);
+    EXPECT(Commands.size() == 1 && Commands[0] == "open -a Mail");
+    EXPECT(OnlyChanged(&Old, &New, NULL));
+
+    RemoveStatement(&New, Config_Exec);
+    EXPECT(KwmNewConfigExecs(&Old, &New).size() == 1);
+    EXPECT(KwmNewConfigExecs(&New, &Old).size() == 1);
+}
+
+TEST(ExecCountsDuplicates)
+{
+    kwm_config Old = BaseConfig(), New = BaseConfig();
+    New.Statements.push_back(Statement(Config_Exec, 0, "open -a Terminal"));
+    New.Statements.push_back(Statement(Config_Exec, 0, "open -a Terminal"));
+
+    std::vector<std::string> Commands = KwmNewConfigExecs(&Old, &New);
+    EXPECT(Commands.size() == 2);
+    EXPECT(KwmNewConfigExecs(&New, &Old).empty());
+}
+
+int main()
+{
+    return RunTests();
+}
@@ -0,0 +1,404 @@
+#include "../kwm/axlib/frame.h"
+#include "test.h"
+
+#include <pthread.h>
+#include <chrono>
+#include <vector>
+
+/* NOTE(koekeishiya): A window of the fake backend. Ref of an ax_frame_target points to one of these. */
+struct fake_window
+{
+    ax_frame Current;
+    std::vector<ax_frame> Applied;
+    ax_frame_result Result;
+    int References;
+};
+
+struct fake_latency
+{
+    void *Owner;
+    int PID;
+    ax_frame_result Result;
+    bool Queued;
+};
+
+internal pthread_mutex_t FakeLock = PTHREAD_MUTEX_INITIALIZER;
+internal std::vector<fake_latency> FakeLatencies;
+
+internal AX_FRAME_BACKEND_SET(FakeSetFrame)
+{
+    fake_window *Window = (fake_window *) Ref;
+    pthread_mutex_lock(&FakeLock);
+    if(Window->Result == AXFrame_Success)
+    {
+        if(Frame->HasPosition)
+        {
+            Window->Current.X = Frame->X;
+            Window->Current.Y = Frame->Y;
+        }
+
+        if(Frame->HasSize)
+        {
+            Window->Current.Width = Frame->Width;
+            Window->Current.Height = Frame->Height;
+        }
+
+        Window->Applied.push_back(*Frame);
+    }
+    pthread_mutex_unlock(&FakeLock);
+    return Window->Result;
+}
+
+internal AX_FRAME_BACKEND_GET(FakeGetFrame)
+{
+    fake_window *Window = (fake_window *) Ref;
+    pthread_mutex_lock(&FakeLock);
+    *Frame = Window->Current;
+    Frame->HasPosition = true;
+    Frame->HasSize = true;
+    pthread_mutex_unlock(&FakeLock);
+    return AXFrame_Success;
+}
+
+internal AX_FRAME_BACKEND_RETAIN(FakeRetain)
+{
+    pthread_mutex_lock(&FakeLock);
+    ++((fake_window *) Ref)->References;
+    pthread_mutex_unlock(&FakeLock);
+}
+
+internal AX_FRAME_BACKEND_RELEASE(FakeRelease)
+{
+    pthread_mutex_lock(&FakeLock);
+    --((fake_window *) Ref)->References;
+    pthread_mutex_unlock(&FakeLock);
+}
+
+internal AX_FRAME_BACKEND_LATENCY(FakeRecordLatency)
+{
+    fake_latency Latency = { Owner, PID, Result, Queued };
+    pthread_mutex_lock(&FakeLock);
+    FakeLatencies.push_back(Latency);
+    pthread_mutex_unlock(&FakeLock);
+}
+
+internal ax_frame_backend FakeBackend =
+{
+    &FakeSetFrame,
+    &FakeGetFrame,
+    &FakeRetain,
+    &FakeRelease,
+    &FakeRecordLatency,
+};
+
+internal void
+ResetFakeBackend(double Latency)
+{
+    AXLibSetFrameBackend(&FakeBackend);
+    AXLibSetFrameBackendLatency(Latency);
+    FakeLatencies.clear();
+}
+
+internal ax_frame_target
+FakeTarget(fake_window *Window, uint32_t WindowID, ax_queue *Queue)
+{
+    ax_frame_target Target = {};
+    Target.Ref = Window;
+    Target.WindowID = WindowID;
+    Target.Owner = Window;
+    Target.PID = (int) WindowID;
+    Target.Queue = Queue;
+    return Target;
+}
+
+internal ax_frame
+PositionFrame(double X, double Y)
+{
+    ax_frame Frame = {};
+    Frame.HasPosition = true;
+    Frame.X = X;
+    Frame.Y = Y;
+    return Frame;
+}
+
+internal ax_frame
+SizeFrame(double Width, double Height)
+{
+    ax_frame Frame = {};
+    Frame.HasSize = true;
+    Frame.Width = Width;
+    Frame.Height = Height;
+    return Frame;
+}
+
+internal double
+MillisecondsSince(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count();
+}
+
+internal AX_QUEUE_WORK(DoNothing)
+{
+}
+
+/* NOTE(koekeishiya): Returns once everything queued on Queue so far has run. */
+internal void
+DrainQueue(ax_queue *Queue)
+{
+    AXLibQueueSync(Queue, &DoNothing, NULL);
+}
+
+struct read_result
+{
+    bool Called;
+    pthread_t Thread;
+    ax_frame Frame;
+    ax_frame_result Result;
+};
+
+internal AX_FRAME_CALLBACK(StoreReadResult)
+{
+    read_result *Read = (read_result *) Context;
+    Read->Called = true;
+    Read->Thread = pthread_self();
+    Read->Frame = *Frame;
+    Read->Result = Result;
+}
+
+TEST(SyncUpdateReportsResultAndLatency)
+{
+    ResetFakeBackend(0);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+
+    ax_frame Frame = PositionFrame(10, 20);
+    EXPECT(AXLibSubmitFrame(&Target, &Frame));
+    EXPECT(Window.Current.X == 10 && Window.Current.Y == 20);
+    EXPECT(FakeLatencies.size() == 1);
+    EXPECT(FakeLatencies[0].Owner == &Window && !FakeLatencies[0].Queued);
+
+    Window.Result = AXFrame_TimedOut;
+    EXPECT(!AXLibSubmitFrame(&Target, &Frame));
+    EXPECT(FakeLatencies.size() == 2);
+    EXPECT(FakeLatencies[1].Result == AXFrame_TimedOut);
+    EXPECT(Window.References == 0);
+
+    AXLibDestroyQueue(Queue);
+}
+
+TEST(BatchPreservesOrderPerWindow)
+{
+    ResetFakeBackend(0);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+
+    AXLibBeginBatch();
+    for(int Index = 0; Index < 100; ++Index)
+    {
+        ax_frame Frame = PositionFrame(Index, Index);
+        EXPECT(AXLibSubmitFrame(&Target, &Frame));
+    }
+    AXLibEndBatch();
+
+    EXPECT(Window.Applied.size() == 100);
+    for(std::size_t Index = 0; Index < Window.Applied.size(); ++Index)
+        EXPECT(Window.Applied[Index].X == Index);
+
+    EXPECT(Window.References == 0);
+    EXPECT(FakeLatencies.size() == 100 && FakeLatencies[0].Queued && !FakeLatencies[0].Owner);
+    AXLibDestroyQueue(Queue);
+}
+
+TEST(BatchRunsApplicationQueuesConcurrently)
+{
+    ResetFakeBackend(50);
+    ax_queue *Queues[4];
+    fake_window Windows[4] = {};
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    AXLibBeginBatch();
+    for(int Index = 0; Index < 4; ++Index)
+    {
+        Queues[Index] = AXLibCreateQueue("test");
+        ax_frame_target Target = FakeTarget(&Windows[Index], Index + 1, Queues[Index]);
+        ax_frame Frame = SizeFrame(100, 100);
+        AXLibSubmitFrame(&Target, &Frame);
+    }
+    double Submitted = MillisecondsSince(Start);
+    AXLibEndBatch();
+    double Ended = MillisecondsSince(Start);
+
+    EXPECT(Submitted < 25);
+    EXPECT(Ended >= 50 && Ended < 150);
+    for(int Index = 0; Index < 4; ++Index)
+    {
+        EXPECT(Windows[Index].Applied.size() == 1);
+        AXLibDestroyQueue(Queues[Index]);
+    }
+}
+
+TEST(ReadInsideBatchCompletesOnEndingThread)
+{
+    ResetFakeBackend(5);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+    read_result Read = {};
+
+    AXLibBeginBatch();
+    AXLibBeginBatch();
+    ax_frame Position = PositionFrame(30, 40);
+    ax_frame Size = SizeFrame(300, 400);
+    AXLibSubmitFrame(&Target, &Position);
+    AXLibSubmitFrame(&Target, &Size);
+    AXLibReadFrame(&Target, &StoreReadResult, &Read);
+    AXLibEndBatch();
+    EXPECT(!Read.Called);
+    AXLibEndBatch();
+
+    EXPECT(Read.Called);
+    EXPECT(pthread_equal(Read.Thread, pthread_self()));
+    EXPECT(Read.Result == AXFrame_Success);
+    EXPECT(Read.Frame.X == 30 && Read.Frame.Y == 40);
+    EXPECT(Read.Frame.Width == 300 && Read.Frame.Height == 400);
+    EXPECT(Window.References == 0);
+    AXLibDestroyQueue(Queue);
+}
+
+TEST(ReadOutsideBatchCompletesImmediately)
+{
+    ResetFakeBackend(0);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    Window.Current = PositionFrame(5, 6);
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+    read_result Read = {};
+
+    AXLibReadFrame(&Target, &StoreReadResult, &Read);
+    EXPECT(Read.Called);
+    EXPECT(Read.Frame.X == 5 && Read.Frame.Y == 6);
+    EXPECT(Window.References == 0);
+    AXLibDestroyQueue(Queue);
+}
+
+internal pthread_mutex_t GateLock = PTHREAD_MUTEX_INITIALIZER;
+
+internal AX_QUEUE_WORK(WaitForGate)
+{
+    pthread_mutex_lock(&GateLock);
+    pthread_mutex_unlock(&GateLock);
+}
+
+TEST(DegradedUpdatesAreCoalesced)
+{
+    ResetFakeBackend(0);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+    Target.Degraded = true;
+
+    pthread_mutex_lock(&GateLock);
+    AXLibQueueDetached(Queue, &WaitForGate, NULL);
+
+    ax_frame First = PositionFrame(1, 1);
+    ax_frame Second = SizeFrame(200, 200);
+    ax_frame Third = PositionFrame(3, 3);
+    EXPECT(AXLibSubmitFrame(&Target, &First));
+    EXPECT(AXLibSubmitFrame(&Target, &Second));
+    EXPECT(AXLibSubmitFrame(&Target, &Third));
+    EXPECT(Window.Applied.empty());
+
+    pthread_mutex_unlock(&GateLock);
+    DrainQueue(Queue);
+
+    EXPECT(Window.Applied.size() == 2);
+    EXPECT(Window.Applied[0].HasSize && !Window.Applied[0].HasPosition);
+    EXPECT(Window.Applied[1].HasPosition && !Window.Applied[1].HasSize);
+    EXPECT(Window.Current.X == 3 && Window.Current.Y == 3);
+    EXPECT(Window.Current.Width == 200 && Window.Current.Height == 200);
+    EXPECT(FakeLatencies.size() == 1 && FakeLatencies[0].Queued && FakeLatencies[0].PID == 1);
+    EXPECT(Window.References == 0);
+    AXLibDestroyQueue(Queue);
+}
+
+TEST(DegradedMoveThenResizeIsOneUpdate)
+{
+    ResetFakeBackend(0);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+    Target.Degraded = true;
+
+    pthread_mutex_lock(&GateLock);
+    AXLibQueueDetached(Queue, &WaitForGate, NULL);
+
+    ax_frame First = SizeFrame(100, 100);
+    ax_frame Second = PositionFrame(4, 4);
+    ax_frame Third = SizeFrame(300, 300);
+    EXPECT(AXLibSubmitFrame(&Target, &First));
+    EXPECT(AXLibSubmitFrame(&Target, &Second));
+    EXPECT(AXLibSubmitFrame(&Target, &Third));
+
+    pthread_mutex_unlock(&GateLock);
+    DrainQueue(Queue);
+
+    EXPECT(Window.Applied.size() == 1);
+    EXPECT(Window.Applied[0].HasPosition && Window.Applied[0].HasSize);
+    EXPECT(Window.Current.X == 4 && Window.Current.Width == 300);
+    EXPECT(Window.References == 0);
+    AXLibDestroyQueue(Queue);
+}
+
+TEST(DegradedUpdatesDoNotWaitForTheBackend)
+{
+    ResetFakeBackend(50);
+    ax_queue *Queue = AXLibCreateQueue("test");
+    fake_window Window = {};
+    ax_frame_target Target = FakeTarget(&Window, 1, Queue);
+    Target.Degraded = true;
+
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    ax_frame Frame = PositionFrame(7, 7);
+    AXLibBeginBatch();
+    EXPECT(AXLibSubmitFrame(&Target, &Frame));
+    AXLibEndBatch();
+    EXPECT(MillisecondsSince(Start) < 25);
+
+    DrainQueue(Queue);
+    EXPECT(Window.Current.X == 7);
+    AXLibDestroyQueue(Queue);
+}
+
+struct nested_sync
+{
+    ax_queue *Queue;
+    bool Ran;
+};
+
+internal AX_QUEUE_WORK(MarkRan)
+{
+    *(bool *) Context = true;
+}
+
+internal AX_QUEUE_WORK(SyncOnOwnQueue)
+{
+    nested_sync *Nested = (nested_sync *) Context;
+    AXLibQueueSync(Nested->Queue, &MarkRan, &Nested->Ran);
+}
+
+TEST(SyncFromOwnQueueRunsInline)
+{
+    ax_queue *Queue = AXLibCreateQueue("test");
+    nested_sync Nested = { Queue, false };
+    AXLibQueueSync(Queue, &SyncOnOwnQueue, &Nested);
+    EXPECT(Nested.Ran);
+    EXPECT(!AXLibIsOnQueue(Queue));
+    AXLibDestroyQueue(Queue);
+}
+
+int main()
+{
+    return RunTests();
+}
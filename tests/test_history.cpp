@@ -0,0 +1,167 @@
+#include "../kwm/history.h"
+#include "layout.h"
+#include "test.h"
+
+#include <pthread.h>
+
+internal std::string
+UniqueSpace()
+{
+    static int Count = 0;
+    return "space-" + std::to_string(++Count);
+}
+
+internal uint64_t
+VersionCount()
+{
+    uint64_t Versions, Nodes;
+    GetLayoutHistoryUsage(&Versions, &Nodes);
+    return Versions;
+}
+
+/* NOTE(koekeishiya): Steps the history the way StepWindowNodeTree does, replacing the live tree. */
+internal bool
+Step(std::string Space, tree_node **Live, int Step)
+{
+    space_tiling_option Mode = SpaceModeBSP;
+    tree_node *Result = StepLayoutHistory(Space, *Live, &Mode, Step);
+    if(!Result)
+        return false;
+
+    DestroyTestTree(*Live);
+    *Live = Result;
+    return true;
+}
+
+internal bool
+HasWindow(tree_node *Root, uint32_t WindowID)
+{
+    return GetTestLeaf(Root, WindowID) != NULL;
+}
+
+TEST(UndoAndRedo)
+{
+    std::string Space = UniqueSpace();
+    tree_node *Live = CreateTestTree(2);
+    EXPECT(RecordLayoutHistory(Space, Live, SpaceModeBSP));
+    EXPECT(!RecordLayoutHistory(Space, Live, SpaceModeBSP));
+
+    SplitTestNode(GetTestLeaf(Live, 2), 3);
+    EXPECT(RecordLayoutHistory(Space, Live, SpaceModeBSP));
+
+    EXPECT(Step(Space, &Live, -1));
+    EXPECT(!HasWindow(Live, 3));
+    EXPECT(!Step(Space, &Live, -1));
+
+    EXPECT(Step(Space, &Live, 1));
+    EXPECT(HasWindow(Live, 3));
+    EXPECT(!Step(Space, &Live, 1));
+    DestroyTestTree(Live);
+}
+
+TEST(StepKeepsRedoWhenTreeChangedAfterUndo)
+{
+    std::string Space = UniqueSpace();
+    tree_node *Live = CreateTestTree(2);
+    RecordLayoutHistory(Space, Live, SpaceModeBSP);
+    SplitTestNode(GetTestLeaf(Live, 2), 3);
+    RecordLayoutHistory(Space, Live, SpaceModeBSP);
+
+    EXPECT(Step(Space, &Live, -1));
+    GetTestLeaf(Live, 1)->Parent->SplitRatio = 0.3;
+
+    /* NOTE(koekeishiya): The changed tree is kept as a version, and the one we undid can
+     *                    still be redone from it. */
+    EXPECT(Step(Space, &Live, 1));
+    EXPECT(HasWindow(Live, 3));
+    EXPECT(Step(Space, &Live, -1));
+    EXPECT(Live->SplitRatio == 0.3);
+    DestroyTestTree(Live);
+}
+
+TEST(RecordDropsRedo)
+{
+    std::string Space = UniqueSpace();
+    tree_node *Live = CreateTestTree(2);
+    RecordLayoutHistory(Space, Live, SpaceModeBSP);
+    SplitTestNode(GetTestLeaf(Live, 2), 3);
+    RecordLayoutHistory(Space, Live, SpaceModeBSP);
+
+    EXPECT(Step(Space, &Live, -1));
+    SplitTestNode(GetTestLeaf(Live, 1), 4);
+    EXPECT(RecordLayoutHistory(Space, Live, SpaceModeBSP));
+    EXPECT(!Step(Space, &Live, 1));
+    DestroyTestTree(Live);
+}
+
+TEST(HistoryIsBounded)
+{
+    std::string Space = UniqueSpace();
+    uint64_t Before = VersionCount();
+    tree_node *Live = CreateTestTree(2);
+    for(int Index = 0; Index < 2 * KWM_LAYOUT_HISTORY_LIMIT; ++Index)
+    {
+        Live->SplitRatio = 0.1 + Index * 0.001;
+        RecordLayoutHistory(Space, Live, SpaceModeBSP);
+    }
+
+    EXPECT(VersionCount() - Before == KWM_LAYOUT_HISTORY_LIMIT);
+
+    int Undone = 0;
+    while(Step(Space, &Live, -1))
+        ++Undone;
+
+    EXPECT(Undone == KWM_LAYOUT_HISTORY_LIMIT - 1);
+    DestroyTestTree(Live);
+}
+
+struct history_thread
+{
+    std::string Space;
+    bool Undo;
+};
+
+internal void *
+ChangeHistory(void *Context)
+{
+    history_thread *Thread = (history_thread *) Context;
+    tree_node *Live = CreateTestTree(4);
+    for(int Index = 0; Index < 1000; ++Index)
+    {
+        if(Thread->Undo && Index % 3 == 0)
+        {
+            Step(Thread->Space, &Live, -1);
+        }
+        else
+        {
+            Live->SplitRatio = 0.1 + (Index % 100) * 0.005;
+            RecordLayoutHistory(Thread->Space, Live, SpaceModeBSP);
+        }
+    }
+
+    DestroyTestTree(Live);
+    return NULL;
+}
+
+/* NOTE(koekeishiya): The daemon and the event thread both change the history of a space. */
+TEST(ConcurrentRecordAndStep)
+{
+    history_thread Threads[2] = { { UniqueSpace(), false }, { "", true } };
+    Threads[1].Space = Threads[0].Space;
+
+    pthread_t Handles[2];
+    for(int Index = 0; Index < 2; ++Index)
+        pthread_create(&Handles[Index], NULL, &ChangeHistory, &Threads[Index]);
+
+    for(int Index = 0; Index < 2; ++Index)
+        pthread_join(Handles[Index], NULL);
+
+    uint64_t Versions, Nodes;
+    GetLayoutHistoryUsage(&Versions, &Nodes);
+    EXPECT(Versions > 0 && Nodes >= Versions);
+}
+
+int main()
+{
+    return RunTests();
+}
@@ -0,0 +1,106 @@
+#include "../kwm/library.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+internal std::string TestDirectory;
+
+internal std::string
+CreateTestLibrary(const char *Name)
+{
+    std::string Library = TestDirectory + "/" + Name;
+    unlink(Library.c_str());
+    return Library;
+}
+
+internal off_t
+FileSize(std::string File)
+{
+    struct stat Buffer = {};
+    stat(File.c_str(), &Buffer);
+    return Buffer.st_size;
+}
+
+internal bool
+HasLayout(std::string Library, std::string Name, std::string Expected)
+{
+    std::string Data;
+    return ReadLayoutFromLibrary(Library, Name, &Data) && Data == Expected;
+}
+
+TEST(StoreAndLookup)
+{
+    std::string Library = CreateTestLibrary("store");
+    std::string Data;
+    EXPECT(!ReadLayoutFromLibrary(Library, "main", &Data));
+
+    EXPECT(WriteLayoutToLibrary(Library, "main", std::string("\x01\x00\x02", 3)));
+    EXPECT(WriteLayoutToLibrary(Library, "side", "abc"));
+    EXPECT(HasLayout(Library, "main", std::string("\x01\x00\x02", 3)));
+    EXPECT(HasLayout(Library, "side", "abc"));
+    EXPECT(!ReadLayoutFromLibrary(Library, "mai", &Data));
+    EXPECT(!WriteLayoutToLibrary(Library, "", "abc"));
+}
+
+TEST(LaterSavesAreAppendedAndReplaceEarlierOnes)
+{
+    std::string Library = CreateTestLibrary("append");
+    EXPECT(WriteLayoutToLibrary(Library, "main", "first"));
+    off_t Size = FileSize(Library);
+
+    EXPECT(WriteLayoutToLibrary(Library, "main", "second"));
+    EXPECT(FileSize(Library) > Size);
+    EXPECT(HasLayout(Library, "main", "second"));
+
+    EXPECT(WriteLayoutToLibrary(Library, "main", "third"));
+    EXPECT(HasLayout(Library, "main", "third"));
+}
+
+TEST(CompactionKeepsEveryLayout)
+{
+    std::string Library = CreateTestLibrary("compact");
+    std::string Data(200, 'x');
+    bool Shrunk = false;
+    off_t Size = 0;
+    for(int Index = 0; Index < 500; ++Index)
+    {
+        Data[0] = (char) Index;
+        EXPECT(WriteLayoutToLibrary(Library, "layout-" + std::to_string(Index % 50), Data));
+        Shrunk = Shrunk || FileSize(Library) < Size;
+        Size = FileSize(Library);
+    }
+
+    EXPECT(Shrunk);
+    for(int Index = 450; Index < 500; ++Index)
+    {
+        Data[0] = (char) Index;
+        EXPECT(HasLayout(Library, "layout-" + std::to_string(Index % 50), Data));
+    }
+}
+
+TEST(InterruptedAppendIsIgnored)
+{
+    std::string Library = CreateTestLibrary("interrupted");
+    EXPECT(WriteLayoutToLibrary(Library, "main", "first"));
+    EXPECT(WriteLayoutToLibrary(Library, "main", "second"));
+    EXPECT(truncate(Library.c_str(), FileSize(Library) - 1) == 0);
+    EXPECT(HasLayout(Library, "main", "first"));
+
+    EXPECT(WriteLayoutToLibrary(Library, "side", "abc"));
+    EXPECT(HasLayout(Library, "side", "abc"));
+    EXPECT(HasLayout(Library, "main", "first"));
+}
+
+int main()
+{
+    char Template[] = "/tmp/kwm-test-library-XXXXXX";
+    if(!mkdtemp(Template))
+        return 1;
+
+    TestDirectory = Template;
+    int Result = RunTests();
+    system(("rm -rf " + TestDirectory).c_str());
+    return Result;
+}
@@ -0,0 +1,105 @@
+#include "../kwm/axlib/membership.h"
+#include "test.h"
+
+/* NOTE(koekeishiya): Stands in for the window server. Calls records every space it was asked about. */
+struct recording_server
+{
+    std::map<CGSSpaceID, std::vector<uint32_t> > SpaceWindows;
+    std::vector<CGSSpaceID> Calls;
+};
+
+internal SPACE_WINDOWS_SOURCE(RecordWindowsOnSpace)
+{
+    recording_server *Server = (recording_server *) Context;
+    Server->Calls.push_back(SpaceID);
+    *Windows = Server->SpaceWindows[SpaceID];
+}
+
+/* NOTE(koekeishiya): Spaces 1 and 2 on one display, space 5 on another. Window 10 is on space 1,
+                      window 11 on space 2, window 12 is sticky and window 13 is on no space. */
+internal recording_server
+TwoDisplays(std::vector<CGSSpaceID> *Spaces)
+{
+    recording_server Server;
+    Server.SpaceWindows[1].push_back(10);
+    Server.SpaceWindows[1].push_back(12);
+    Server.SpaceWindows[2].push_back(11);
+    Server.SpaceWindows[2].push_back(12);
+    Server.SpaceWindows[5].push_back(12);
+    Server.SpaceWindows[5].push_back(99);
+
+    Spaces->push_back(1);
+    Spaces->push_back(2);
+    Spaces->push_back(5);
+    return Server;
+}
+
+TEST(SpacesArePerWindow)
+{
+    std::vector<CGSSpaceID> Spaces;
+    recording_server Server = TwoDisplays(&Spaces);
+
+    std::vector<uint32_t> WindowIDs;
+    WindowIDs.push_back(10);
+    WindowIDs.push_back(11);
+    WindowIDs.push_back(12);
+    WindowIDs.push_back(13);
+
+    ax_window_spaces WindowSpaces = AXLibCollectWindowSpaces(WindowIDs, Spaces, &RecordWindowsOnSpace, &Server);
+    EXPECT(WindowSpaces.size() == 4);
+    EXPECT(WindowSpaces[10].size() == 1 && WindowSpaces[10][0] == 1);
+    EXPECT(WindowSpaces[11].size() == 1 && WindowSpaces[11][0] == 2);
+    EXPECT(WindowSpaces[12].size() == 3);
+    EXPECT(WindowSpaces[13].empty());
+    EXPECT(WindowSpaces.find(99) == WindowSpaces.end());
+}
+
+TEST(OnlyOnSpaceExcludesStickyAndOtherSpaces)
+{
+    std::vector<CGSSpaceID> Spaces;
+    recording_server Server = TwoDisplays(&Spaces);
+
+    std::vector<uint32_t> WindowIDs;
+    for(uint32_t WindowID = 10; WindowID <= 13; ++WindowID)
+        WindowIDs.push_back(WindowID);
+
+    ax_window_spaces WindowSpaces = AXLibCollectWindowSpaces(WindowIDs, Spaces, &RecordWindowsOnSpace, &Server);
+    EXPECT(AXLibWindowOnlyOnSpace(WindowSpaces[10], 1));
+    EXPECT(!AXLibWindowOnlyOnSpace(WindowSpaces[10], 2));
+    EXPECT(AXLibWindowOnlyOnSpace(WindowSpaces[11], 2));
+    EXPECT(!AXLibWindowOnlyOnSpace(WindowSpaces[12], 1));
+    EXPECT(!AXLibWindowOnlyOnSpace(WindowSpaces[13], 1));
+}
+
+TEST(OneCallPerSpaceRegardlessOfWindowCount)
+{
+    std::vector<CGSSpaceID> Spaces;
+    recording_server Server = TwoDisplays(&Spaces);
+
+    std::vector<uint32_t> WindowIDs;
+    for(uint32_t WindowID = 1000; WindowID < 1200; ++WindowID)
+    {
+        Server.SpaceWindows[1 + (WindowID % 2)].push_back(WindowID);
+        WindowIDs.push_back(WindowID);
+    }
+
+    ax_window_spaces WindowSpaces = AXLibCollectWindowSpaces(WindowIDs, Spaces, &RecordWindowsOnSpace, &Server);
+    EXPECT(Server.Calls == Spaces);
+    EXPECT(WindowSpaces.size() == 200);
+    EXPECT(AXLibWindowOnlyOnSpace(WindowSpaces[1001], 2));
+}
+
+TEST(NoWindowsMakesNoCalls)
+{
+    std::vector<CGSSpaceID> Spaces;
+    recording_server Server = TwoDisplays(&Spaces);
+
+    ax_window_spaces WindowSpaces = AXLibCollectWindowSpaces(std::vector<uint32_t>(), Spaces, &RecordWindowsOnSpace, &Server);
+    EXPECT(WindowSpaces.empty());
+    EXPECT(Server.Calls.empty());
+}
+
+int main()
+{
+    return RunTests();
+}
@@ -0,0 +1,137 @@
+#include "../kwm/axlib/placement.h"
+#include "test.h"
+
+/* NOTE(koekeishiya): A scripted display arrangement. Reads counts how often the arrangement is asked for its frames. */
+struct fake_arrangement
+{
+    std::vector<ax_display_area> Areas;
+    int Reads;
+};
+
+internal DISPLAY_ARRANGEMENT_SOURCE(ReadFakeArrangement)
+{
+    fake_arrangement *Fake = (fake_arrangement *) Context;
+    *Areas = Fake->Areas;
+    ++Fake->Reads;
+}
+
+internal int DisplayTags[3];
+#define MAIN_DISPLAY (&DisplayTags[0])
+#define SIDE_DISPLAY (&DisplayTags[1])
+#define TOP_DISPLAY (&DisplayTags[2])
+
+internal ax_display_area
+Area(void *Display, double X, double Y, double Width, double Height)
+{
+    ax_display_area Result = { Display, X, Y, Width, Height };
+    return Result;
+}
+
+/* NOTE(koekeishiya): A 1920x1080 main display, a 1280x1024 display to its right, and a
+                      2560x1440 display stacked above the main display. */
+internal fake_arrangement
+ThreeDisplays()
+{
+    fake_arrangement Fake = {};
+    Fake.Areas.push_back(Area(MAIN_DISPLAY, 0, 0, 1920, 1080));
+    Fake.Areas.push_back(Area(SIDE_DISPLAY, 1920, 0, 1280, 1024));
+    Fake.Areas.push_back(Area(TOP_DISPLAY, -320, -1440, 2560, 1440));
+    return Fake;
+}
+
+internal void
+InitArrangement(ax_display_arrangement *Arrangement, fake_arrangement *Fake)
+{
+    AXLibInitDisplayArrangement(Arrangement, &ReadFakeArrangement, Fake);
+}
+
+TEST(WindowsOnSideBySideAndStackedDisplays)
+{
+    fake_arrangement Fake = ThreeDisplays();
+    ax_display_arrangement Arrangement;
+    InitArrangement(&Arrangement, &Fake);
+
+    ax_window_placement Main = {}, Side = {}, Top = {}, Outside = {};
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Main, 100, 100, 800, 600) == MAIN_DISPLAY);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Side, 2000, 100, 800, 600) == SIDE_DISPLAY);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Top, 0, -1000, 800, 600) == TOP_DISPLAY);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Outside, 5000, 5000, 800, 600) == NULL);
+    EXPECT(Fake.Reads == 1);
+}
+
+TEST(StraddlingWindowBelongsToLargestIntersection)
+{
+    fake_arrangement Fake = ThreeDisplays();
+    ax_display_arrangement Arrangement;
+    InitArrangement(&Arrangement, &Fake);
+
+    ax_window_placement Left = {}, Right = {}, Above = {};
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Left, 1500, 100, 800, 600) == MAIN_DISPLAY);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Right, 1700, 100, 800, 600) == SIDE_DISPLAY);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Above, 100, -400, 800, 600) == TOP_DISPLAY);
+}
+
+TEST(PlacementIsCachedUntilInvalidated)
+{
+    fake_arrangement Fake = ThreeDisplays();
+    ax_display_arrangement Arrangement;
+    InitArrangement(&Arrangement, &Fake);
+
+    ax_window_placement Placement = {};
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Placement, 100, 100, 800, 600) == MAIN_DISPLAY);
+
+    /* NOTE(koekeishiya): The window has moved to the side display, but nobody invalidated it. */
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Placement, 2000, 100, 800, 600) == MAIN_DISPLAY);
+
+    AXLibInvalidateWindowPlacement(&Placement);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Placement, 2000, 100, 800, 600) == SIDE_DISPLAY);
+    EXPECT(Fake.Reads == 1);
+}
+
+TEST(ArrangementChangeRecomputesEveryWindow)
+{
+    fake_arrangement Fake = ThreeDisplays();
+    ax_display_arrangement Arrangement;
+    InitArrangement(&Arrangement, &Fake);
+
+    ax_window_placement Side = {}, Main = {};
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Side, 2000, 100, 800, 600) == SIDE_DISPLAY);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Main, 100, 100, 800, 600) == MAIN_DISPLAY);
+
+    /* NOTE(koekeishiya): The side display is disconnected. No window may keep pointing at it. */
+    Fake.Areas.erase(Fake.Areas.begin() + 1);
+    AXLibChangeDisplayArrangement(&Arrangement);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Side, 2000, 100, 800, 600) == NULL);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Main, 100, 100, 800, 600) == MAIN_DISPLAY);
+
+    /* NOTE(koekeishiya): The top display is moved to the right of the main display. */
+    Fake.Areas[1] = Area(TOP_DISPLAY, 1920, 0, 2560, 1440);
+    AXLibChangeDisplayArrangement(&Arrangement);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Side, 2000, 100, 800, 600) == TOP_DISPLAY);
+    EXPECT(Fake.Reads == 3);
+}
+
+TEST(ArrangementIsReadOncePerGeneration)
+{
+    fake_arrangement Fake = ThreeDisplays();
+    ax_display_arrangement Arrangement;
+    InitArrangement(&Arrangement, &Fake);
+
+    std::vector<ax_window_placement> Placements(100, ax_window_placement());
+    for(int Generation = 0; Generation < 3; ++Generation)
+    {
+        for(std::size_t Index = 0; Index < Placements.size(); ++Index)
+            AXLibPlaceWindow(&Arrangement, &Placements[Index], Index * 30.0, 100, 400, 300);
+
+        AXLibChangeDisplayArrangement(&Arrangement);
+    }
+
+    EXPECT(Fake.Reads == 3);
+    EXPECT(AXLibPlaceWindow(&Arrangement, &Placements[0], 0, 100, 400, 300) == MAIN_DISPLAY);
+    EXPECT(Fake.Reads == 4);
+}
+
+int main()
+{
+    return RunTests();
+}
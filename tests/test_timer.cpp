@@ -0,0 +1,287 @@
+#include "../kwm/axlib/timer.h"
+#include "test.h"
+
+#include <time.h>
+#include <chrono>
+#include <vector>
+
+internal std::vector<ax_timer *>
+PopExpiredTimers(ax_timer_wheel *Wheel)
+{
+    std::vector<ax_timer *> Result;
+    ax_timer *Timer;
+    while((Timer = AXLibPopExpiredTimer(Wheel)))
+        Result.push_back(Timer);
+
+    return Result;
+}
+
+/* NOTE(koekeishiya): Advance one tick at a time and return the tick at which Timer expired. */
+internal uint64_t
+AdvanceUntilExpired(ax_timer_wheel *Wheel, ax_timer *Timer, uint64_t Limit)
+{
+    for(uint64_t Tick = Wheel->Tick; Tick < Limit; ++Tick)
+    {
+        AXLibAdvanceTimerWheel(Wheel, Tick);
+        std::vector<ax_timer *> Expired = PopExpiredTimers(Wheel);
+        for(std::size_t Index = 0; Index < Expired.size(); ++Index)
+        {
+            if(Expired[Index] == Timer)
+                return Tick;
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+TEST(AddAndExpire)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 100);
+
+    ax_timer A = {}, B = {};
+    AXLibAddTimer(&Wheel, &A, 105);
+    AXLibAddTimer(&Wheel, &B, 103);
+    EXPECT(Wheel.Count == 2);
+    EXPECT(AXLibNextTimerTick(&Wheel) == 103);
+
+    AXLibAdvanceTimerWheel(&Wheel, 102);
+    EXPECT(AXLibPopExpiredTimer(&Wheel) == NULL);
+
+    AXLibAdvanceTimerWheel(&Wheel, 110);
+    std::vector<ax_timer *> Expired = PopExpiredTimers(&Wheel);
+    EXPECT(Expired.size() == 2);
+    EXPECT(Expired[0] == &B && Expired[1] == &A);
+    EXPECT(!AXLibIsTimerPending(&A) && !AXLibIsTimerPending(&B));
+    EXPECT(Wheel.Count == 0);
+    EXPECT(AXLibNextTimerTick(&Wheel) == UINT64_MAX);
+}
+
+TEST(Cancel)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 0);
+
+    ax_timer A = {}, B = {};
+    AXLibAddTimer(&Wheel, &A, 10);
+    AXLibAddTimer(&Wheel, &B, 5000);
+    AXLibRemoveTimer(&Wheel, &A);
+    AXLibRemoveTimer(&Wheel, &B);
+    AXLibRemoveTimer(&Wheel, &B);
+    EXPECT(!AXLibIsTimerPending(&A) && !AXLibIsTimerPending(&B));
+    EXPECT(Wheel.Count == 0);
+
+    AXLibAdvanceTimerWheel(&Wheel, 10000);
+    EXPECT(AXLibPopExpiredTimer(&Wheel) == NULL);
+}
+
+TEST(CancelExpiredBeforePop)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 0);
+
+    ax_timer A = {};
+    AXLibAddTimer(&Wheel, &A, 3);
+    AXLibAdvanceTimerWheel(&Wheel, 3);
+    AXLibRemoveTimer(&Wheel, &A);
+    EXPECT(AXLibPopExpiredTimer(&Wheel) == NULL);
+    EXPECT(Wheel.Count == 0);
+}
+
+TEST(Rearm)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 0);
+
+    ax_timer A = {};
+    AXLibAddTimer(&Wheel, &A, 10);
+    AXLibAdvanceTimerWheel(&Wheel, 8);
+    AXLibAddTimer(&Wheel, &A, 20);
+    EXPECT(Wheel.Count == 1);
+    EXPECT(AdvanceUntilExpired(&Wheel, &A, 1000) == 20);
+    EXPECT(Wheel.Count == 0);
+}
+
+TEST(Cascade)
+{
+    uint64_t Expiries[] = { 63, 64, 65, 4095, 4096, 4097, 64 * 64 * 64 + 7, 64 * 64 * 64 * 3 + 4100 };
+    for(std::size_t Index = 0; Index < sizeof(Expiries) / sizeof(Expiries[0]); ++Index)
+    {
+        ax_timer_wheel Wheel;
+        AXLibInitTimerWheel(&Wheel, 1);
+
+        ax_timer A = {};
+        AXLibAddTimer(&Wheel, &A, Expiries[Index]);
+        EXPECT(AdvanceUntilExpired(&Wheel, &A, Expiries[Index] + 2) == Expiries[Index]);
+    }
+}
+
+TEST(CascadeWithJump)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 0);
+
+    ax_timer A = {}, B = {};
+    AXLibAddTimer(&Wheel, &A, 70000);
+    AXLibAddTimer(&Wheel, &B, 5000);
+    AXLibAdvanceTimerWheel(&Wheel, 69999);
+
+    std::vector<ax_timer *> Expired = PopExpiredTimers(&Wheel);
+    EXPECT(Expired.size() == 1 && Expired[0] == &B);
+
+    AXLibAdvanceTimerWheel(&Wheel, 70000);
+    Expired = PopExpiredTimers(&Wheel);
+    EXPECT(Expired.size() == 1 && Expired[0] == &A);
+}
+
+TEST(NextTick)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 10);
+
+    ax_timer A = {};
+    AXLibAddTimer(&Wheel, &A, 1000);
+
+    /* NOTE(koekeishiya): A sits in a higher level, so the wheel must wake at the next wrap. */
+    EXPECT(AXLibNextTimerTick(&Wheel) == 64);
+    EXPECT(AdvanceUntilExpired(&Wheel, &A, 2000) == 1000);
+}
+
+TEST(Clamp)
+{
+    ax_timer_wheel Wheel;
+    AXLibInitTimerWheel(&Wheel, 50);
+
+    uint64_t Range = (uint64_t) 1 << (AX_TIMER_WHEEL_BITS * AX_TIMER_WHEEL_LEVELS);
+    ax_timer Past = {}, Far = {};
+    AXLibAddTimer(&Wheel, &Past, 10);
+    AXLibAddTimer(&Wheel, &Far, UINT64_MAX - 1);
+    EXPECT(Past.Expires == 50);
+    EXPECT(Far.Expires == 50 + Range - 1);
+
+    AXLibAdvanceTimerWheel(&Wheel, 50);
+    std::vector<ax_timer *> Expired = PopExpiredTimers(&Wheel);
+    EXPECT(Expired.size() == 1 && Expired[0] == &Past);
+    EXPECT(AdvanceUntilExpired(&Wheel, &Far, 50 + Range + 1) == 50 + Range - 1);
+}
+
+TEST(SignalBeforeWaitIsNotLost)
+{
+    pthread_mutex_t Lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_cond_t Condition = PTHREAD_COND_INITIALIZER;
+    ax_wakeup Wakeup = { &Lock, &Condition, false };
+
+    pthread_mutex_lock(&Lock);
+    AXLibSignalWakeup(&Wakeup);
+    EXPECT(AXLibWaitForWakeup(&Wakeup, 5));
+    EXPECT(!Wakeup.Pending);
+    EXPECT(!AXLibWaitForWakeup(&Wakeup, 0.001));
+    pthread_mutex_unlock(&Lock);
+}
+
+#define LOOP_TICK_MS 10
+
+/* NOTE(koekeishiya): A wheel with an owning thread that sleeps between expiries, the same way
+                      the axlib event-loop does. Expired is the tick at which Timer fired. */
+struct timer_loop
+{
+    pthread_mutex_t Lock;
+    pthread_cond_t Condition;
+    ax_wakeup Wakeup;
+    ax_timer_wheel Wheel;
+    std::chrono::steady_clock::time_point Epoch;
+    ax_timer *Timer;
+    uint64_t Expired;
+    bool Running;
+};
+
+internal uint64_t
+CurrentLoopTick(timer_loop *Loop)
+{
+    std::chrono::duration<double, std::milli> Elapsed = std::chrono::steady_clock::now() - Loop->Epoch;
+    return (uint64_t) (Elapsed.count() / LOOP_TICK_MS);
+}
+
+internal void *
+RunTimerLoop(void *Context)
+{
+    timer_loop *Loop = (timer_loop *) Context;
+    pthread_mutex_lock(&Loop->Lock);
+    while(Loop->Running)
+    {
+        uint64_t Tick = CurrentLoopTick(Loop);
+        AXLibAdvanceTimerWheel(&Loop->Wheel, Tick);
+
+        ax_timer *Timer;
+        while((Timer = AXLibPopExpiredTimer(&Loop->Wheel)))
+        {
+            if(Timer == Loop->Timer)
+                Loop->Expired = Tick;
+        }
+
+        uint64_t Next = AXLibNextTimerTick(&Loop->Wheel);
+        double Timeout = Next == UINT64_MAX ? -1 : (Next > Tick ? Next - Tick : 1) * LOOP_TICK_MS / 1000.0;
+        AXLibWaitForWakeup(&Loop->Wakeup, Timeout);
+    }
+    pthread_mutex_unlock(&Loop->Lock);
+    return NULL;
+}
+
+TEST(ScheduleFromAnotherThreadWhileIdle)
+{
+    timer_loop Loop;
+    pthread_mutex_init(&Loop.Lock, NULL);
+    pthread_cond_init(&Loop.Condition, NULL);
+    Loop.Wakeup.Lock = &Loop.Lock;
+    Loop.Wakeup.Condition = &Loop.Condition;
+    Loop.Wakeup.Pending = false;
+    Loop.Epoch = std::chrono::steady_clock::now();
+    AXLibInitTimerWheel(&Loop.Wheel, 0);
+    Loop.Expired = UINT64_MAX;
+    Loop.Running = true;
+
+    /* NOTE(koekeishiya): The loop goes to sleep for ten seconds, until the far timer is due. */
+    ax_timer Far = {}, Near = {};
+    AXLibAddTimer(&Loop.Wheel, &Far, 1000);
+    Loop.Timer = &Near;
+
+    pthread_t Thread;
+    pthread_create(&Thread, NULL, &RunTimerLoop, &Loop);
+
+    struct timespec Idle = { 0, 50 * 1000000 };
+    nanosleep(&Idle, NULL);
+
+    pthread_mutex_lock(&Loop.Lock);
+    uint64_t Scheduled = CurrentLoopTick(&Loop);
+    AXLibAdvanceTimerWheel(&Loop.Wheel, Scheduled);
+    AXLibAddTimer(&Loop.Wheel, &Near, Scheduled + 2);
+    AXLibSignalWakeup(&Loop.Wakeup);
+    pthread_mutex_unlock(&Loop.Lock);
+
+    for(int Attempt = 0; Attempt < 100; ++Attempt)
+    {
+        pthread_mutex_lock(&Loop.Lock);
+        bool Fired = Loop.Expired != UINT64_MAX;
+        pthread_mutex_unlock(&Loop.Lock);
+        if(Fired)
+            break;
+
+        struct timespec Delay = { 0, LOOP_TICK_MS * 1000000 };
+        nanosleep(&Delay, NULL);
+    }
+
+    pthread_mutex_lock(&Loop.Lock);
+    EXPECT(Loop.Expired >= Scheduled + 2 && Loop.Expired < Scheduled + 50);
+    Loop.Running = false;
+    AXLibSignalWakeup(&Loop.Wakeup);
+    pthread_mutex_unlock(&Loop.Lock);
+
+    pthread_join(Thread, NULL);
+    pthread_cond_destroy(&Loop.Condition);
+    pthread_mutex_destroy(&Loop.Lock);
+}
+
+int main()
+{
+    return RunTests();
+}
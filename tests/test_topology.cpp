@@ -0,0 +1,97 @@
+#include "../kwm/axlib/topology.h"
+#include "test.h"
+
+/* NOTE(koekeishiya): Stands in for the window server; counts how often it is read. */
+struct scripted_topology
+{
+    std::vector<CGSSpaceID> Spaces;
+    int Reads;
+};
+
+internal SPACE_TOPOLOGY_SOURCE(ReadScriptedTopology)
+{
+    scripted_topology *Script = (scripted_topology *) Context;
+    *SpaceOrder = Script->Spaces;
+    ++Script->Reads;
+}
+
+internal void
+InitScriptedTopology(ax_space_topology *Topology, scripted_topology *Script, std::vector<CGSSpaceID> Spaces)
+{
+    Script->Spaces = Spaces;
+    Script->Reads = 0;
+    AXLibInitSpaceTopology(Topology, &ReadScriptedTopology, Script);
+}
+
+TEST(LookupsReadOnce)
+{
+    scripted_topology Script;
+    ax_space_topology Topology;
+    InitScriptedTopology(&Topology, &Script, { 4, 9, 2 });
+    EXPECT(Script.Reads == 0);
+
+    EXPECT(AXLibTopologySpacesCount(&Topology) == 3);
+    EXPECT(AXLibTopologyDesktopID(&Topology, 4) == 1);
+    EXPECT(AXLibTopologyDesktopID(&Topology, 2) == 3);
+    EXPECT(AXLibTopologySpaceID(&Topology, 2) == 9);
+    EXPECT(Script.Reads == 1);
+}
+
+TEST(StaleRereads)
+{
+    scripted_topology Script;
+    ax_space_topology Topology;
+    InitScriptedTopology(&Topology, &Script, { 4, 9 });
+    EXPECT(AXLibTopologySpaceID(&Topology, 1) == 4);
+
+    Script.Spaces = { 9, 4 };
+    EXPECT(AXLibTopologySpaceID(&Topology, 1) == 4);
+
+    AXLibMarkSpaceTopologyStale(&Topology);
+    EXPECT(Script.Reads == 1);
+    EXPECT(AXLibTopologySpaceID(&Topology, 1) == 9);
+    EXPECT(AXLibTopologyDesktopID(&Topology, 4) == 2);
+    EXPECT(Script.Reads == 2);
+}
+
+TEST(MissRefreshesOnce)
+{
+    scripted_topology Script;
+    ax_space_topology Topology;
+    InitScriptedTopology(&Topology, &Script, { 1, 2 });
+    EXPECT(AXLibTopologySpacesCount(&Topology) == 2);
+
+    /* NOTE(koekeishiya): A space added in Mission Control without any notification. */
+    Script.Spaces = { 1, 2, 7 };
+    EXPECT(AXLibTopologyDesktopID(&Topology, 7) == 3);
+    EXPECT(Script.Reads == 2);
+
+    Script.Spaces = { 1, 2, 7, 8 };
+    EXPECT(AXLibTopologySpaceID(&Topology, 4) == 8);
+    EXPECT(Script.Reads == 3);
+}
+
+TEST(UnknownSpace)
+{
+    scripted_topology Script;
+    ax_space_topology Topology;
+    InitScriptedTopology(&Topology, &Script, { 1, 2 });
+
+    EXPECT(AXLibTopologyDesktopID(&Topology, 42) == 0);
+    EXPECT(AXLibTopologySpaceID(&Topology, 0) == 0);
+    EXPECT(AXLibTopologySpaceID(&Topology, 3) == 0);
+    EXPECT(AXLibTopologySpacesCount(&Topology) == 2);
+}
+
+TEST(NoSource)
+{
+    ax_space_topology Topology;
+    AXLibInitSpaceTopology(&Topology, NULL, NULL);
+    EXPECT(AXLibTopologySpacesCount(&Topology) == 0);
+    EXPECT(AXLibTopologySpaceID(&Topology, 1) == 0);
+}
+
+int main()
+{
+    return RunTests();
+}
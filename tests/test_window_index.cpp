@@ -0,0 +1,112 @@
+#include "../kwm/axlib/windowindex.h"
+#include "test.h"
+
+#include <vector>
+
+/* NOTE(koekeishiya): The index only stores pointers, so the test can use its own windows. */
+struct ax_window
+{
+    uint32_t ID;
+};
+
+TEST(LookupInsertAndErase)
+{
+    ax_window_index Index;
+    AXLibInitWindowIndex(&Index);
+
+    ax_window A = { 10 }, B = { 20 };
+    EXPECT(AXLibLookupWindow(&Index, 10) == NULL);
+
+    AXLibInsertWindow(&Index, A.ID, &A);
+    AXLibInsertWindow(&Index, B.ID, &B);
+    EXPECT(AXLibLookupWindow(&Index, 10) == &A);
+    EXPECT(AXLibLookupWindow(&Index, 20) == &B);
+
+    EXPECT(AXLibEraseWindow(&Index, A.ID, &A));
+    EXPECT(!AXLibEraseWindow(&Index, A.ID, &A));
+    EXPECT(AXLibLookupWindow(&Index, 10) == NULL);
+    EXPECT(AXLibLookupWindow(&Index, 20) == &B);
+}
+
+/* NOTE(koekeishiya): A window id can be reused by a new window before the destroyed notification of
+                      the old one has been handled, which must not remove the new window. */
+TEST(ReusedIdIsNotErasedByOldWindow)
+{
+    ax_window_index Index;
+    AXLibInitWindowIndex(&Index);
+
+    ax_window Old = { 30 }, New = { 30 };
+    AXLibInsertWindow(&Index, Old.ID, &Old);
+    AXLibInsertWindow(&Index, New.ID, &New);
+    EXPECT(AXLibLookupWindow(&Index, 30) == &New);
+
+    EXPECT(!AXLibEraseWindow(&Index, Old.ID, &Old));
+    EXPECT(AXLibLookupWindow(&Index, 30) == &New);
+}
+
+#define WORKER_COUNT 4
+#define WINDOWS_PER_WORKER 2000
+
+struct index_worker
+{
+    ax_window_index *Index;
+    std::vector<ax_window> Windows;
+};
+
+internal void *
+InsertWindows(void *Context)
+{
+    index_worker *Worker = (index_worker *) Context;
+    for(std::size_t Window = 0; Window < Worker->Windows.size(); ++Window)
+        AXLibInsertWindow(Worker->Index, Worker->Windows[Window].ID, &Worker->Windows[Window]);
+
+    return NULL;
+}
+
+/* NOTE(koekeishiya): Applications are loaded on several workers while the event thread keeps
+                      looking windows up, as AXLibRunningApplications does at runtime. */
+TEST(ConcurrentInsertAndLookup)
+{
+    ax_window_index Index;
+    AXLibInitWindowIndex(&Index);
+
+    index_worker Workers[WORKER_COUNT];
+    pthread_t Threads[WORKER_COUNT];
+    for(int Worker = 0; Worker < WORKER_COUNT; ++Worker)
+    {
+        Workers[Worker].Index = &Index;
+        Workers[Worker].Windows.resize(WINDOWS_PER_WORKER);
+        for(int Window = 0; Window < WINDOWS_PER_WORKER; ++Window)
+            Workers[Worker].Windows[Window].ID = 1 + Worker * WINDOWS_PER_WORKER + Window;
+    }
+
+    for(int Worker = 0; Worker < WORKER_COUNT; ++Worker)
+        pthread_create(&Threads[Worker], NULL, &InsertWindows, &Workers[Worker]);
+
+    bool Consistent = true;
+    for(int Lookup = 0; Lookup < 20000; ++Lookup)
+    {
+        uint32_t WID = 1 + Lookup % (WORKER_COUNT * WINDOWS_PER_WORKER);
+        ax_window *Window = AXLibLookupWindow(&Index, WID);
+        if(Window && Window->ID != WID)
+            Consistent = false;
+    }
+
+    for(int Worker = 0; Worker < WORKER_COUNT; ++Worker)
+        pthread_join(Threads[Worker], NULL);
+
+    EXPECT(Consistent);
+    for(int Worker = 0; Worker < WORKER_COUNT; ++Worker)
+    {
+        for(int Window = 0; Window < WINDOWS_PER_WORKER; ++Window)
+        {
+            ax_window *Expected = &Workers[Worker].Windows[Window];
+            EXPECT(AXLibLookupWindow(&Index, Expected->ID) == Expected);
+        }
+    }
+}
+
+int main()
+{
+    return RunTests();
+}